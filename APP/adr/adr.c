@@ -0,0 +1,159 @@
+/**
+ * @file adr.c
+ * @brief LoRa自适应速率: 根据链路余量调整发射功率
+ *
+ * 每收到一次应答调用 ADR_OnAck()，样本取网关在应答中回报的上行SNR，应答不含该字段时
+ * 取本机测得的应答包SNR(LORA_GetPacketStatus，链路近似互易)：
+ *  - 累计 ADR_WINDOW 个样本后，以窗口内最大SNR减去 ADR_SF 的解调门限和 ADR_MARGIN_DB 得到余量，
+ *    每 ADR_STEP_DB 降一档功率直到 ADR_DBM_MIN；余量为负时升功率；余量不足一档时保持不变，
+ *    避免在门限附近来回切换。
+ *  - 发送后未收到应答调用 ADR_OnLoss()：连续 ADR_LOSS_STEP 次丢失升一档功率，
+ *    连续 ADR_LOSS_FALLBACK 次丢失直接恢复默认的 ADR_DBM_MAX。
+ * 点对点链路中网关只以 ADR_SF 接收，也不跟随各节点切换，因此扩频因子固定为 ADR_SF，只调整功率。
+ * 结果写入 loraConfig，由 LORA_ApplyConfig() 只下发变化的设置。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "adr/adr.h"
+
+AdrStateTypeDef adrState = {0};
+
+/* LLCC68各扩频因子的解调SNR门限(dB, 向上取整), 下标为SF-LLCC68_LORA_SF_5 */
+static const int8_t adrRequiredSnr[] = {-2, -5, -7, -10, -12, -15, -17};
+
+/* 编译期检查: ADR_SF(即LLCC68_LORA_DEFAULT_SF)需在门限表范围内 */
+typedef char AdrSfCheck[(ADR_SF >= LLCC68_LORA_SF_5 && ADR_SF - LLCC68_LORA_SF_5 < sizeof(adrRequiredSnr)) ? 1 : -1];
+
+/**
+ * @brief 开始新的统计窗口
+ */
+static void ADR_ClearWindow(void)
+{
+    adrState.snrMax = ADR_SNR_NONE;
+    adrState.samples = 0;
+}
+
+/**
+ * @brief 把当前速率写入目标配置, 射频已初始化时立即下发
+ */
+static void ADR_Apply(uint8_t sendNow)
+{
+    loraConfig.sf = adrState.sf;
+    loraConfig.txDbm = adrState.txDbm;
+    if (sendNow)
+    {
+        (void)LORA_ApplyConfig(&loraConfig);
+    }
+}
+
+/**
+ * @brief 恢复默认速率并清除统计
+ */
+void ADR_Reset(void)
+{
+    adrState.sf = ADR_SF;
+    adrState.txDbm = ADR_DBM_MAX;
+    adrState.losses = 0;
+    ADR_ClearWindow();
+}
+
+/**
+ * @brief 恢复掉电保持的速率
+ * @note 需在PERSIST_Init()之后、LORA_Init()之前调用, 掉电保持的数据无效时恢复默认
+ */
+void ADR_Init(void)
+{
+#ifdef ADR_ENABLE
+    if (adrState.sf != ADR_SF ||
+        adrState.txDbm < ADR_DBM_MIN || adrState.txDbm > ADR_DBM_MAX)
+    {
+        ADR_Reset();
+    }
+#else
+    ADR_Reset();
+#endif
+    ADR_Apply(0);
+}
+
+/**
+ * @brief 按余量调整速率
+ * @param steps 正数为可降低的档数, 负数为需升高的档数
+ */
+static void ADR_Step(int8_t steps)
+{
+    while (steps > 0 && adrState.txDbm > ADR_DBM_MIN)
+    {
+        adrState.txDbm = (adrState.txDbm - ADR_STEP_DB > ADR_DBM_MIN) ? adrState.txDbm - ADR_STEP_DB : ADR_DBM_MIN;
+        steps--;
+    }
+    while (steps < 0 && adrState.txDbm < ADR_DBM_MAX)
+    {
+        adrState.txDbm = (adrState.txDbm + ADR_STEP_DB < ADR_DBM_MAX) ? adrState.txDbm + ADR_STEP_DB : ADR_DBM_MAX;
+        steps++;
+    }
+}
+
+/**
+ * @brief 收到应答时记录链路质量
+ * @param rssi 应答包RSSI(dBm), 仅用于调试输出
+ * @param snr 上行SNR(dB), 见文件说明
+ */
+void ADR_OnAck(int16_t rssi, int8_t snr)
+{
+#ifdef ADR_ENABLE
+    int16_t margin;
+    int8_t txDbm = adrState.txDbm;
+
+    adrState.losses = 0;
+    if (snr > adrState.snrMax)
+    {
+        adrState.snrMax = snr;
+    }
+    if (++adrState.samples < ADR_WINDOW)
+    {
+        return;
+    }
+
+    margin = adrState.snrMax - adrRequiredSnr[ADR_SF - LLCC68_LORA_SF_5] - ADR_MARGIN_DB;
+    ADR_Step((int8_t)(margin >= 0 ? margin / ADR_STEP_DB : -((-margin + ADR_STEP_DB - 1) / ADR_STEP_DB)));
+    ADR_ClearWindow();
+
+    if (adrState.txDbm != txDbm)
+    {
+        DEBUG_Info("ADR %ddBm -> %ddBm (margin %ddB, rssi %d)\r\n", txDbm, adrState.txDbm, margin, rssi);
+        ADR_Apply(1);
+    }
+#else
+    (void)rssi;
+    (void)snr;
+#endif
+}
+
+/**
+ * @brief 发送后未收到应答
+ */
+void ADR_OnLoss(void)
+{
+#ifdef ADR_ENABLE
+    adrState.losses++;
+    ADR_ClearWindow();
+
+    if (adrState.losses >= ADR_LOSS_FALLBACK)
+    {
+        if (adrState.txDbm == ADR_DBM_MAX)
+        {
+            return;
+        }
+        ADR_Reset();
+        DEBUG_Warn("ADR fallback %ddBm\r\n", adrState.txDbm);
+        ADR_Apply(1);
+    }
+    else if (adrState.losses % ADR_LOSS_STEP == 0)
+    {
+        ADR_Step(-1);
+        DEBUG_Warn("ADR loss %d, %ddBm\r\n", adrState.losses, adrState.txDbm);
+        ADR_Apply(1);
+    }
+#endif
+}
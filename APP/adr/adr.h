@@ -0,0 +1,32 @@
+#ifndef __ADR_H__
+#define __ADR_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "LoRa/lora.h"
+
+#define ADR_SF          LLCC68_LORA_DEFAULT_SF          /* 网关固定以此扩频因子接收, ADR不改变SF */
+#define ADR_DBM_MIN     2                               /* 最低发射功率(dBm) */
+#define ADR_DBM_MAX     LLCC68_LORA_DEFAULT_TX_DBM      /* 最高发射功率(dBm) */
+#define ADR_STEP_DB     3                               /* 每档对应的SNR余量(dB) */
+#define ADR_SNR_NONE    (-128)                          /* 窗口内尚无样本 */
+
+/* ADR状态, 由persist模块掉电保持 */
+typedef struct
+{
+    uint8_t sf;             // 当前扩频因子 llcc68_lora_sf_t
+    int8_t txDbm;           // 当前发射功率(dBm)
+    int8_t snrMax;          // 本窗口内的最大SNR(dB)
+    uint8_t samples;        // 本窗口内的样本数
+    uint8_t losses;         // 连续丢失应答的次数
+    uint8_t reserved[3];
+} AdrStateTypeDef;
+
+extern AdrStateTypeDef adrState;
+
+void ADR_Init(void);
+void ADR_Reset(void);
+void ADR_OnAck(int16_t rssi, int8_t snr);
+void ADR_OnLoss(void);
+
+#endif
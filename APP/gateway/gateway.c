@@ -0,0 +1,263 @@
+/**
+ * @file gateway.c
+ * @brief LoRa汇聚网关: 收集附近叶节点的位置帧, 经NB-IoT批量上行
+ *
+ * 网关的LLCC68始终处于连续接收，收到的位置帧按节点ID保存在节点表中：
+ *  - 同一节点序号落后不超过 GATEWAY_DUP_WINDOW 的帧视为重复帧丢弃
+ *    (叶节点重发或被多次接收)，更新的帧覆盖尚未上行的旧帧，每个节点每批只上行最新位置；
+ *  - 每个上报周期由 GATEWAY_BuildBatch() 把自身位置和所有待上行的叶节点位置拼成一个批量帧，
+ *    整批只付出一次NB-IoT附着、连接的开销。
+ * 两次上报之间 GATEWAY_Listen() 让MCU停在STOP模式，DIO1中断唤醒后处理数据包，
+ * 不进入STANDBY以保持接收和节点表。使能TDMA时同时由RTC闹钟在每个超帧起点唤醒发送信标。
+ * 超过一帧的消息由 loraFrag 分片层重组后按位置帧逐个保存；单个位置帧经 loraLink 链路层统计，
+ * 处理完数据包后回复待发的应答或SACK。
+ * 网关自身上报(GNSS定位、NB-IoT发送)期间不处理LoRa，芯片缓冲区只保留最近一包，
+ * 此期间到达的其他帧由叶节点下个周期补上。
+ * Tools/host/gateway_sim.c 在PC上以虚拟信道仿真多个叶节点的冲突、重发，检查去重和批量上行。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "gateway/gateway.h"
+
+/* 节点表条目 */
+typedef struct
+{
+    LoraPositionTypeDef position;   // 最近一帧位置
+    uint8_t used;                   // 1 表示条目已分配
+    uint8_t pending;                // 1 表示最近一帧尚未上行
+} GatewayNodeTypeDef;
+
+GatewayStatsTypeDef gatewayStats = {0};
+
+static GatewayNodeTypeDef gatewayNodes[GATEWAY_MAX_NODES];
+
+/**
+ * @brief 查找节点条目, 不存在时分配空闲条目或已上行的条目
+ * @return GatewayNodeTypeDef* 节点条目, 节点表已满且均待上行时返回NULL
+ */
+static GatewayNodeTypeDef *GATEWAY_FindNode(uint32_t nodeId)
+{
+    GatewayNodeTypeDef *spare = NULL;
+    uint8_t i;
+
+    for (i = 0; i < GATEWAY_MAX_NODES; i++)
+    {
+        GatewayNodeTypeDef *node = &gatewayNodes[i];
+
+        if (node->used && node->position.nodeId == nodeId)
+        {
+            return node;
+        }
+        if (spare == NULL && (!node->used || !node->pending))
+        {
+            spare = node;
+        }
+    }
+    if (spare != NULL)
+    {
+        spare->used = 0;
+        spare->pending = 0;
+    }
+    return spare;
+}
+
+/**
+ * @brief 去重后把位置帧保存到节点表
+ */
+static void GATEWAY_Store(const LoraPositionTypeDef *position)
+{
+    GatewayNodeTypeDef *node;
+
+    gatewayStats.received++;
+    node = GATEWAY_FindNode(position->nodeId);
+    if (node == NULL)
+    {
+        gatewayStats.overflow++;
+        return;
+    }
+    if (node->used && (uint16_t)(node->position.seq - position->seq) < GATEWAY_DUP_WINDOW)
+    {
+        gatewayStats.duplicates++;
+        return;
+    }
+
+    node->position = *position;
+    node->used = 1;
+    node->pending = 1;
+    DEBUG_Trace("Gateway rx node %08lX seq %u\r\n", position->nodeId, position->seq);
+}
+
+/**
+ * @brief 分片重组完成回调: 消息由连续的位置帧组成, 按发送顺序逐个保存
+ */
+static void GATEWAY_OnMessage(uint32_t nodeId, const uint8_t *data, uint16_t length)
+{
+    LoraPositionTypeDef position;
+    uint16_t offset;
+
+    for (offset = 0; offset + LORAFRAME_POSITION_LEN <= length; offset += LORAFRAME_POSITION_LEN)
+    {
+        if (LORAFRAME_DecodePosition(data + offset, LORAFRAME_POSITION_LEN, &position) != 0 ||
+            position.nodeId != nodeId)
+        {
+            gatewayStats.invalid++;
+            continue;
+        }
+        GATEWAY_Store(&position);
+    }
+}
+
+/**
+ * @brief 连续接收回调: 分片帧交给分片层重组, 位置帧经链路层统计并应答, 去重后保存到节点表
+ * @note 链路层重复帧(叶节点未收到应答而重发)在保存时按序号窗口丢弃
+ */
+static void GATEWAY_OnReceive(uint8_t *buffer, uint16_t length)
+{
+    LoraPositionTypeDef position;
+
+    if (buffer == NULL || LORAFRAG_OnReceive(buffer, length, GATEWAY_OnMessage) == 0)
+    {
+        return;
+    }
+    if (LORAFRAME_DecodePosition(buffer, length, &position) != 0)
+    {
+        gatewayStats.invalid++;
+        return;
+    }
+    (void)LORALINK_OnReceive(buffer, length);
+    GATEWAY_Store(&position);
+}
+
+/**
+ * @brief 开始连续接收
+ */
+static void GATEWAY_StartReceive(void)
+{
+    if (LORA_ReceiveAsync(0, GATEWAY_OnReceive) != 0)
+    {
+        DEBUG_Error("Gateway receive start failed\r\n");
+    }
+}
+
+/**
+ * @brief 初始化LoRa并开始连续接收
+ */
+void GATEWAY_Init(void)
+{
+    memset(gatewayNodes, 0, sizeof(gatewayNodes));
+    LORA_Init();
+    GATEWAY_StartReceive();
+}
+
+/**
+ * @brief 生成批量帧: 自身位置在前, 其后为所有待上行的叶节点位置
+ * @param buffer 输出缓冲区, 至少GATEWAY_BATCH_MAX字节
+ * @param self 网关自身的位置帧
+ * @return uint16_t 批量帧长度
+ */
+uint16_t GATEWAY_BuildBatch(uint8_t *buffer, const LoraPositionTypeDef *self)
+{
+    uint16_t length = LORAFRAME_BATCH_HEADER_LEN;
+    uint8_t count = 1;
+    uint8_t i;
+
+    length += LORAFRAME_EncodePosition(self, buffer + length);
+    for (i = 0; i < GATEWAY_MAX_NODES; i++)
+    {
+        if (gatewayNodes[i].pending)
+        {
+            length += LORAFRAME_EncodePosition(&gatewayNodes[i].position, buffer + length);
+            gatewayNodes[i].pending = 0;
+            count++;
+        }
+    }
+    LORAFRAME_EncodeBatchHeader(buffer, self->nodeId, count);
+
+    gatewayStats.forwarded += count - 1;
+    gatewayStats.batches++;
+    DEBUG_Info("Gateway batch %u nodes, rx %lu dup %lu overflow %lu\r\n",
+               count - 1, gatewayStats.received, gatewayStats.duplicates, gatewayStats.overflow);
+    return length;
+}
+
+/**
+ * @brief 关闭外设模块, 以STOP模式保持LoRa接收seconds秒
+ * @details DIO1(EXTI14)唤醒后恢复时钟并调用LORA_Process()分发接收回调, 然后重新进入STOP。
+ *          检查唤醒标志与进入STOP之间关中断, 避免标志在两者之间置位而错过数据包。
+ *          使能TDMA时RTC闹钟取接收结束与下一个超帧起点中较早者, 到达超帧起点时发送信标后继续接收。
+ *          调试串口输入唤醒时处理命令行, 命令请求立即上报时提前结束接收。
+ * @param seconds 接收时长(秒)
+ */
+void GATEWAY_Listen(uint32_t seconds)
+{
+    uint32_t now = RTC_GetCounter();
+    uint32_t end = now + seconds;
+    uint32_t wake;
+    uint8_t report = SHELL_Poll(); // 执行调试命令行已收到的命令
+
+    LOWPOWER_SleepModules();
+    PROFILE_SleepBegin();
+
+    DEBUG_Info("Gateway listening %lu s...\r\n", seconds);
+    DEBUG_Flush();
+
+    while (now < end && report == 0)
+    {
+        wake = end;
+#ifdef TDMA_ENABLE
+        if (TDMA_GetNextBeacon(now) < wake)
+        {
+            wake = TDMA_GetNextBeacon(now);
+        }
+#endif
+        RTC_SetAlarm(wake - now);
+
+        SHELL_ArmWakeup();
+        HAL_SuspendTick();
+        while (rtcAlarmFlag == 0 && report == 0)
+        {
+            __disable_irq();
+            if (rtcAlarmFlag == 0 && gpioB14Flag == 0 && gpioA10Flag == 0)
+            {
+                HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+            }
+            __enable_irq();
+
+            if (gpioA10Flag)
+            {
+                HAL_ResumeTick();
+                CLOCK_Resume();
+                report = SHELL_Session(); // 命令行请求立即上报时结束接收
+                SHELL_ArmWakeup();
+                HAL_SuspendTick();
+            }
+
+            if (gpioB14Flag)
+            {
+                HAL_ResumeTick();
+                CLOCK_Resume();
+                LORA_Process();
+                if (LORALINK_Poll() || LORAFRAG_Poll())
+                {
+                    GATEWAY_StartReceive();
+                }
+                HAL_SuspendTick();
+            }
+        }
+        SHELL_DisarmWakeup();
+        HAL_ResumeTick();
+        CLOCK_Resume();
+
+#ifdef TDMA_ENABLE
+        if (report == 0 && wake % TDMA_FRAME_S == 0)
+        {
+            TDMA_SendBeacon();
+            GATEWAY_StartReceive();
+        }
+#endif
+        now = RTC_GetCounter();
+    }
+
+    PROFILE_SleepEnd();
+}
@@ -0,0 +1,33 @@
+#ifndef __GATEWAY_H__
+#define __GATEWAY_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+#include "loraFrag/loraFrag.h"
+#include "loraLink/loraLink.h"
+#include "lowPower/lowPower.h"
+#include "tdma/tdma.h"
+
+/* 网关最大批量帧长度: 头部 + 自身 + GATEWAY_MAX_NODES个位置帧 */
+#define GATEWAY_BATCH_MAX   (LORAFRAME_BATCH_HEADER_LEN + (GATEWAY_MAX_NODES + 1) * LORAFRAME_POSITION_LEN)
+
+/* 网关统计 */
+typedef struct
+{
+    uint32_t received;      // 收到的位置帧
+    uint32_t duplicates;    // 丢弃的重复帧
+    uint32_t invalid;       // 长度或类型不符的帧
+    uint32_t overflow;      // 节点表已满而丢弃的帧
+    uint32_t forwarded;     // 已批量上行的叶节点位置帧
+    uint32_t batches;       // 批量上行次数
+} GatewayStatsTypeDef;
+
+extern GatewayStatsTypeDef gatewayStats;
+
+void GATEWAY_Init(void);
+uint16_t GATEWAY_BuildBatch(uint8_t *buffer, const LoraPositionTypeDef *self);
+void GATEWAY_Listen(uint32_t seconds);
+
+#endif
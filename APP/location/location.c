@@ -4,8 +4,13 @@
  *
  * 本文件负责从 AT6558R 模块获取 GPS 数据、从 DS3553 获取步数，并将
  * 解析后的位置信息与步数打包为 JSON 字符串，通过 QS100 模块发送。
+ * 叶节点(NODE_ROLE_LEAF)改为把位置帧经 LoRa 发给网关，不使用 QS100；
+ * 网关(NODE_ROLE_GATEWAY)把自身位置帧与收集到的叶节点位置帧批量经 QS100 发送；
+ * LoRaWAN 节点(NODE_ROLE_LORAWAN)把位置帧作为 LoRaWAN 上行发送，不使用 QS100。
  */
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_LOCATION
+
 #include "location.h"
 
 /**
@@ -40,30 +45,29 @@ static uint8_t LOCATION_GetGPSData(void)
         if (AT6558R_VerifyIntegrityOfGPSData() == 1)
         {
             /* 获取到完整的GPS数据 */
-            DEBUG_Printf("Integrity GPS data received\r\n");
-            DEBUG_Printf("GPS Data:\r\n%s\r\n", rxBuffer);
+            DEBUG_Info("Integrity GPS data received\r\n");
             if (AT6558R_VerifyValidityOfGPSData() == 1)
             {
-                DEBUG_Printf("Valid GPS data received\r\n");
+                DEBUG_Info("Valid GPS data received\r\n");
                 return 1; // 获取到有效的GPS数据，跳出循环
             }
             else
             {
-                DEBUG_Printf("Invalid GPS data\r\n");
-                DEBUG_Printf("Try Again Of %d...\r\n", i);
+                DEBUG_Warn("Invalid GPS data:\r\n%s\r\n", rxBuffer); // 只在无效时输出原始数据
+                DEBUG_Info("Try Again Of %d...\r\n", i);
                 HAL_Delay(1000); // 延时1秒后重试
                 i++;
             }
         }
         else
         {
-            DEBUG_Printf("Don't have Integrity GPS data\r\n");
-            DEBUG_Printf("Try Again Of %d...\r\n", i);
+            DEBUG_Warn("Don't have Integrity GPS data\r\n");
+            DEBUG_Info("Try Again Of %d...\r\n", i);
             HAL_Delay(1000); // 延时1秒后重试
             i++;
         }
     }
-    DEBUG_Printf("Failed to get valid GPS data after 10 attempts\r\n");
+    DEBUG_Error("Failed to get valid GPS data after 10 attempts\r\n");
     return 0; /* 获取完整且有效的GPS数据失败 */
 }
 
@@ -71,34 +75,109 @@ static uint8_t LOCATION_GetGPSData(void)
 /**
  * @brief 读取并更新步数数据
  *
- * 本函数负责初始化步数传感器 DS3553，并读取当前步数计数，存入
+ * 本函数负责打开步数传感器 DS3553 会话(整机上电后才配置芯片)，并读取当前步数计数，存入
  * 全局变量 locationData.steps 中，同时打印当前步数以便调试。
  *
  * 无返回值，若传感器初始化或读取失败，应由底层函数通过调试信息提示。
  */
 static void LOCATION_GetStepData(void)
 {
-    DS3553_Init();
+    DS3553_Open();
     locationData.steps = DS3553_GetStepCount();
-    DEBUG_Printf("Current Step Count: %lu\r\n", locationData.steps);
+    DEBUG_Info("Current Step Count: %lu\r\n", locationData.steps);
+}
+
+
+/**
+ * @brief 用 GNSS 时间为 RTC 授时
+ *
+ * AT6558R_ExtractGNRMCData() 已将时间换算为东八区本地时间，这里换算回
+ * UTC 的 Unix 时间戳后交给 RTC_SyncWithGNSS() 授时并校准 LSI。
+ */
+static void LOCATION_SyncTime(void)
+{
+    RTC_DateTypeDef date = {0};
+    RTC_TimeTypeDef time = {0};
+
+    date.Year = locationData.calendar.year;
+    date.Month = locationData.calendar.month;
+    date.Date = locationData.calendar.day;
+    time.Hours = locationData.time.hour;
+    time.Minutes = locationData.time.minute;
+    time.Seconds = locationData.time.second;
+
+    RTC_SyncWithGNSS(RTC_DateTimeToEpoch(&date, &time) - TIMEZONE_OFFSET);
+}
+
+
+/**
+ * @brief 从 RTC 读取本地时间
+ *
+ * 无 GNSS 定位时使用，RTC 计数器为 UTC 的 Unix 时间戳。
+ *
+ * @return uint8_t 1 表示 RTC 已授时、时间有效；0 表示尚未授时
+ */
+static uint8_t LOCATION_GetTimeFromRTC(void)
+{
+    RTC_DateTypeDef date = {0};
+    RTC_TimeTypeDef time = {0};
+
+    if (RTC_IsTimeValid() == 0)
+    {
+        return 0;
+    }
+
+    RTC_EpochToDateTime(RTC_GetCounter() + TIMEZONE_OFFSET, &date, &time);
+    locationData.calendar.year = date.Year;
+    locationData.calendar.month = date.Month;
+    locationData.calendar.day = date.Date;
+    locationData.time.hour = time.Hours;
+    locationData.time.minute = time.Minutes;
+    locationData.time.second = time.Seconds;
+    return 1;
 }
 
 
+/**
+ * @brief 更新本周期的时间与坐标
+ *
+ * 有定位时调用 AT6558R_ExtractGNRMCData() 更新全局的 locationData（时间、坐标等）
+ * 并为 RTC 授时；无定位时从 RTC 读取时间。
+ *
+ * @param hasFix 1 表示已获取到有效的 GPS 数据
+ * @return uint8_t 1 表示时间有效；0 表示无定位且 RTC 尚未授时
+ */
+static uint8_t LOCATION_UpdateData(uint8_t hasFix)
+{
+    if (hasFix)
+    {
+        AT6558R_ExtractGNRMCData();
+        LOCATION_SyncTime();
+        return 1;
+    }
+    return LOCATION_GetTimeFromRTC();
+}
+
+
+#if NODE_ROLE == NODE_ROLE_STANDALONE
 /**
  * @brief 处理并打包位置与步数信息为 JSON
  *
- * 先调用 AT6558R_ExtractGNRMCData() 更新全局的 locationData（时间、坐标等）
+ * 先调用 LOCATION_UpdateData() 更新时间与坐标，无定位时不输出坐标字段。
  * 然后使用 cJSON 构造一个包含 ID、datetime、latitude、lat_dir、longitude、
- * lon_dir、steps 的 JSON 对象，将其序列化为紧凑字符串并复制到
- * locationData.json_data 中。
+ * lon_dir、speed、steps 的 JSON 对象，将其序列化为紧凑字符串并复制到
+ * locationData.json_data 中。RTC 尚未授时且无定位时省略 datetime。
  *
- * 注意：cJSON_PrintUnformatted 返回分配的字符串，函数内部调用 cJSON_free
- * 释放该内存。复制时应确保 destination 有足够空间以避免溢出（调用者
- * 需在设计时保证）。
+ * 注意：cJSON 的节点和字符串分配自固定块内存池(Memory/memory.c)，序列化用
+ * cJSON_PrintPreallocated 直接写入 json_data，不再分配整段输出缓冲区；
+ * 内存池不足或超出 json_data 大小时输出空字符串。
+ *
+ * @param hasFix 1 表示已获取到有效的 GPS 数据
+ * @return uint8_t 1 表示时间有效；0 表示无定位且 RTC 尚未授时
  */
-static void LOCATION_ProcessData(void)
+static uint8_t LOCATION_ProcessData(uint8_t hasFix)
 {
-    AT6558R_ExtractGNRMCData();
+    uint8_t hasTime = LOCATION_UpdateData(hasFix);
 
     cJSON *root = cJSON_CreateObject();
 
@@ -106,67 +185,205 @@ static void LOCATION_ProcessData(void)
     cJSON_AddStringToObject(root, "ID", (char *)locationData.ID);
 
     /* 日期时间字符串 */
-    char datetime_str[20];
-    sprintf(datetime_str, "%d-%d-%d %02d:%02d:%02d",
-            locationData.calendar.year + 2000, locationData.calendar.month, locationData.calendar.day,
-            locationData.time.hour, locationData.time.minute, locationData.time.second);
-    cJSON_AddStringToObject(root, "datetime", datetime_str);
+    if (hasTime)
+    {
+        char datetime_str[20];
+        sprintf(datetime_str, "%d-%d-%d %02d:%02d:%02d",
+                locationData.calendar.year + 2000, locationData.calendar.month, locationData.calendar.day,
+                locationData.time.hour, locationData.time.minute, locationData.time.second);
+        cJSON_AddStringToObject(root, "datetime", datetime_str);
+    }
 
     /* 坐标 */
-    cJSON_AddNumberToObject(root, "latitude",  locationData.latitude);
-    cJSON_AddStringToObject(root, "lat_dir",   (locationData.latitude_direction==0) ? "N" : "S");
-    cJSON_AddNumberToObject(root, "longitude", locationData.longitude);
-    cJSON_AddStringToObject(root, "lon_dir",   (locationData.longitude_direction==0) ? "E" : "W");
+    if (hasFix)
+    {
+        cJSON_AddNumberToObject(root, "latitude",  locationData.latitude);
+        cJSON_AddStringToObject(root, "lat_dir",   (locationData.latitude_direction==0) ? "N" : "S");
+        cJSON_AddNumberToObject(root, "longitude", locationData.longitude);
+        cJSON_AddStringToObject(root, "lon_dir",   (locationData.longitude_direction==0) ? "E" : "W");
+        cJSON_AddNumberToObject(root, "speed",     locationData.speed);
+    }
 
     /* 步数 */
     cJSON_AddNumberToObject(root, "steps", locationData.steps);
 
-    /* 输出成字符串（需要 free 掉） */
-    char *json_str = cJSON_PrintUnformatted(root);
-
-    DEBUG_Printf("JSON String:\r\n%s\r\n", json_str);
-    memcpy(locationData.json_data, (uint8_t *)json_str, strlen(json_str));
+    /* 各阶段耗时(可选) */
+    PROFILE_AddToJSON(root);
 
-    /* 确保字符串以'\0'结尾 */
-    locationData.json_data[strlen(json_str)] = '\0';
+    /* 紧凑格式直接输出到 json_data */
+    if (root == NULL ||
+        !cJSON_PrintPreallocated(root, (char *)locationData.json_data, sizeof(locationData.json_data), 0))
+    {
+        locationData.json_data[0] = '\0';
+        DEBUG_Error("JSON print failed, pool failures %u\r\n", memoryStats.poolFailures);
+    }
 
-    DEBUG_Printf("JSON Data:\r\n%s\r\n", locationData.json_data);
+    DEBUG_Trace("JSON Data:\r\n%s\r\n", locationData.json_data);
 
     cJSON_Delete(root);
-    cJSON_free(json_str);
+    return hasTime;
 }
 
+#ifdef TRANSPORT_ENABLE
+/**
+ * @brief 由链路选择模块发送本周期上报
+ *
+ * 同时准备 JSON(NB-IoT) 和位置帧(LoRa，经附近网关转发)，由 TRANSPORT_Send() 按期望能耗选择链路，
+ * 截止时间取当前上报间隔。
+ *
+ * @param hasFix 1 表示已获取到有效的 GPS 数据
+ * @param hasTime 1 表示时间有效
+ */
+static void LOCATION_SendReport(uint8_t hasFix, uint8_t hasTime)
+{
+    static uint8_t frame[LORAFRAME_POSITION_LEN];
+    LoraPositionTypeDef position;
 
+    LORAFRAME_FromLocation(&position, &locationData, hasFix, hasTime);
+    if (TRANSPORT_Send(frame, LORAFRAME_EncodePosition(&position, frame), locationData.json_data,
+                       strlen((char *)locationData.json_data), policyState.interval * 1000) == TRANSPORT_LINK_NUM)
+    {
+        DEBUG_Error("Report send failed on all links\r\n");
+    }
+}
+#endif
+#else
 /**
- * @brief 初始化外设并发送位置信息
+ * @brief 生成本机位置帧并发送
+ *
+ * 叶节点：热启动 LLCC68 后经 LoRa 发送位置帧并等待网关应答(使能 TDMA 时在本节点时隙内发送，不等待应答)，完成后芯片回到热启动睡眠；
+ * 网关：把自身位置帧与待上行的叶节点位置帧拼成批量帧，经 QS100 发送一次；
+ * LoRaWAN 节点：位置帧经 LORAWAN_Send() 以非确认上行发送，未入网时先入网。
  *
- * @param seconds 进入低功耗模式前的延迟（秒），调用 LOWPOWER_EnterLowPower(seconds)
+ * @param hasFix 1 表示已获取到有效的 GPS 数据
+ */
+static void LOCATION_SendFrame(uint8_t hasFix)
+{
+    static uint8_t frame[GATEWAY_BATCH_MAX];
+    LoraPositionTypeDef position;
+
+    PROFILE_Begin(PROFILE_PHASE_JSON);
+    LORAFRAME_FromLocation(&position, &locationData, hasFix, LOCATION_UpdateData(hasFix));
+    PROFILE_End(PROFILE_PHASE_JSON);
+
+#if NODE_ROLE == NODE_ROLE_LEAF
+    PROFILE_Begin(PROFILE_PHASE_SEND);
+#ifdef TDMA_ENABLE
+    if (TDMA_Send(frame, LORAFRAME_EncodePosition(&position, frame)) != 0)
+    {
+        DEBUG_Error("LoRa send failed\r\n");
+    }
+#else
+    LORA_Init();
+    if (LORALINK_Send(frame, LORAFRAME_EncodePosition(&position, frame)) != 0)
+    {
+        DEBUG_Warn("LoRa send not acked\r\n");
+    }
+    LORA_Sleep();
+#endif
+    PROFILE_End(PROFILE_PHASE_SEND);
+#elif NODE_ROLE == NODE_ROLE_LORAWAN
+    PROFILE_Begin(PROFILE_PHASE_SEND);
+    if (LORAWAN_Send(LORAWAN_FPORT, frame, LORAFRAME_EncodePosition(&position, frame), 0) != 0)
+    {
+        DEBUG_Error("LoRaWAN send failed\r\n");
+    }
+    PROFILE_End(PROFILE_PHASE_SEND);
+#else
+    QS100_SendData(frame, GATEWAY_BuildBatch(frame, &position));
+    LORALINK_Report();
+#endif
+}
+#endif
+
+
+/**
+ * @brief 初始化外设并发送位置信息
  *
  * 函数流程：
- *  - 初始化 AT6558R（GPS）与 QS100（通信）模块
+ *  - 切换到 8MHz：本周期大部分时间在等待串口和 GNSS，仅打包 JSON 时切回 72MHz
+ *  - 先读取步数，由 POLICY_Gate 做运动门控：
+ *    - 静止且无运动：跳过本周期，不唤醒任何模块，仅耗时数毫秒
+ *    - 心跳周期：只唤醒 QS100，发送不含坐标的数据
+ *  - 初始化 AT6558R（GPS，输出频率由上报策略选择）与 QS100（通信）模块
  *  - 从低功耗模式唤醒
  *  - 尝试获取并验证 GPS 数据（调用 LOCATION_GetGPSData）
- *    - 若成功：获取步数、处理数据为 JSON 并通过 QS100_SendData 发送
- *    - 若失败：发送错误信息字符串
- *  - 最后调用 LOWPOWER_EnterLowPower(seconds) 返回低功耗状态
+ *  - 处理数据为 JSON 并通过 QS100_SendData 发送；使能 TRANSPORT_ENABLE 时由 TRANSPORT_Send 在 LoRa 和 NB-IoT 之间选择
+ *    - 若定位失败：JSON 不含坐标，时间取自 RTC
+ *  - 叶节点和 LoRaWAN 节点不初始化 QS100，位置帧经 LoRa 发送；网关位置帧与叶节点位置帧批量经 QS100 发送
+ *  - 输出本周期各频率运行时间和分阶段性能统计
+ *
+ * 进入低功耗模式由调用者按上报策略选择的间隔完成。
+ *
+ * @return uint8_t 1 表示本周期获取到有效定位；0 表示定位失败
  */
-void LOCATION_SendLocationData(uint32_t seconds)
+uint8_t LOCATION_SendLocationData(void)
 {
-    AT6558R_Init();
-    QS100_Init();
+    uint8_t hasFix = 0;
 
-    LOWPOWER_Wakeup(); // 从低功耗模式唤醒
+    CLOCK_SetMode(CLOCK_MODE_SLOW);
 
-    if(LOCATION_GetGPSData())
+    PROFILE_Begin(PROFILE_PHASE_STEP);
+    LOCATION_GetStepData();
+    PROFILE_End(PROFILE_PHASE_STEP);
+
+    PolicyActionTypeDef action = POLICY_Gate();
+    if (action == POLICY_ACTION_SKIP)
+    {
+        DEBUG_Info("No motion, skip this report\r\n");
+        PROFILE_Report();
+        return 0;
+    }
+
+#if NODE_ROLE == NODE_ROLE_LEAF && defined(TDMA_ENABLE)
+    TDMA_Prepare(); // 定位期间在后台接收信标
+#endif
+
+    PROFILE_Begin(PROFILE_PHASE_WAKE);
+    if (action == POLICY_ACTION_REPORT)
     {
-        LOCATION_GetStepData();
-        LOCATION_ProcessData();
-        QS100_SendData(locationData.json_data, strlen((char *)locationData.json_data));
+        AT6558R_Init(POLICY_GetGnssFrequency());
+#if LOCATION_USE_QS100
+        QS100_Init();
+        LOWPOWER_Wakeup(); // 从低功耗模式唤醒
+#else
+        LOWPOWER_WakeupModules(LOWPOWER_MODULE_AT6558R); // 叶节点和LoRaWAN节点不使用NB-IoT
+#endif
     }
     else
     {
-        QS100_SendData("No valid GPS data available", strlen("No valid GPS data available"));
+        DEBUG_Info("No motion, send heartbeat\r\n");
+#if LOCATION_USE_QS100
+        QS100_Init();
+        LOWPOWER_WakeupModules(LOWPOWER_MODULE_QS100); // 心跳不需要GNSS
+#endif
     }
+    PROFILE_End(PROFILE_PHASE_WAKE);
+
+    if (action == POLICY_ACTION_REPORT)
+    {
+        PROFILE_Begin(PROFILE_PHASE_GNSS);
+        hasFix = LOCATION_GetGPSData();
+        PROFILE_End(PROFILE_PHASE_GNSS);
+    }
+
+#if NODE_ROLE == NODE_ROLE_STANDALONE
+    PROFILE_Begin(PROFILE_PHASE_JSON);
+    CLOCK_SetMode(CLOCK_MODE_FAST);
+    uint8_t hasTime = LOCATION_ProcessData(hasFix);
+    CLOCK_SetMode(CLOCK_MODE_SLOW);
+    PROFILE_End(PROFILE_PHASE_JSON);
+#ifdef TRANSPORT_ENABLE
+    LOCATION_SendReport(hasFix, hasTime);
+#else
+    (void)hasTime;
+    QS100_SendData(locationData.json_data, strlen((char *)locationData.json_data));
+#endif
+#else
+    LOCATION_SendFrame(hasFix);
+#endif
 
-    LOWPOWER_EnterLowPower(seconds); // 进入低功耗模式，20秒后唤醒
+    CLOCK_Report();
+    PROFILE_Report();
+    return hasFix;
 }
\ No newline at end of file
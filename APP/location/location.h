@@ -9,9 +9,23 @@
 #include "qs100/qs100.h"
 #include "Debug/debug.h"
 #include "cJSON/cJSON.h"
+#include "policy/policy.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+#include "gateway/gateway.h"
+#include "tdma/tdma.h"
+#include "lorawan/lorawan.h"
+#include "transport/transport.h"
+
+/* 唤醒时即初始化QS100的角色; 使能链路选择时由transport模块在选用NB-IoT时再唤醒 */
+#if NODE_ROLE == NODE_ROLE_GATEWAY || (NODE_ROLE == NODE_ROLE_STANDALONE && !defined(TRANSPORT_ENABLE))
+#define LOCATION_USE_QS100  1
+#else
+#define LOCATION_USE_QS100  0
+#endif
 
 extern LocationDataTypeDef locationData;
 
-void LOCATION_SendLocationData(uint32_t seconds);
+uint8_t LOCATION_SendLocationData(void);
 
 #endif
@@ -0,0 +1,335 @@
+/**
+ * @file loraFrag.c
+ * @brief LoRa分片传输: 超过一帧的消息分片发送, 接收方选择性应答, 发送方只重发缺失的分片
+ *
+ * 发送方(叶节点)把消息切成 LORAFRAG_FRAGMENT_SIZE 字节的分片逐个发送，每轮最后一个分片
+ * 带 LORAFRAG_FLAG_ACK_REQ，发完后单次接收等待SACK。SACK携带已收到分片的位图，下一轮只发送
+ * 位图中缺失的分片；丢失SACK时下一轮重发全部未确认的分片。消息ID保存在备份寄存器中，
+ * STANDBY唤醒后继续递增。
+ * 接收方(网关)有 LORAFRAG_RX_SLOTS 个重组缓冲区，按节点ID分配：同一节点开始新消息时放弃旧消息，
+ * 超过 LORAFRAG_RX_TIMEOUT_S 没有新分片的缓冲区可被其他节点占用，缓冲区均被占用时丢弃分片，
+ * 由发送方下一轮重发。收到请求应答的分片只记录待回复的缓冲区，由主循环调用 LORAFRAG_Poll()
+ * 发送SACK，避免在接收回调中阻塞发送。
+ * Tools/host/lorafrag_test.c 在PC上经有损的虚拟信道检查选择性重发和重组。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "loraFrag/loraFrag.h"
+
+/* 接收方重组缓冲区 */
+typedef struct
+{
+    uint32_t nodeId;                        // 发送方节点ID
+    uint32_t received;                      // 已收到分片的位图
+    uint32_t updated;                       // 最近收到分片的RTC时间(秒)
+    uint16_t msgId;                         // 消息ID
+    uint16_t length;                        // 消息总长度
+    uint8_t count;                          // 分片总数
+    uint8_t used;                           // 1 表示缓冲区已分配
+    uint8_t complete;                       // 1 表示已重组完成
+    uint8_t data[LORAFRAG_MESSAGE_MAX];     // 消息数据
+} LoraFragSlotTypeDef;
+
+LoraFragStatsTypeDef loraFragStats = {0};
+
+static LoraFragSlotTypeDef loraFragSlots[LORAFRAG_RX_SLOTS];
+static LoraFragSlotTypeDef *loraFragAckSlot = NULL;    // 待回复SACK的缓冲区
+
+static volatile uint8_t loraFragWaiting = 0;            // 1 表示正在等待SACK
+static uint32_t loraFragAcked = 0;                      // 发送方: 已确认分片的位图
+static uint16_t loraFragMsgId = 0;                      // 发送方: 当前消息ID
+
+/**
+ * @brief 分片数对应的完整位图
+ */
+static uint32_t LORAFRAG_AllMask(uint8_t count)
+{
+    return (count >= LORAFRAG_MAX_FRAGMENTS) ? 0xFFFFFFFFU : ((1UL << count) - 1);
+}
+
+/**
+ * @brief SACK接收回调: 校验节点ID和消息ID后合并位图
+ */
+static void LORAFRAG_OnSack(uint8_t *buffer, uint16_t length)
+{
+    loraFragWaiting = 0;
+    if (buffer == NULL || length != LORAFRAG_SACK_LEN || buffer[0] != LORAFRAG_TYPE_SACK)
+    {
+        return;
+    }
+    if (LORAFRAME_Get(buffer + 1, 4) != LORAFRAME_GetNodeId() || LORAFRAME_Get(buffer + 5, 2) != loraFragMsgId)
+    {
+        return;
+    }
+    loraFragAcked |= LORAFRAME_Get(buffer + 7, 4);
+}
+
+/**
+ * @brief 等待SACK接收结束(收到数据包或超时)
+ */
+static void LORAFRAG_WaitSack(void)
+{
+    while (loraFragWaiting)
+    {
+        LORA_Process();
+        if (loraFragWaiting && LORA_GetState() != LORA_STATE_RX)
+        {
+            loraFragWaiting = 0;
+        }
+        if (loraFragWaiting)
+        {
+            __WFI();
+        }
+    }
+}
+
+/**
+ * @brief 分片发送一条消息, 直到全部分片被确认或轮数用尽
+ * @details 调用前需已调用LORA_Init(), 发送期间MCU在空中传输和等待SACK时以WFI休眠
+ * @param data 消息数据
+ * @param length 消息长度, 不超过LORAFRAG_MESSAGE_MAX
+ * @return uint8_t 0 表示全部分片已确认；1 表示参数错误或轮数用尽；2 表示超出占空比额度
+ */
+uint8_t LORAFRAG_Send(const uint8_t *data, uint16_t length)
+{
+    uint8_t frame[LORAFRAG_HEADER_LEN + LORAFRAG_FRAGMENT_SIZE];
+    uint32_t all;
+    uint16_t offset;
+    uint8_t count;
+    uint8_t size;
+    uint8_t last;
+    uint8_t round;
+    uint8_t result;
+    uint8_t i;
+
+    if (length == 0 || length > LORAFRAG_MESSAGE_MAX)
+    {
+        return 1;
+    }
+
+    count = (uint8_t)((length + LORAFRAG_FRAGMENT_SIZE - 1) / LORAFRAG_FRAGMENT_SIZE);
+    all = LORAFRAG_AllMask(count);
+    loraFragMsgId = PWR_ReadBackup(PWR_BKP_LORA_FRAG_ID) + 1;
+    PWR_WriteBackup(PWR_BKP_LORA_FRAG_ID, loraFragMsgId);
+    loraFragAcked = 0;
+    loraFragStats.messages++;
+
+    frame[0] = LORAFRAG_TYPE_FRAGMENT;
+    LORAFRAME_Put(frame + 1, LORAFRAME_GetNodeId(), 4);
+    LORAFRAME_Put(frame + 5, loraFragMsgId, 2);
+    frame[8] = count;
+    LORAFRAME_Put(frame + 9, length, 2);
+
+    for (round = 0; round < LORAFRAG_MAX_ROUNDS; round++)
+    {
+        /* 本轮最后一个未确认的分片请求应答 */
+        last = count - 1;
+        while (loraFragAcked & (1UL << last))
+        {
+            last--;
+        }
+
+        for (i = 0; i <= last; i++)
+        {
+            if (loraFragAcked & (1UL << i))
+            {
+                continue;
+            }
+            offset = (uint16_t)i * LORAFRAG_FRAGMENT_SIZE;
+            size = (length - offset < LORAFRAG_FRAGMENT_SIZE) ? (uint8_t)(length - offset) : LORAFRAG_FRAGMENT_SIZE;
+            frame[7] = i | ((i == last) ? LORAFRAG_FLAG_ACK_REQ : 0);
+            memcpy(frame + LORAFRAG_HEADER_LEN, data + offset, size);
+
+            result = LORA_SendData(frame, LORAFRAG_HEADER_LEN + size);
+            if (result == 2)
+            {
+                return 2;
+            }
+            if (result == 0)
+            {
+                loraFragStats.fragments++;
+                if (round > 0)
+                {
+                    loraFragStats.resent++;
+                }
+            }
+        }
+
+        if (LORA_ReceiveAsync(LORAFRAG_ACK_TIMEOUT_MS, LORAFRAG_OnSack) == 0)
+        {
+            loraFragWaiting = 1;
+            LORAFRAG_WaitSack();
+        }
+        loraFragAcked &= all;
+        if (loraFragAcked == all)
+        {
+            return 0;
+        }
+        DEBUG_Trace("LoRa frag msg %u round %u acked %08lX\r\n", loraFragMsgId, round, loraFragAcked);
+    }
+
+    loraFragStats.failed++;
+    return 1;
+}
+
+/**
+ * @brief 查找节点的重组缓冲区, 不存在时分配空闲、已完成或超时的缓冲区
+ * @return LoraFragSlotTypeDef* 缓冲区, 均被占用时返回NULL
+ */
+static LoraFragSlotTypeDef *LORAFRAG_FindSlot(uint32_t nodeId, uint32_t now)
+{
+    LoraFragSlotTypeDef *spare = NULL;
+    uint8_t i;
+
+    for (i = 0; i < LORAFRAG_RX_SLOTS; i++)
+    {
+        LoraFragSlotTypeDef *slot = &loraFragSlots[i];
+
+        if (slot->used && slot->nodeId == nodeId)
+        {
+            return slot;
+        }
+        if (spare == NULL && (!slot->used || slot->complete || now - slot->updated > LORAFRAG_RX_TIMEOUT_S))
+        {
+            spare = slot;
+        }
+    }
+    if (spare != NULL)
+    {
+        if (spare->used && !spare->complete)
+        {
+            loraFragStats.evicted++;
+        }
+        spare->used = 0;
+    }
+    return spare;
+}
+
+/**
+ * @brief 接收方处理一个数据包, 是分片时写入重组缓冲区
+ * @details 全部分片到齐时调用callback; 分片带LORAFRAG_FLAG_ACK_REQ时记录待回复SACK,
+ *          已完成的消息再次收到分片时只回复SACK, 不重复调用callback
+ * @param buffer 接收到的数据
+ * @param length 数据长度
+ * @param callback 重组完成回调
+ * @return uint8_t 0 表示是分片帧(已处理)；1 表示不是分片帧, 由调用方继续解码
+ */
+uint8_t LORAFRAG_OnReceive(const uint8_t *buffer, uint16_t length, LORAFRAG_MessageCallbackTypeDef callback)
+{
+    LoraFragSlotTypeDef *slot;
+    uint32_t nodeId;
+    uint32_t now;
+    uint16_t msgId;
+    uint16_t total;
+    uint16_t offset;
+    uint16_t size;
+    uint8_t index;
+    uint8_t count;
+
+    if (buffer == NULL || length <= LORAFRAG_HEADER_LEN || buffer[0] != LORAFRAG_TYPE_FRAGMENT)
+    {
+        return 1;
+    }
+
+    nodeId = LORAFRAME_Get(buffer + 1, 4);
+    msgId = (uint16_t)LORAFRAME_Get(buffer + 5, 2);
+    index = buffer[7] & LORAFRAG_INDEX_MASK;
+    count = buffer[8];
+    total = (uint16_t)LORAFRAME_Get(buffer + 9, 2);
+    size = length - LORAFRAG_HEADER_LEN;
+
+    /* 除最后一个分片外长度相同, 由此计算偏移 */
+    if (count == 0 || count > LORAFRAG_MAX_FRAGMENTS || index >= count || total > LORAFRAG_MESSAGE_MAX || size > total)
+    {
+        return 0;
+    }
+    offset = (index == count - 1) ? (total - size) : (uint16_t)(index * size);
+    if (offset + size > total)
+    {
+        return 0;
+    }
+
+    now = RTC_GetCounter();
+    slot = LORAFRAG_FindSlot(nodeId, now);
+    if (slot == NULL)
+    {
+        loraFragStats.overflow++;
+        return 0;
+    }
+
+    /* 同一节点开始新消息时放弃未完成的旧消息 */
+    if (slot->used && (slot->msgId != msgId || slot->count != count || slot->length != total))
+    {
+        if (!slot->complete)
+        {
+            loraFragStats.evicted++;
+        }
+        slot->used = 0;
+    }
+    if (!slot->used)
+    {
+        slot->nodeId = nodeId;
+        slot->msgId = msgId;
+        slot->count = count;
+        slot->length = total;
+        slot->received = 0;
+        slot->complete = 0;
+        slot->used = 1;
+    }
+
+    slot->updated = now;
+    if (!slot->complete)
+    {
+        memcpy(slot->data + offset, buffer + LORAFRAG_HEADER_LEN, size);
+        slot->received |= 1UL << index;
+        if (slot->received == LORAFRAG_AllMask(count))
+        {
+            slot->complete = 1;
+            loraFragStats.completed++;
+            DEBUG_Info("LoRa frag node %08lX msg %u complete, %u bytes\r\n", nodeId, msgId, total);
+            if (callback != NULL)
+            {
+                callback(nodeId, slot->data, total);
+            }
+        }
+    }
+
+    if (buffer[7] & LORAFRAG_FLAG_ACK_REQ)
+    {
+        loraFragAckSlot = slot;
+    }
+    return 0;
+}
+
+/**
+ * @brief 接收方发送待回复的SACK
+ * @details 在LORA_Process()之后调用; 发送后芯片回到不带回调的接收模式, 调用方需重新启动接收
+ * @return uint8_t 1 表示已发送SACK；0 表示没有待回复的SACK
+ */
+uint8_t LORAFRAG_Poll(void)
+{
+    uint8_t frame[LORAFRAG_SACK_LEN];
+    LoraFragSlotTypeDef *slot = loraFragAckSlot;
+
+    if (slot == NULL)
+    {
+        return 0;
+    }
+    loraFragAckSlot = NULL;
+
+    frame[0] = LORAFRAG_TYPE_SACK;
+    LORAFRAME_Put(frame + 1, slot->nodeId, 4);
+    LORAFRAME_Put(frame + 5, slot->msgId, 2);
+    LORAFRAME_Put(frame + 7, slot->received, 4);
+
+    /* 与链路层应答相同, SACK不做先听后发, 否则CAD退避可能超过发送方的等待时间 */
+    HAL_Delay(LORAFRAG_TURNAROUND_MS);
+    LORA_SetLbt(0);
+    if (LORA_SendData(frame, LORAFRAG_SACK_LEN) != 0)
+    {
+        DEBUG_Warn("LoRa frag SACK send failed\r\n");
+    }
+    LORA_SetLbt(1);
+    return 1;
+}
@@ -0,0 +1,65 @@
+#ifndef __LORAFRAG_H__
+#define __LORAFRAG_H__
+
+#include "string.h"
+#include "user_config.h"
+#include "debug/debug.h"
+#include "rtc/rtc.h"
+#include "PWR/pwr.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+
+/*
+ * 帧格式(多字节字段均为小端):
+ *  分片帧 LORAFRAG_TYPE_FRAGMENT, 共LORAFRAG_HEADER_LEN字节头部加分片数据
+ *    [0]     类型
+ *    [1..4]  发送方节点ID
+ *    [5..6]  消息ID, 每条消息加1
+ *    [7]     低5位为分片序号, LORAFRAG_FLAG_ACK_REQ 表示本轮最后一个分片, 接收方需回复SACK
+ *    [8]     分片总数
+ *    [9..10] 消息总长度
+ *    [11..]  分片数据, 除最后一个分片外长度相同
+ *  SACK帧 LORAFRAG_TYPE_SACK, 共LORAFRAG_SACK_LEN字节
+ *    [0]     类型
+ *    [1..4]  分片发送方节点ID
+ *    [5..6]  消息ID
+ *    [7..10] 已收到分片的位图, 第i位对应分片i
+ */
+#define LORAFRAG_TYPE_FRAGMENT  0x46
+#define LORAFRAG_TYPE_SACK      0x41
+#define LORAFRAG_HEADER_LEN     11
+#define LORAFRAG_SACK_LEN       11
+#define LORAFRAG_FLAG_ACK_REQ   0x80
+#define LORAFRAG_INDEX_MASK     0x1F
+#define LORAFRAG_MAX_FRAGMENTS  32      /* 受SACK位图宽度限制 */
+#define LORAFRAG_TURNAROUND_MS  10      /* 网关收到请求应答的分片后延时回复, 等待发送方切换到接收 */
+
+#if LORAFRAG_HEADER_LEN + LORAFRAG_FRAGMENT_SIZE > LLCC68_LORA_DEFAULT_BUFFER_SIZE
+#error "LORAFRAG_FRAGMENT_SIZE exceeds one LoRa frame"
+#endif
+#if LORAFRAG_MESSAGE_MAX > LORAFRAG_MAX_FRAGMENTS * LORAFRAG_FRAGMENT_SIZE
+#error "LORAFRAG_MESSAGE_MAX needs more than LORAFRAG_MAX_FRAGMENTS fragments"
+#endif
+
+/* 分片传输统计 */
+typedef struct
+{
+    uint32_t messages;      // 发送方: 发送的消息数
+    uint32_t fragments;     // 发送方: 发出的分片数(含重发)
+    uint32_t resent;        // 发送方: 重发的分片数
+    uint32_t failed;        // 发送方: 轮数用尽仍未全部确认的消息数
+    uint32_t completed;     // 接收方: 重组完成的消息数
+    uint32_t evicted;       // 接收方: 未完成即被新消息占用缓冲区的消息数
+    uint32_t overflow;      // 接收方: 重组缓冲区均被占用而丢弃的分片数
+} LoraFragStatsTypeDef;
+
+extern LoraFragStatsTypeDef loraFragStats;
+
+/* 接收方重组完成回调 */
+typedef void (*LORAFRAG_MessageCallbackTypeDef)(uint32_t nodeId, const uint8_t *data, uint16_t length);
+
+uint8_t LORAFRAG_Send(const uint8_t *data, uint16_t length);
+uint8_t LORAFRAG_OnReceive(const uint8_t *buffer, uint16_t length, LORAFRAG_MessageCallbackTypeDef callback);
+uint8_t LORAFRAG_Poll(void);
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file loraFrame.c
+ * @brief LoRa位置帧的编解码
+ *
+ * 叶节点把定位结果压缩为定长26字节的位置帧经LoRa发给网关，网关把收到的位置帧
+ * 原样拼接成批量帧经NB-IoT上行。帧格式见 loraFrame.h。
+ * 节点ID由96位芯片UID经FNV-1a散列为32位；帧序号保存在备份寄存器中，
+ * STANDBY唤醒后继续递增，网关据(节点ID, 序号)去重。
+ */
+
+#include "loraFrame/loraFrame.h"
+
+/**
+ * @brief 按小端写入多字节字段
+ */
+void LORAFRAME_Put(uint8_t *buffer, uint32_t value, uint8_t size)
+{
+    uint8_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief 按小端读取多字节字段
+ */
+uint32_t LORAFRAME_Get(const uint8_t *buffer, uint8_t size)
+{
+    uint32_t value = 0;
+    uint8_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        value |= (uint32_t)buffer[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief 由芯片UID计算节点ID
+ * @return uint32_t 节点ID, FNV-1a(UID)
+ */
+uint32_t LORAFRAME_GetNodeId(void)
+{
+    uint32_t uid[3];
+    uint32_t hash = 2166136261U;
+    uint8_t i;
+
+    uid[0] = HAL_GetUIDw0();
+    uid[1] = HAL_GetUIDw1();
+    uid[2] = HAL_GetUIDw2();
+    for (i = 0; i < 12; i++)
+    {
+        hash ^= (uint8_t)(uid[i / 4] >> (8 * (i % 4)));
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @brief 由本机定位结果生成位置帧, 并分配下一个帧序号
+ * @param position 输出位置帧
+ * @param location 定位结果
+ * @param hasFix 1 表示坐标有效
+ * @param hasTime 1 表示时间有效(RTC已授时)
+ */
+void LORAFRAME_FromLocation(LoraPositionTypeDef *position, const LocationDataTypeDef *location, uint8_t hasFix, uint8_t hasTime)
+{
+    uint16_t seq = PWR_ReadBackup(PWR_BKP_LORA_FRAME_SEQ) + 1;
+
+    PWR_WriteBackup(PWR_BKP_LORA_FRAME_SEQ, seq);
+
+    memset(position, 0, sizeof(LoraPositionTypeDef));
+    position->nodeId = LORAFRAME_GetNodeId();
+    position->seq = seq;
+    position->steps = location->steps;
+    if (hasTime)
+    {
+        position->flags |= LORAFRAME_FLAG_TIME;
+        position->timestamp = RTC_GetCounter();
+    }
+    if (hasFix)
+    {
+        position->flags |= LORAFRAME_FLAG_FIX;
+        position->latitude = (int32_t)(location->latitude * 1000000.0f);
+        position->longitude = (int32_t)(location->longitude * 1000000.0f);
+        if (location->latitude_direction)
+        {
+            position->latitude = -position->latitude;
+        }
+        if (location->longitude_direction)
+        {
+            position->longitude = -position->longitude;
+        }
+        position->speed = (uint16_t)(location->speed * 10.0f);
+    }
+}
+
+/**
+ * @brief 编码位置帧
+ * @param position 位置帧
+ * @param buffer 输出缓冲区, 至少LORAFRAME_POSITION_LEN字节
+ * @return uint8_t 帧长度
+ */
+uint8_t LORAFRAME_EncodePosition(const LoraPositionTypeDef *position, uint8_t *buffer)
+{
+    buffer[0] = LORAFRAME_TYPE_POSITION;
+    LORAFRAME_Put(buffer + 1, position->nodeId, 4);
+    LORAFRAME_Put(buffer + 5, position->seq, 2);
+    buffer[7] = position->flags;
+    LORAFRAME_Put(buffer + 8, position->timestamp, 4);
+    LORAFRAME_Put(buffer + 12, (uint32_t)position->latitude, 4);
+    LORAFRAME_Put(buffer + 16, (uint32_t)position->longitude, 4);
+    LORAFRAME_Put(buffer + 20, position->speed, 2);
+    LORAFRAME_Put(buffer + 22, position->steps, 4);
+    return LORAFRAME_POSITION_LEN;
+}
+
+/**
+ * @brief 解码位置帧
+ * @param buffer 接收到的数据
+ * @param length 数据长度
+ * @param position 输出位置帧
+ * @return uint8_t 0 表示成功；1 表示长度或类型不符
+ */
+uint8_t LORAFRAME_DecodePosition(const uint8_t *buffer, uint16_t length, LoraPositionTypeDef *position)
+{
+    if (length != LORAFRAME_POSITION_LEN || buffer[0] != LORAFRAME_TYPE_POSITION)
+    {
+        return 1;
+    }
+
+    position->nodeId = LORAFRAME_Get(buffer + 1, 4);
+    position->seq = (uint16_t)LORAFRAME_Get(buffer + 5, 2);
+    position->flags = buffer[7];
+    position->timestamp = LORAFRAME_Get(buffer + 8, 4);
+    position->latitude = (int32_t)LORAFRAME_Get(buffer + 12, 4);
+    position->longitude = (int32_t)LORAFRAME_Get(buffer + 16, 4);
+    position->speed = (uint16_t)LORAFRAME_Get(buffer + 20, 2);
+    position->steps = LORAFRAME_Get(buffer + 22, 4);
+    return 0;
+}
+
+/**
+ * @brief 编码批量帧头部
+ * @param buffer 输出缓冲区, 其后紧跟count个位置帧
+ * @param gatewayId 网关节点ID
+ * @param count 位置帧个数
+ * @return uint16_t 头部长度
+ */
+uint16_t LORAFRAME_EncodeBatchHeader(uint8_t *buffer, uint32_t gatewayId, uint8_t count)
+{
+    buffer[0] = LORAFRAME_TYPE_BATCH;
+    LORAFRAME_Put(buffer + 1, gatewayId, 4);
+    buffer[5] = count;
+    return LORAFRAME_BATCH_HEADER_LEN;
+}
+
+/**
+ * @brief 编码信标帧
+ * @param beacon 信标
+ * @param buffer 输出缓冲区, 至少LORAFRAME_BEACON_LEN字节
+ * @return uint8_t 帧长度
+ */
+uint8_t LORAFRAME_EncodeBeacon(const LoraBeaconTypeDef *beacon, uint8_t *buffer)
+{
+    buffer[0] = LORAFRAME_TYPE_BEACON;
+    LORAFRAME_Put(buffer + 1, beacon->gatewayId, 4);
+    LORAFRAME_Put(buffer + 5, beacon->epoch, 4);
+    LORAFRAME_Put(buffer + 9, beacon->millis, 2);
+    LORAFRAME_Put(buffer + 11, beacon->frameS, 2);
+    LORAFRAME_Put(buffer + 13, beacon->slotMs, 2);
+    LORAFRAME_Put(buffer + 15, beacon->slotNum, 2);
+    return LORAFRAME_BEACON_LEN;
+}
+
+/**
+ * @brief 解码信标帧
+ * @param buffer 接收到的数据
+ * @param length 数据长度
+ * @param beacon 输出信标
+ * @return uint8_t 0 表示成功；1 表示长度、类型或参数不符
+ */
+uint8_t LORAFRAME_DecodeBeacon(const uint8_t *buffer, uint16_t length, LoraBeaconTypeDef *beacon)
+{
+    if (length != LORAFRAME_BEACON_LEN || buffer[0] != LORAFRAME_TYPE_BEACON)
+    {
+        return 1;
+    }
+
+    beacon->gatewayId = LORAFRAME_Get(buffer + 1, 4);
+    beacon->epoch = LORAFRAME_Get(buffer + 5, 4);
+    beacon->millis = (uint16_t)LORAFRAME_Get(buffer + 9, 2);
+    beacon->frameS = (uint16_t)LORAFRAME_Get(buffer + 11, 2);
+    beacon->slotMs = (uint16_t)LORAFRAME_Get(buffer + 13, 2);
+    beacon->slotNum = (uint16_t)LORAFRAME_Get(buffer + 15, 2);
+    if (beacon->frameS == 0 || beacon->slotMs == 0 || beacon->slotNum == 0 || beacon->millis >= 1000)
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef __LORAFRAME_H__
+#define __LORAFRAME_H__
+
+#include "string.h"
+#include "user_config.h"
+#include "rtc/rtc.h"
+#include "PWR/pwr.h"
+
+/*
+ * 帧格式(多字节字段均为小端):
+ *  位置帧 LORAFRAME_TYPE_POSITION, 共LORAFRAME_POSITION_LEN字节
+ *    [0]     类型
+ *    [1..4]  节点ID
+ *    [5..6]  序号, 每发送一帧加1
+ *    [7]     标志 LORAFRAME_FLAG_*
+ *    [8..11] UTC Unix时间戳, 无时间时为0
+ *    [12..15] 纬度(1e-6度, 南纬为负)
+ *    [16..19] 经度(1e-6度, 西经为负)
+ *    [20..21] 速度(0.1km/h)
+ *    [22..25] 步数
+ *  批量帧 LORAFRAME_TYPE_BATCH, 网关经NB-IoT上行
+ *    [0]     类型
+ *    [1..4]  网关节点ID
+ *    [5]     位置帧个数n
+ *    [6..]   n个完整的位置帧, 第一个为网关自身
+ *  信标帧 LORAFRAME_TYPE_BEACON, 共LORAFRAME_BEACON_LEN字节, 网关在每个TDMA超帧开始发送
+ *    [0]     类型
+ *    [1..4]  网关节点ID
+ *    [5..8]  开始发送时网关的UTC Unix时间戳
+ *    [9..10] 开始发送时的秒内毫秒
+ *    [11..12] 超帧周期(秒)
+ *    [13..14] 时隙长度(ms)
+ *    [15..16] 时隙数
+ */
+#define LORAFRAME_TYPE_POSITION     0x50
+#define LORAFRAME_TYPE_BATCH        0x42
+#define LORAFRAME_POSITION_LEN      26
+#define LORAFRAME_BATCH_HEADER_LEN  6
+#define LORAFRAME_TYPE_BEACON       0x54
+#define LORAFRAME_BEACON_LEN        17
+
+#define LORAFRAME_FLAG_FIX          0x01    // 含有效坐标
+#define LORAFRAME_FLAG_TIME         0x02    // 含有效时间
+
+typedef struct
+{
+    uint32_t nodeId;        // 节点ID, 由芯片UID计算
+    uint16_t seq;           // 帧序号
+    uint8_t flags;          // LORAFRAME_FLAG_*
+    uint32_t timestamp;     // UTC Unix时间戳
+    int32_t latitude;       // 纬度(1e-6度, 南纬为负)
+    int32_t longitude;      // 经度(1e-6度, 西经为负)
+    uint16_t speed;         // 速度(0.1km/h)
+    uint32_t steps;         // 步数
+} LoraPositionTypeDef;
+
+typedef struct
+{
+    uint32_t gatewayId;     // 网关节点ID
+    uint32_t epoch;         // 开始发送时的UTC Unix时间戳
+    uint16_t millis;        // 开始发送时的秒内毫秒
+    uint16_t frameS;        // 超帧周期(秒)
+    uint16_t slotMs;        // 时隙长度(ms)
+    uint16_t slotNum;       // 时隙数
+} LoraBeaconTypeDef;
+
+void LORAFRAME_Put(uint8_t *buffer, uint32_t value, uint8_t size);
+uint32_t LORAFRAME_Get(const uint8_t *buffer, uint8_t size);
+uint32_t LORAFRAME_GetNodeId(void);
+void LORAFRAME_FromLocation(LoraPositionTypeDef *position, const LocationDataTypeDef *location, uint8_t hasFix, uint8_t hasTime);
+uint8_t LORAFRAME_EncodePosition(const LoraPositionTypeDef *position, uint8_t *buffer);
+uint8_t LORAFRAME_DecodePosition(const uint8_t *buffer, uint16_t length, LoraPositionTypeDef *position);
+uint16_t LORAFRAME_EncodeBatchHeader(uint8_t *buffer, uint32_t gatewayId, uint8_t count);
+uint8_t LORAFRAME_EncodeBeacon(const LoraBeaconTypeDef *beacon, uint8_t *buffer);
+uint8_t LORAFRAME_DecodeBeacon(const uint8_t *buffer, uint16_t length, LoraBeaconTypeDef *beacon);
+
+#endif
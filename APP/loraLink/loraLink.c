@@ -0,0 +1,269 @@
+/**
+ * @file loraLink.c
+ * @brief LoRa可靠链路: 应答、重发和接收方去重
+ *
+ * 发送方(叶节点)每发出一帧，单次接收 LORALINK_ACK_WINDOW_MS 等待应答(llcc68_single_receive，
+ * 超时后芯片回到待机)，其余时间芯片不接收。未收到应答时调用 ADR_OnLoss()，随机退避后以相同序号
+ * 重发，最多 LORALINK_MAX_RETRIES 次；收到应答时以应答中回报的上行SNR调用 ADR_OnAck()。
+ * 接收方(网关)按节点记录最近序号：落后不超过 GATEWAY_DUP_WINDOW 的帧视为重发，仍回复应答但由调用方丢弃；
+ * 序号前跳时按间隔累计丢失帧数，后退更多时视为对端重新上电(备份域丢失，序号从1开始)，从新序号重新同步。应答不在接收回调中发送，由主循环调用 LORALINK_Poll() 发送，
+ * 发送时关闭先听后发，避免退避使应答落在发送方的接收窗口之外。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "loraLink/loraLink.h"
+
+#define LORALINK_TURNAROUND_MS  10      /* 网关收到帧后延时回复, 等待发送方切换到接收 */
+
+LoraLinkStatsTypeDef loraLinkStats = {0};
+LoraLinkPeerTypeDef loraLinkPeers[LORALINK_MAX_PEERS];
+
+static volatile uint8_t loraLinkWaiting = 0;    // 1 表示正在等待应答
+static uint8_t loraLinkAcked = 0;               // 1 表示已收到当前帧的应答
+static const uint8_t *loraLinkFrame = NULL;     // 发送方: 等待应答的帧
+static uint8_t loraLinkAck[LORALINK_ACK_LEN];   // 接收方: 待发送的应答
+static uint8_t loraLinkAckPending = 0;          // 1 表示有待发送的应答
+static uint8_t loraLinkNextPeer = 0;            // 对端表满时下一个被替换的条目
+
+/**
+ * @brief 应答接收回调: 与等待应答的帧头比较后记录链路质量
+ */
+static void LORALINK_OnAck(uint8_t *buffer, uint16_t length)
+{
+    int16_t rssi;
+    int8_t snr;
+
+    loraLinkWaiting = 0;
+    if (buffer == NULL || length != LORALINK_ACK_LEN || buffer[0] != LORALINK_TYPE_ACK)
+    {
+        return;
+    }
+    if (memcmp(buffer + 1, loraLinkFrame + 1, 6) != 0 || buffer[7] != loraLinkFrame[0])
+    {
+        return;
+    }
+
+    loraLinkAcked = 1;
+    LORA_GetPacketStatus(&rssi, &snr);
+    ADR_OnAck(rssi, (int8_t)buffer[8]);
+}
+
+/**
+ * @brief 等待应答窗口结束(收到数据包或超时)
+ */
+static void LORALINK_WaitAck(void)
+{
+    while (loraLinkWaiting)
+    {
+        LORA_Process();
+        if (loraLinkWaiting && LORA_GetState() != LORA_STATE_RX)
+        {
+            loraLinkWaiting = 0;
+        }
+        if (loraLinkWaiting)
+        {
+            __WFI();
+        }
+    }
+}
+
+/**
+ * @brief 发送一帧并等待应答, 未收到应答时退避重发
+ * @details 调用前需已调用LORA_Init(); 帧需带公共帧头, 重发使用相同的序号
+ * @param frame 帧数据
+ * @param length 帧长度, 不小于LORALINK_HEADER_LEN
+ * @return uint8_t 0 表示已收到应答；1 表示重发用尽仍未收到应答；2 表示超出占空比额度
+ */
+uint8_t LORALINK_Send(uint8_t *frame, uint8_t length)
+{
+    uint32_t tickstart;
+    uint32_t backoff;
+    uint8_t attempt;
+    uint8_t result;
+
+    if (length < LORALINK_HEADER_LEN)
+    {
+        return 1;
+    }
+
+    loraLinkFrame = frame;
+    for (attempt = 0; attempt <= LORALINK_MAX_RETRIES; attempt++)
+    {
+        if (attempt > 0)
+        {
+            /* 芯片已在接收窗口结束后回到待机, 退避期间MCU以WFI休眠 */
+            backoff = LORA_Random() % ((uint32_t)LORALINK_BACKOFF_MS << attempt);
+            tickstart = HAL_GetTick();
+            while ((HAL_GetTick() - tickstart) < backoff)
+            {
+                __WFI();
+            }
+            loraLinkStats.retries++;
+        }
+
+        result = LORA_SendData(frame, length);
+        if (result == 2)
+        {
+            return 2;
+        }
+        if (result != 0)
+        {
+            continue;
+        }
+        loraLinkStats.sent++;
+
+        loraLinkAcked = 0;
+        if (LORA_ReceiveAsync(LORALINK_ACK_WINDOW_MS, LORALINK_OnAck) == 0)
+        {
+            loraLinkWaiting = 1;
+            LORALINK_WaitAck();
+        }
+        if (loraLinkAcked)
+        {
+            loraLinkStats.acked++;
+            return 0;
+        }
+        ADR_OnLoss();
+    }
+
+    loraLinkStats.failed++;
+    return 1;
+}
+
+/**
+ * @brief 查找对端条目, 不存在时分配空闲条目, 表满时轮流替换
+ */
+static LoraLinkPeerTypeDef *LORALINK_FindPeer(uint32_t nodeId)
+{
+    LoraLinkPeerTypeDef *peer;
+    uint8_t i;
+
+    for (i = 0; i < LORALINK_MAX_PEERS; i++)
+    {
+        if (loraLinkPeers[i].used && loraLinkPeers[i].nodeId == nodeId)
+        {
+            return &loraLinkPeers[i];
+        }
+    }
+    for (i = 0; i < LORALINK_MAX_PEERS; i++)
+    {
+        if (!loraLinkPeers[i].used)
+        {
+            break;
+        }
+    }
+    if (i == LORALINK_MAX_PEERS)
+    {
+        i = loraLinkNextPeer;
+        loraLinkNextPeer = (loraLinkNextPeer + 1) % LORALINK_MAX_PEERS;
+    }
+
+    peer = &loraLinkPeers[i];
+    memset(peer, 0, sizeof(LoraLinkPeerTypeDef));
+    peer->nodeId = nodeId;
+    return peer;
+}
+
+/**
+ * @brief 接收方处理一个带公共帧头的帧: 更新对端统计并准备应答
+ * @details 在接收回调中调用; 使能TDMA时下一个时隙紧随其后, 不发送应答
+ * @param buffer 接收到的帧
+ * @param length 帧长度
+ * @return uint8_t 0 表示新帧；1 表示重复帧(已应答过的重发)或帧头不完整
+ */
+uint8_t LORALINK_OnReceive(const uint8_t *buffer, uint16_t length)
+{
+    LoraLinkPeerTypeDef *peer;
+    uint32_t nodeId;
+    uint16_t seq;
+    uint16_t gap;
+    uint16_t back;
+    uint8_t duplicate;
+
+    if (buffer == NULL || length < LORALINK_HEADER_LEN)
+    {
+        return 1;
+    }
+
+    nodeId = LORAFRAME_Get(buffer + 1, 4);
+    seq = (uint16_t)LORAFRAME_Get(buffer + 5, 2);
+    peer = LORALINK_FindPeer(nodeId);
+    LORA_GetPacketStatus(&peer->rssi, &peer->snr);
+
+    /* 与网关节点表相同的去重窗口; 前跳不到半个序号空间时计入丢失, 更大的后退视为对端重新上电 */
+    gap = (uint16_t)(seq - peer->lastSeq);
+    back = (uint16_t)(peer->lastSeq - seq);
+    duplicate = peer->used && back < GATEWAY_DUP_WINDOW;
+    if (duplicate)
+    {
+        peer->duplicates++;
+    }
+    else
+    {
+        if (peer->used && gap > 1 && gap < 0x8000)
+        {
+            peer->lost += gap - 1;
+        }
+        peer->frames++;
+        peer->lastSeq = seq;
+        peer->used = 1;
+    }
+
+#ifndef TDMA_ENABLE
+    loraLinkAck[0] = LORALINK_TYPE_ACK;
+    memcpy(loraLinkAck + 1, buffer + 1, 6);
+    loraLinkAck[7] = buffer[0];
+    loraLinkAck[8] = (uint8_t)peer->snr;
+    loraLinkAck[9] = (uint8_t)(-peer->rssi > 0xFF ? 0xFF : -peer->rssi);
+    loraLinkAckPending = 1;
+#endif
+    return duplicate;
+}
+
+/**
+ * @brief 接收方发送待回复的应答
+ * @details 在LORA_Process()之后调用; 发送后芯片回到不带回调的接收模式, 调用方需重新启动接收
+ * @return uint8_t 1 表示已发送应答；0 表示没有待发送的应答
+ */
+uint8_t LORALINK_Poll(void)
+{
+    if (!loraLinkAckPending)
+    {
+        return 0;
+    }
+    loraLinkAckPending = 0;
+
+    HAL_Delay(LORALINK_TURNAROUND_MS);
+    LORA_SetLbt(0);
+    if (LORA_SendData(loraLinkAck, LORALINK_ACK_LEN) != 0)
+    {
+        DEBUG_Warn("LoRa ack send failed\r\n");
+    }
+    LORA_SetLbt(1);
+    return 1;
+}
+
+/**
+ * @brief 通过调试串口输出链路统计
+ * @details 输出格式:
+ *          LINK,tx,<发出帧数>,<收到应答数>,<重发次数>,<失败帧数>
+ *          LINK,<节点ID>,<收到帧数>,<重复帧数>,<丢失帧数>,<RSSI>,<SNR>  (每个对端一行)
+ */
+void LORALINK_Report(void)
+{
+    uint8_t i;
+
+    DEBUG_Info("LINK,tx,%lu,%lu,%lu,%lu\r\n", loraLinkStats.sent, loraLinkStats.acked,
+               loraLinkStats.retries, loraLinkStats.failed);
+    for (i = 0; i < LORALINK_MAX_PEERS; i++)
+    {
+        LoraLinkPeerTypeDef *peer = &loraLinkPeers[i];
+
+        if (peer->used)
+        {
+            DEBUG_Info("LINK,%08lX,%lu,%lu,%lu,%d,%d\r\n", peer->nodeId, peer->frames, peer->duplicates,
+                       peer->lost, peer->rssi, peer->snr);
+        }
+    }
+}
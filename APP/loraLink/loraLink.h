@@ -0,0 +1,55 @@
+#ifndef __LORALINK_H__
+#define __LORALINK_H__
+
+#include "string.h"
+#include "user_config.h"
+#include "debug/debug.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+#include "adr/adr.h"
+
+/*
+ * 可靠链路作用于带公共帧头的帧: [0]类型, [1..4]发送方节点ID, [5..6]序号(位置帧即如此)。
+ *  应答帧 LORALINK_TYPE_ACK, 共LORALINK_ACK_LEN字节
+ *    [0]     类型
+ *    [1..4]  被应答帧的发送方节点ID
+ *    [5..6]  被应答帧的序号
+ *    [7]     被应答帧的类型
+ *    [8]     网关测得的上行SNR(dB, 有符号)
+ *    [9]     网关测得的上行RSSI的相反数(dBm)
+ */
+#define LORALINK_TYPE_ACK   0x4B
+#define LORALINK_ACK_LEN    10
+#define LORALINK_HEADER_LEN 7       /* 公共帧头长度 */
+
+/* 发送方统计 */
+typedef struct
+{
+    uint32_t sent;          // 发出的帧数(含重发)
+    uint32_t acked;         // 收到应答的帧数
+    uint32_t retries;       // 重发次数
+    uint32_t failed;        // 重发用尽仍未收到应答的帧数
+} LoraLinkStatsTypeDef;
+
+/* 接收方对端统计 */
+typedef struct
+{
+    uint32_t nodeId;        // 对端节点ID
+    uint32_t frames;        // 收到的不重复帧数
+    uint32_t duplicates;    // 重发造成的重复帧数(序号落后不超过GATEWAY_DUP_WINDOW)
+    uint32_t lost;          // 按序号间隔推算的丢失帧数, 对端重新上电时不计
+    uint16_t lastSeq;       // 最近一帧的序号
+    int16_t rssi;           // 最近一帧的RSSI(dBm)
+    int8_t snr;             // 最近一帧的SNR(dB)
+    uint8_t used;           // 1 表示条目已分配
+} LoraLinkPeerTypeDef;
+
+extern LoraLinkStatsTypeDef loraLinkStats;
+extern LoraLinkPeerTypeDef loraLinkPeers[LORALINK_MAX_PEERS];
+
+uint8_t LORALINK_Send(uint8_t *frame, uint8_t length);
+uint8_t LORALINK_OnReceive(const uint8_t *buffer, uint16_t length);
+uint8_t LORALINK_Poll(void);
+void LORALINK_Report(void);
+
+#endif
@@ -0,0 +1,782 @@
+/**
+ * @file lorawan.c
+ * @brief LoRaWAN 1.0.x Class A终端(CN470-510), 建立在LLCC68驱动之上
+ *
+ * 支持OTAA(LORAWAN_OTAA)和ABP入网，上行帧加密和MIC，下行帧校验、解密和帧计数防重放，
+ * 以及LinkCheckAns、LinkADRReq、DutyCycleReq、RXParamSetupReq、DevStatusReq、RXTimingSetupReq。
+ * 会话(密钥、帧计数、信道掩码、速率)由persist模块掉电保持；上行帧计数低15位同时写入备份寄存器，
+ * STANDBY前未保存时以备份寄存器为准，备份域也丢失时跳过 LORAWAN_FCNT_GAP。
+ *
+ * 接收窗口: 发送完成的DIO1中断时刻换算到RTC时间作为基准，RX1在基准后 rxDelay 秒、RX2再晚1秒。
+ * 两次窗口之间LLCC68处于热启动睡眠，MCU超过2秒的等待进入STOP模式，其余以WFI等待；
+ * 窗口前 LORAWAN_WAKE_LEAD_MS 唤醒芯片，窗口只覆盖 LORAWAN_RX_SYMBOLS 个符号加定时余量，
+ * 检测到同步字后芯片定时器停止，直到数据包接收完成。RX1收到有效下行时不再打开RX2。
+ *
+ * 与标准的差异: LLCC68不支持SF10~SF12(DR0~DR2)，数据速率限制在DR3~DR5；
+ * 不实现LinkADRReq的NbTrans重复发送和同一下行中多个LinkADRReq的整体应答；入网应答的CFList忽略。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "lorawan/lorawan.h"
+
+#define LORAWAN_MHDR_JOIN_REQUEST   0x00
+#define LORAWAN_MHDR_JOIN_ACCEPT    0x20
+#define LORAWAN_MHDR_UNCONFIRMED_UP 0x40
+#define LORAWAN_MHDR_UNCONFIRMED_DN 0x60
+#define LORAWAN_MHDR_CONFIRMED_UP   0x80
+#define LORAWAN_MHDR_CONFIRMED_DN   0xA0
+#define LORAWAN_MTYPE_MASK          0xE0
+#define LORAWAN_FCTRL_ADR           0x80
+#define LORAWAN_FCTRL_ACK           0x20
+#define LORAWAN_FCNT_VALID          0x8000      /* 备份寄存器中帧计数有效标记 */
+
+LorawanSessionTypeDef lorawanSession = {0};
+
+#ifdef LORAWAN_OTAA
+static const uint8_t lorawanDevEui[8] = LORAWAN_DEV_EUI;
+static const uint8_t lorawanJoinEui[8] = LORAWAN_JOIN_EUI;
+static const uint8_t lorawanAppKey[AES_BLOCK_SIZE] = LORAWAN_APP_KEY;
+#else
+static const uint8_t lorawanNwkSKey[AES_BLOCK_SIZE] = LORAWAN_NWK_SKEY;
+static const uint8_t lorawanAppSKey[AES_BLOCK_SIZE] = LORAWAN_APP_SKEY;
+#endif
+static const uint16_t lorawanChMask[LORAWAN_MASK_WORDS] = LORAWAN_CHANNEL_MASK;
+
+static uint8_t lorawanRxBuffer[LORAWAN_PHY_MAX];        /* 最近一次接收窗口收到的数据包 */
+static uint8_t lorawanRxLength = 0;
+static volatile uint8_t lorawanRxWaiting = 0;           /* 1 表示接收窗口打开中 */
+static uint64_t lorawanTxDoneMs = 0;                    /* 最近一次发送完成的RTC时间(ms) */
+static uint8_t lorawanAcked = 0;                        /* 1 表示收到确认型上行的ACK */
+
+/* 下行帧处理函数, 返回0表示数据包有效 */
+typedef uint8_t (*LORAWAN_RxHandlerTypeDef)(uint8_t *phy, uint8_t length);
+
+/**
+ * @brief 读取RTC时间(ms)
+ */
+static uint64_t LORAWAN_NowMs(void)
+{
+    uint16_t millis;
+    uint32_t seconds = RTC_GetCounterMs(&millis);
+
+    return (uint64_t)seconds * 1000 + millis;
+}
+
+/**
+ * @brief 按字节倒序复制(EUI以高字节在前配置, 空中小端传输)
+ */
+static void LORAWAN_CopyReversed(uint8_t *dst, const uint8_t *src, uint8_t length)
+{
+    uint8_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        dst[i] = src[length - 1 - i];
+    }
+}
+
+/**
+ * @brief 计算AES-CMAC的前4字节作为MIC
+ */
+static void LORAWAN_Cmac(const uint8_t *key, const uint8_t *data, uint16_t length, uint8_t mic[4])
+{
+    AesContextTypeDef ctx;
+    uint8_t mac[AES_BLOCK_SIZE];
+
+    AES_SetKey(&ctx, key);
+    AES_Cmac(&ctx, data, length, mac);
+    memcpy(mic, mac, 4);
+}
+
+/**
+ * @brief 计算数据帧MIC: CMAC(NwkSKey, B0 | msg)
+ * @param dir 0 上行；1 下行
+ */
+static void LORAWAN_DataMic(uint8_t dir, uint32_t fcnt, const uint8_t *msg, uint8_t length, uint8_t mic[4])
+{
+    static uint8_t block[AES_BLOCK_SIZE + LORAWAN_PHY_MAX];
+
+    memset(block, 0, AES_BLOCK_SIZE);
+    block[0] = 0x49;
+    block[5] = dir;
+    LORAFRAME_Put(block + 6, lorawanSession.devAddr, 4);
+    LORAFRAME_Put(block + 10, fcnt, 4);
+    block[15] = length;
+    memcpy(block + AES_BLOCK_SIZE, msg, length);
+    LORAWAN_Cmac(lorawanSession.nwkSKey, block, AES_BLOCK_SIZE + length, mic);
+}
+
+/**
+ * @brief 加密或解密FRMPayload(AES-CTR方式, 两个方向运算相同)
+ * @param dir 0 上行；1 下行
+ */
+static void LORAWAN_Crypt(const uint8_t *key, uint8_t dir, uint32_t fcnt, uint8_t *data, uint8_t length)
+{
+    AesContextTypeDef ctx;
+    uint8_t a[AES_BLOCK_SIZE];
+    uint8_t s[AES_BLOCK_SIZE];
+    uint16_t i;
+    uint8_t j;
+
+    AES_SetKey(&ctx, key);
+    for (i = 0; i < length; i += AES_BLOCK_SIZE)
+    {
+        memset(a, 0, AES_BLOCK_SIZE);
+        a[0] = 0x01;
+        a[5] = dir;
+        LORAFRAME_Put(a + 6, lorawanSession.devAddr, 4);
+        LORAFRAME_Put(a + 10, fcnt, 4);
+        a[15] = (uint8_t)(i / AES_BLOCK_SIZE + 1);
+        AES_Encrypt(&ctx, a, s);
+        for (j = 0; j < AES_BLOCK_SIZE && i + j < length; j++)
+        {
+            data[i + j] ^= s[j];
+        }
+    }
+}
+
+/**
+ * @brief 恢复区域默认的信道、速率和接收参数
+ */
+static void LORAWAN_ResetParams(void)
+{
+    memcpy(lorawanSession.chMask, lorawanChMask, sizeof(lorawanSession.chMask));
+    lorawanSession.dataRate = LORAWAN_DEFAULT_DR;
+    lorawanSession.txPower = LORAWAN_DEFAULT_TX_POWER;
+    lorawanSession.rx1DrOffset = 0;
+    lorawanSession.rx2Dr = LORAWAN_RX2_DR;
+    lorawanSession.rx2Frequency = LORAWAN_RX2_FREQUENCY;
+    lorawanSession.rxDelay = LORAWAN_RECEIVE_DELAY1_S;
+    lorawanSession.ackDown = 0;
+    lorawanSession.macAnsLen = 0;
+}
+
+/**
+ * @brief 把上行帧计数写入备份寄存器
+ */
+static void LORAWAN_SaveFCnt(void)
+{
+    PWR_WriteBackup(PWR_BKP_LORAWAN_FCNT, LORAWAN_FCNT_VALID | (lorawanSession.fCntUp & 0x7FFF));
+}
+
+/**
+ * @brief 恢复会话并校正上行帧计数
+ * @note 需在PERSIST_Init()之后调用
+ */
+void LORAWAN_Init(void)
+{
+    uint16_t saved = PWR_ReadBackup(PWR_BKP_LORAWAN_FCNT);
+    uint16_t ahead;
+
+    if (lorawanSession.magic != LORAWAN_SESSION_MAGIC)
+    {
+        memset(&lorawanSession, 0, sizeof(lorawanSession));
+        lorawanSession.magic = LORAWAN_SESSION_MAGIC;
+        LORAWAN_ResetParams();
+    }
+
+#ifndef LORAWAN_OTAA
+    lorawanSession.devAddr = LORAWAN_DEV_ADDR;
+    memcpy(lorawanSession.nwkSKey, lorawanNwkSKey, AES_BLOCK_SIZE);
+    memcpy(lorawanSession.appSKey, lorawanAppSKey, AES_BLOCK_SIZE);
+    lorawanSession.joined = 1;
+#endif
+
+    /* 掉电保持的计数落后于备份寄存器时(发送后未及保存)追上; 备份域丢失时无法得知, 跳过一段 */
+    if (saved & LORAWAN_FCNT_VALID)
+    {
+        ahead = (saved - (uint16_t)lorawanSession.fCntUp) & 0x7FFF;
+        if (ahead < 0x4000)
+        {
+            lorawanSession.fCntUp += ahead;
+        }
+    }
+    else if (lorawanSession.fCntUp != 0)
+    {
+        lorawanSession.fCntUp += LORAWAN_FCNT_GAP;
+    }
+    LORAWAN_SaveFCnt();
+}
+
+/**
+ * @brief 设置射频频率、数据速率和发射功率
+ */
+static void LORAWAN_SetRadio(uint32_t frequency, uint8_t dataRate)
+{
+    int8_t txDbm = LORAWAN_MAX_EIRP_DBM - 2 * lorawanSession.txPower;
+
+    loraConfig.frequency = frequency;
+    loraConfig.sf = (uint8_t)(12 - dataRate);
+    loraConfig.bandwidth = LLCC68_LORA_BANDWIDTH_125_KHZ;
+    loraConfig.ldro = LLCC68_BOOL_FALSE;
+    loraConfig.txDbm = (txDbm > LLCC68_LORA_DEFAULT_TX_DBM) ? LLCC68_LORA_DEFAULT_TX_DBM : txDbm;
+    (void)LORA_ApplyConfig(&loraConfig);
+}
+
+/**
+ * @brief 在启用的上行信道中随机选择一个
+ */
+static uint8_t LORAWAN_SelectChannel(void)
+{
+    uint8_t count = 0;
+    uint8_t pick;
+    uint8_t i;
+
+    for (i = 0; i < LORAWAN_UP_CHANNELS; i++)
+    {
+        count += (lorawanSession.chMask[i / 16] >> (i % 16)) & 1;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    pick = (uint8_t)(LORA_Random() % count);
+    for (i = 0; i < LORAWAN_UP_CHANNELS; i++)
+    {
+        if (((lorawanSession.chMask[i / 16] >> (i % 16)) & 1) && pick-- == 0)
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief 在随机信道上发送一帧, 记录发送完成时刻后芯片进入热启动睡眠
+ * @param channel 输出使用的上行信道号
+ * @return uint8_t LORA_SendData()的结果
+ */
+static uint8_t LORAWAN_Transmit(uint8_t *frame, uint8_t length, uint8_t *channel)
+{
+    uint8_t result;
+
+    *channel = LORAWAN_SelectChannel();
+    LORAWAN_SetRadio(LORAWAN_UP_FREQ_BASE + (uint32_t)*channel * LORAWAN_FREQ_STEP, lorawanSession.dataRate);
+    result = LORA_SendData(frame, length);
+
+    /* TX_DONE的DIO1中断时刻换算到RTC时间, 作为接收窗口的基准 */
+    lorawanTxDoneMs = LORAWAN_NowMs() - (HAL_GetTick() - gpioB14Tick);
+    LORA_Sleep();
+    return result;
+}
+
+/**
+ * @brief 等待到RTC时间target(ms), 超过2秒时以STOP模式等待到目标前1秒内
+ */
+static void LORAWAN_WaitUntil(uint64_t target)
+{
+    uint64_t now = LORAWAN_NowMs();
+
+    if (target > now + 2000)
+    {
+        LOWPOWER_StopFor((uint32_t)((target - now) / 1000) - 1);
+    }
+    while (LORAWAN_NowMs() < target)
+    {
+        __WFI();
+    }
+}
+
+/**
+ * @brief 接收窗口回调: 保存数据包
+ */
+static void LORAWAN_OnRx(uint8_t *buffer, uint16_t length)
+{
+    int16_t rssi;
+
+    lorawanRxWaiting = 0;
+    if (buffer != NULL && length <= LORAWAN_PHY_MAX)
+    {
+        memcpy(lorawanRxBuffer, buffer, length);
+        lorawanRxLength = (uint8_t)length;
+        LORA_GetPacketStatus(&rssi, &lorawanSession.snr);
+    }
+}
+
+/**
+ * @brief 在发送完成后delayMs处打开一个接收窗口
+ * @return uint8_t 收到的数据包长度, 0表示窗口内没有数据包
+ */
+static uint8_t LORAWAN_RxWindow(uint32_t delayMs, uint32_t frequency, uint8_t dataRate)
+{
+    uint32_t symbolUs = (1UL << (12 - dataRate)) * 8;   /* 125kHz下符号时间 2^SF / 125kHz */
+    uint32_t windowMs = LORAWAN_RX_SYMBOLS * symbolUs / 1000 + 2 * LORAWAN_RX_ERROR_MS;
+    uint64_t open = lorawanTxDoneMs + delayMs - LORAWAN_RX_ERROR_MS;
+
+    LORAWAN_WaitUntil(open - LORAWAN_WAKE_LEAD_MS);
+    LORA_Wakeup();
+    LORA_SetRxInvertIq(LLCC68_BOOL_TRUE);
+    LORAWAN_SetRadio(frequency, dataRate);
+    LORAWAN_WaitUntil(open);
+
+    lorawanRxLength = 0;
+    if (LORA_ReceiveAsync(windowMs, LORAWAN_OnRx) == 0)
+    {
+        lorawanRxWaiting = 1;
+        while (lorawanRxWaiting)
+        {
+            LORA_Process();
+            if (lorawanRxWaiting && LORA_GetState() != LORA_STATE_RX)
+            {
+                lorawanRxWaiting = 0;
+            }
+            if (lorawanRxWaiting)
+            {
+                __WFI();
+            }
+        }
+    }
+
+    LORA_SetRxInvertIq(LLCC68_LORA_DEFAULT_INVERT_IQ);
+    LORA_Sleep();
+    return lorawanRxLength;
+}
+
+/**
+ * @brief 依次打开RX1、RX2, 直到handler接受一个数据包
+ * @param channel 上行信道号
+ * @param delayS RX1延时(秒)
+ * @return uint8_t 0 表示收到有效下行；1 表示两个窗口均无有效下行
+ */
+static uint8_t LORAWAN_ReceiveWindows(uint8_t channel, uint8_t delayS, LORAWAN_RxHandlerTypeDef handler)
+{
+    uint8_t rx1Dr = lorawanSession.dataRate;
+    uint8_t length;
+
+    rx1Dr = (rx1Dr >= LORAWAN_DR_MIN + lorawanSession.rx1DrOffset) ? rx1Dr - lorawanSession.rx1DrOffset : LORAWAN_DR_MIN;
+    length = LORAWAN_RxWindow((uint32_t)delayS * 1000,
+                              LORAWAN_DOWN_FREQ_BASE + (uint32_t)(channel % LORAWAN_DOWN_CHANNELS) * LORAWAN_FREQ_STEP, rx1Dr);
+    if (length > 0 && handler(lorawanRxBuffer, length) == 0)
+    {
+        return 0;
+    }
+
+    length = LORAWAN_RxWindow((uint32_t)(delayS + 1) * 1000, lorawanSession.rx2Frequency, lorawanSession.rx2Dr);
+    if (length > 0 && handler(lorawanRxBuffer, length) == 0)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief 追加一条MAC应答, 随下一个上行帧的FOpts发送
+ */
+static void LORAWAN_AddAnswer(const uint8_t *answer, uint8_t length)
+{
+    if (lorawanSession.macAnsLen + length <= LORAWAN_FOPTS_MAX)
+    {
+        memcpy(lorawanSession.macAns + lorawanSession.macAnsLen, answer, length);
+        lorawanSession.macAnsLen += length;
+    }
+}
+
+/**
+ * @brief 处理LinkADRReq
+ * @param req DataRate_TXPower, ChMask(2), Redundancy
+ * @return uint8_t LinkADRAns状态: bit2功率, bit1速率, bit0信道掩码, 全部接受时才生效
+ */
+static uint8_t LORAWAN_LinkAdr(const uint8_t *req)
+{
+    uint16_t chMask[LORAWAN_MASK_WORDS];
+    uint8_t dataRate = req[0] >> 4;
+    uint8_t txPower = req[0] & 0x0F;
+    uint8_t maskCntl = (req[3] >> 4) & 0x07;
+    uint8_t status = 0x07;
+    uint8_t enabled = 0;
+    uint8_t i;
+
+    memcpy(chMask, lorawanSession.chMask, sizeof(chMask));
+    if (maskCntl < LORAWAN_MASK_WORDS)
+    {
+        chMask[maskCntl] = (uint16_t)LORAFRAME_Get(req + 1, 2);
+    }
+    else if (maskCntl == 6)
+    {
+        memset(chMask, 0xFF, sizeof(chMask));   /* 全部信道开启 */
+    }
+    else
+    {
+        status &= ~0x01;
+    }
+    for (i = 0; i < LORAWAN_MASK_WORDS; i++)
+    {
+        enabled |= (chMask[i] != 0);
+    }
+    if (!enabled)
+    {
+        status &= ~0x01;
+    }
+    if (dataRate != 0x0F && (dataRate < LORAWAN_DR_MIN || dataRate > LORAWAN_DR_MAX))
+    {
+        status &= ~0x02;
+    }
+    if (txPower != 0x0F && txPower > 7)
+    {
+        status &= ~0x04;
+    }
+
+    if (status == 0x07)
+    {
+        memcpy(lorawanSession.chMask, chMask, sizeof(chMask));
+        if (dataRate != 0x0F)
+        {
+            lorawanSession.dataRate = dataRate;
+        }
+        if (txPower != 0x0F)
+        {
+            lorawanSession.txPower = txPower;
+        }
+        DEBUG_Info("LoRaWAN ADR DR%u TXPower %u\r\n", lorawanSession.dataRate, lorawanSession.txPower);
+    }
+    return status;
+}
+
+/**
+ * @brief 处理RXParamSetupReq
+ * @param req DLsettings, Frequency(3, 单位100Hz)
+ * @return uint8_t RXParamSetupAns状态: bit2 RX1偏移, bit1 RX2速率, bit0频率
+ */
+static uint8_t LORAWAN_RxParamSetup(const uint8_t *req)
+{
+    uint8_t offset = (req[0] >> 4) & 0x07;
+    uint8_t dataRate = req[0] & 0x0F;
+    uint32_t frequency = LORAFRAME_Get(req + 1, 3) * 100;
+    uint8_t status = 0x07;
+
+    if (offset > LORAWAN_RX1_DR_OFFSET_MAX)
+    {
+        status &= ~0x04;
+    }
+    if (dataRate < LORAWAN_DR_MIN || dataRate > LORAWAN_DR_MAX)
+    {
+        status &= ~0x02;
+    }
+    if (frequency < LORAWAN_DOWN_FREQ_BASE ||
+        frequency > LORAWAN_DOWN_FREQ_BASE + (LORAWAN_DOWN_CHANNELS - 1) * LORAWAN_FREQ_STEP)
+    {
+        status &= ~0x01;
+    }
+
+    if (status == 0x07)
+    {
+        lorawanSession.rx1DrOffset = offset;
+        lorawanSession.rx2Dr = dataRate;
+        lorawanSession.rx2Frequency = frequency;
+    }
+    return status;
+}
+
+/**
+ * @brief 按供电电压估算DevStatusAns电量(1~254, 255表示无法测量)
+ */
+static uint8_t LORAWAN_GetBattery(void)
+{
+    uint16_t vdd = ADC1_ReadVdd();
+
+    if (vdd == 0)
+    {
+        return 255;
+    }
+    if (vdd <= LORAWAN_VDD_EMPTY_MV)
+    {
+        return 1;
+    }
+    if (vdd >= LORAWAN_VDD_FULL_MV)
+    {
+        return 254;
+    }
+    return (uint8_t)(1 + (uint32_t)(vdd - LORAWAN_VDD_EMPTY_MV) * 253 / (LORAWAN_VDD_FULL_MV - LORAWAN_VDD_EMPTY_MV));
+}
+
+/**
+ * @brief 处理下行MAC命令, 应答保存到会话中随下一个上行帧发送
+ * @note 未知命令无法确定长度, 遇到时停止解析其余命令
+ */
+static void LORAWAN_ProcessMac(const uint8_t *cmd, uint8_t length)
+{
+    uint8_t answer[3];
+    uint8_t i = 0;
+
+    while (i < length)
+    {
+        answer[0] = cmd[i];
+        switch (cmd[i])
+        {
+        case 0x02: /* LinkCheckAns: Margin, GwCnt */
+            if (i + 3 > length)
+            {
+                return;
+            }
+            DEBUG_Info("LoRaWAN link margin %u dB, %u gateways\r\n", cmd[i + 1], cmd[i + 2]);
+            i += 3;
+            break;
+        case 0x03: /* LinkADRReq */
+            if (i + 5 > length)
+            {
+                return;
+            }
+            answer[1] = LORAWAN_LinkAdr(cmd + i + 1);
+            LORAWAN_AddAnswer(answer, 2);
+            i += 5;
+            break;
+        case 0x04: /* DutyCycleReq: 占空比由lora.c的区域限制负责, 只应答 */
+            if (i + 2 > length)
+            {
+                return;
+            }
+            LORAWAN_AddAnswer(answer, 1);
+            i += 2;
+            break;
+        case 0x05: /* RXParamSetupReq */
+            if (i + 5 > length)
+            {
+                return;
+            }
+            answer[1] = LORAWAN_RxParamSetup(cmd + i + 1);
+            LORAWAN_AddAnswer(answer, 2);
+            i += 5;
+            break;
+        case 0x06: /* DevStatusReq */
+            answer[1] = LORAWAN_GetBattery();
+            answer[2] = (uint8_t)lorawanSession.snr & 0x3F;
+            LORAWAN_AddAnswer(answer, 3);
+            i += 1;
+            break;
+        case 0x08: /* RXTimingSetupReq */
+            if (i + 2 > length)
+            {
+                return;
+            }
+            lorawanSession.rxDelay = (cmd[i + 1] & 0x0F) ? (cmd[i + 1] & 0x0F) : 1;
+            LORAWAN_AddAnswer(answer, 1);
+            i += 2;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 处理数据下行: 校验地址、帧计数和MIC, 处理ACK、MAC命令和应用数据
+ * @return uint8_t 0 表示有效下行；1 表示不是发给本机的有效数据帧
+ */
+static uint8_t LORAWAN_OnData(uint8_t *phy, uint8_t length)
+{
+    uint8_t mtype = phy[0] & LORAWAN_MTYPE_MASK;
+    uint8_t mic[4];
+    uint8_t foptsLen;
+    uint8_t start;
+    uint32_t fcnt;
+
+    if (length < 12 || (mtype != LORAWAN_MHDR_UNCONFIRMED_DN && mtype != LORAWAN_MHDR_CONFIRMED_DN) ||
+        LORAFRAME_Get(phy + 1, 4) != lorawanSession.devAddr)
+    {
+        return 1;
+    }
+    foptsLen = phy[5] & 0x0F;
+    start = 8 + foptsLen;
+    if (start + 4 > length)
+    {
+        return 1;
+    }
+
+    /* 16位帧计数扩展为32位, 小于下一个可接受值的视为重放 */
+    fcnt = (lorawanSession.fCntDown & 0xFFFF0000U) | LORAFRAME_Get(phy + 6, 2);
+    if (fcnt < lorawanSession.fCntDown)
+    {
+        fcnt += 0x10000;
+    }
+    LORAWAN_DataMic(1, fcnt, phy, length - 4, mic);
+    if (memcmp(mic, phy + length - 4, 4) != 0)
+    {
+        return 1;
+    }
+    lorawanSession.fCntDown = fcnt + 1;
+
+    if (phy[5] & LORAWAN_FCTRL_ACK)
+    {
+        lorawanAcked = 1;
+    }
+    if (mtype == LORAWAN_MHDR_CONFIRMED_DN)
+    {
+        lorawanSession.ackDown = 1;
+    }
+    LORAWAN_ProcessMac(phy + 8, foptsLen);
+
+    if (start < length - 4)
+    {
+        uint8_t port = phy[start];
+        uint8_t *data = phy + start + 1;
+        uint8_t dataLen = length - 4 - start - 1;
+
+        LORAWAN_Crypt(port == 0 ? lorawanSession.nwkSKey : lorawanSession.appSKey, 1, fcnt, data, dataLen);
+        if (port == 0)
+        {
+            LORAWAN_ProcessMac(data, dataLen);
+        }
+        else
+        {
+            DEBUG_Info("LoRaWAN downlink port %u, %u bytes\r\n", port, dataLen);
+        }
+    }
+    return 0;
+}
+
+#ifdef LORAWAN_OTAA
+/**
+ * @brief 处理入网应答: 解密、校验MIC后派生会话密钥
+ * @return uint8_t 0 表示入网成功；1 表示不是有效的入网应答
+ */
+static uint8_t LORAWAN_OnJoinAccept(uint8_t *phy, uint8_t length)
+{
+    AesContextTypeDef ctx;
+    uint8_t block[AES_BLOCK_SIZE];
+    uint8_t mic[4];
+    uint8_t i;
+
+    if ((phy[0] & LORAWAN_MTYPE_MASK) != LORAWAN_MHDR_JOIN_ACCEPT || (length != 17 && length != 33))
+    {
+        return 1;
+    }
+
+    /* 服务器以AES解密运算加密, 终端用加密运算还原 */
+    AES_SetKey(&ctx, lorawanAppKey);
+    for (i = 1; i < length; i += AES_BLOCK_SIZE)
+    {
+        AES_Encrypt(&ctx, phy + i, phy + i);
+    }
+    LORAWAN_Cmac(lorawanAppKey, phy, length - 4, mic);
+    if (memcmp(mic, phy + length - 4, 4) != 0)
+    {
+        return 1;
+    }
+
+    /* 会话密钥 = AES(AppKey, 0x01/0x02 | AppNonce | NetID | DevNonce | 填充) */
+    memset(block, 0, AES_BLOCK_SIZE);
+    memcpy(block + 1, phy + 1, 6);
+    LORAFRAME_Put(block + 7, lorawanSession.devNonce, 2);
+    block[0] = 0x01;
+    AES_Encrypt(&ctx, block, lorawanSession.nwkSKey);
+    block[0] = 0x02;
+    AES_Encrypt(&ctx, block, lorawanSession.appSKey);
+
+    lorawanSession.devAddr = LORAFRAME_Get(phy + 7, 4);
+    lorawanSession.rx1DrOffset = (phy[11] >> 4) & 0x07;
+    if ((phy[11] & 0x0F) >= LORAWAN_DR_MIN)
+    {
+        lorawanSession.rx2Dr = phy[11] & 0x0F;
+    }
+    else
+    {
+        DEBUG_Warn("LoRaWAN RX2 DR%u unsupported, keep DR%u\r\n", phy[11] & 0x0F, lorawanSession.rx2Dr);
+    }
+    lorawanSession.rxDelay = (phy[12] & 0x0F) ? (phy[12] & 0x0F) : 1;
+    lorawanSession.fCntUp = 0;
+    lorawanSession.fCntDown = 0;
+    lorawanSession.joined = 1;
+    LORAWAN_SaveFCnt();
+
+    DEBUG_Info("LoRaWAN joined, DevAddr %08lX\r\n", lorawanSession.devAddr);
+    return 0;
+}
+#endif
+
+/**
+ * @brief OTAA入网: 发送入网请求并在JOIN_ACCEPT窗口接收应答
+ * @details 调用前需已调用LORA_Wakeup(), 返回时LLCC68处于热启动睡眠。ABP下会话已配置, 直接返回。
+ * @return uint8_t 0 表示已入网；1 表示入网失败
+ */
+uint8_t LORAWAN_Join(void)
+{
+#ifdef LORAWAN_OTAA
+    uint8_t frame[23];
+    uint8_t channel;
+
+    lorawanSession.joined = 0;
+    lorawanSession.devNonce++;
+    LORAWAN_ResetParams();
+
+    frame[0] = LORAWAN_MHDR_JOIN_REQUEST;
+    LORAWAN_CopyReversed(frame + 1, lorawanJoinEui, 8);
+    LORAWAN_CopyReversed(frame + 9, lorawanDevEui, 8);
+    LORAFRAME_Put(frame + 17, lorawanSession.devNonce, 2);
+    LORAWAN_Cmac(lorawanAppKey, frame, 19, frame + 19);
+
+    if (LORAWAN_Transmit(frame, sizeof(frame), &channel) != 0)
+    {
+        return 1;
+    }
+    (void)LORAWAN_ReceiveWindows(channel, LORAWAN_JOIN_DELAY1_S, LORAWAN_OnJoinAccept);
+#endif
+    return lorawanSession.joined ? 0 : 1;
+}
+
+/**
+ * @brief 发送一个数据上行帧, 并在RX1/RX2接收下行
+ * @details 内部唤醒LLCC68, 返回时芯片处于热启动睡眠。未入网时先入网(每次调用最多尝试一次)。
+ *          待发送的MAC应答放在FOpts中; 收到确认型下行后下一个上行帧置位ACK。
+ * @param port 应用端口(1~223)
+ * @param data 应用数据
+ * @param length 数据长度, 不超过LORAWAN_PAYLOAD_MAX
+ * @param confirmed 1 表示确认型上行, 需在接收窗口收到ACK
+ * @return uint8_t 0 表示已发送(确认型上行已收到ACK)；1 表示失败；2 表示超出占空比额度
+ */
+uint8_t LORAWAN_Send(uint8_t port, const uint8_t *data, uint8_t length, uint8_t confirmed)
+{
+    static uint8_t frame[LORAWAN_PHY_MAX];
+    uint8_t channel;
+    uint8_t result;
+    uint8_t len = 0;
+
+    if (port == 0 || port > 223 || length > LORAWAN_PAYLOAD_MAX)
+    {
+        return 1;
+    }
+
+    LORA_Wakeup();
+    if (!lorawanSession.joined)
+    {
+        if (LORAWAN_Join() != 0)
+        {
+            return 1;
+        }
+        LORA_Wakeup();
+    }
+
+    frame[len++] = confirmed ? LORAWAN_MHDR_CONFIRMED_UP : LORAWAN_MHDR_UNCONFIRMED_UP;
+    LORAFRAME_Put(frame + len, lorawanSession.devAddr, 4);
+    len += 4;
+    frame[len++] = lorawanSession.macAnsLen | (lorawanSession.ackDown ? LORAWAN_FCTRL_ACK : 0)
+#ifdef LORAWAN_ADR
+                   | LORAWAN_FCTRL_ADR
+#endif
+        ;
+    LORAFRAME_Put(frame + len, lorawanSession.fCntUp, 2);
+    len += 2;
+    memcpy(frame + len, lorawanSession.macAns, lorawanSession.macAnsLen);
+    len += lorawanSession.macAnsLen;
+    frame[len++] = port;
+    memcpy(frame + len, data, length);
+    LORAWAN_Crypt(lorawanSession.appSKey, 0, lorawanSession.fCntUp, frame + len, length);
+    len += length;
+    LORAWAN_DataMic(0, lorawanSession.fCntUp, frame, len, frame + len);
+    len += 4;
+
+    result = LORAWAN_Transmit(frame, len, &channel);
+    if (result != 0)
+    {
+        return result;
+    }
+    lorawanSession.fCntUp++;
+    LORAWAN_SaveFCnt();
+    lorawanSession.macAnsLen = 0;
+    lorawanSession.ackDown = 0;
+
+    lorawanAcked = 0;
+    (void)LORAWAN_ReceiveWindows(channel, lorawanSession.rxDelay, LORAWAN_OnData);
+    return (confirmed && !lorawanAcked) ? 1 : 0;
+}
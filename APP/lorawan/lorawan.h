@@ -0,0 +1,73 @@
+#ifndef __LORAWAN_H__
+#define __LORAWAN_H__
+
+#include "string.h"
+#include "user_config.h"
+#include "debug/debug.h"
+#include "rtc/rtc.h"
+#include "gpio/gpio.h"
+#include "PWR/pwr.h"
+#include "ADC/adc.h"
+#include "Aes/aes.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+#include "lowPower/lowPower.h"
+
+/* CN470-510信道规划: 上行96个信道, RX1使用上行信道号对48取余的下行信道 */
+#define LORAWAN_UP_FREQ_BASE        470300000U
+#define LORAWAN_DOWN_FREQ_BASE      500300000U
+#define LORAWAN_FREQ_STEP           200000U
+#define LORAWAN_UP_CHANNELS         96
+#define LORAWAN_DOWN_CHANNELS       48
+#define LORAWAN_MASK_WORDS          (LORAWAN_UP_CHANNELS / 16)
+#define LORAWAN_DR_MIN              3           /* LLCC68在125kHz下最高SF9, 对应DR3 */
+#define LORAWAN_DR_MAX              5           /* DR5 = SF7 */
+#define LORAWAN_MAX_EIRP_DBM        19          /* TXPower 0对应的发射功率(dBm) */
+#define LORAWAN_RX1_DR_OFFSET_MAX   5
+#define LORAWAN_RECEIVE_DELAY1_S    1           /* 区域默认RX1延时, 可由RXTimingSetupReq修改 */
+#define LORAWAN_JOIN_DELAY1_S       5           /* 入网应答RX1延时 */
+
+/* 接收窗口定时 */
+#define LORAWAN_RX_SYMBOLS          8           /* 窗口至少覆盖的前导码符号数 */
+#define LORAWAN_RX_ERROR_MS         10          /* 窗口两侧的定时误差余量(ms) */
+#define LORAWAN_WAKE_LEAD_MS        20          /* 窗口前提前唤醒LLCC68的时间(ms), 覆盖热启动耗时 */
+
+#define LORAWAN_PHY_MAX             (LLCC68_LORA_DEFAULT_BUFFER_SIZE)
+#define LORAWAN_FOPTS_MAX           15
+#define LORAWAN_PAYLOAD_MAX         (LORAWAN_PHY_MAX - 13 - LORAWAN_FOPTS_MAX)
+#define LORAWAN_SESSION_MAGIC       0x4C57
+#define LORAWAN_FCNT_GAP            32          /* 备份域复位后上行帧计数跳过的值, 弥补最后一次未保存的发送 */
+#define LORAWAN_VDD_EMPTY_MV        2000        /* DevStatusAns电量1对应的供电电压 */
+#define LORAWAN_VDD_FULL_MV         3600        /* DevStatusAns电量254对应的供电电压 */
+
+/* 会话状态, 由persist模块掉电保持 */
+typedef struct
+{
+    uint16_t magic;                             // LORAWAN_SESSION_MAGIC, 其他值表示未初始化
+    uint16_t devNonce;                          // 最近一次入网请求使用的DevNonce
+    uint32_t devAddr;                           // 设备地址
+    uint32_t fCntUp;                            // 下一个上行帧计数
+    uint32_t fCntDown;                          // 下一个可接受的下行帧计数
+    uint32_t rx2Frequency;                      // RX2频率(Hz)
+    uint8_t nwkSKey[AES_BLOCK_SIZE];            // 网络会话密钥
+    uint8_t appSKey[AES_BLOCK_SIZE];            // 应用会话密钥
+    uint16_t chMask[LORAWAN_MASK_WORDS];        // 启用的上行信道
+    uint8_t joined;                             // 1 表示会话有效
+    uint8_t dataRate;                           // 上行数据速率
+    uint8_t txPower;                            // TXPower档位
+    uint8_t rx1DrOffset;                        // RX1数据速率偏移
+    uint8_t rx2Dr;                              // RX2数据速率
+    uint8_t rxDelay;                            // RX1延时(秒)
+    uint8_t ackDown;                            // 1 表示下一个上行帧需确认收到的确认型下行
+    uint8_t macAnsLen;                          // 待随下一个上行帧发送的MAC应答长度
+    uint8_t macAns[LORAWAN_FOPTS_MAX];          // 待发送的MAC应答
+    int8_t snr;                                 // 最近一次下行的SNR(dB)
+} LorawanSessionTypeDef;
+
+extern LorawanSessionTypeDef lorawanSession;
+
+void LORAWAN_Init(void);
+uint8_t LORAWAN_Join(void);
+uint8_t LORAWAN_Send(uint8_t port, const uint8_t *data, uint8_t length, uint8_t confirmed);
+
+#endif
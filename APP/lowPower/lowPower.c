@@ -1,26 +1,276 @@
+#define LOG_MODULE_LEVEL LOG_LEVEL_POWER
+
 #include "lowPower/lowPower.h"
 
-void LOWPOWER_EnterLowPower(uint32_t seconds)
+static uint8_t lowPowerAwakeModules = 0; /* 本周期已唤醒的模块 LowPowerModuleTypeDef, 运动门控跳过的周期不唤醒模块 */
+static uint32_t lowPowerWakeSecond = 0;   /* 由RTC闹钟从STANDBY唤醒的秒(闹钟在秒边界触发), 0表示不测量 */
+
+/**
+ * @brief 读取实测的待机唤醒重新初始化耗时
+ * @retval 重新初始化耗时(us), 尚未实测时返回默认值
+ */
+static uint32_t LOWPOWER_GetReinitTime(void)
+{
+    uint32_t reinit = PWR_ReadBackup(PWR_BKP_REINIT_TIME);
+
+    if (reinit == 0)
+    {
+        return LOWPOWER_REINIT_DEFAULT_US;
+    }
+    return reinit * 100; // 备份寄存器中以100us为单位保存
+}
+
+/**
+ * @brief 配置运动唤醒
+ * @details 仅在静止模式下使能: STOP模式由PA0的EXTI0中断唤醒, STANDBY模式由WKUP引脚上升沿唤醒。
+ *          其他模式上报间隔较短, 不使能以免行走时频繁唤醒。
+ */
+static void LOWPOWER_ConfigMotionWakeup(void)
 {
-    QS100_EnterLowPowerMode();
-    AT6558R_EnterLowPowerMode();
-    /*  */
-    RTC_Init();
-    RTC_SetAlarm(seconds); // 设置20秒后唤醒
+    gpioA0Flag = 0;
 
+#ifdef MOTION_WAKEUP_ENABLE
+    if (POLICY_IsStationary())
+    {
+        GPIOA0_Init();
+        HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1);
+        return;
+    }
+    HAL_PWR_DisableWakeUpPin(PWR_WAKEUP_PIN1);
+    HAL_NVIC_DisableIRQ(EXTI0_IRQn);
+#endif
+}
+
+/**
+ * @brief 进入STOP模式(稳压器低功耗), 等待RTC闹钟或运动唤醒
+ * @note  STOP模式保持SRAM和外设寄存器, 唤醒后系统时钟为HSI, 需要恢复进入前的时钟模式。
+ *        调试串口输入唤醒时处理命令行后继续休眠, 命令请求立即上报时提前返回。
+ */
+static void LOWPOWER_EnterStop(void)
+{
+    uint8_t report = 0;
+
+    DEBUG_Info("Entering STOP Mode...\r\n");
+    DEBUG_Flush(); // 等待调试信息发送完成
+
+    SHELL_ArmWakeup();
+    HAL_SuspendTick(); // 关闭SysTick中断, 避免其唤醒内核
+    while (rtcAlarmFlag == 0 && gpioA0Flag == 0 && report == 0) // 非闹钟、非运动中断唤醒时重新进入STOP模式
+    {
+        HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+        if (gpioA10Flag)
+        {
+            HAL_ResumeTick();
+            CLOCK_Resume();
+            report = SHELL_Session();
+            SHELL_ArmWakeup();
+            HAL_SuspendTick();
+        }
+    }
+    SHELL_DisarmWakeup();
+
+    HAL_ResumeTick();
+    CLOCK_Resume(); // 恢复进入STOP前的时钟模式
+    PROFILE_SleepEnd();
+    DEBUG_Info("Wake up from STOP Mode%s\r\n", gpioA0Flag ? " (motion)" : "");
+}
+
+/**
+ * @brief 进入STANDBY模式, 等待RTC闹钟唤醒
+ * @note  STANDBY模式唤醒后系统复位, 从main重新执行
+ */
+static void LOWPOWER_EnterStandby(void)
+{
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU); // 清除唤醒标志
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_SB); // 清除待机标志
 
-    DEBUG_Printf("Entering Low Power Mode...\r\n");
-    HAL_Delay(1000);            // 确保所有设置生效
-    
+    MEMORY_Update(); // 本次运行的栈和堆水位计入掉电保持的最大值
+    PERSIST_Flush(); // STANDBY模式下RAM丢失, 保存需要保持的数据
+
+    DEBUG_Info("Entering STANDBY Mode...\r\n");
+    DEBUG_Flush(); // 等待调试信息发送完成
+
     HAL_PWR_EnterSTANDBYMode(); // 进入待机模式
-    DEBUG_Printf("!!!mei Jin Low Power Mode!!!\r\n");
+    DEBUG_Error("!!!mei Jin Low Power Mode!!!\r\n");
+}
+
+/**
+ * @brief 低功耗管理初始化
+ * @details 系统复位后尽早调用, 初始化RTC。若本次复位由RTC闹钟从STANDBY唤醒引起, 记录唤醒所在的秒,
+ *          由 LOWPOWER_InitDone() 在全部初始化完成后计算重新初始化耗时。需在PERSIST_Init()之后调用。
+ */
+void LOWPOWER_Init(void)
+{
+    uint16_t millis;
+
+    PWR_Init();
+    RTC_Init(); // RTC在整个运行期间提供时间戳, 复位后立即同步
+
+    lowPowerWakeSecond = 0;
+    if (__HAL_PWR_GET_FLAG(PWR_FLAG_SB) != RESET)
+    {
+        __HAL_PWR_CLEAR_FLAG(PWR_FLAG_SB);
+        if (__HAL_RTC_ALARM_GET_FLAG(&hrtc, RTC_FLAG_ALRAF) != RESET) // 运动(WKUP引脚)唤醒不在秒边界, 不测量
+        {
+            lowPowerWakeSecond = RTC_GetCounterMs(&millis);
+        }
+    }
+    PROFILE_SleepEnd();
+}
+
+/**
+ * @brief 初始化完成, 记录STANDBY唤醒的重新初始化耗时
+ * @details 在main中全部模块初始化之后调用。RTC闹钟在秒边界唤醒芯片, 因此当前RTC时间减去唤醒所在的
+ *          秒即为唤醒、复位、分散加载和各模块重新初始化的总耗时, 即STANDBY模式相对STOP模式多付出的时间;
+ *          将其以指数滑动平均的方式记录到备份寄存器中, 供休眠策略计算切换点。
+ *          GNSS和NB-IoT模块在每个上报周期都重新初始化, 与休眠模式无关, 不计入。
+ */
+void LOWPOWER_InitDone(void)
+{
+    uint16_t millis;
+    uint32_t us;
+    uint32_t average;
+
+    if (lowPowerWakeSecond == 0)
+    {
+        return;
+    }
+
+    us = ((RTC_GetCounterMs(&millis) - lowPowerWakeSecond) * 1000 + millis) * 1000;
+    average = PWR_ReadBackup(PWR_BKP_REINIT_TIME);
+    average = (average == 0) ? us / 100 : (average * 3 + us / 100) / 4;
+    PWR_WriteBackup(PWR_BKP_REINIT_TIME, (uint16_t)((average > 0xFFFF) ? 0xFFFF : average));
+    lowPowerWakeSecond = 0;
+
+    DEBUG_Info("Reinit after STANDBY: %lu us\r\n", us);
+}
+
+/**
+ * @brief 计算STOP与STANDBY模式的切换点
+ * @details STANDBY唤醒需要复位并重新初始化，额外能耗为 I_run * t_reinit；
+ *          STOP模式保持SRAM但漏电流更大，额外能耗为 (I_stop - I_standby) * T。
+ *          休眠时长 T 小于 I_run * t_reinit / (I_stop - I_standby) 时STOP模式更省电。
+ * @retval 切换点(秒)
+ */
+uint32_t LOWPOWER_GetCrossoverSeconds(void)
+{
+    uint64_t charge = (uint64_t)LOWPOWER_RUN_CURRENT_UA * LOWPOWER_GetReinitTime(); // 重新初始化电荷(uA*us)
+
+    return (uint32_t)(charge / (LOWPOWER_STOP_CURRENT_UA - LOWPOWER_STANDBY_CURRENT_UA) / 1000000);
+}
+
+/**
+ * @brief 根据休眠时长选择低功耗模式
+ * @param seconds 休眠时长(秒)
+ * @retval LOWPOWER_MODE_STOP 或 LOWPOWER_MODE_STANDBY
+ */
+LowPowerModeTypeDef LOWPOWER_SelectMode(uint32_t seconds)
+{
+    if (SHELL_IsActive())
+    {
+        return LOWPOWER_MODE_STOP; // STANDBY下调试串口无法唤醒
+    }
+    return (seconds < LOWPOWER_GetCrossoverSeconds()) ? LOWPOWER_MODE_STOP : LOWPOWER_MODE_STANDBY;
+}
+
+/**
+ * @brief 以STOP模式等待seconds秒, 不改变外设模块状态
+ * @details 用于周期内的短暂等待(如等待TDMA时隙), 由RTC闹钟唤醒后恢复时钟返回, 不进入STANDBY。
+ *          闹钟在秒边界触发, 实际等待时间为seconds-1到seconds秒。
+ * @param seconds 等待时长(秒)
+ */
+void LOWPOWER_StopFor(uint32_t seconds)
+{
+    if (seconds == 0)
+    {
+        return;
+    }
+
+    RTC_SetAlarm(seconds);
+    DEBUG_Flush();
+
+    HAL_SuspendTick();
+    while (rtcAlarmFlag == 0)
+    {
+        HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+    }
+    HAL_ResumeTick();
+    CLOCK_Resume();
+}
+
+/**
+ * @brief 让本周期唤醒过的外设模块进入低功耗
+ * @note  未唤醒的模块串口未初始化, 不能发送AT命令
+ */
+void LOWPOWER_SleepModules(void)
+{
+    if (lowPowerAwakeModules & LOWPOWER_MODULE_QS100)
+    {
+        QS100_EnterLowPowerMode();
+    }
+    if (lowPowerAwakeModules & LOWPOWER_MODULE_AT6558R)
+    {
+        AT6558R_EnterLowPowerMode();
+    }
+    lowPowerAwakeModules = 0;
+}
+
+/**
+ * @brief 获取本周期已唤醒的外设模块 LowPowerModuleTypeDef
+ */
+uint8_t LOWPOWER_GetAwakeModules(void)
+{
+    return lowPowerAwakeModules;
+}
+
+/**
+ * @brief 关闭外设模块并进入低功耗模式，seconds秒后由RTC闹钟唤醒
+ * @details 所有休眠路径的统一入口。短休眠使用STOP模式，唤醒后恢复时钟并从本函数返回；
+ *          长休眠使用STANDBY模式，唤醒后系统复位。进入前先执行调试命令行已收到的命令。
+ * @param seconds 休眠时长(秒)
+ */
+void LOWPOWER_EnterLowPower(uint32_t seconds)
+{
+    if (SHELL_Poll())
+    {
+        return; // 命令行请求立即上报
+    }
+    LOWPOWER_SleepModules();
+
+    RTC_SetAlarm(seconds); // 设置seconds秒后唤醒
+    LOWPOWER_ConfigMotionWakeup();
+    PROFILE_SleepBegin();
+
+    if (LOWPOWER_SelectMode(seconds) == LOWPOWER_MODE_STOP)
+    {
+        LOWPOWER_EnterStop();
+    }
+    else
+    {
+        LOWPOWER_EnterStandby();
+    }
 }
 
 void LOWPOWER_Wakeup(void)
 {
-    QS100_Wakeup();
-    AT6558R_Wakeup();
-    DEBUG_Printf("Wake up from Low Power Mode\r\n");
-}
\ No newline at end of file
+    LOWPOWER_WakeupModules(LOWPOWER_MODULE_ALL);
+}
+
+/**
+ * @brief 唤醒指定的外设模块
+ * @param modules LowPowerModuleTypeDef 的组合
+ */
+void LOWPOWER_WakeupModules(uint8_t modules)
+{
+    if (modules & LOWPOWER_MODULE_QS100)
+    {
+        QS100_Wakeup();
+    }
+    if (modules & LOWPOWER_MODULE_AT6558R)
+    {
+        AT6558R_Wakeup();
+    }
+    lowPowerAwakeModules |= modules;
+    DEBUG_Info("Wake up from Low Power Mode\r\n");
+}
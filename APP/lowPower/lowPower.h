@@ -6,8 +6,32 @@
 #include "ds3553/ds3553.h"
 #include "rtc/rtc.h"
 #include "pwr/pwr.h"
+#include "CLOCK/clock.h"
+#include "persist/persist.h"
+#include "shell/shell.h"
 
+typedef enum
+{
+    LOWPOWER_MODE_STOP = 0,     // STOP模式: 保持SRAM, 微秒级唤醒
+    LOWPOWER_MODE_STANDBY,      // STANDBY模式: 最低漏电, 唤醒后复位
+} LowPowerModeTypeDef;
+
+typedef enum
+{
+    LOWPOWER_MODULE_QS100 = 0x01,   // NB-IoT模块
+    LOWPOWER_MODULE_AT6558R = 0x02, // GNSS模块
+    LOWPOWER_MODULE_ALL = 0x03,
+} LowPowerModuleTypeDef;
+
+void LOWPOWER_Init(void);
+void LOWPOWER_InitDone(void);
+uint32_t LOWPOWER_GetCrossoverSeconds(void);
+LowPowerModeTypeDef LOWPOWER_SelectMode(uint32_t seconds);
+void LOWPOWER_StopFor(uint32_t seconds);
+void LOWPOWER_SleepModules(void);
+uint8_t LOWPOWER_GetAwakeModules(void);
 void LOWPOWER_EnterLowPower(uint32_t seconds);
 void LOWPOWER_Wakeup(void);
+void LOWPOWER_WakeupModules(uint8_t modules);
 
 #endif
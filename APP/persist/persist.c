@@ -0,0 +1,233 @@
+#include "persist/persist.h"
+
+/*
+ * 页格式: [魔数(2) | 页序号(2) | 记录 ...], 未写区域为0xFF
+ * 记录格式: [键(2) | 长度(2) | 数据(长度, 补齐到偶数) | 校验和(2)]
+ */
+#define PERSIST_PAGE_ADDR(page)     (PERSIST_BASE + (page) * FLASH_PAGE_SIZE)
+#define PERSIST_HEADER_SIZE         4
+#define PERSIST_RECORD_SIZE(len)    (4 + (((len) + 1) & ~1U) + 2)
+#define PERSIST_KEY_FREE            0xFFFF
+
+typedef struct
+{
+    uint16_t key;   // 键
+    void *data;     // 数据所在的RAM地址
+    uint16_t len;   // 数据长度
+    uint8_t lazy;   // 1 表示统计数据, 距上次写入不足PERSIST_LAZY_INTERVAL时不写入
+} PersistItemTypeDef;
+
+typedef struct
+{
+    uint32_t lazyTime;  // 上次写入统计数据项时的RTC计数
+} PersistStateTypeDef;
+
+static PersistStateTypeDef persistState = {0};
+
+/* 需要掉电保持的数据项(键, 全局变量, 是否为统计数据), 数据本身由各模块以全局变量持有 */
+#define PERSIST_ITEMS(X)                            \
+    X(PERSIST_KEY_PROFILE, profileStats, 1)         \
+    X(PERSIST_KEY_POLICY, policyState, 0)           \
+    X(PERSIST_KEY_DS3553, ds3553Shadow, 0)          \
+    X(PERSIST_KEY_LORA, loraShadow, 0)              \
+    X(PERSIST_KEY_ADR, adrState, 0)                 \
+    X(PERSIST_KEY_LORA_DUTY, loraDuty, 0)           \
+    X(PERSIST_KEY_TDMA, tdmaState, 0)               \
+    X(PERSIST_KEY_LORAWAN, lorawanSession, 0)       \
+    X(PERSIST_KEY_TRANSPORT, transportState, 0)     \
+    X(PERSIST_KEY_LOG, logConfig, 0)                \
+    X(PERSIST_KEY_POLICY_CONFIG, policyConfig, 0)   \
+    X(PERSIST_KEY_MEMORY, memoryStats, 1)           \
+    X(PERSIST_KEY_PERSIST, persistState, 1)         \
+    X(PERSIST_KEY_PROFILE_SLEEP, profileSleepStart, 0)
+
+#define PERSIST_ITEM_ENTRY(key, var, lazy)  {key, &var, sizeof(var), lazy},
+#define PERSIST_ITEM_SIZE(key, var, lazy)   + PERSIST_RECORD_SIZE(sizeof(var))
+
+static const PersistItemTypeDef persistItems[] = {
+    PERSIST_ITEMS(PERSIST_ITEM_ENTRY)
+};
+
+#define PERSIST_ITEM_NUM (sizeof(persistItems) / sizeof(persistItems[0]))
+
+/* 编译期检查: 新页中的全部数据项快照必须能放入一页 */
+typedef char PersistSnapshotCheck[(PERSIST_HEADER_SIZE PERSIST_ITEMS(PERSIST_ITEM_SIZE) <= FLASH_PAGE_SIZE) ? 1 : -1];
+
+static int8_t persistPage = -1;                 /* 当前写入页, -1表示尚无有效页 */
+static uint16_t persistSeq = 0;                 /* 当前写入页的序号 */
+static uint32_t persistAddr = 0;                /* 下一条记录的写入地址 */
+static uint32_t persistRecord[PERSIST_ITEM_NUM]; /* 各数据项最新记录的数据地址, 0表示无记录 */
+
+static uint16_t PERSIST_Checksum(uint16_t key, const uint8_t *data, uint16_t len)
+{
+    uint16_t sum = key + len;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        sum = (uint16_t)((sum << 1) | (sum >> 15)) + data[i];
+    }
+    return sum;
+}
+
+static int8_t PERSIST_FindItem(uint16_t key)
+{
+    uint8_t i;
+
+    for (i = 0; i < PERSIST_ITEM_NUM; i++)
+    {
+        if (persistItems[i].key == key)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 回放一页中的记录到RAM
+ * @retval 页内第一个空闲地址; 遇到损坏的记录(写入时掉电)返回页尾, 使该页不再写入
+ */
+static uint32_t PERSIST_ReplayPage(uint8_t page)
+{
+    uint32_t addr = PERSIST_PAGE_ADDR(page) + PERSIST_HEADER_SIZE;
+    uint32_t end = PERSIST_PAGE_ADDR(page) + FLASH_PAGE_SIZE;
+
+    while (addr + PERSIST_RECORD_SIZE(0) <= end)
+    {
+        uint16_t key = *(__IO uint16_t *)addr;
+        uint16_t len = *(__IO uint16_t *)(addr + 2);
+        const uint8_t *data = (const uint8_t *)(addr + 4);
+
+        if (key == PERSIST_KEY_FREE)
+        {
+            return addr;
+        }
+        if (addr + PERSIST_RECORD_SIZE(len) > end ||
+            *(__IO uint16_t *)(addr + PERSIST_RECORD_SIZE(len) - 2) != PERSIST_Checksum(key, data, len))
+        {
+            return end;
+        }
+
+        int8_t item = PERSIST_FindItem(key);
+        if (item >= 0 && persistItems[item].len == len) /* 长度不符说明结构体已改变, 丢弃旧数据 */
+        {
+            memcpy(persistItems[item].data, data, len);
+            persistRecord[item] = (uint32_t)data;
+        }
+        addr += PERSIST_RECORD_SIZE(len);
+    }
+    return end;
+}
+
+static void PERSIST_WriteRecord(uint8_t item)
+{
+    const PersistItemTypeDef *p = &persistItems[item];
+    uint16_t header[2] = {p->key, p->len};
+    uint16_t checksum = PERSIST_Checksum(p->key, p->data, p->len);
+
+    FLASH_Write(persistAddr, header, sizeof(header));
+    FLASH_Write(persistAddr + 4, p->data, p->len);
+    FLASH_Write(persistAddr + PERSIST_RECORD_SIZE(p->len) - 2, &checksum, sizeof(checksum));
+
+    persistRecord[item] = persistAddr + 4;
+    persistAddr += PERSIST_RECORD_SIZE(p->len);
+}
+
+/**
+ * @brief 擦除下一页并写入全部数据项的快照
+ */
+static void PERSIST_NextPage(void)
+{
+    uint16_t header[2];
+    uint8_t i;
+
+    persistPage = (persistPage + 1) % PERSIST_PAGE_NUM;
+    persistSeq++;
+    header[0] = PERSIST_MAGIC;
+    header[1] = persistSeq;
+
+    FLASH_Erase(PERSIST_PAGE_ADDR(persistPage));
+    FLASH_Write(PERSIST_PAGE_ADDR(persistPage), header, sizeof(header));
+    persistAddr = PERSIST_PAGE_ADDR(persistPage) + PERSIST_HEADER_SIZE;
+
+    for (i = 0; i < PERSIST_ITEM_NUM; i++)
+    {
+        PERSIST_WriteRecord(i);
+    }
+}
+
+/**
+ * @brief 从Flash恢复全部数据项
+ * @details 找到序号最新的页, 从其后一页(最旧)开始依次回放, 后写入的记录覆盖先写入的。
+ *          未找到有效页时各数据项保持初值。
+ */
+void PERSIST_Init(void)
+{
+    uint8_t i;
+
+    persistPage = -1;
+    for (i = 0; i < PERSIST_PAGE_NUM; i++)
+    {
+        uint16_t magic = *(__IO uint16_t *)PERSIST_PAGE_ADDR(i);
+        uint16_t seq = *(__IO uint16_t *)(PERSIST_PAGE_ADDR(i) + 2);
+
+        if (magic == PERSIST_MAGIC && (persistPage < 0 || (int16_t)(seq - persistSeq) > 0))
+        {
+            persistPage = i;
+            persistSeq = seq;
+        }
+    }
+    if (persistPage < 0)
+    {
+        return;
+    }
+
+    for (i = 1; i <= PERSIST_PAGE_NUM; i++)
+    {
+        uint8_t page = (persistPage + i) % PERSIST_PAGE_NUM;
+
+        if (*(__IO uint16_t *)PERSIST_PAGE_ADDR(page) == PERSIST_MAGIC)
+        {
+            persistAddr = PERSIST_ReplayPage(page);
+        }
+    }
+}
+
+/**
+ * @brief 将内容有变化的数据项写入Flash
+ * @note  与最新记录逐字节比较, 未变化的数据项不写入, 以减少Flash擦写次数。
+ *        每个周期都变化的统计数据(性能统计、内存水位)距上次写入不少于PERSIST_LAZY_INTERVAL才写入,
+ *        其间STANDBY唤醒后从上次写入的值继续累计, 即统计按该间隔抽样; 换页时的快照仍包含全部数据项。
+ */
+void PERSIST_Flush(void)
+{
+    uint32_t now = RTC_GetCounter();
+    uint8_t lazyDue = (now - persistState.lazyTime >= PERSIST_LAZY_INTERVAL) || now < persistState.lazyTime;
+    uint8_t i;
+
+    if (lazyDue)
+    {
+        persistState.lazyTime = now;    /* 时间倒退(重新授时)时也重新计时 */
+    }
+
+    for (i = 0; i < PERSIST_ITEM_NUM; i++)
+    {
+        const PersistItemTypeDef *p = &persistItems[i];
+
+        if (persistRecord[i] != 0 && memcmp((const void *)persistRecord[i], p->data, p->len) == 0)
+        {
+            continue;
+        }
+        if (p->lazy && persistRecord[i] != 0 && !lazyDue)
+        {
+            continue;
+        }
+        if (persistPage < 0 || persistAddr + PERSIST_RECORD_SIZE(p->len) > PERSIST_PAGE_ADDR(persistPage) + FLASH_PAGE_SIZE)
+        {
+            PERSIST_NextPage(); /* 新页中写入全部数据项 */
+            return;
+        }
+        PERSIST_WriteRecord(i);
+    }
+}
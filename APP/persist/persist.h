@@ -0,0 +1,52 @@
+#ifndef __PERSIST_H__
+#define __PERSIST_H__
+
+#include "sys/sys.h"
+#include "string.h"
+#include "FLASH/flash.h"
+#include "Profile/profile.h"
+#include "policy/policy.h"
+#include "ds3553/ds3553.h"
+#include "LoRa/lora.h"
+#include "adr/adr.h"
+#include "tdma/tdma.h"
+#include "lorawan/lorawan.h"
+#include "transport/transport.h"
+#include "Log/log.h"
+#include "Memory/memory.h"
+
+/**
+ * Flash末尾4KB(4页)作为掉电保持区, 按日志方式追加记录, 写满一页后擦除下一页继续写,
+ * 并在新页写入全部数据项的快照, 因此最旧的页可以随时擦除。工程的IROM大小相应减为0xF000。
+ * 全部数据项的快照需小于一页(编译期检查); 只在进入STANDBY前写入有变化的数据项, 以控制擦写次数。
+ * 性能统计(约270字节)每个周期都变化, 每次写入会使页在约两次休眠后写满; 统计数据项因此按
+ * PERSIST_LAZY_INTERVAL限速写入, 其余数据项每次变化约20~50字节, 一页可容纳十余次写入。
+ */
+#define PERSIST_BASE        0x0800F000
+#define PERSIST_PAGE_NUM    4
+#define PERSIST_MAGIC       0x5053      /* 页头标记"PS" */
+#define PERSIST_LAZY_INTERVAL   3600    /* 统计数据项的最短写入间隔(RTC秒) */
+
+typedef enum
+{
+    PERSIST_KEY_PROFILE = 1,    // 性能统计 profileStats
+    PERSIST_KEY_POLICY,         // 上报策略状态 policyState
+    PERSIST_KEY_DS3553,         // DS3553寄存器影子 ds3553Shadow
+    PERSIST_KEY_LORA,           // LLCC68配置影子 loraShadow
+    PERSIST_KEY_ADR,            // 自适应速率状态 adrState
+    PERSIST_KEY_LORA_DUTY,      // 占空比额度 loraDuty
+    PERSIST_KEY_TDMA,           // TDMA同步状态 tdmaState
+    PERSIST_KEY_LORAWAN,        // LoRaWAN会话 lorawanSession
+    PERSIST_KEY_TRANSPORT,      // 链路选择估计值 transportState
+    PERSIST_KEY_LOG,            // 运行时日志级别 logConfig
+    PERSIST_KEY_POLICY_CONFIG,  // 上报策略参数 policyConfig
+    PERSIST_KEY_MEMORY,         // 内存水位 memoryStats
+    PERSIST_KEY_PERSIST,        // 本模块状态(统计数据项上次写入时间)
+    PERSIST_KEY_PROFILE_SLEEP,  // 休眠开始时刻 profileSleepStart, 每次进入STANDBY都要写入
+    PERSIST_KEY_NUM,
+} PersistKeyTypeDef;
+
+void PERSIST_Init(void);
+void PERSIST_Flush(void);
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file policy.c
+ * @brief 上报策略: 根据运动状态、电池电压和网络代价选择下一次上报间隔和GNSS输出频率
+ *
+ * 每个上报周期结束后调用 POLICY_Update()：
+ *  - RMC 速度不低于 POLICY_VEHICLE_SPEED 判为车载，步数增量不低于 POLICY_WALKING_STEPS 判为步行；
+ *  - 连续 POLICY_STILL_CYCLES 个周期既无速度也无步数才转为静止，避免在红绿灯等短暂停留时来回切换；
+ *  - 静止模式下间隔从步行间隔开始逐次加倍，直到静止模式间隔上限；
+ *  - 电池电压低于 POLICY_BATTERY_LOW_MV 或网络代价高(附着耗时长、重试多)时间隔各加倍，
+ *    最终不超过间隔上限。
+ * 各模式间隔、间隔上限和GNSS输出周期保存在 policyConfig 中，默认取 POLICY_*_INTERVAL，
+ * 可经调试命令行修改，掉电保持。
+ *
+ * 唤醒后读取步数即调用 POLICY_Gate()：静止模式下步数增量不足时跳过 GNSS 定位，
+ * 被跳过的周期不更新步数基准，增量跨周期累计。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LOCATION
+
+#include "policy/policy.h"
+
+extern LocationDataTypeDef locationData;
+
+PolicyStateTypeDef policyState = {0};
+PolicyConfigTypeDef policyConfig = {0};
+
+static const PolicyConfigTypeDef policyDefaults = {
+    {POLICY_STATIONARY_INTERVAL, POLICY_WALKING_INTERVAL, POLICY_VEHICLE_INTERVAL},
+    POLICY_MAX_INTERVAL,
+    {1000, 1000, 500},  // 静止、步行1Hz, 车载2Hz
+    POLICY_CONFIG_VALID,
+    0,
+};
+
+static const char *const policyName[POLICY_PROFILE_NUM] = {"stationary", "walking", "vehicle"};
+
+static uint8_t policyGated = 0; /* 本周期是否被运动门控跳过定位 */
+
+/**
+ * @brief 恢复默认策略参数
+ */
+void POLICY_ResetConfig(void)
+{
+    policyConfig = policyDefaults;
+}
+
+/**
+ * @brief 策略参数初始化
+ * @note  需在PERSIST_Init()之后调用, 未保存过参数时取默认值
+ */
+void POLICY_Init(void)
+{
+    if (policyConfig.valid != POLICY_CONFIG_VALID)
+    {
+        POLICY_ResetConfig();
+    }
+}
+
+/**
+ * @brief 计算自上次完整上报以来的步数增量
+ */
+static uint32_t POLICY_GetStepDelta(void)
+{
+    uint32_t steps = locationData.steps;
+
+    return (steps >= policyState.lastSteps) ? steps - policyState.lastSteps : steps; /* 计步芯片掉电后从0计数 */
+}
+
+/**
+ * @brief 当前是否处于静止模式
+ * @retval 1 已连续静止 POLICY_STILL_CYCLES 个周期; 0 其他
+ */
+uint8_t POLICY_IsStationary(void)
+{
+    return (policyState.profile == POLICY_PROFILE_STATIONARY && policyState.stillCycles >= POLICY_STILL_CYCLES);
+}
+
+/**
+ * @brief 运动门控: 根据唤醒后读取的步数决定本周期的动作
+ * @note 需在 locationData.steps 更新后调用
+ * @retval POLICY_ACTION_REPORT / POLICY_ACTION_HEARTBEAT / POLICY_ACTION_SKIP
+ */
+PolicyActionTypeDef POLICY_Gate(void)
+{
+    policyGated = 0;
+
+#ifdef MOTION_GATE_ENABLE
+    if (POLICY_IsStationary() && POLICY_GetStepDelta() < POLICY_WALKING_STEPS)
+    {
+        policyGated = 1;
+        policyState.gatedCycles++;
+        if (MOTION_HEARTBEAT_CYCLES != 0 && policyState.gatedCycles >= MOTION_HEARTBEAT_CYCLES)
+        {
+            policyState.gatedCycles = 0;
+            return POLICY_ACTION_HEARTBEAT;
+        }
+        return POLICY_ACTION_SKIP;
+    }
+#endif
+
+    policyState.gatedCycles = 0;
+    return POLICY_ACTION_REPORT;
+}
+
+/**
+ * @brief 根据运动状态选择模式
+ * @param hasFix 本周期是否获取到有效定位(速度有效)
+ * @param stepDelta 本周期步数增量
+ */
+static PolicyProfileTypeDef POLICY_SelectProfile(uint8_t hasFix, uint32_t stepDelta)
+{
+    if (hasFix && locationData.speed >= POLICY_VEHICLE_SPEED)
+    {
+        policyState.stillCycles = 0;
+        return POLICY_PROFILE_VEHICLE;
+    }
+    if (stepDelta >= POLICY_WALKING_STEPS)
+    {
+        policyState.stillCycles = 0;
+        return POLICY_PROFILE_WALKING;
+    }
+
+    if (policyState.stillCycles < POLICY_STILL_CYCLES)
+    {
+        policyState.stillCycles++;
+        return (PolicyProfileTypeDef)policyState.profile; /* 保持原模式 */
+    }
+    return POLICY_PROFILE_STATIONARY;
+}
+
+/**
+ * @brief 更新策略并返回下一次上报间隔
+ * @param hasFix 本周期是否获取到有效定位
+ * @retval 下一次上报间隔(秒)
+ */
+uint32_t POLICY_Update(uint8_t hasFix)
+{
+    uint32_t stepDelta = POLICY_GetStepDelta();
+    PolicyProfileTypeDef profile = POLICY_SelectProfile(hasFix, stepDelta);
+    uint32_t interval = policyConfig.interval[profile];
+    uint16_t vdd;
+
+    if (profile == POLICY_PROFILE_STATIONARY)
+    {
+        /* 静止时间隔逐次加倍 */
+        interval = policyState.interval * 2;
+        if (interval < policyConfig.interval[POLICY_PROFILE_WALKING])
+        {
+            interval = policyConfig.interval[POLICY_PROFILE_WALKING];
+        }
+        if (interval > policyConfig.interval[POLICY_PROFILE_STATIONARY])
+        {
+            interval = policyConfig.interval[POLICY_PROFILE_STATIONARY];
+        }
+    }
+    policyState.profile = profile;
+    if (policyGated == 0)
+    {
+        policyState.lastSteps = locationData.steps;
+    }
+    policyState.interval = interval;
+
+    /* 电池电压低时降低上报频率 */
+    ADC1_Init();
+    vdd = ADC1_ReadVdd();
+    if (vdd != 0 && vdd < POLICY_BATTERY_LOW_MV)
+    {
+        interval *= 2;
+    }
+
+    /* 网络代价高时降低上报频率 */
+    if (qs100LinkStats.attachTime > POLICY_LINK_SLOW_MS || qs100LinkStats.retries > POLICY_LINK_RETRIES)
+    {
+        interval *= 2;
+    }
+
+    if (interval > policyConfig.maxInterval)
+    {
+        interval = policyConfig.maxInterval;
+    }
+
+    DEBUG_Info("Policy: %s, steps +%lu, speed %.1f km/h, vdd %u mV, attach %lu ms, retries %u -> %lu s\r\n",
+               policyName[profile], stepDelta, hasFix ? locationData.speed : 0.0f, vdd,
+               qs100LinkStats.attachTime, qs100LinkStats.retries, interval);
+    return interval;
+}
+
+/**
+ * @brief 获取当前模式的GNSS输出频率命令
+ */
+char *POLICY_GetGnssFrequency(void)
+{
+    static char command[16];
+
+    sprintf(command, "PCAS02,%u", policyConfig.gnssPeriod[policyState.profile]);
+    return command;
+}
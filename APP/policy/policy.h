@@ -0,0 +1,57 @@
+#ifndef __POLICY_H__
+#define __POLICY_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "ADC/adc.h"
+#include "at6558r/at6558r.h"
+#include "qs100/qs100.h"
+
+typedef enum
+{
+    POLICY_PROFILE_STATIONARY = 0,  // 静止: 上报间隔逐次加倍至上限
+    POLICY_PROFILE_WALKING,         // 步行: 由步数增量判断
+    POLICY_PROFILE_VEHICLE,         // 车载: 由RMC速度判断
+    POLICY_PROFILE_NUM,
+} PolicyProfileTypeDef;
+
+typedef enum
+{
+    POLICY_ACTION_REPORT = 0,       // 完整上报: GNSS定位并发送
+    POLICY_ACTION_HEARTBEAT,        // 心跳: 不定位, 发送不含坐标的数据
+    POLICY_ACTION_SKIP,             // 跳过: 不唤醒任何模块
+} PolicyActionTypeDef;
+
+#define POLICY_CONFIG_VALID     0xA5    /* 掉电保持的策略参数有效标记 */
+
+/* 策略参数, 默认取 user_config.h, 可经调试命令行修改并由persist模块掉电保持 */
+typedef struct
+{
+    uint32_t interval[POLICY_PROFILE_NUM];      // 各模式上报间隔(秒), 静止模式为逐次加倍的上限
+    uint32_t maxInterval;                       // 叠加电池和网络因素后的间隔上限(秒)
+    uint16_t gnssPeriod[POLICY_PROFILE_NUM];    // 各模式GNSS输出周期(ms): 100/200/250/500/1000
+    uint8_t valid;                              // POLICY_CONFIG_VALID 表示已初始化
+    uint8_t reserved;
+} PolicyConfigTypeDef;
+
+/* 策略状态, 由persist模块掉电保持 */
+typedef struct
+{
+    uint32_t lastSteps;     // 上一周期的步数
+    uint32_t interval;      // 当前上报间隔(秒)
+    uint8_t profile;        // 当前模式 PolicyProfileTypeDef
+    uint8_t stillCycles;    // 连续静止的周期数
+    uint8_t gatedCycles;    // 运动门控连续跳过定位的周期数
+} PolicyStateTypeDef;
+
+extern PolicyStateTypeDef policyState;
+extern PolicyConfigTypeDef policyConfig;
+
+void POLICY_Init(void);
+void POLICY_ResetConfig(void);
+PolicyActionTypeDef POLICY_Gate(void);
+uint8_t POLICY_IsStationary(void);
+uint32_t POLICY_Update(uint8_t hasFix);
+char *POLICY_GetGnssFrequency(void);
+
+#endif
@@ -0,0 +1,467 @@
+/**
+ * @file shell.c
+ * @brief USART1调试命令行: 查看统计、修改上报策略、操作GNSS和NB-IoT模块、读写掉电保持的参数
+ *
+ * 接收中断(RXNE)逐字节收取到行缓冲区，收到回车或换行后交给线程执行，中断中不执行命令。
+ * 命令只在两处执行，主流程不因命令行而等待：
+ *  - 每次进入低功耗前(LOWPOWER_EnterLowPower)调用 SHELL_Poll()；
+ *  - STOP模式下RX引脚(PA10)的下降沿经EXTI10唤醒MCU，SHELL_Session() 以WFI等待输入并执行命令，
+ *    SHELL_IDLE_MS 内无输入后返回，继续休眠到原定的RTC闹钟。唤醒字符在时钟恢复前到达，会丢失。
+ * STANDBY模式下串口无法唤醒，最近一条命令后 SHELL_SESSION_S 秒内以STOP模式代替STANDBY。
+ * 回复以文本经printf输出，使能LOG_BINARY时与二进制日志帧交错，log_decode.py原样输出。
+ */
+
+#include "shell/shell.h"
+#include "location/location.h"
+#include "persist/persist.h"
+#include "Profile/profile.h"
+
+#ifdef SHELL_ENABLE
+
+typedef struct
+{
+    const char *name;                                   // 命令名
+    void (*handler)(uint8_t argc, char **argv);         // 处理函数, argv[0]为命令名
+    const char *help;                                   // 帮助信息
+} ShellCommandTypeDef;
+
+/* 可经 get/set 读写的掉电保持参数 */
+typedef struct
+{
+    const char *name;       // 参数名
+    void *value;            // 参数地址
+    uint8_t size;           // 参数字节数: 1/2/4
+    uint32_t min;           // 取值下限
+    uint32_t max;           // 取值上限
+} ShellVariableTypeDef;
+
+static const ShellVariableTypeDef shellVariables[] = {
+    {"still", &policyConfig.interval[POLICY_PROFILE_STATIONARY], 4, 10, 86400},
+    {"walk", &policyConfig.interval[POLICY_PROFILE_WALKING], 4, 10, 86400},
+    {"vehicle", &policyConfig.interval[POLICY_PROFILE_VEHICLE], 4, 10, 86400},
+    {"max", &policyConfig.maxInterval, 4, 10, 86400},
+    {"gnss.still", &policyConfig.gnssPeriod[POLICY_PROFILE_STATIONARY], 2, 100, 1000},
+    {"gnss.walk", &policyConfig.gnssPeriod[POLICY_PROFILE_WALKING], 2, 100, 1000},
+    {"gnss.vehicle", &policyConfig.gnssPeriod[POLICY_PROFILE_VEHICLE], 2, 100, 1000},
+    {"logmask", &logConfig.mask, 1, 0, 0xFF},
+};
+
+#define SHELL_VARIABLE_NUM (sizeof(shellVariables) / sizeof(shellVariables[0]))
+
+static char shellRx[SHELL_LINE_MAX];            /* 中断中接收的行 */
+static volatile uint8_t shellRxLength = 0;
+static char shellLine[SHELL_LINE_MAX];          /* 待执行的命令行 */
+static volatile uint8_t shellLineReady = 0;     /* 1 表示shellLine待执行, 执行完之前丢弃新的命令行 */
+static volatile uint32_t shellRxTick = 0;       /* 最近一次收到字符的HAL tick */
+static uint32_t shellActive = 0;                /* 最近一条命令的RTC计数, 0表示无会话 */
+static uint8_t shellReport = 0;                 /* 1 表示请求立即上报 */
+
+static void SHELL_CmdHelp(uint8_t argc, char **argv);
+
+/**
+ * @brief 输出当前统计: 各阶段耗时、内存水位、网络代价、日志丢弃数和本节点角色的LoRa统计
+ */
+static void SHELL_CmdStats(uint8_t argc, char **argv)
+{
+    PROFILE_Print();
+    MEMORY_Print();
+    printf("QS100,attach %lu ms,retries %u\r\n", qs100LinkStats.attachTime, qs100LinkStats.retries);
+    printf("LOG,dropped %lu\r\n", LOG_GetDropped());
+#if NODE_ROLE == NODE_ROLE_LEAF || defined(TRANSPORT_ENABLE)
+    printf("LINK,tx,%lu,%lu,%lu,%lu\r\n", loraLinkStats.sent, loraLinkStats.acked,
+           loraLinkStats.retries, loraLinkStats.failed);
+    printf("ADR,SF%u,%ddBm\r\n", adrState.sf, adrState.txDbm);
+#elif NODE_ROLE == NODE_ROLE_GATEWAY
+    printf("GW,rx %lu,dup %lu,invalid %lu,overflow %lu,forwarded %lu,batches %lu\r\n", gatewayStats.received,
+           gatewayStats.duplicates, gatewayStats.invalid, gatewayStats.overflow, gatewayStats.forwarded,
+           gatewayStats.batches);
+#elif NODE_ROLE == NODE_ROLE_LORAWAN
+    printf("LORAWAN,%08lX,up %lu,down %lu\r\n", lorawanSession.devAddr, lorawanSession.fCntUp,
+           lorawanSession.fCntDown);
+#endif
+#ifdef TRANSPORT_ENABLE
+    {
+        uint8_t i;
+
+        for (i = 0; i < TRANSPORT_LINK_NUM; i++)
+        {
+            TransportLinkStatsTypeDef *link = &transportState.link[i];
+
+            printf("XPORT,%u,%lu uJ/B,%lu ms,%lu/%lu failed,success %u/256\r\n", i, link->energyPerByte,
+                   link->latencyMs, link->failures, link->attempts, link->success);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief 输出一个参数
+ */
+static void SHELL_PrintVariable(const ShellVariableTypeDef *var)
+{
+    uint32_t value = 0;
+
+    memcpy(&value, var->value, var->size);
+    printf("%s = %lu\r\n", var->name, value);
+}
+
+/**
+ * @brief get [参数名]: 输出全部或指定的参数, 以及当前策略状态
+ */
+static void SHELL_CmdGet(uint8_t argc, char **argv)
+{
+    uint8_t i;
+
+    for (i = 0; i < SHELL_VARIABLE_NUM; i++)
+    {
+        if (argc < 2 || strcmp(argv[1], shellVariables[i].name) == 0)
+        {
+            SHELL_PrintVariable(&shellVariables[i]);
+        }
+    }
+    if (argc < 2)
+    {
+        printf("profile %u, interval %lu s, still cycles %u\r\n", policyState.profile, policyState.interval,
+               policyState.stillCycles);
+    }
+}
+
+/**
+ * @brief set <参数名> <值>: 修改参数, 进入STANDBY前或执行save时写入Flash
+ */
+static void SHELL_CmdSet(uint8_t argc, char **argv)
+{
+    const ShellVariableTypeDef *var = NULL;
+    uint32_t value;
+    char *end;
+    uint8_t i;
+
+    if (argc < 3)
+    {
+        printf("usage: set <name> <value>\r\n");
+        return;
+    }
+    for (i = 0; i < SHELL_VARIABLE_NUM; i++)
+    {
+        if (strcmp(argv[1], shellVariables[i].name) == 0)
+        {
+            var = &shellVariables[i];
+        }
+    }
+    if (var == NULL)
+    {
+        printf("unknown name: %s\r\n", argv[1]);
+        return;
+    }
+
+    value = strtoul(argv[2], &end, 0);
+    if (*end != '\0' || value < var->min || value > var->max)
+    {
+        printf("%s: %lu..%lu\r\n", var->name, var->min, var->max);
+        return;
+    }
+    memcpy(var->value, &value, var->size); // 小端, 取低位字节
+    SHELL_PrintVariable(var);
+}
+
+/**
+ * @brief save: 立即把有变化的掉电保持数据写入Flash
+ */
+static void SHELL_CmdSave(uint8_t argc, char **argv)
+{
+    PERSIST_Flush();
+    printf("saved\r\n");
+}
+
+/**
+ * @brief defaults: 恢复默认的策略参数和日志级别掩码
+ */
+static void SHELL_CmdDefaults(uint8_t argc, char **argv)
+{
+    POLICY_ResetConfig();
+    LOG_SetMask(LOG_DEFAULT_MASK);
+    SHELL_CmdGet(1, argv);
+}
+
+/**
+ * @brief report: 结束本次休眠, 立即开始一个上报周期
+ */
+static void SHELL_CmdReport(uint8_t argc, char **argv)
+{
+    shellReport = 1;
+    printf("report now\r\n");
+}
+
+/**
+ * @brief gnss [wake]: 输出最近一次定位结果, 或唤醒GNSS模块
+ */
+static void SHELL_CmdGnss(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "wake") == 0)
+    {
+        AT6558R_Init(POLICY_GetGnssFrequency());
+        LOWPOWER_WakeupModules(LOWPOWER_MODULE_AT6558R);
+        return;
+    }
+    printf("GNSS %02u-%02u-%02u %02u:%02u:%02u, %.6f %c, %.6f %c, %.1f km/h, steps %lu\r\n",
+           locationData.calendar.year, locationData.calendar.month, locationData.calendar.day,
+           locationData.time.hour, locationData.time.minute, locationData.time.second,
+           locationData.latitude, locationData.latitude_direction ? 'S' : 'N',
+           locationData.longitude, locationData.longitude_direction ? 'W' : 'E',
+           locationData.speed, locationData.steps);
+}
+
+/**
+ * @brief modem wake: 唤醒QS100
+ */
+static void SHELL_CmdModem(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "wake") == 0)
+    {
+        QS100_Init();
+        LOWPOWER_WakeupModules(LOWPOWER_MODULE_QS100);
+        return;
+    }
+    printf("usage: modem wake\r\n");
+}
+
+/**
+ * @brief at <命令>: 向已唤醒的QS100发送AT命令并输出响应
+ */
+static void SHELL_CmdAt(uint8_t argc, char **argv)
+{
+    char cmd[SHELL_LINE_MAX + 2];
+
+    if (argc < 2)
+    {
+        printf("usage: at <AT command>\r\n");
+        return;
+    }
+    if ((LOWPOWER_GetAwakeModules() & LOWPOWER_MODULE_QS100) == 0)
+    {
+        printf("modem asleep, run 'modem wake' first\r\n");
+        return;
+    }
+
+    sprintf(cmd, "%s\r\n", argv[1]);
+    QS100_SendCommand((uint8_t *)cmd);
+    printf("%s\r\n", tempBuffer);
+}
+
+/**
+ * @brief sleep: 让已唤醒的GNSS和NB-IoT模块进入低功耗
+ */
+static void SHELL_CmdSleep(uint8_t argc, char **argv)
+{
+    LOWPOWER_SleepModules();
+}
+
+/**
+ * @brief exit: 结束会话, 允许进入STANDBY
+ */
+static void SHELL_CmdExit(uint8_t argc, char **argv)
+{
+    shellActive = 0;
+}
+
+static const ShellCommandTypeDef shellCommands[] = {
+    {"help", SHELL_CmdHelp, "list commands"},
+    {"stats", SHELL_CmdStats, "phase timings, memory and link counters"},
+    {"get", SHELL_CmdGet, "[name] show persisted settings"},
+    {"set", SHELL_CmdSet, "<name> <value> change a setting"},
+    {"save", SHELL_CmdSave, "write settings to flash now"},
+    {"defaults", SHELL_CmdDefaults, "restore default settings"},
+    {"report", SHELL_CmdReport, "end sleep and report now"},
+    {"gnss", SHELL_CmdGnss, "[wake] show last fix or wake GNSS"},
+    {"modem", SHELL_CmdModem, "wake: wake QS100"},
+    {"at", SHELL_CmdAt, "<cmd> send AT command to QS100"},
+    {"sleep", SHELL_CmdSleep, "put awake modules to sleep"},
+    {"exit", SHELL_CmdExit, "end session, allow STANDBY"},
+};
+
+#define SHELL_COMMAND_NUM (sizeof(shellCommands) / sizeof(shellCommands[0]))
+
+/**
+ * @brief help: 列出命令
+ */
+static void SHELL_CmdHelp(uint8_t argc, char **argv)
+{
+    uint8_t i;
+
+    for (i = 0; i < SHELL_COMMAND_NUM; i++)
+    {
+        printf("%-9s %s\r\n", shellCommands[i].name, shellCommands[i].help);
+    }
+}
+
+/**
+ * @brief 拆分并执行一行命令
+ */
+static void SHELL_Execute(char *line)
+{
+    char *argv[SHELL_ARGS_MAX];
+    uint8_t argc = 0;
+    uint8_t i;
+
+    while (*line != '\0' && argc < SHELL_ARGS_MAX)
+    {
+        while (*line == ' ')
+        {
+            *line++ = '\0';
+        }
+        if (*line == '\0')
+        {
+            break;
+        }
+        argv[argc++] = line;
+        while (*line != ' ' && *line != '\0')
+        {
+            line++;
+        }
+    }
+    if (argc == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < SHELL_COMMAND_NUM; i++)
+    {
+        if (strcmp(argv[0], shellCommands[i].name) == 0)
+        {
+            shellCommands[i].handler(argc, argv);
+            return;
+        }
+    }
+    printf("unknown command: %s, try 'help'\r\n", argv[0]);
+}
+
+/**
+ * @brief 初始化命令行: 使能USART1接收中断
+ * @note  需在DEBUG_Init()之后调用
+ */
+void SHELL_Init(void)
+{
+    __HAL_UART_ENABLE_IT(&huart1, UART_IT_RXNE);
+    HAL_NVIC_SetPriority(USART1_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+}
+
+/**
+ * @brief 执行已收到的命令行
+ * @retval 1 表示命令请求立即上报(report); 0 其他
+ */
+uint8_t SHELL_Poll(void)
+{
+    uint8_t report;
+
+    if (shellLineReady)
+    {
+        shellActive = RTC_GetCounter();
+        if (shellActive == 0)
+        {
+            shellActive = 1;
+        }
+        SHELL_Execute(shellLine);
+        shellLineReady = 0;
+    }
+
+    report = shellReport;
+    shellReport = 0;
+    return report;
+}
+
+/**
+ * @brief 被串口唤醒后处理命令, 直到 SHELL_IDLE_MS 内无输入或请求上报
+ * @note  需在恢复时钟之后调用; 等待输入时以WFI休眠, 由接收中断或SysTick唤醒
+ * @retval 1 表示请求立即上报; 0 其他
+ */
+uint8_t SHELL_Session(void)
+{
+    uint8_t report = 0;
+
+    SHELL_DisarmWakeup();
+    shellRxTick = HAL_GetTick();
+
+    while (!report && HAL_GetTick() - shellRxTick < SHELL_IDLE_MS)
+    {
+        if (shellLineReady)
+        {
+            report = SHELL_Poll();
+            DEBUG_Flush();
+        }
+        else
+        {
+            __WFI();
+        }
+    }
+    return report;
+}
+
+/**
+ * @brief 是否处于命令行会话中(最近一条命令后 SHELL_SESSION_S 秒内)
+ */
+uint8_t SHELL_IsActive(void)
+{
+    return shellActive != 0 && RTC_GetCounter() - shellActive < SHELL_SESSION_S;
+}
+
+/**
+ * @brief 进入STOP前使能RX引脚下降沿唤醒
+ */
+void SHELL_ArmWakeup(void)
+{
+    gpioA10Flag = 0;
+    GPIOA10_Init();
+}
+
+/**
+ * @brief 关闭RX引脚唤醒, 避免运行时每个字符都触发EXTI中断
+ */
+void SHELL_DisarmWakeup(void)
+{
+    CLEAR_BIT(EXTI->IMR, GPIO_PIN_10);
+    __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_10);
+    gpioA10Flag = 0;
+}
+
+/**
+ * @brief 收到一个字符: 回车或换行结束一行, 退格删除一个字符
+ */
+static void SHELL_Receive(char ch)
+{
+    shellRxTick = HAL_GetTick();
+
+    if (ch == '\r' || ch == '\n')
+    {
+        if (shellRxLength > 0 && !shellLineReady)
+        {
+            memcpy(shellLine, shellRx, shellRxLength);
+            shellLine[shellRxLength] = '\0';
+            shellLineReady = 1;
+        }
+        shellRxLength = 0;
+    }
+    else if (ch == '\b' || ch == 0x7F)
+    {
+        if (shellRxLength > 0)
+        {
+            shellRxLength--;
+        }
+    }
+    else if (ch >= ' ' && ch < 0x7F && shellRxLength < SHELL_LINE_MAX - 1)
+    {
+        shellRx[shellRxLength++] = ch;
+    }
+}
+
+void USART1_IRQHandler(void)
+{
+    uint32_t sr = USART1->SR;
+
+    if (sr & (USART_SR_RXNE | USART_SR_ORE))
+    {
+        SHELL_Receive((char)(USART1->DR & 0xFF)); /* 读DR同时清除RXNE和ORE */
+    }
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef __SHELL_H__
+#define __SHELL_H__
+
+#include "sys/sys.h"
+#include "user_config.h"
+#include "GPIO/gpio.h"
+
+#define SHELL_ARGS_MAX      4       /* 命令行最多拆分的参数个数(含命令名) */
+
+#ifdef SHELL_ENABLE
+    void SHELL_Init(void);
+    uint8_t SHELL_Poll(void);
+    uint8_t SHELL_Session(void);
+    uint8_t SHELL_IsActive(void);
+    void SHELL_ArmWakeup(void);
+    void SHELL_DisarmWakeup(void);
+#else
+    #define SHELL_Init()
+    #define SHELL_Poll()            0
+    #define SHELL_Session()         0
+    #define SHELL_IsActive()        0
+    #define SHELL_ArmWakeup()
+    #define SHELL_DisarmWakeup()
+#endif
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * @file tdma.c
+ * @brief LoRa时隙调度(TDMA): 信标同步, 每个叶节点只在自己的时隙发送
+ *
+ * 网关在UTC秒数为 TDMA_FRAME_S 整数倍时发送信标，信标携带开始发送时刻的网关时间和超帧参数。
+ * 超帧内信标之后 TDMA_BEACON_GUARD_MS 起依次为 TDMA_SLOT_NUM 个时隙，叶节点的时隙号
+ * 为部署时分配的 TDMA_NODE_INDEX，未分配时取节点ID对时隙数取余(此时不同节点可能落在同一时隙)。
+ *
+ * 叶节点不需要与网关的绝对时间一致，只记录最近一次同步的超帧起点在本地RTC上的时刻：
+ *  - 超帧起点 = 信标接收完成时刻(DIO1中断的HAL tick换算到RTC) - 信标空中时间 - 信标发送时刻在超帧内的偏移；
+ *  - 相隔n个超帧的两次同步给出本地时钟的漂移(ppm)，按1/4权重平滑，预测以后的超帧起点时扣除漂移；
+ *  - 信标接收窗口按距上次同步的时间以 TDMA_DRIFT_PPM 放宽；连续丢失超过 TDMA_MAX_MISSED 次
+ *    或从未同步时，接收整个超帧搜索信标。
+ * 上报间隔由 TDMA_AlignSleep() 对齐到信标前 TDMA_WAKE_LEAD_S 秒唤醒，唤醒后 TDMA_Prepare()
+ * 先开始接收信标，GNSS定位期间信标由芯片接收，TDMA_Send() 再处理信标并在时隙到来时发送。
+ * 时隙内发送时刻居中，前后各留一半保护间隔。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LORA
+
+#include "tdma/tdma.h"
+
+TdmaStateTypeDef tdmaState = {0};
+
+static uint8_t tdmaRadioOn = 0;     /* 1 表示本周期已启动LLCC68 */
+static uint8_t tdmaListening = 0;   /* 1 表示信标接收进行中 */
+
+/**
+ * @brief 读取本地时间(ms)
+ */
+static uint64_t TDMA_NowMs(void)
+{
+    uint16_t millis;
+    uint32_t seconds = RTC_GetCounterMs(&millis);
+
+    return (uint64_t)seconds * 1000 + millis;
+}
+
+/**
+ * @brief 预测最近同步之后第frames个超帧内偏移offsetMs(网关时间)处对应的本地时间(ms)
+ */
+static uint64_t TDMA_LocalTime(uint32_t frames, uint32_t offsetMs)
+{
+    uint64_t elapsed = (uint64_t)frames * tdmaState.frameS * 1000 + offsetMs;
+    uint64_t base = (uint64_t)tdmaState.frameSec * 1000 + tdmaState.frameMs;
+
+    return base + elapsed + (int64_t)elapsed * tdmaState.driftPpm / 1000000;
+}
+
+/**
+ * @brief 查找超帧内偏移offsetMs处不早于本地时间t的最近超帧
+ * @return uint32_t 相对最近同步的超帧序号
+ */
+static uint32_t TDMA_NextFrame(uint64_t t, uint32_t offsetMs)
+{
+    uint64_t base = (uint64_t)tdmaState.frameSec * 1000 + tdmaState.frameMs;
+    uint32_t frames = (t > base) ? (uint32_t)((t - base) / ((uint32_t)tdmaState.frameS * 1000)) : 0;
+
+    if (frames > 0)
+    {
+        frames--;
+    }
+    while (TDMA_LocalTime(frames, offsetMs) < t)
+    {
+        frames++;
+    }
+    return frames;
+}
+
+/**
+ * @brief 按距上次同步的时间计算信标接收窗口余量(ms)
+ */
+static uint32_t TDMA_GetWindowMs(uint64_t at)
+{
+    uint64_t base = (uint64_t)tdmaState.frameSec * 1000 + tdmaState.frameMs;
+    uint64_t elapsed = (at > base) ? at - base : 0;
+
+    return TDMA_BEACON_WINDOW_MS + (uint32_t)(elapsed * TDMA_DRIFT_PPM / 1000000);
+}
+
+/**
+ * @brief 获取本节点的时隙号
+ */
+uint16_t TDMA_GetSlot(void)
+{
+    uint16_t slotNum = tdmaState.synced ? tdmaState.slotNum : TDMA_SLOT_NUM;
+
+#ifdef TDMA_NODE_INDEX
+    return TDMA_NODE_INDEX % slotNum;
+#else
+    return LORAFRAME_GetNodeId() % slotNum;
+#endif
+}
+
+/**
+ * @brief 信标接收回调: 计算超帧起点并估计漂移
+ */
+static void TDMA_OnBeacon(uint8_t *buffer, uint16_t length)
+{
+    LoraBeaconTypeDef beacon;
+    uint64_t frameStart;
+    uint64_t base;
+    uint32_t periodMs;
+    uint32_t frames;
+    int32_t drift;
+
+    tdmaListening = 0;
+    if (buffer == NULL || LORAFRAME_DecodeBeacon(buffer, length, &beacon) != 0)
+    {
+        tdmaState.missed++;
+        DEBUG_Warn("TDMA beacon missed (%u)\r\n", tdmaState.missed);
+        return;
+    }
+
+    /* 接收完成时刻减去空中时间为信标开始发送时刻, 再减去发送时刻在超帧内的偏移 */
+    frameStart = TDMA_NowMs() - (HAL_GetTick() - gpioB14Tick) - LORA_GetTimeOnAirUs((uint8_t)length) / 1000;
+    frameStart -= (uint64_t)(beacon.epoch % beacon.frameS) * 1000 + beacon.millis;
+
+    base = (uint64_t)tdmaState.frameSec * 1000 + tdmaState.frameMs;
+    periodMs = (uint32_t)beacon.frameS * 1000;
+    if (tdmaState.synced && tdmaState.frameS == beacon.frameS && frameStart > base)
+    {
+        frames = (uint32_t)((frameStart - base + periodMs / 2) / periodMs);
+        if (frames > 0)
+        {
+            drift = (int32_t)((int64_t)(frameStart - base - (uint64_t)frames * periodMs) * 1000000 /
+                              ((int64_t)frames * periodMs));
+            tdmaState.driftPpm = (int16_t)((3 * (int32_t)tdmaState.driftPpm + drift) / 4);
+        }
+    }
+    else
+    {
+        tdmaState.driftPpm = 0;
+    }
+
+    tdmaState.frameSec = (uint32_t)(frameStart / 1000);
+    tdmaState.frameMs = (uint16_t)(frameStart % 1000);
+    tdmaState.frameS = beacon.frameS;
+    tdmaState.slotMs = beacon.slotMs;
+    tdmaState.slotNum = beacon.slotNum;
+    tdmaState.synced = 1;
+    tdmaState.missed = 0;
+    DEBUG_Info("TDMA sync gateway %08lX, drift %d ppm, slot %u\r\n", beacon.gatewayId, tdmaState.driftPpm, TDMA_GetSlot());
+}
+
+/**
+ * @brief 等待进行中的信标接收结束
+ */
+static void TDMA_WaitBeacon(void)
+{
+    while (tdmaListening)
+    {
+        LORA_Process();
+        if (tdmaListening && LORA_GetState() != LORA_STATE_RX)
+        {
+            tdmaListening = 0;
+        }
+        if (tdmaListening)
+        {
+            __WFI();
+        }
+    }
+}
+
+/**
+ * @brief 周期开始时调用: 已同步且即将到达信标时启动LLCC68接收信标
+ * @details 接收在后台进行, 本周期的GNSS定位等操作照常执行, 由TDMA_Send()处理接收结果
+ */
+void TDMA_Prepare(void)
+{
+    uint64_t now;
+    uint64_t beacon;
+    uint32_t window;
+
+    tdmaListening = 0;
+    tdmaRadioOn = 0;
+    if (!tdmaState.synced || tdmaState.missed > TDMA_MAX_MISSED)
+    {
+        return;
+    }
+
+    now = TDMA_NowMs();
+    beacon = TDMA_LocalTime(TDMA_NextFrame(now, 0), 0);
+    if (beacon - now > (TDMA_WAKE_LEAD_S + 1) * 1000)
+    {
+        return; // 不在信标附近, 按预测的超帧起点发送
+    }
+
+    window = TDMA_GetWindowMs(beacon);
+    LORA_Init();
+    tdmaRadioOn = 1;
+    if (LORA_ReceiveAsync((uint32_t)(beacon - now) + 2 * window + LORA_GetTimeOnAirUs(LORAFRAME_BEACON_LEN) / 1000,
+                          TDMA_OnBeacon) == 0)
+    {
+        tdmaListening = 1;
+    }
+}
+
+/**
+ * @brief 接收整个超帧搜索信标
+ * @return uint8_t 0 表示已同步；1 表示未收到信标
+ */
+static uint8_t TDMA_Scan(void)
+{
+    DEBUG_Info("TDMA scanning for beacon...\r\n");
+    tdmaState.synced = 0;
+    if (LORA_ReceiveAsync((uint32_t)TDMA_FRAME_S * 1000 + TDMA_BEACON_GUARD_MS, TDMA_OnBeacon) != 0)
+    {
+        return 1;
+    }
+    tdmaListening = 1;
+    TDMA_WaitBeacon();
+    return tdmaState.synced ? 0 : 1;
+}
+
+/**
+ * @brief 等待到本地时间target(ms)
+ * @details 超过2秒时LLCC68进入热启动睡眠, MCU以STOP模式等待到目标前1秒内, 再以SLEEP模式等到目标时刻
+ */
+static void TDMA_WaitUntil(uint64_t target)
+{
+    uint64_t now = TDMA_NowMs();
+
+    if (target > now + 2000)
+    {
+        LORA_Sleep();
+        LOWPOWER_StopFor((uint32_t)((target - now) / 1000) - 1);
+        LORA_Init();
+    }
+    while (TDMA_NowMs() < target)
+    {
+        __WFI();
+    }
+}
+
+/**
+ * @brief 在本节点时隙内发送数据包, 发送后LLCC68进入热启动睡眠
+ * @param data 数据
+ * @param length 数据长度
+ * @return uint8_t 0 表示发送成功；1 表示未同步或发送失败; 2 表示超出占空比额度
+ */
+uint8_t TDMA_Send(uint8_t *data, uint8_t length)
+{
+    uint32_t offsetMs;
+    uint32_t airtimeMs;
+    uint64_t slot;
+    uint8_t result = 1;
+
+    if (!tdmaRadioOn)
+    {
+        LORA_Init();
+        tdmaRadioOn = 1;
+    }
+    TDMA_WaitBeacon();
+
+    if ((tdmaState.synced && tdmaState.missed <= TDMA_MAX_MISSED) || TDMA_Scan() == 0)
+    {
+        /* 发送时刻居中于时隙, 前后各留一半保护间隔 */
+        airtimeMs = LORA_GetTimeOnAirUs(length) / 1000;
+        offsetMs = TDMA_BEACON_GUARD_MS + (uint32_t)TDMA_GetSlot() * tdmaState.slotMs;
+        if (tdmaState.slotMs > airtimeMs)
+        {
+            offsetMs += (tdmaState.slotMs - airtimeMs) / 2;
+        }
+
+        slot = TDMA_LocalTime(TDMA_NextFrame(TDMA_NowMs() + 10, offsetMs), offsetMs);
+        TDMA_WaitUntil(slot);
+        result = LORA_SendData(data, length);
+    }
+    else
+    {
+        DEBUG_Warn("TDMA no beacon, skip send\r\n");
+    }
+
+    LORA_Sleep();
+    tdmaRadioOn = 0;
+    return result;
+}
+
+/**
+ * @brief 把休眠时长对齐到信标前TDMA_WAKE_LEAD_S秒唤醒
+ * @param seconds 上报策略给出的休眠时长(秒)
+ * @return uint32_t 对齐后的休眠时长(秒), 不短于seconds; 未同步时原样返回
+ */
+uint32_t TDMA_AlignSleep(uint32_t seconds)
+{
+    uint64_t now;
+    uint64_t wake;
+
+    if (!tdmaState.synced)
+    {
+        return seconds;
+    }
+
+    now = TDMA_NowMs();
+    wake = TDMA_LocalTime(TDMA_NextFrame(now + ((uint64_t)seconds + TDMA_WAKE_LEAD_S) * 1000, 0), 0) -
+           TDMA_WAKE_LEAD_S * 1000;
+    return (uint32_t)((wake - now) / 1000);
+}
+
+/**
+ * @brief 网关: 计算now之后的下一个信标时刻
+ * @param now 当前RTC计数(秒)
+ * @return uint32_t 下一个超帧起点(秒)
+ */
+uint32_t TDMA_GetNextBeacon(uint32_t now)
+{
+    return (now / TDMA_FRAME_S + 1) * TDMA_FRAME_S;
+}
+
+/**
+ * @brief 网关: 立即发送信标
+ * @details 信标携带读取RTC时的时间, 关闭先听后发避免退避推迟发送时刻
+ */
+void TDMA_SendBeacon(void)
+{
+    LoraBeaconTypeDef beacon;
+    uint8_t frame[LORAFRAME_BEACON_LEN];
+
+    beacon.gatewayId = LORAFRAME_GetNodeId();
+    beacon.frameS = TDMA_FRAME_S;
+    beacon.slotMs = TDMA_SLOT_MS;
+    beacon.slotNum = TDMA_SLOT_NUM;
+
+    LORA_SetLbt(0);
+    beacon.epoch = RTC_GetCounterMs(&beacon.millis);
+    if (LORA_SendData(frame, LORAFRAME_EncodeBeacon(&beacon, frame)) != 0)
+    {
+        DEBUG_Error("TDMA beacon send failed\r\n");
+    }
+    LORA_SetLbt(1);
+}
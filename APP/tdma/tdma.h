@@ -0,0 +1,41 @@
+#ifndef __TDMA_H__
+#define __TDMA_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "rtc/rtc.h"
+#include "gpio/gpio.h"
+#include "LoRa/lora.h"
+#include "loraFrame/loraFrame.h"
+#include "lowPower/lowPower.h"
+
+#if TDMA_BEACON_GUARD_MS + TDMA_SLOT_NUM * TDMA_SLOT_MS > TDMA_FRAME_S * 1000
+#error "TDMA slots do not fit in one frame"
+#endif
+
+#define TDMA_DRIFT_PPM      50      /* 校正后残余漂移上限(ppm), 按距上次同步的时间放宽信标接收窗口 */
+#define TDMA_WAKE_LEAD_S    2       /* 叶节点在信标前该秒数唤醒并开始接收信标 */
+
+/* 叶节点同步状态, 时间均为本地RTC时间, 由persist模块掉电保持 */
+typedef struct
+{
+    uint32_t frameSec;      // 最近一次同步的超帧起点(秒)
+    uint16_t frameMs;       // 超帧起点的秒内毫秒
+    int16_t driftPpm;       // 本地时钟相对网关的漂移(ppm), 正数表示本地偏快
+    uint16_t frameS;        // 超帧周期(秒), 取自信标
+    uint16_t slotMs;        // 时隙长度(ms), 取自信标
+    uint16_t slotNum;       // 时隙数, 取自信标
+    uint8_t synced;         // 1 表示已同步
+    uint8_t missed;         // 连续丢失信标的次数
+} TdmaStateTypeDef;
+
+extern TdmaStateTypeDef tdmaState;
+
+uint16_t TDMA_GetSlot(void);
+void TDMA_Prepare(void);
+uint8_t TDMA_Send(uint8_t *data, uint8_t length);
+uint32_t TDMA_AlignSleep(uint32_t seconds);
+uint32_t TDMA_GetNextBeacon(uint32_t now);
+void TDMA_SendBeacon(void);
+
+#endif
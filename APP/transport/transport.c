@@ -0,0 +1,257 @@
+/**
+ * @file transport.c
+ * @brief 上行链路选择: 每次上报在LoRa和NB-IoT之间按能耗选择
+ *
+ * 每条链路维护三个指数滑动平均(权重 1/2^TRANSPORT_EWMA_SHIFT)：每字节能耗、单次发送耗时和成功率。
+ * 能耗按 耗时 x 链路平均电流(TRANSPORT_*_MA) x 供电电压(TRANSPORT_SUPPLY_MV) 估算，耗时从唤醒
+ * 模块开始计到发送函数返回，NB-IoT包含附着和建立套接字，LoRa包含应答窗口和退避重发。
+ * 链路尚无测量时以 TRANSPORT_*_PRIOR_MS 作为单次发送耗时的先验。
+ *
+ * 选择规则：
+ *  - 期望能耗 = 每字节能耗 x 本链路载荷字节数 / 成功率(失败重发的代价)；
+ *  - 成功率不低于 TRANSPORT_MIN_SUCCESS 且耗时不超过截止时间的链路为候选，选期望能耗最低者；
+ *  - 没有候选时选成功率最高者；
+ *  - 期望能耗更低但不满足条件的链路连续 TRANSPORT_PROBE_CYCLES 次未被选用时试探一次，
+ *    使网关重新进入覆盖范围等变化能反映到估计值中。
+ * 首选链路失败时自动改用另一条链路。每次选择和每次发送结果通过调试串口输出，
+ * 可用 Tools/transport_tune.py 汇总并按不同的能耗参数重新评估。
+ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LOCATION
+
+#include "transport/transport.h"
+
+TransportStateTypeDef transportState = {0};
+
+static const char *transportName[TRANSPORT_LINK_NUM] = {"lora", "nbiot"};
+static const uint16_t transportCurrent[TRANSPORT_LINK_NUM] = {TRANSPORT_LORA_MA, TRANSPORT_NBIOT_MA};
+static const uint32_t transportPriorMs[TRANSPORT_LINK_NUM] = {TRANSPORT_LORA_PRIOR_MS, TRANSPORT_NBIOT_PRIOR_MS};
+
+/**
+ * @brief 按能耗模型把链路工作时长换算为能耗(uJ)
+ */
+static uint32_t TRANSPORT_EnergyUj(uint8_t link, uint32_t ms)
+{
+    return (uint32_t)((uint64_t)ms * transportCurrent[link] * TRANSPORT_SUPPLY_MV / 1000);
+}
+
+/**
+ * @brief 链路成功率(Q8), 尚无测量时为100%
+ */
+static uint16_t TRANSPORT_GetSuccess(uint8_t link)
+{
+    return transportState.link[link].attempts ? transportState.link[link].success : TRANSPORT_SUCCESS_ONE;
+}
+
+/**
+ * @brief 链路单次发送耗时(ms), 尚无测量时取先验值
+ */
+static uint32_t TRANSPORT_GetLatency(uint8_t link)
+{
+    return transportState.link[link].attempts ? transportState.link[link].latencyMs : transportPriorMs[link];
+}
+
+/**
+ * @brief 发送length字节的期望能耗(uJ), 按成功率折算重发代价
+ */
+static uint32_t TRANSPORT_GetCost(uint8_t link, uint16_t length)
+{
+    TransportLinkStatsTypeDef *stats = &transportState.link[link];
+    uint16_t success = TRANSPORT_GetSuccess(link);
+    uint64_t energy;
+
+    if (stats->attempts == 0)
+    {
+        energy = TRANSPORT_EnergyUj(link, transportPriorMs[link]);
+    }
+    else
+    {
+        energy = (uint64_t)stats->energyPerByte * length;
+    }
+    if (success < TRANSPORT_SUCCESS_FLOOR)
+    {
+        success = TRANSPORT_SUCCESS_FLOOR;
+    }
+
+    energy = energy * TRANSPORT_SUCCESS_ONE / success;
+    return (energy > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)energy;
+}
+
+/**
+ * @brief 指数滑动平均
+ */
+static uint32_t TRANSPORT_Average(uint32_t average, uint32_t sample)
+{
+    return (uint32_t)((int64_t)average + (((int64_t)sample - (int64_t)average) >> TRANSPORT_EWMA_SHIFT));
+}
+
+/**
+ * @brief 以一次发送结果更新链路估计值
+ */
+static void TRANSPORT_Update(uint8_t link, uint16_t length, uint32_t ms, uint8_t ok)
+{
+    TransportLinkStatsTypeDef *stats = &transportState.link[link];
+    uint32_t energy = TRANSPORT_EnergyUj(link, ms);
+    uint32_t perByte = energy / (length ? length : 1);
+
+    if (stats->attempts == 0)
+    {
+        stats->energyPerByte = perByte;
+        stats->latencyMs = ms;
+        stats->success = TRANSPORT_SUCCESS_ONE;
+    }
+    else
+    {
+        stats->energyPerByte = TRANSPORT_Average(stats->energyPerByte, perByte);
+        stats->latencyMs = TRANSPORT_Average(stats->latencyMs, ms);
+    }
+    stats->success = (uint16_t)TRANSPORT_Average(stats->success, ok ? TRANSPORT_SUCCESS_ONE : 0);
+    stats->attempts++;
+    if (!ok)
+    {
+        stats->failures++;
+    }
+
+    DEBUG_Info("XPORT,res,%s,%u,%lu,%lu,%u\r\n", transportName[link], ok, ms, energy, length);
+}
+
+/**
+ * @brief 经LoRa可靠链路发送位置帧
+ * @return uint8_t 0 表示已收到网关应答；1 表示失败；2 表示超出占空比额度
+ */
+static uint8_t TRANSPORT_SendLora(uint8_t *frame, uint8_t length)
+{
+    uint8_t result;
+
+    PROFILE_Begin(PROFILE_PHASE_SEND);
+    LORA_Init();
+    result = LORALINK_Send(frame, length);
+    LORA_Sleep();
+    PROFILE_End(PROFILE_PHASE_SEND);
+    return result;
+}
+
+/**
+ * @brief 唤醒QS100并经NB-IoT发送
+ * @return uint8_t 0 表示发送成功；1 表示失败
+ */
+static uint8_t TRANSPORT_SendNbiot(uint8_t *data, uint16_t length)
+{
+    QS100_Init();
+    LOWPOWER_WakeupModules(LOWPOWER_MODULE_QS100); // 由低功耗模块在休眠前关闭
+    return QS100_SendData(data, length);
+}
+
+/**
+ * @brief 选择首选链路并输出选择依据
+ * @return uint8_t 首选链路 TransportLinkTypeDef
+ */
+static uint8_t TRANSPORT_Select(const uint16_t *length, uint32_t deadlineMs)
+{
+    uint32_t cost[TRANSPORT_LINK_NUM];
+    uint8_t eligible[TRANSPORT_LINK_NUM];
+    const char *reason = "cost";
+    uint8_t choice = TRANSPORT_LINK_NUM;
+    uint8_t link;
+    uint8_t other;
+
+    for (link = 0; link < TRANSPORT_LINK_NUM; link++)
+    {
+        cost[link] = TRANSPORT_GetCost(link, length[link]);
+        eligible[link] = TRANSPORT_GetSuccess(link) >= TRANSPORT_MIN_SUCCESS &&
+                         TRANSPORT_GetLatency(link) <= deadlineMs;
+        if (eligible[link] && (choice == TRANSPORT_LINK_NUM || cost[link] < cost[choice]))
+        {
+            choice = link;
+        }
+    }
+
+    if (choice == TRANSPORT_LINK_NUM)
+    {
+        reason = "best";
+        choice = (TRANSPORT_GetSuccess(TRANSPORT_LINK_LORA) >= TRANSPORT_GetSuccess(TRANSPORT_LINK_NBIOT))
+                     ? TRANSPORT_LINK_LORA
+                     : TRANSPORT_LINK_NBIOT;
+    }
+
+    /* 更省电但被排除的链路定期试探, 否则其估计值不再更新 */
+    other = (choice == TRANSPORT_LINK_LORA) ? TRANSPORT_LINK_NBIOT : TRANSPORT_LINK_LORA;
+    if (!eligible[other] && cost[other] < cost[choice])
+    {
+        if (++transportState.link[other].skipped >= TRANSPORT_PROBE_CYCLES)
+        {
+            reason = "probe";
+            choice = other;
+        }
+    }
+    transportState.link[choice].skipped = 0;
+
+    DEBUG_Info("XPORT,sel,%s,%s,%lu,%lu,%lu,%u,%lu,%lu,%u\r\n", transportName[choice], reason, deadlineMs,
+               cost[TRANSPORT_LINK_LORA], TRANSPORT_GetLatency(TRANSPORT_LINK_LORA),
+               TRANSPORT_GetSuccess(TRANSPORT_LINK_LORA) * 100 / TRANSPORT_SUCCESS_ONE,
+               cost[TRANSPORT_LINK_NBIOT], TRANSPORT_GetLatency(TRANSPORT_LINK_NBIOT),
+               TRANSPORT_GetSuccess(TRANSPORT_LINK_NBIOT) * 100 / TRANSPORT_SUCCESS_ONE);
+    return choice;
+}
+
+/**
+ * @brief 选择链路发送一次上报, 首选链路失败时改用另一条链路
+ * @details 调用前不需唤醒QS100, 选用NB-IoT时在本函数内唤醒。
+ *          输出格式(供调参):
+ *          XPORT,sel,<首选链路>,<cost|best|probe>,<截止时间ms>,<LoRa期望能耗uJ>,<LoRa耗时ms>,<LoRa成功率%>,
+ *                    <NB-IoT期望能耗uJ>,<NB-IoT耗时ms>,<NB-IoT成功率%>
+ *          XPORT,res,<链路>,<1成功|0失败>,<耗时ms>,<能耗uJ>,<字节数>
+ * @param frame LoRa位置帧
+ * @param frameLength 位置帧长度
+ * @param data NB-IoT上行数据(JSON)
+ * @param dataLength 上行数据长度
+ * @param deadlineMs 本次上报的截止时间(ms), 超过 TRANSPORT_DEADLINE_MS 时按后者
+ * @return uint8_t 完成发送的链路 TransportLinkTypeDef, TRANSPORT_LINK_NUM 表示两条链路均失败
+ */
+uint8_t TRANSPORT_Send(uint8_t *frame, uint8_t frameLength, uint8_t *data, uint16_t dataLength, uint32_t deadlineMs)
+{
+    uint16_t length[TRANSPORT_LINK_NUM];
+    uint32_t tickstart;
+    uint32_t elapsed;
+    uint8_t link;
+    uint8_t result;
+    uint8_t i;
+
+    length[TRANSPORT_LINK_LORA] = frameLength;
+    length[TRANSPORT_LINK_NBIOT] = dataLength;
+    if (deadlineMs > TRANSPORT_DEADLINE_MS)
+    {
+        deadlineMs = TRANSPORT_DEADLINE_MS;
+    }
+
+    link = TRANSPORT_Select(length, deadlineMs);
+    for (i = 0; i < TRANSPORT_LINK_NUM; i++)
+    {
+        tickstart = HAL_GetTick();
+        if (link == TRANSPORT_LINK_LORA)
+        {
+            result = TRANSPORT_SendLora(frame, frameLength);
+        }
+        else
+        {
+            result = TRANSPORT_SendNbiot(data, dataLength);
+        }
+        elapsed = HAL_GetTick() - tickstart;
+
+        /* 占空比额度不足与链路质量无关, 不计入估计值 */
+        if (result == 2)
+        {
+            DEBUG_Warn("XPORT,duty,%s\r\n", transportName[link]);
+        }
+        else
+        {
+            TRANSPORT_Update(link, length[link], elapsed, result == 0);
+            if (result == 0)
+            {
+                return link;
+            }
+        }
+        link = (link == TRANSPORT_LINK_LORA) ? TRANSPORT_LINK_NBIOT : TRANSPORT_LINK_LORA;
+    }
+    return TRANSPORT_LINK_NUM;
+}
@@ -0,0 +1,42 @@
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "qs100/qs100.h"
+#include "LoRa/lora.h"
+#include "loraLink/loraLink.h"
+#include "lowPower/lowPower.h"
+#include "Profile/profile.h"
+
+#define TRANSPORT_SUCCESS_ONE   256     /* 成功率Q8定点, 256表示100% */
+
+typedef enum
+{
+    TRANSPORT_LINK_LORA = 0,        // LoRa发给附近网关(可靠链路, 需收到应答)
+    TRANSPORT_LINK_NBIOT,           // QS100经NB-IoT直接上行
+    TRANSPORT_LINK_NUM,             // 作为返回值时表示两条链路均发送失败
+} TransportLinkTypeDef;
+
+/* 单条链路的估计值 */
+typedef struct
+{
+    uint32_t energyPerByte; // 每字节能耗(uJ/字节, 指数滑动平均)
+    uint32_t latencyMs;     // 单次发送耗时(ms, 指数滑动平均)
+    uint32_t attempts;      // 发送次数
+    uint32_t failures;      // 发送失败次数
+    uint16_t success;       // 成功率(Q8, 指数滑动平均)
+    uint16_t skipped;       // 因成功率或时限不满足而连续未被选用的次数
+} TransportLinkStatsTypeDef;
+
+/* 链路选择状态, 由persist模块掉电保持 */
+typedef struct
+{
+    TransportLinkStatsTypeDef link[TRANSPORT_LINK_NUM];
+} TransportStateTypeDef;
+
+extern TransportStateTypeDef transportState;
+
+uint8_t TRANSPORT_Send(uint8_t *frame, uint8_t frameLength, uint8_t *data, uint16_t dataLength, uint32_t deadlineMs);
+
+#endif
@@ -0,0 +1,56 @@
+#include "adc.h"
+
+ADC_HandleTypeDef hadc1;
+
+void ADC1_Init(void)
+{
+    RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
+    ADC_ChannelConfTypeDef sConfig = {0};
+
+    __HAL_RCC_ADC1_CLK_ENABLE();
+
+    /* ADC时钟 = PCLK2/6, 72MHz下为12MHz(上限14MHz) */
+    PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_ADC;
+    PeriphClkInitStruct.AdcClockSelection = RCC_ADCPCLK2_DIV6;
+    HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct);
+
+    hadc1.Instance = ADC1;
+    hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;         /* 单通道 */
+    hadc1.Init.ContinuousConvMode = DISABLE;            /* 单次转换 */
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;   /* 软件触发 */
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.NbrOfConversion = 1;
+    HAL_ADC_Init(&hadc1);
+
+    /* 内部参考电压通道, 采样时间需大于17.1us */
+    sConfig.Channel = ADC_CHANNEL_VREFINT;
+    sConfig.Rank = ADC_REGULAR_RANK_1;
+    sConfig.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
+    HAL_ADC_ConfigChannel(&hadc1, &sConfig);
+
+    HAL_ADCEx_Calibration_Start(&hadc1);
+}
+
+/**
+ * @brief 通过内部参考电压测量供电电压
+ * @details VDD = VREFINT * 4095 / ADC读数。电池经低压差稳压或直接供电时可据此估计电池电压。
+ * @retval 供电电压(mV), 转换失败返回0
+ */
+uint16_t ADC1_ReadVdd(void)
+{
+    uint32_t raw = 0;
+
+    HAL_ADC_Start(&hadc1);
+    if (HAL_ADC_PollForConversion(&hadc1, 10) == HAL_OK)
+    {
+        raw = HAL_ADC_GetValue(&hadc1);
+    }
+    HAL_ADC_Stop(&hadc1); /* 关闭ADC以降低功耗 */
+
+    if (raw == 0)
+    {
+        return 0;
+    }
+    return (uint16_t)(ADC_VREFINT_MV * 4095 / raw);
+}
@@ -0,0 +1,13 @@
+#ifndef __ADC_H__
+#define __ADC_H__
+
+#include "sys/sys.h"
+
+#define ADC_VREFINT_MV      1200    /* 内部参考电压典型值(mV), 器件间偏差约±3% */
+
+extern ADC_HandleTypeDef hadc1;
+
+void ADC1_Init(void);
+uint16_t ADC1_ReadVdd(void);
+
+#endif
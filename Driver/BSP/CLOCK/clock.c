@@ -0,0 +1,200 @@
+#include "clock.h"
+
+/* 各模式下的系统时钟频率(MHz) */
+static const uint8_t clockFrequency[CLOCK_MODE_NUM] = {72, 8};
+
+static ClockModeTypeDef clockMode = CLOCK_MODE_FAST;
+static uint32_t clockStamp = 0;                 /* 上次统计时的DWT周期计数 */
+static uint64_t clockCycles[CLOCK_MODE_NUM];    /* 本周期内各模式累计的CPU周期数 */
+static uint32_t clockMicros = 0;                /* 累计运行时间(us), 不含STOP模式 */
+
+/**
+ * @brief 将上次统计以来的CPU周期计入当前模式
+ * @note  DWT->CYCCNT为32位, 72MHz下约59秒溢出一次, 两次统计的间隔需小于该值
+ */
+static void CLOCK_Account(void)
+{
+    uint32_t now = DWT->CYCCNT;
+
+    clockCycles[clockMode] += now - clockStamp;
+    clockMicros += (now - clockStamp) / clockFrequency[clockMode];
+    clockStamp = now;
+}
+
+/**
+ * @brief 切换到HSI 8MHz, 所有总线不分频, 然后关闭PLL和HSE
+ */
+static void CLOCK_ConfigSlow(void)
+{
+    RCC_OscInitTypeDef rcc_osc_init = {0};
+    RCC_ClkInitTypeDef rcc_clk_init = {0};
+
+    rcc_osc_init.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    rcc_osc_init.HSIState = RCC_HSI_ON;
+    rcc_osc_init.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    HAL_RCC_OscConfig(&rcc_osc_init);
+
+    rcc_clk_init.ClockType = (RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2);
+    rcc_clk_init.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+    rcc_clk_init.AHBCLKDivider = RCC_SYSCLK_DIV1;
+    rcc_clk_init.APB1CLKDivider = RCC_HCLK_DIV1;
+    rcc_clk_init.APB2CLKDivider = RCC_HCLK_DIV1;
+    HAL_RCC_ClockConfig(&rcc_clk_init, FLASH_LATENCY_0);    /* 同时更新SystemCoreClock和SysTick */
+
+    /* 先关PLL再关HSE */
+    rcc_osc_init.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    rcc_osc_init.PLL.PLLState = RCC_PLL_OFF;
+    HAL_RCC_OscConfig(&rcc_osc_init);
+    rcc_osc_init.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+    rcc_osc_init.HSEState = RCC_HSE_OFF;
+    rcc_osc_init.PLL.PLLState = RCC_PLL_NONE;
+    HAL_RCC_OscConfig(&rcc_osc_init);
+}
+
+/**
+ * @brief 按新的PCLK重新计算串口波特率寄存器
+ */
+static void CLOCK_UpdateUart(UART_HandleTypeDef *huart, uint32_t pclk)
+{
+    if (huart->gState == HAL_UART_STATE_RESET) /* 未初始化的串口跳过 */
+    {
+        return;
+    }
+    huart->Instance->BRR = UART_BRR_SAMPLING16(pclk, huart->Init.BaudRate);
+}
+
+/**
+ * @brief 按新的PCLK2选择SPI1预分频, 使SCK不超过CLOCK_SPI_MAX_HZ
+ */
+static void CLOCK_UpdateSpi(SPI_HandleTypeDef *hspi, uint32_t pclk)
+{
+    uint32_t br = 0;
+    uint32_t enabled;
+
+    if (hspi->State == HAL_SPI_STATE_RESET)
+    {
+        return;
+    }
+    while (br < 7 && (pclk >> (br + 1)) > CLOCK_SPI_MAX_HZ)
+    {
+        br++;
+    }
+
+    enabled = hspi->Instance->CR1 & SPI_CR1_SPE;
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Init.BaudRatePrescaler = br << SPI_CR1_BR_Pos;
+    MODIFY_REG(hspi->Instance->CR1, SPI_CR1_BR, hspi->Init.BaudRatePrescaler);
+    hspi->Instance->CR1 |= enabled;
+}
+
+/**
+ * @brief 时钟切换后重新推导与时钟相关的外设参数
+ * @details SysTick已由HAL_RCC_ClockConfig重新配置; 这里更新delay_us倍乘数、
+ *          各串口波特率寄存器、I2C1时序(重新初始化)和SPI1预分频。
+ */
+static void CLOCK_UpdatePeripherals(void)
+{
+    delay_init(SystemCoreClock / 1000000);
+
+    CLOCK_UpdateUart(&huart1, HAL_RCC_GetPCLK2Freq());
+    CLOCK_UpdateUart(&huart2, HAL_RCC_GetPCLK1Freq());
+    CLOCK_UpdateUart(&huart3, HAL_RCC_GetPCLK1Freq());
+
+    if (hi2c1.State != HAL_I2C_STATE_RESET)
+    {
+        HAL_I2C_Init(&hi2c1);
+    }
+
+    CLOCK_UpdateSpi(&hspi1, HAL_RCC_GetPCLK2Freq());
+}
+
+/**
+ * @brief 按指定模式配置时钟树并更新外设
+ */
+static void CLOCK_Config(ClockModeTypeDef mode)
+{
+    if (mode == CLOCK_MODE_FAST)
+    {
+        sys_stm32_clock_init(RCC_PLL_MUL9);
+    }
+    else
+    {
+        CLOCK_ConfigSlow();
+    }
+    CLOCK_UpdatePeripherals();
+}
+
+/**
+ * @brief 时钟管理初始化, 配置为72MHz并开始统计各频率运行时间
+ */
+void CLOCK_Init(void)
+{
+    sys_stm32_clock_init(RCC_PLL_MUL9);
+    delay_init(72);
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; /* 使能DWT周期计数器 */
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    clockMode = CLOCK_MODE_FAST;
+    clockStamp = DWT->CYCCNT;
+}
+
+/**
+ * @brief 切换时钟模式
+ * @note  切换前等待调试串口发送完成, 避免波特率变化时输出乱码
+ * @param mode CLOCK_MODE_FAST 或 CLOCK_MODE_SLOW
+ */
+void CLOCK_SetMode(ClockModeTypeDef mode)
+{
+    if (mode == clockMode)
+    {
+        return;
+    }
+
+    DEBUG_Flush();
+    CLOCK_Account();
+    CLOCK_Config(mode);
+    clockMode = mode;
+}
+
+ClockModeTypeDef CLOCK_GetMode(void)
+{
+    return clockMode;
+}
+
+/**
+ * @brief STOP模式唤醒后恢复进入前的时钟模式
+ * @note  STOP唤醒后系统时钟固定为HSI, PLL和HSE关闭。DWT->CYCCNT在STOP期间停止计数但保持原值,
+ *        先把进入STOP前运行的周期计入, 之后继续以原值为基准, 微秒时间戳不会回退
+ */
+void CLOCK_Resume(void)
+{
+    CLOCK_Account();
+    CLOCK_Config(clockMode);
+}
+
+/**
+ * @brief 读取与频率无关的微秒时间戳
+ * @details 基于DWT周期计数器, 每次切换时钟时按原频率折算累加, 可跨时钟切换计算时间间隔
+ * @retval 运行时间(us), 约71分钟回绕一次, 仅用于求差
+ */
+uint32_t CLOCK_GetMicros(void)
+{
+    return clockMicros + (DWT->CYCCNT - clockStamp) / clockFrequency[clockMode];
+}
+
+/**
+ * @brief 输出本周期内各频率的运行时间并清零统计
+ */
+void CLOCK_Report(void)
+{
+    uint8_t i;
+
+    CLOCK_Account();
+    for (i = 0; i < CLOCK_MODE_NUM; i++)
+    {
+        DEBUG_Info("Clock %2dMHz: %lu ms\r\n", clockFrequency[i],
+                   (uint32_t)(clockCycles[i] / (clockFrequency[i] * 1000UL)));
+        clockCycles[i] = 0;
+    }
+}
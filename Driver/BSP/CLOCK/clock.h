@@ -0,0 +1,28 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include "sys/sys.h"
+#include "delay/delay.h"
+#include "debug/debug.h"
+#include "usart/usart.h"
+#include "usart/usart3.h"
+#include "I2C/i2c.h"
+#include "spi/spi.h"
+
+#define CLOCK_SPI_MAX_HZ    4500000     /* SPI1最高时钟, 与72MHz下16分频一致 */
+
+typedef enum
+{
+    CLOCK_MODE_FAST = 0,    // HSE+PLL 72MHz, 用于计算
+    CLOCK_MODE_SLOW,        // HSI 8MHz, PLL和HSE关闭, 用于等待外设
+    CLOCK_MODE_NUM,
+} ClockModeTypeDef;
+
+void CLOCK_Init(void);
+void CLOCK_SetMode(ClockModeTypeDef mode);
+ClockModeTypeDef CLOCK_GetMode(void);
+void CLOCK_Resume(void);
+uint32_t CLOCK_GetMicros(void);
+void CLOCK_Report(void);
+
+#endif
@@ -0,0 +1,40 @@
+#include "flash.h"
+
+/**
+ * @brief 擦除address所在的Flash页(1KB)
+ * @param address 页内任意地址
+ */
+void FLASH_Erase(uint32_t address)
+{
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t pageError = 0;
+
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = address & ~(FLASH_PAGE_SIZE - 1);
+    erase.NbPages = 1;
+
+    HAL_FLASH_Unlock();
+    HAL_FLASHEx_Erase(&erase, &pageError);
+    HAL_FLASH_Lock();
+}
+
+/**
+ * @brief 按半字写入Flash
+ * @param address 目标地址, 需半字对齐且已擦除
+ * @param data 数据
+ * @param len 字节数, 为奇数时最后一个半字的高字节补0xFF
+ * @note  编程期间CPU从Flash取指会被挂起, 需保证HSI处于开启状态
+ */
+void FLASH_Write(uint32_t address, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t i;
+
+    HAL_FLASH_Unlock();
+    for (i = 0; i < len; i += 2)
+    {
+        uint16_t halfword = p[i] | ((i + 1 < len) ? (p[i + 1] << 8) : 0xFF00);
+        HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + i, halfword);
+    }
+    HAL_FLASH_Lock();
+}
@@ -0,0 +1,9 @@
+#ifndef __FLASH_H__
+#define __FLASH_H__
+
+#include "sys/sys.h"
+
+void FLASH_Erase(uint32_t address);
+void FLASH_Write(uint32_t address, const void *data, uint32_t len);
+
+#endif
@@ -1,5 +1,17 @@
 #include "gpio.h"
 
+/* PA0上升沿标志, EXTI0中断中置1 */
+volatile uint8_t gpioA0Flag = 0;
+
+/* PB14上升沿标志, EXTI14中断中置1 */
+volatile uint8_t gpioB14Flag = 0;
+
+/* PB14最近一次上升沿的HAL tick */
+volatile uint32_t gpioB14Tick = 0;
+
+/* PA10下降沿标志, EXTI10中断中置1 */
+volatile uint8_t gpioA10Flag = 0;
+
 void GPIOB3_Init(void)
 {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -138,4 +150,94 @@ void GPIOB13_Init(void)
 
     /* 设置初始状态为低电平 */
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET);
-}
\ No newline at end of file
+}
+
+void GPIOA0_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* 使能GPIOA时钟 */
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /* 配置PA0引脚为上升沿中断输入, 与待机模式下WKUP引脚的下拉一致 */
+    GPIO_InitStruct.Pin = GPIO_PIN_0;           /* 选择PA0引脚 */
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING; /* 上升沿触发中断 */
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;       /* 下拉 */
+
+    /* 初始化GPIOA */
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* 使能EXTI0中断, 用于从STOP模式唤醒 */
+    HAL_NVIC_SetPriority(EXTI0_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+}
+
+void GPIOB14_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* 使能GPIOB时钟 */
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    /* 配置PB14引脚为上升沿中断输入, DIO1在中断状态清除前保持高电平 */
+    GPIO_InitStruct.Pin = GPIO_PIN_14;          /* 选择PB14引脚 */
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING; /* 上升沿触发中断 */
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;       /* 下拉 */
+
+    /* 初始化GPIOB */
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    /* 使能EXTI15_10中断 */
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+
+void GPIOA10_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* 使能GPIOA时钟 */
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /* PA10仍作为USART1 RX输入, 同时以下降沿(起始位)触发EXTI10, 用于从STOP模式唤醒 */
+    GPIO_InitStruct.Pin = GPIO_PIN_10;           /* 选择PA10引脚 */
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING; /* 下降沿触发中断 */
+    GPIO_InitStruct.Pull = GPIO_PULLUP;          /* 上拉, 与串口空闲电平一致 */
+
+    /* 初始化GPIOA */
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* 使能EXTI15_10中断 */
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+
+/* EXTI0中断服务函数 */
+void EXTI0_IRQHandler(void)
+{
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+}
+
+/* EXTI15_10中断服务函数 */
+void EXTI15_10_IRQHandler(void)
+{
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_10);
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_14);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == GPIO_PIN_0)
+    {
+        gpioA0Flag = 1;
+    }
+    else if (GPIO_Pin == GPIO_PIN_14)
+    {
+        gpioB14Flag = 1;
+        gpioB14Tick = HAL_GetTick();
+    }
+    else if (GPIO_Pin == GPIO_PIN_10)
+    {
+        gpioA10Flag = 1;
+    }
+}
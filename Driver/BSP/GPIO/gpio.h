@@ -11,8 +11,17 @@ void GPIOB0_Init(void);     /*  LoRa芯片RST引脚, 复位 */
 void GPIOB1_Init(void);     /*  LoRa芯片BUSY引脚, 只读 */
 void GPIOB2_Init(void);     /*  LoRa芯片TxEN引脚, 写使能 */
 void GPIOB12_Init(void);    /*  LoRa芯片RxEN引脚, 读使能 */
+void GPIOB14_Init(void);    /*  LoRa芯片DIO1引脚, 上升沿触发EXTI14 */
 
 void GPIOB13_Init(void);    /*  QS100芯片Wakeup引脚, 唤醒 */
 
+void GPIOA0_Init(void);     /*  DS3553运动中断输入引脚(WKUP), 上升沿触发EXTI0 */
+void GPIOA10_Init(void);    /*  USART1 RX引脚, 下降沿触发EXTI10 */
+
+extern volatile uint8_t gpioA0Flag;     /* PA0上升沿标志, EXTI0中断中置1 */
+extern volatile uint8_t gpioB14Flag;    /* PB14上升沿标志, EXTI14中断中置1 */
+extern volatile uint32_t gpioB14Tick;   /* PB14最近一次上升沿的HAL tick, 用于数据包接收时刻 */
+extern volatile uint8_t gpioA10Flag;    /* PA10下降沿标志, EXTI10中断中置1 */
+
 
 #endif
@@ -4,6 +4,10 @@
 /* I2C1句柄结构体 */
 I2C_HandleTypeDef hi2c1;
 
+/* 当前异步传输的完成回调, 为NULL表示总线空闲 */
+static I2C1_CallbackTypeDef i2c1Callback = NULL;
+static volatile uint8_t i2c1Busy = 0;
+
 void I2C1_Init(void)
 { 
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -15,7 +19,7 @@ void I2C1_Init(void)
     /* 配置I2C1基本参数 */
     hi2c1.Instance = I2C1;
     hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;  /* 7位地址模式 */
-    hi2c1.Init.ClockSpeed = 100000;                       /* 通信速率，最大400k */
+    hi2c1.Init.ClockSpeed = 400000;                       /* 通信速率，快速模式400k */
     hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE; /* 单地址模式 */
     hi2c1.Init.DutyCycle = I2C_DUTYCYCLE_2;               /* SCL高低电平持续时间之比  */
     hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE; /* 禁用广播模式 */
@@ -34,6 +38,12 @@ void I2C1_Init(void)
     GPIO_InitStruct.Pin = GPIO_PIN_6 | GPIO_PIN_7; /* PB6(SCL) PB7(SDA) */
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;  /* 高速输出 */
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);      /* 初始化GPIO */
+
+    /* 使能I2C1事件与错误中断, 供异步传输使用 */
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
 }
 
 /*
@@ -88,4 +98,143 @@ void I2C1_ReceiveByte(uint16_t adr, uint8_t *recieveBuffer)
 void I2C1_ReceiveBytes(uint16_t adr, uint8_t *recieveBuffer, uint8_t len)
 {
     HAL_I2C_Master_Receive(&hi2c1, adr, recieveBuffer, len, 1000);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 结束当前异步传输并调用完成回调
+ * @param status 传输结果
+ */
+static void I2C1_Complete(HAL_StatusTypeDef status)
+{
+    I2C1_CallbackTypeDef callback = i2c1Callback;
+
+    i2c1Callback = NULL;
+    i2c1Busy = 0;
+    if (callback != NULL)
+    {
+        callback(status);
+    }
+}
+
+/**
+ * @brief 中断方式向从设备寄存器写入数据
+ * @param adr I2C从设备地址(已左移1位)
+ * @param reg 寄存器地址
+ * @param sendBuffer 发送数据缓冲区, 传输完成前必须保持有效
+ * @param len 发送数据长度
+ * @param callback 完成回调, 可为NULL
+ * @retval HAL_OK 已启动传输; HAL_BUSY 总线正忙; 其他 启动失败
+ * @note 一次传输内完成 起始-从机地址-寄存器地址-数据-停止, 函数立即返回
+ */
+HAL_StatusTypeDef I2C1_MemWriteAsync(uint16_t adr, uint8_t reg, uint8_t *sendBuffer, uint8_t len, I2C1_CallbackTypeDef callback)
+{
+    HAL_StatusTypeDef status;
+
+    if (i2c1Busy)
+    {
+        return HAL_BUSY;
+    }
+
+    i2c1Busy = 1;
+    i2c1Callback = callback;
+    status = HAL_I2C_Mem_Write_IT(&hi2c1, adr, reg, I2C_MEMADD_SIZE_8BIT, sendBuffer, len);
+    if (status != HAL_OK)
+    {
+        i2c1Callback = NULL;
+        i2c1Busy = 0;
+    }
+    return status;
+}
+
+/**
+ * @brief 中断方式从从设备寄存器读取数据
+ * @param adr I2C从设备地址(已左移1位)
+ * @param reg 起始寄存器地址
+ * @param recieveBuffer 接收数据缓冲区, 传输完成前必须保持有效
+ * @param len 接收数据长度
+ * @param callback 完成回调, 可为NULL
+ * @retval HAL_OK 已启动传输; HAL_BUSY 总线正忙; 其他 启动失败
+ * @note 写寄存器地址后以重复起始条件直接转入读, 中间不产生停止条件
+ */
+HAL_StatusTypeDef I2C1_MemReadAsync(uint16_t adr, uint8_t reg, uint8_t *recieveBuffer, uint8_t len, I2C1_CallbackTypeDef callback)
+{
+    HAL_StatusTypeDef status;
+
+    if (i2c1Busy)
+    {
+        return HAL_BUSY;
+    }
+
+    i2c1Busy = 1;
+    i2c1Callback = callback;
+    status = HAL_I2C_Mem_Read_IT(&hi2c1, adr, reg, I2C_MEMADD_SIZE_8BIT, recieveBuffer, len);
+    if (status != HAL_OK)
+    {
+        i2c1Callback = NULL;
+        i2c1Busy = 0;
+    }
+    return status;
+}
+
+/**
+ * @brief 查询异步传输是否进行中
+ * @retval 1 进行中; 0 空闲
+ */
+uint8_t I2C1_IsBusy(void)
+{
+    return i2c1Busy;
+}
+
+/**
+ * @brief 放弃未完成的异步传输并重新初始化I2C1
+ * @note 用于从设备无响应等超时场合, 被放弃传输的回调不再调用
+ */
+void I2C1_Reset(void)
+{
+    HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
+
+    HAL_I2C_DeInit(&hi2c1);
+    HAL_I2C_Init(&hi2c1);
+    i2c1Callback = NULL;
+    i2c1Busy = 0;
+
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1)
+    {
+        I2C1_Complete(HAL_OK);
+    }
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1)
+    {
+        I2C1_Complete(HAL_OK);
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1)
+    {
+        I2C1_Complete(HAL_ERROR);
+    }
+}
+
+/* I2C1事件中断服务函数 */
+void I2C1_EV_IRQHandler(void)
+{
+    HAL_I2C_EV_IRQHandler(&hi2c1);
+}
+
+/* I2C1错误中断服务函数 */
+void I2C1_ER_IRQHandler(void)
+{
+    HAL_I2C_ER_IRQHandler(&hi2c1);
+}
@@ -3,6 +3,9 @@
 
 #include "sys/sys.h"
 
+/* 异步传输完成回调, 在I2C1中断上下文中调用, status为HAL_OK表示传输成功 */
+typedef void (*I2C1_CallbackTypeDef)(HAL_StatusTypeDef status);
+
 extern I2C_HandleTypeDef hi2c1;
 
 void I2C1_Init(void);
@@ -10,5 +13,9 @@ void I2C1_SendByte(uint16_t adr, uint8_t data);
 void I2C1_SendBytes(uint16_t adr, uint8_t *sendBuffre, uint8_t len);
 void I2C1_ReceiveByte(uint16_t adr, uint8_t *recieveBuffer);
 void I2C1_ReceiveBytes(uint16_t adr, uint8_t *recieveBuffer, uint8_t len);
+HAL_StatusTypeDef I2C1_MemWriteAsync(uint16_t adr, uint8_t reg, uint8_t *sendBuffer, uint8_t len, I2C1_CallbackTypeDef callback);
+HAL_StatusTypeDef I2C1_MemReadAsync(uint16_t adr, uint8_t reg, uint8_t *recieveBuffer, uint8_t len, I2C1_CallbackTypeDef callback);
+uint8_t I2C1_IsBusy(void);
+void I2C1_Reset(void);
 
 #endif
\ No newline at end of file
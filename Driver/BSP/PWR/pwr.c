@@ -4,5 +4,51 @@
 void PWR_Init(void)
 { 
     __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
     HAL_PWR_EnableBkUpAccess();
 }
+
+/**
+ * @brief 读取备份寄存器
+ * @param reg 备份寄存器编号(RTC_BKP_DR1 ~ RTC_BKP_DR10)
+ * @retval 寄存器中保存的16位数据
+ * @note 备份寄存器位于备份域, 待机模式和系统复位后内容保持不变
+ */
+uint16_t PWR_ReadBackup(uint32_t reg)
+{
+    return (uint16_t)(*(__IO uint32_t *)(BKP_BASE + reg * 4U) & BKP_DR1_D);
+}
+
+/**
+ * @brief 写入备份寄存器
+ * @param reg 备份寄存器编号(RTC_BKP_DR1 ~ RTC_BKP_DR10)
+ * @param data 要写入的16位数据
+ * @note 调用前需先调用PWR_Init()解除备份域写保护
+ */
+void PWR_WriteBackup(uint32_t reg, uint16_t data)
+{
+    *(__IO uint32_t *)(BKP_BASE + reg * 4U) = data;
+}
+
+
+/**
+ * @brief 读取外设会话标记
+ * @param flag PWR_SESSION_* 标记位
+ * @retval 1 标记已置位, 0 未置位
+ */
+uint8_t PWR_GetSession(uint16_t flag)
+{
+    return (PWR_ReadBackup(PWR_BKP_SESSION) & flag) != 0;
+}
+
+/**
+ * @brief 置位或清除外设会话标记
+ * @param flag PWR_SESSION_* 标记位
+ * @param set 1 置位, 0 清除
+ */
+void PWR_SetSession(uint16_t flag, uint8_t set)
+{
+    uint16_t session = PWR_ReadBackup(PWR_BKP_SESSION);
+
+    PWR_WriteBackup(PWR_BKP_SESSION, set ? (session | flag) : (session & ~flag));
+}
@@ -3,6 +3,26 @@
 
 #include "sys/sys.h"
 
+/* 备份寄存器分配表 (BKP_DR1~BKP_DR10, 每个16位, 待机模式下保持) */
+#define PWR_BKP_REINIT_TIME     RTC_BKP_DR1     /* 待机唤醒后重新初始化耗时(单位100us), 供休眠策略使用 */
+#define PWR_BKP_RTC_MAGIC       RTC_BKP_DR2     /* RTC已配置标记 */
+#define PWR_BKP_RTC_PRESCALER   RTC_BKP_DR3     /* 已校准的RTC预分频值(RTC_PRL只写) */
+#define PWR_BKP_RTC_SYNC_H      RTC_BKP_DR4     /* LSI校准基线(上次用于校准的GNSS授时)的Unix时间戳高16位 */
+#define PWR_BKP_RTC_SYNC_L      RTC_BKP_DR5     /* LSI校准基线的Unix时间戳低16位 */
+#define PWR_BKP_SESSION         RTC_BKP_DR6     /* 外设会话标记 PWR_SESSION_*, 整机掉电后丢失 */
+#define PWR_BKP_RTC_DRIFT       RTC_BKP_DR7     /* 校准基线以来各次授时对计数器的累计修正(秒, 有符号) */
+#define PWR_BKP_LORA_FRAME_SEQ  RTC_BKP_DR8     /* LoRa位置帧序号, 网关据此去重 */
+#define PWR_BKP_LORA_FRAG_ID    RTC_BKP_DR9     /* LoRa分片消息ID, 网关据此区分新消息与重发 */
+#define PWR_BKP_LORAWAN_FCNT    RTC_BKP_DR10    /* LoRaWAN上行帧计数低15位, 最高位为有效标记 */
+
+/* PWR_BKP_SESSION 中的标记位 */
+#define PWR_SESSION_DS3553      0x0001          /* DS3553本次上电已完成配置 */
+#define PWR_SESSION_LORA        0x0002          /* LLCC68处于热启动睡眠且配置与影子一致 */
+
 void PWR_Init(void);
+uint16_t PWR_ReadBackup(uint32_t reg);
+void PWR_WriteBackup(uint32_t reg, uint16_t data);
+uint8_t PWR_GetSession(uint16_t flag);
+void PWR_SetSession(uint16_t flag, uint8_t set);
 
 #endif
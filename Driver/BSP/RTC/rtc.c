@@ -1,7 +1,98 @@
 #include "rtc.h"
 
 RTC_HandleTypeDef hrtc;
+volatile uint8_t rtcAlarmFlag = 0; /* RTC闹钟触发标志, 闹钟中断中置1 */
 
+/**
+ * @brief 进入RTC配置模式
+ * @note  等待上一次写操作完成(RTOFF)后置位CNF
+ */
+static void RTC_EnterConfigMode(void)
+{
+    while ((hrtc.Instance->CRL & RTC_CRL_RTOFF) == 0)
+        ;
+    __HAL_RTC_WRITEPROTECTION_DISABLE(&hrtc);
+}
+
+/**
+ * @brief 退出RTC配置模式, 等待写操作完成
+ */
+static void RTC_ExitConfigMode(void)
+{
+    __HAL_RTC_WRITEPROTECTION_ENABLE(&hrtc);
+    while ((hrtc.Instance->CRL & RTC_CRL_RTOFF) == 0)
+        ;
+}
+
+/**
+ * @brief 读取当前使用的预分频值
+ * @note  RTC_PRL寄存器只写, 预分频值同时保存在备份寄存器中
+ */
+static uint32_t RTC_GetPrescaler(void)
+{
+    uint32_t prescaler = PWR_ReadBackup(PWR_BKP_RTC_PRESCALER);
+
+    if (prescaler < RTC_PRESCALER_MIN || prescaler > RTC_PRESCALER_MAX)
+    {
+        return LSI_VALUE - 1;
+    }
+    return prescaler;
+}
+
+/**
+ * @brief 写入预分频值并保存到备份寄存器
+ * @param prescaler 预分频值, RTC计数频率 = LSI / (prescaler + 1)
+ */
+static void RTC_SetPrescaler(uint32_t prescaler)
+{
+    RTC_EnterConfigMode();
+    WRITE_REG(hrtc.Instance->PRLH, (prescaler >> 16) & RTC_PRLH_PRL);
+    WRITE_REG(hrtc.Instance->PRLL, prescaler & RTC_PRLL_PRL);
+    RTC_ExitConfigMode();
+
+    PWR_WriteBackup(PWR_BKP_RTC_PRESCALER, (uint16_t)prescaler);
+}
+
+/**
+ * @brief 读取上一次GNSS授时的时间戳
+ * @retval 上次授时的Unix时间戳, 从未授时返回0
+ */
+static uint32_t RTC_GetLastSync(void)
+{
+    return ((uint32_t)PWR_ReadBackup(PWR_BKP_RTC_SYNC_H) << 16) | PWR_ReadBackup(PWR_BKP_RTC_SYNC_L);
+}
+
+static void RTC_SetLastSync(uint32_t epoch)
+{
+    PWR_WriteBackup(PWR_BKP_RTC_SYNC_H, (uint16_t)(epoch >> 16));
+    PWR_WriteBackup(PWR_BKP_RTC_SYNC_L, (uint16_t)epoch);
+}
+
+/**
+ * @brief 等待下一个RTC秒标志
+ * @retval 0: 成功, 1: 超时
+ */
+static uint8_t RTC_WaitSecond(void)
+{
+    uint32_t tickstart = HAL_GetTick();
+
+    __HAL_RTC_SECOND_CLEAR_FLAG(&hrtc, RTC_FLAG_SEC);
+    while (__HAL_RTC_SECOND_GET_FLAG(&hrtc, RTC_FLAG_SEC) == RESET)
+    {
+        if (HAL_GetTick() - tickstart > 2000)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief RTC初始化
+ * @details RTC时钟为LSI, 32位计数器作为Unix时间戳(秒)使用。备份域在待机和系统复位后保持,
+ *          因此只有首次上电(备份寄存器无配置标记)时才配置预分频并用HSE校准LSI,
+ *          之后的复位只做同步, 不改写已校准的预分频和正在运行的计数器。
+ */
 void RTC_Init(void)
 {
     /* 使能PWR时钟并解锁备份域 */
@@ -25,34 +116,262 @@ void RTC_Init(void)
 
     /* 配置RTC */
     hrtc.Instance = RTC;
-    hrtc.Init.AsynchPrediv = RTC_AUTO_1_SECOND; /* 自动配置1秒预分频 */
+    hrtc.Init.AsynchPrediv = RTC_GetPrescaler();
+
+    if (PWR_ReadBackup(PWR_BKP_RTC_MAGIC) == RTC_CONFIGURED_MAGIC)
+    {
+        /* 已配置: 仅等待寄存器同步 */
+        hrtc.State = HAL_RTC_STATE_READY;
+        HAL_RTC_WaitForSynchro(&hrtc);
+    }
+    else
+    {
+        /* 首次配置: 计数器从0开始, 清除授时记录, 用HSE校准LSI */
+        HAL_RTC_Init(&hrtc);
+        RTC_SetCounter(0);
+        RTC_SetLastSync(0);
+        PWR_WriteBackup(PWR_BKP_RTC_DRIFT, 0);
+        PWR_WriteBackup(PWR_BKP_RTC_PRESCALER, (uint16_t)hrtc.Init.AsynchPrediv);
+        RTC_CalibrateWithHSE();
+        PWR_WriteBackup(PWR_BKP_RTC_MAGIC, RTC_CONFIGURED_MAGIC);
+    }
 
-    HAL_RTC_Init(&hrtc);
+    /* 使能RTC闹钟中断(EXTI17), 用于从STOP模式唤醒 */
+    HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
 }
 
+/**
+ * @brief 设置seconds秒后的RTC闹钟
+ * @details 闹钟直接写入绝对计数值(当前计数+seconds), 不经过时分秒换算
+ * @param seconds 距当前时刻的秒数
+ */
 void RTC_SetAlarm(uint32_t seconds)
 {
-    RTC_AlarmTypeDef sAlarm = {0};
-
-    /* 获取当前时间 */
-    RTC_TimeTypeDef sTime = {0};
-    RTC_DateTypeDef sDate = {0};
-    HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN);
-    HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
-
-    // 计算闹钟时间，处理秒数溢出
-    uint32_t totalSeconds = sTime.Seconds + seconds;
-    sAlarm.AlarmTime.Hours = sTime.Hours;
-    sAlarm.AlarmTime.Minutes = sTime.Minutes;
-    sAlarm.AlarmTime.Seconds = totalSeconds % 60;
-    
-    // 处理分钟进位
-    uint32_t additionalMinutes = totalSeconds / 60;
-    sAlarm.AlarmTime.Minutes = (sAlarm.AlarmTime.Minutes + additionalMinutes) % 60;
-    
-    // 处理小时进位
-    uint32_t additionalHours = (sTime.Minutes + additionalMinutes) / 60;
-    sAlarm.AlarmTime.Hours = (sAlarm.AlarmTime.Hours + additionalHours) % 24;
-
-    HAL_RTC_SetAlarm(&hrtc, &sAlarm, RTC_FORMAT_BIN);
-}
\ No newline at end of file
+    uint32_t alarm = RTC_GetCounter() + seconds;
+
+    rtcAlarmFlag = 0;
+
+    RTC_EnterConfigMode();
+    WRITE_REG(hrtc.Instance->ALRH, alarm >> 16);
+    WRITE_REG(hrtc.Instance->ALRL, alarm & RTC_ALRL_RTC_ALR);
+    RTC_ExitConfigMode();
+
+    /* 中断方式, STOP和STANDBY模式均可唤醒 */
+    __HAL_RTC_ALARM_CLEAR_FLAG(&hrtc, RTC_FLAG_ALRAF);
+    __HAL_RTC_ALARM_ENABLE_IT(&hrtc, RTC_IT_ALRA);
+    __HAL_RTC_ALARM_EXTI_CLEAR_FLAG();
+    __HAL_RTC_ALARM_EXTI_ENABLE_IT();
+    __HAL_RTC_ALARM_EXTI_ENABLE_RISING_EDGE();
+}
+
+/**
+ * @brief 读取RTC计数器(Unix时间戳, 秒)
+ * @note  CNTH和CNTL分两次读取, 若读取期间低16位溢出则重读
+ */
+uint32_t RTC_GetCounter(void)
+{
+    uint16_t high1 = READ_REG(hrtc.Instance->CNTH & RTC_CNTH_RTC_CNT);
+    uint16_t low = READ_REG(hrtc.Instance->CNTL & RTC_CNTL_RTC_CNT);
+    uint16_t high2 = READ_REG(hrtc.Instance->CNTH & RTC_CNTH_RTC_CNT);
+
+    if (high1 != high2)
+    {
+        low = READ_REG(hrtc.Instance->CNTL & RTC_CNTL_RTC_CNT);
+    }
+    return ((uint32_t)high2 << 16) | low;
+}
+
+/**
+ * @brief 读取RTC计数器及秒内毫秒数
+ * @details 秒内时间由预分频余数RTC_DIV换算: DIV从预分频值递减到0后计数器加1。
+ *          读取期间计数器跳变则重读, 保证秒与毫秒属于同一秒。
+ * @param millis 输出秒内毫秒数(0~999)
+ * @retval Unix时间戳(秒)
+ */
+uint32_t RTC_GetCounterMs(uint16_t *millis)
+{
+    uint32_t prescaler = RTC_GetPrescaler();
+    uint32_t counter;
+    uint32_t divider;
+
+    do
+    {
+        counter = RTC_GetCounter();
+        divider = ((uint32_t)READ_REG(hrtc.Instance->DIVH & RTC_DIVH_RTC_DIV) << 16) |
+                  READ_REG(hrtc.Instance->DIVL & RTC_DIVL_RTC_DIV);
+    } while (counter != RTC_GetCounter());
+
+    if (divider > prescaler)
+    {
+        divider = prescaler;
+    }
+    *millis = (uint16_t)((prescaler - divider) * 1000 / (prescaler + 1));
+    return counter;
+}
+
+/**
+ * @brief 设置RTC计数器
+ * @param counter Unix时间戳(秒)
+ */
+void RTC_SetCounter(uint32_t counter)
+{
+    RTC_EnterConfigMode();
+    WRITE_REG(hrtc.Instance->CNTH, counter >> 16);
+    WRITE_REG(hrtc.Instance->CNTL, counter & RTC_CNTL_RTC_CNT);
+    RTC_ExitConfigMode();
+}
+
+/**
+ * @brief RTC时间是否有效
+ * @retval 1: 至少经过一次GNSS授时, 计数器为有效的Unix时间戳; 0: 尚未授时
+ */
+uint8_t RTC_IsTimeValid(void)
+{
+    return RTC_GetLastSync() != 0;
+}
+
+/**
+ * @brief 以HSE为基准校准LSI频率
+ * @details F103C8没有可捕获LSI的定时器通道(TIM5_CH4仅大容量型号有), 这里用DWT周期计数器
+ *          (由HSE经PLL产生)测量RTC_CALIB_HSE_SECONDS个RTC秒的长度, 换算出实际LSI频率后写入预分频。
+ * @retval 1: 校准成功, 0: 测量超时或结果超出范围
+ */
+uint8_t RTC_CalibrateWithHSE(void)
+{
+    uint32_t start;
+    uint32_t cycles;
+    uint64_t lsi;
+    uint8_t i;
+
+    if (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK) /* HSE未作为时钟基准 */
+    {
+        return 0;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; /* 使能DWT周期计数器 */
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    if (RTC_WaitSecond() != 0) /* 对齐到秒边沿 */
+    {
+        return 0;
+    }
+    start = DWT->CYCCNT;
+    for (i = 0; i < RTC_CALIB_HSE_SECONDS; i++)
+    {
+        if (RTC_WaitSecond() != 0)
+        {
+            return 0;
+        }
+    }
+    cycles = DWT->CYCCNT - start;
+
+    lsi = (uint64_t)(RTC_GetPrescaler() + 1) * RTC_CALIB_HSE_SECONDS * SystemCoreClock / cycles;
+    if (lsi - 1 < RTC_PRESCALER_MIN || lsi - 1 > RTC_PRESCALER_MAX)
+    {
+        return 0;
+    }
+
+    RTC_SetPrescaler((uint32_t)lsi - 1);
+    DEBUG_Info("RTC calibrated with HSE: LSI = %lu Hz\r\n", (uint32_t)lsi);
+    return 1;
+}
+
+/**
+ * @brief 用GNSS的UTC时间授时, 并根据距校准基线的累积漂移校准LSI
+ * @details 每次授时都把计数器设置为UTC时间。校准基线时计数器等于当时的UTC时间, 之后各次授时对计数器的
+ *          修正累计在备份寄存器中, 因此基线以来RTC实际计数 = 当前计数 - 基线 + 累计修正, 与UTC经过的
+ *          时间之比即为预分频的修正比例。距基线不足RTC_CALIB_MIN_SPAN时只授时并累计修正, 不校准。
+ * @param epoch GNSS定位时刻的Unix时间戳(UTC)
+ */
+void RTC_SyncWithGNSS(uint32_t epoch)
+{
+    uint32_t last = RTC_GetLastSync();
+    uint32_t now = RTC_GetCounter();
+    int32_t drift = (int16_t)PWR_ReadBackup(PWR_BKP_RTC_DRIFT) + (int32_t)(now - epoch);
+
+    RTC_SetCounter(epoch);
+
+    if (last == 0 || epoch <= last || drift > INT16_MAX || drift < INT16_MIN) /* 首次授时、时间未前进(如演示数据)或修正溢出 */
+    {
+        RTC_SetLastSync(epoch);
+        PWR_WriteBackup(PWR_BKP_RTC_DRIFT, 0);
+        return;
+    }
+
+    if (epoch - last < RTC_CALIB_MIN_SPAN) /* 距基线太短, 保留基线以累计漂移 */
+    {
+        PWR_WriteBackup(PWR_BKP_RTC_DRIFT, (uint16_t)drift);
+        return;
+    }
+
+    uint32_t span = epoch - last;
+    uint32_t prescaler = (uint32_t)(((uint64_t)(RTC_GetPrescaler() + 1) * (span + drift) + span / 2) / span) - 1;
+    if (prescaler >= RTC_PRESCALER_MIN && prescaler <= RTC_PRESCALER_MAX)
+    {
+        RTC_SetPrescaler(prescaler);
+        DEBUG_Info("RTC calibrated with GNSS: drift %ld s in %lu s, prescaler %lu\r\n", drift, span, prescaler);
+    }
+
+    RTC_SetLastSync(epoch);
+    PWR_WriteBackup(PWR_BKP_RTC_DRIFT, 0);
+}
+
+/**
+ * @brief 日期时间转换为Unix时间戳
+ * @param date 日期, Year为2000年起的两位年
+ * @param time 时间
+ * @retval Unix时间戳(秒)
+ */
+uint32_t RTC_DateTimeToEpoch(const RTC_DateTypeDef *date, const RTC_TimeTypeDef *time)
+{
+    uint32_t year = 2000 + date->Year - (date->Month <= 2);
+    uint32_t era = year / 400;
+    uint32_t yoe = year - era * 400;
+    uint32_t doy = (153 * (date->Month + (date->Month > 2 ? -3 : 9)) + 2) / 5 + date->Date - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468; /* 距1970-01-01的天数 */
+
+    return days * 86400 + time->Hours * 3600 + time->Minutes * 60 + time->Seconds;
+}
+
+/**
+ * @brief Unix时间戳转换为日期时间
+ * @param epoch Unix时间戳(秒), 需不早于2000年
+ * @param date 输出日期, Year为2000年起的两位年
+ * @param time 输出时间
+ */
+void RTC_EpochToDateTime(uint32_t epoch, RTC_DateTypeDef *date, RTC_TimeTypeDef *time)
+{
+    uint32_t days = epoch / 86400;
+    uint32_t secs = epoch % 86400;
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t month = (mp < 10) ? mp + 3 : mp - 9;
+    uint32_t year = yoe + era * 400 + (month <= 2);
+
+    date->Year = (uint8_t)(year - 2000);
+    date->Month = (uint8_t)month;
+    date->Date = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    date->WeekDay = (uint8_t)((days + 4) % 7); /* 1970-01-01为星期四 */
+
+    time->Hours = (uint8_t)(secs / 3600);
+    time->Minutes = (uint8_t)(secs % 3600 / 60);
+    time->Seconds = (uint8_t)(secs % 60);
+}
+
+/* RTC闹钟中断服务函数(EXTI17) */
+void RTC_Alarm_IRQHandler(void)
+{
+    HAL_RTC_AlarmIRQHandler(&hrtc);
+}
+
+/* RTC闹钟事件回调函数 */
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+{
+    rtcAlarmFlag = 1;
+}
@@ -3,10 +3,29 @@
 
 #include "sys/sys.h"
 #include "PWR/pwr.h"
+#include "debug/debug.h"
+
+#define RTC_CONFIGURED_MAGIC    0xA5A5      /* 备份寄存器标记: RTC已配置, 复位后不再改写预分频和计数器 */
+#define RTC_PRESCALER_MIN       29999       /* LSI标称30kHz~60kHz, 校准结果超出范围视为无效 */
+#define RTC_PRESCALER_MAX       59999
+#define RTC_CALIB_HSE_SECONDS   2           /* HSE校准测量的RTC秒数 */
+#define RTC_CALIB_MIN_SPAN      600         /* 距校准基线不小于该值(秒)的GNSS授时才用于校准LSI */
 
 extern RTC_HandleTypeDef hrtc;
+extern volatile uint8_t rtcAlarmFlag;
 
 void RTC_Init(void);
 void RTC_SetAlarm(uint32_t seconds);
 
+uint32_t RTC_GetCounter(void);
+uint32_t RTC_GetCounterMs(uint16_t *millis);
+void RTC_SetCounter(uint32_t counter);
+uint8_t RTC_IsTimeValid(void);
+
+uint8_t RTC_CalibrateWithHSE(void);
+void RTC_SyncWithGNSS(uint32_t epoch);
+
+uint32_t RTC_DateTimeToEpoch(const RTC_DateTypeDef *date, const RTC_TimeTypeDef *time);
+void RTC_EpochToDateTime(uint32_t epoch, RTC_DateTypeDef *date, RTC_TimeTypeDef *time);
+
 #endif
@@ -5,6 +5,16 @@ static void cs_low() { HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_RESET); }
 static void cs_high() { HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_SET); }  
 
 SPI_HandleTypeDef hspi1;  /* SPI句柄定义 */
+DMA_HandleTypeDef hdma_spi1_rx;  /* SPI1接收DMA句柄(DMA1通道2) */
+DMA_HandleTypeDef hdma_spi1_tx;  /* SPI1发送DMA句柄(DMA1通道3) */
+
+/* 只读传输时MOSI发送的NOP源, 放在Flash中供DMA直接读取, 不占RAM */
+static const uint8_t spiNop[SPI_MAX_LEN] = {0};
+
+/* 当前异步传输的完成回调与忙标志 */
+static SPI_CallbackTypeDef spiCallback = NULL;
+static volatile uint8_t spiBusy = 0;
+static volatile HAL_StatusTypeDef spiStatus = HAL_OK;
 
 void SPI_Init(void)
 {
@@ -45,6 +55,41 @@ void SPI_Init(void)
 
     /* 初始片选信号为高电平 */
     cs_high();  
+
+    /* 配置SPI1收发DMA, 数据段直接在调用者缓冲区与外设之间搬运 */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_spi1_rx.Instance = DMA1_Channel2;                         /* SPI1_RX固定映射到DMA1通道2 */
+    hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;            /* 外设到内存 */
+    hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;                /* 外设地址不自增 */
+    hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;                    /* 内存地址自增 */
+    hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;   /* 外设字节对齐 */
+    hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;      /* 内存字节对齐 */
+    hdma_spi1_rx.Init.Mode = DMA_NORMAL;                           /* 单次模式 */
+    hdma_spi1_rx.Init.Priority = DMA_PRIORITY_VERY_HIGH;           /* 接收优先于发送, 避免溢出 */
+    HAL_DMA_Init(&hdma_spi1_rx);
+    __HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+
+    hdma_spi1_tx.Instance = DMA1_Channel3;                         /* SPI1_TX固定映射到DMA1通道3 */
+    hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;            /* 内存到外设 */
+    hdma_spi1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_tx.Init.Priority = DMA_PRIORITY_HIGH;
+    HAL_DMA_Init(&hdma_spi1_tx);
+    __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+    HAL_NVIC_SetPriority(SPI1_IRQn, 1, 0);                         /* DMA模式下的错误中断 */
+    HAL_NVIC_EnableIRQ(SPI1_IRQn);
+
+    spiCallback = NULL;
+    spiBusy = 0;
 }
 
 void SPI_Start(void)
@@ -89,4 +134,173 @@ uint8_t SPI_SwapByte(uint8_t transmitData)
 void SPI_SwapBytes(uint8_t *transmitDataBuffer, uint8_t *receiveDataBuffer, uint16_t size)
 {
     HAL_SPI_TransmitReceive(&hspi1, transmitDataBuffer, receiveDataBuffer, size, 1000);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief       结束当前传输: 释放片选、清忙标志并调用回调
+ * @param       status: 传输结果
+ * @retval      无
+ */
+static void SPI_Complete(HAL_StatusTypeDef status)
+{
+    SPI_CallbackTypeDef callback = spiCallback;
+
+    cs_high();
+    spiCallback = NULL;
+    spiStatus = status;
+    spiBusy = 0;
+    if (callback != NULL)
+    {
+        callback(status);
+    }
+}
+
+/**
+ * @brief       分段(头部+数据)异步传输
+ * @note        片选拉低后先轮询发送命令头部, 再直接对调用者缓冲区传输数据段, 不做中间拷贝。
+ *              数据段: txData和rxData均非空为全双工; 仅txData为只写; 仅rxData为只读, MOSI发送NOP。
+ *              数据段不少于SPI_DMA_MIN_LEN时由DMA搬运, 在DMA完成中断中释放片选并调用回调;
+ *              较短的数据段直接轮询完成, 回调在本函数返回前调用。缓冲区在回调前必须保持有效。
+ * @param       header: 命令头部, 可为NULL
+ * @param       headerLen: 头部长度
+ * @param       txData: 发送数据段, 可为NULL
+ * @param       rxData: 接收数据段, 可为NULL
+ * @param       len: 数据段长度, 不超过SPI_MAX_LEN
+ * @param       callback: 完成回调, 可为NULL
+ * @retval      HAL_OK 已启动(或已完成), HAL_BUSY 总线忙, HAL_ERROR 参数或传输错误
+ */
+HAL_StatusTypeDef SPI_TransferAsync(const uint8_t *header, uint16_t headerLen, uint8_t *txData, uint8_t *rxData,
+                                    uint16_t len, SPI_CallbackTypeDef callback)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if (len > SPI_MAX_LEN || (len > 0 && txData == NULL && rxData == NULL))
+    {
+        return HAL_ERROR;
+    }
+    if (spiBusy)
+    {
+        return HAL_BUSY;
+    }
+
+    spiBusy = 1;
+    spiCallback = callback;
+    cs_low();
+
+    if (headerLen > 0)
+    {
+        status = HAL_SPI_Transmit(&hspi1, header, headerLen, 1000);
+    }
+
+    if (status == HAL_OK && len >= SPI_DMA_MIN_LEN)
+    {
+        if (rxData == NULL)
+        {
+            status = HAL_SPI_Transmit_DMA(&hspi1, txData, len);
+        }
+        else
+        {
+            status = HAL_SPI_TransmitReceive_DMA(&hspi1, txData != NULL ? txData : spiNop, rxData, len);
+        }
+        if (status == HAL_OK)
+        {
+            return HAL_OK; /* 由DMA完成中断结束传输 */
+        }
+    }
+    else if (status == HAL_OK && len > 0)
+    {
+        if (rxData == NULL)
+        {
+            status = HAL_SPI_Transmit(&hspi1, txData, len, 1000);
+        }
+        else
+        {
+            status = HAL_SPI_TransmitReceive(&hspi1, txData != NULL ? txData : spiNop, rxData, len, 1000);
+        }
+    }
+
+    SPI_Complete(status);
+    return status;
+}
+
+/**
+ * @brief       分段(头部+数据)同步传输, 等待DMA完成后返回
+ * @param       参数含义同SPI_TransferAsync
+ * @retval      HAL_OK 成功, 其他 失败
+ */
+HAL_StatusTypeDef SPI_Transfer(const uint8_t *header, uint16_t headerLen, uint8_t *txData, uint8_t *rxData, uint16_t len)
+{
+    uint32_t start;
+    HAL_StatusTypeDef status = SPI_TransferAsync(header, headerLen, txData, rxData, len, NULL);
+
+    if (status != HAL_OK)
+    {
+        return status;
+    }
+
+    start = HAL_GetTick();
+    while (spiBusy)
+    {
+        if (HAL_GetTick() - start > 1000)
+        {
+            HAL_SPI_Abort(&hspi1);
+            SPI_Complete(HAL_TIMEOUT);
+            break;
+        }
+    }
+    return spiStatus;
+}
+
+/**
+ * @brief       查询SPI1是否有异步传输进行中
+ * @retval      1 忙, 0 空闲
+ */
+uint8_t SPI_IsBusy(void)
+{
+    return spiBusy;
+}
+
+/* HAL库SPI发送完成回调(只写DMA) */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance == SPI1)
+    {
+        SPI_Complete(HAL_OK);
+    }
+}
+
+/* HAL库SPI收发完成回调(只读/全双工DMA) */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance == SPI1)
+    {
+        SPI_Complete(HAL_OK);
+    }
+}
+
+/* HAL库SPI错误回调 */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance == SPI1 && spiBusy)
+    {
+        SPI_Complete(HAL_ERROR);
+    }
+}
+
+/* DMA1通道2中断(SPI1_RX) */
+void DMA1_Channel2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi1_rx);
+}
+
+/* DMA1通道3中断(SPI1_TX) */
+void DMA1_Channel3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi1_tx);
+}
+
+/* SPI1中断, DMA传输期间处理溢出等错误 */
+void SPI1_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&hspi1);
+}
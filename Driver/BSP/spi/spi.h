@@ -3,7 +3,14 @@
 
 #include "sys/sys.h"
 
+#define SPI_DMA_MIN_LEN 16    /* 数据段不少于该长度时使用DMA, 短帧轮询更快 */
+#define SPI_MAX_LEN     256   /* 单次数据段最大长度(与NOP发送源大小一致) */
+
+typedef void (*SPI_CallbackTypeDef)(HAL_StatusTypeDef status); /* 传输完成回调, 在中断上下文调用 */
+
 extern SPI_HandleTypeDef hspi1;  /* SPI句柄声明 */
+extern DMA_HandleTypeDef hdma_spi1_rx;  /* SPI1接收DMA句柄声明 */
+extern DMA_HandleTypeDef hdma_spi1_tx;  /* SPI1发送DMA句柄声明 */
 
 void SPI_Init(void);
 void SPI_Start(void);
@@ -14,5 +21,9 @@ uint8_t SPI_ReceiveByte(void);
 void SPI_ReceiveBytes(uint8_t *receiveDataBuffer, uint16_t size);
 uint8_t SPI_SwapByte(uint8_t transmitData);
 void SPI_SwapBytes(uint8_t *transmitDataBuffer, uint8_t *receiveDataBuffer, uint16_t size);
+HAL_StatusTypeDef SPI_TransferAsync(const uint8_t *header, uint16_t headerLen, uint8_t *txData, uint8_t *rxData,
+                                    uint16_t len, SPI_CallbackTypeDef callback);
+HAL_StatusTypeDef SPI_Transfer(const uint8_t *header, uint16_t headerLen, uint8_t *txData, uint8_t *rxData, uint16_t len);
+uint8_t SPI_IsBusy(void);
 
 #endif /* __SPI_H */
@@ -134,6 +134,15 @@
 #define LLCC68_REG_DIO3_OUTPUT_CONTROL                   0x0920      /**< dio3 output voltage control register */
 #define LLCC68_REG_EVENT_MASK                            0x0944      /**< event mask register */
 
+/**
+ * @brief busy wait definition
+ */
+#define LLCC68_BUSY_POLL_US                              2           /**< busy poll interval in us */
+#define LLCC68_BUSY_TIMEOUT_US                           1000000     /**< busy timeout in us */
+#define LLCC68_SPI_MAX_LEN                               256         /**< max data phase length of one transfer */
+#define LLCC68_TX_WAIT_MARGIN_MS                         100         /**< tx wait margin over the chip timeout in ms */
+#define LLCC68_TX_WAIT_DEFAULT_MS                        10000       /**< tx wait when the chip timeout is disabled in ms */
+
 /**
  * @brief      read bytes
  * @param[in]  *handle points to an llcc68 handle structure
@@ -147,9 +156,9 @@
  */
 static uint8_t a_llcc68_spi_read(llcc68_handle_t *handle, uint8_t reg, uint8_t *buf, uint16_t len)
 {
-    if (handle->spi_write_read(&reg, 1, buf, len) != 0)   /* spi read */
+    if (handle->spi_transfer(&reg, 1, NULL, buf, len) != 0)   /* spi read */
     {
-        return 1;                                         /* return error */
+        return 1;                                             /* return error */
     }
     else
     {
@@ -166,22 +175,19 @@ static uint8_t a_llcc68_spi_read(llcc68_handle_t *handle, uint8_t reg, uint8_t *
  * @return    status code
  *            - 0 success
  *            - 1 spi write failed
- *            - 2 len is over 383
+ *            - 2 len is over 256
  * @note      none
  */
 static uint8_t a_llcc68_spi_write(llcc68_handle_t *handle, uint8_t reg, uint8_t *buf, uint16_t len)
 {
-    if (len > (384 - 1))                                              /* check the length */
+    if (len > LLCC68_SPI_MAX_LEN)                                     /* check the length */
     {
-        handle->debug_print("llcc68: len is over 383.\n");            /* len is over 383 */
+        handle->debug_print("llcc68: len is over 256.\n");            /* len is over 256 */
         
         return 2;                                                     /* return error */
     }
     
-    memset(handle->buf, 0, sizeof(uint8_t) * 384);                    /* clear the buffer */
-    handle->buf[0] = reg;                                             /* set the reg */
-    memcpy(&handle->buf[1], buf, len);                                /* copy the buffer */
-    if (handle->spi_write_read(handle->buf, len + 1, NULL, 0) != 0)   /* spi write */
+    if (handle->spi_transfer(&reg, 1, buf, NULL, len) != 0)           /* spi write */
     {
         return 1;                                                     /* return error */
     }
@@ -200,32 +206,30 @@ static uint8_t a_llcc68_spi_write(llcc68_handle_t *handle, uint8_t reg, uint8_t
  * @return     status code
  *             - 0 success
  *             - 1 spi read register failed
- *             - 2 len is over 383
+ *             - 2 len is over 256
  * @note       none
  */
 static uint8_t a_llcc68_spi_read_register(llcc68_handle_t *handle, uint16_t reg, uint8_t *buf, uint16_t len)
 {
-    uint8_t reg_buf[3];
+    uint8_t reg_buf[4];
     
-    if (len > (384 - 1))                                                            /* check the length */
+    if (len > LLCC68_SPI_MAX_LEN)                                                   /* check the length */
     {
-        handle->debug_print("llcc68: len is over 383.\n");                          /* len is over 383 */
+        handle->debug_print("llcc68: len is over 256.\n");                          /* len is over 256 */
         
         return 2;                                                                   /* return error */
     }
     
-    memset(handle->buf, 0, sizeof(uint8_t) * 384);                                  /* clear the buffer */
     reg_buf[0] = LLCC68_COMMAND_READ_REGISTER;                                      /* set the command */
     reg_buf[1] = (reg >> 8) & 0xFF;                                                 /* set msb */
     reg_buf[2] = (reg >> 0) & 0xFF;                                                 /* set lsb */
-    if (handle->spi_write_read((uint8_t *)reg_buf, 3, handle->buf, len + 1) != 0)   /* spi read */
+    reg_buf[3] = 0x00;                                                              /* status byte clocked as nop */
+    if (handle->spi_transfer((uint8_t *)reg_buf, 4, NULL, buf, len) != 0)           /* spi read */
     {
         return 1;                                                                   /* return error */
     }
     else
     {
-        memcpy(buf, handle->buf + 1, len);                                          /* copy the data */
-        
         return 0;                                                                   /* success return 0 */
     }
 }
@@ -239,24 +243,24 @@ static uint8_t a_llcc68_spi_read_register(llcc68_handle_t *handle, uint16_t reg,
  * @return    status code
  *            - 0 success
  *            - 1 spi write register failed
- *            - 2 len is over 381
+ *            - 2 len is over 256
  * @note      none
  */
 static uint8_t a_llcc68_spi_write_register(llcc68_handle_t *handle, uint16_t reg, uint8_t *buf, uint16_t len)
 {
-    if (len > (384 - 3))                                              /* check the length */
+    uint8_t reg_buf[3];
+    
+    if (len > LLCC68_SPI_MAX_LEN)                                     /* check the length */
     {
-        handle->debug_print("llcc68: len is over 381.\n");            /* len is over 381 */
+        handle->debug_print("llcc68: len is over 256.\n");            /* len is over 256 */
         
         return 2;                                                     /* return error */
     }
     
-    memset(handle->buf, 0, sizeof(uint8_t) * 384);                    /* clear the buffer */
-    handle->buf[0] = LLCC68_COMMAND_WRITE_REGISTER;                   /* set the command */
-    handle->buf[1] = (reg >> 8) & 0xFF;                               /* set reg msb */
-    handle->buf[2] = (reg >> 0) & 0xFF;                               /* set reg lsb */
-    memcpy(&handle->buf[3], buf, len);                                /* copy the buffer */
-    if (handle->spi_write_read(handle->buf, len + 3, NULL, 0) != 0)   /* spi write */
+    reg_buf[0] = LLCC68_COMMAND_WRITE_REGISTER;                       /* set the command */
+    reg_buf[1] = (reg >> 8) & 0xFF;                                   /* set reg msb */
+    reg_buf[2] = (reg >> 0) & 0xFF;                                   /* set reg lsb */
+    if (handle->spi_transfer(reg_buf, 3, buf, NULL, len) != 0)        /* spi write */
     {
         return 1;                                                     /* return error */
     }
@@ -275,23 +279,23 @@ static uint8_t a_llcc68_spi_write_register(llcc68_handle_t *handle, uint16_t reg
  * @return    status code
  *            - 0 success
  *            - 1 spi write buffer failed
- *            - 2 len is over 382
+ *            - 2 len is over 256
  * @note      none
  */
 static uint8_t a_llcc68_spi_write_buffer(llcc68_handle_t *handle, uint8_t offset, uint8_t *buf, uint16_t len)
 {
-    if (len > (384 - 2))                                              /* check the length */
+    uint8_t reg_buf[2];
+    
+    if (len > LLCC68_SPI_MAX_LEN)                                     /* check the length */
     {
-        handle->debug_print("llcc68: len is over 382.\n");            /* len is over 382 */
+        handle->debug_print("llcc68: len is over 256.\n");            /* len is over 256 */
         
         return 2;                                                     /* return error */
     }
     
-    memset(handle->buf, 0, sizeof(uint8_t) * 384);                    /* clear the buffer */
-    handle->buf[0] = LLCC68_COMMAND_WRITE_BUFFER;                     /* set the command */
-    handle->buf[1] = offset;                                          /* set reg msb */
-    memcpy(&handle->buf[2], buf, len);                                /* copy the buffer */
-    if (handle->spi_write_read(handle->buf, len + 2, NULL, 0) != 0)   /* spi write */
+    reg_buf[0] = LLCC68_COMMAND_WRITE_BUFFER;                         /* set the command */
+    reg_buf[1] = offset;                                              /* set the offset */
+    if (handle->spi_transfer(reg_buf, 2, buf, NULL, len) != 0)        /* spi write, payload streamed from caller */
     {
         return 1;                                                     /* return error */
     }
@@ -310,31 +314,29 @@ static uint8_t a_llcc68_spi_write_buffer(llcc68_handle_t *handle, uint8_t offset
  * @return     status code
  *             - 0 success
  *             - 1 spi read buffer failed
- *             - 2 len is over 383
+ *             - 2 len is over 256
  * @note      none
  */
 static uint8_t a_llcc68_spi_read_buffer(llcc68_handle_t *handle, uint8_t offset, uint8_t *buf, uint16_t len)
 {
-    uint8_t reg_buf[2];
+    uint8_t reg_buf[3];
     
-    if (len > (384 - 1))                                                            /* check the length */
+    if (len > LLCC68_SPI_MAX_LEN)                                                   /* check the length */
     {
-        handle->debug_print("llcc68: len is over 383.\n");                          /* len is over 383 */
+        handle->debug_print("llcc68: len is over 256.\n");                          /* len is over 256 */
         
         return 2;                                                                   /* return error */
     }
     
-    memset(handle->buf, 0, sizeof(uint8_t) * 384);                                  /* clear the buffer */
     reg_buf[0] = LLCC68_COMMAND_READ_BUFFER ;                                       /* set the command */
-    reg_buf[1] = offset;                                                            /* set msb */
-    if (handle->spi_write_read((uint8_t *)reg_buf, 2, handle->buf, len + 1) != 0)   /* spi write */
+    reg_buf[1] = offset;                                                            /* set the offset */
+    reg_buf[2] = 0x00;                                                              /* status byte clocked as nop */
+    if (handle->spi_transfer((uint8_t *)reg_buf, 3, NULL, buf, len) != 0)           /* spi read into caller */
     {
         return 1;                                                                   /* return error */
     }
     else
     {
-        memcpy(buf, handle->buf + 1, len);                                          /* copy the data */
-        
         return 0;                                                                   /* success return 0 */
     }
 }
@@ -345,14 +347,14 @@ static uint8_t a_llcc68_spi_read_buffer(llcc68_handle_t *handle, uint8_t offset,
  * @return    status code
  *            - 0 idle
  *            - 1 busy or error
- * @note      none
+ * @note      busy is polled every LLCC68_BUSY_POLL_US, most commands release it within a few us
  */
 static uint8_t a_llcc68_check_busy(llcc68_handle_t *handle)
 {
     uint8_t level;
-    uint8_t timeout;
+    uint32_t timeout;
     
-    timeout = 100;                                            /* set max 100 */
+    timeout = LLCC68_BUSY_TIMEOUT_US / LLCC68_BUSY_POLL_US;  /* set max polls */
     
     while (1)                                                 /* loop */
     {
@@ -360,30 +362,16 @@ static uint8_t a_llcc68_check_busy(llcc68_handle_t *handle)
         {
              return 1;                                        /* return error */
         }
-        else
+        if (level == 0)                                       /* check level */
         {
-            if (level == 0)                                   /* check level */
-            {
-                return 0;                                     /* success return 0 */
-            }
-            else if ((level == 1) && (timeout != 0))          /* check level and timeout */
-            {
-                handle->delay_ms(10);                         /* delay 10 ms */
-                timeout--;                                    /* timeout-- */
-                if (timeout != 0)                             /* check timeout */
-                {
-                    continue;                                 /* continue */
-                }
-                else
-                {
-                    return 1;                                 /* return error */
-                }
-            }
-            else
-            {
-                return 1;                                     /* return error */
-            }
+            return 0;                                         /* success return 0 */
+        }
+        if (timeout == 0)                                     /* check timeout */
+        {
+            return 1;                                         /* return error */
         }
+        handle->delay_us(LLCC68_BUSY_POLL_US);                /* delay poll interval */
+        timeout--;                                            /* timeout-- */
     }
 }
 
@@ -612,6 +600,12 @@ uint8_t llcc68_init(llcc68_handle_t *handle)
        
         return 3;                                                                          /* return error */
     }
+    if (handle->spi_transfer == NULL)                                                      /* check spi_transfer */
+    {
+        handle->debug_print("llcc68: spi_transfer is null.\n");                            /* spi_transfer is null */
+       
+        return 3;                                                                          /* return error */
+    }
     if (handle->reset_gpio_init == NULL)                                                   /* check reset_gpio_init */
     {
         handle->debug_print("llcc68: reset_gpio_init is null.\n");                         /* reset_gpio_init is null */
@@ -654,6 +648,12 @@ uint8_t llcc68_init(llcc68_handle_t *handle)
        
         return 3;                                                                          /* return error */
     }
+    if (handle->delay_us == NULL)                                                          /* check delay_us */
+    {
+        handle->debug_print("llcc68: delay_us is null.\n");                                /* delay_us is null */
+       
+        return 3;                                                                          /* return error */
+    }
     if (handle->receive_callback == NULL)                                                  /* check receive_callback */
     {
         handle->debug_print("llcc68: receive_callback is null.\n");                        /* receive_callback is null */
@@ -738,6 +738,80 @@ uint8_t llcc68_init(llcc68_handle_t *handle)
     return 0;                                                                              /* success return 0 */
 }
 
+/**
+ * @brief     resume the chip from the warm start sleep without a hardware reset
+ * @param[in] *handle points to an llcc68 handle structure
+ * @return    status code
+ *            - 0 success
+ *            - 1 spi initialization failed
+ *            - 2 handle is NULL
+ *            - 3 linked functions is NULL
+ *            - 4 reset gpio initialization failed
+ *            - 5 busy gpio initialization failed
+ *            - 6 wake up chip failed
+ * @note      the configuration kept by the warm start is not touched
+ */
+uint8_t llcc68_resume(llcc68_handle_t *handle)
+{
+    uint8_t buf[1];
+    uint8_t prev;
+    
+    if (handle == NULL)                                                                    /* check handle */
+    {
+        return 2;                                                                          /* return error */
+    }
+    if ((handle->debug_print == NULL) || (handle->spi_init == NULL) ||
+        (handle->spi_transfer == NULL) || (handle->reset_gpio_init == NULL) ||
+        (handle->reset_gpio_write == NULL) || (handle->busy_gpio_init == NULL) ||
+        (handle->busy_gpio_read == NULL) || (handle->delay_us == NULL))                   /* check linked functions */
+    {
+        return 3;                                                                          /* return error */
+    }
+    
+    if (handle->spi_init() != 0)                                                           /* spi initialization */
+    {
+        handle->debug_print("llcc68: spi initialization failed.\n");                       /* spi initialization failed */
+        
+        return 1;                                                                          /* return error */
+    }
+    if (handle->reset_gpio_init() != 0)                                                    /* reset gpio initialization */
+    {
+        handle->debug_print("llcc68: reset gpio initialization failed.\n");                /* reset gpio initialization failed */
+        
+        return 4;                                                                          /* return error */
+    }
+    if (handle->busy_gpio_init() != 0)                                                     /* busy gpio initialization */
+    {
+        handle->debug_print("llcc68: busy gpio initialization failed.\n");                 /* busy gpio initialization failed */
+        
+        return 5;                                                                          /* return error */
+    }
+    if (handle->reset_gpio_write(1) != 0)                                                  /* keep reset released */
+    {
+        handle->debug_print("llcc68: wake up chip failed.\n");                             /* wake up chip failed */
+        
+        return 6;                                                                          /* return error */
+    }
+    
+    (void)a_llcc68_spi_read(handle, LLCC68_COMMAND_GET_STATUS, (uint8_t *)buf, 1);        /* nss falling edge wakes the chip */
+    if (a_llcc68_check_busy(handle) != 0)                                                  /* wait for the warm start */
+    {
+        handle->debug_print("llcc68: wake up chip failed.\n");                             /* wake up chip failed */
+        
+        return 6;                                                                          /* return error */
+    }
+    prev = 0x00;
+    if (a_llcc68_spi_write(handle, LLCC68_COMMAND_SET_STANDBY, (uint8_t *)&prev, 1) != 0)  /* write command */
+    {
+        handle->debug_print("llcc68: set standby failed.\n");                              /* set standby failed */
+        
+        return 6;                                                                          /* return error */
+    }
+    handle->inited = 1;                                                                    /* flag finish initialization */
+    
+    return 0;                                                                              /* success return 0 */
+}
+
 /**
  * @brief     close the chip
  * @param[in] *handle points to an llcc68 handle structure
@@ -1256,7 +1330,7 @@ uint8_t llcc68_lora_transmit(llcc68_handle_t *handle, llcc68_clock_source_t stan
        
         return 1;                                                                                          /* return error */
     }
-    ms = us / 1000 + 10000;                                                                                /* set timeout */
+    ms = (us != 0) ? (us / 1000 + LLCC68_TX_WAIT_MARGIN_MS) : LLCC68_TX_WAIT_DEFAULT_MS;                   /* set timeout */
     while ((ms != 0) && (handle->tx_done == 0) && (handle->timeout == 0))                                  /* check timeout */
     {
         llcc68_irq_handler(handle);
@@ -343,7 +343,10 @@ typedef struct llcc68_handle_s
     uint8_t (*spi_deinit)(void);                                          /**< point to a spi_deinit function address */
     uint8_t (*spi_write_read)(uint8_t *in_buf, uint32_t in_len,
                               uint8_t *out_buf, uint32_t out_len);        /**< point to a spi_write_read function address */
+    uint8_t (*spi_transfer)(uint8_t *header, uint32_t header_len,
+                            uint8_t *tx_buf, uint8_t *rx_buf, uint32_t len); /**< point to a spi_transfer function address */
     void (*delay_ms)(uint32_t ms);                                        /**< point to a delay_ms function address */
+    void (*delay_us)(uint32_t us);                                        /**< point to a delay_us function address */
     void (*debug_print)(const char *const fmt, ...);                      /**< point to a debug_print function address */
     void (*receive_callback)(uint16_t type,
                              uint8_t *buf, uint16_t len);                 /**< point to a receive_callback function address */
@@ -353,7 +356,6 @@ typedef struct llcc68_handle_s
     uint8_t cad_detected;                                                 /**< cad detected flag */
     uint8_t crc_error;                                                    /**< crc error flag */
     uint8_t timeout;                                                      /**< timeout flag */
-    uint8_t buf[384];                                                     /**< inner buffer */
     uint8_t receive_buf[256];                                             /**< receive buffer */
     uint8_t receive_len;
 } llcc68_handle_t;
@@ -417,6 +419,14 @@ typedef struct llcc68_info_s
  */
 #define DRIVER_LLCC68_LINK_SPI_WRITE_READ(HANDLE, FUC)            (HANDLE)->spi_write_read = FUC
 
+/**
+ * @brief     link spi_transfer function
+ * @param[in] HANDLE points to an llcc68 handle structure
+ * @param[in] FUC points to a spi_transfer function address
+ * @note      header and data phase are sent in one chip select window without copying
+ */
+#define DRIVER_LLCC68_LINK_SPI_TRANSFER(HANDLE, FUC)              (HANDLE)->spi_transfer = FUC
+
 /**
  * @brief     link reset_gpio_init function
  * @param[in] HANDLE points to an llcc68 handle structure
@@ -473,6 +483,14 @@ typedef struct llcc68_info_s
  */
 #define DRIVER_LLCC68_LINK_DELAY_MS(HANDLE, FUC)                  (HANDLE)->delay_ms = FUC
 
+/**
+ * @brief     link delay_us function
+ * @param[in] HANDLE points to an llcc68 handle structure
+ * @param[in] FUC points to a delay_us function address
+ * @note      none
+ */
+#define DRIVER_LLCC68_LINK_DELAY_US(HANDLE, FUC)                  (HANDLE)->delay_us = FUC
+
 /**
  * @brief     link debug_print function
  * @param[in] HANDLE points to an llcc68 handle structure
@@ -537,6 +555,21 @@ uint8_t llcc68_irq_handler(llcc68_handle_t *handle);
  */
 uint8_t llcc68_init(llcc68_handle_t *handle);
 
+/**
+ * @brief     resume the chip from the warm start sleep without a hardware reset
+ * @param[in] *handle points to an llcc68 handle structure
+ * @return    status code
+ *            - 0 success
+ *            - 1 spi initialization failed
+ *            - 2 handle is NULL
+ *            - 3 linked functions is NULL
+ *            - 4 reset gpio initialization failed
+ *            - 5 busy gpio initialization failed
+ *            - 6 wake up chip failed
+ * @note      the configuration kept by the warm start is not touched
+ */
+uint8_t llcc68_resume(llcc68_handle_t *handle);
+
 /**
  * @brief     close the chip
  * @param[in] *handle points to an llcc68 handle structure
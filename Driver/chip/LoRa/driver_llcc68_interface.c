@@ -1,8 +1,9 @@
 #include "driver_llcc68_interface.h"
 #include "gpio/gpio.h"
+#include "delay/delay.h"
 
-#define CS_L (HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_RESET))
-#define CS_H (HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_SET))
+/* SPIۼƴֽ(ͷ), ͳƳʼ̵߿ */
+uint32_t llcc68SpiBytes = 0;
 
 /**
  * @brief  interface spi bus init
@@ -14,7 +15,6 @@
 uint8_t llcc68_interface_spi_init(void)
 {
     SPI_Init();
-    GPIOB1_Init();  /* ʼLoRaоƬBUSY, ֻ */
     GPIOB2_Init();  /* ʼLoRaоƬTxEN, дʹ, Ĭʧ */
     GPIOB12_Init(); /* ʼLoRaоƬRxEN, ʹ, Ĭʧ */
     return 0;
@@ -47,35 +47,28 @@ uint8_t llcc68_interface_spi_deinit(void)
 uint8_t llcc68_interface_spi_write_read(uint8_t *in_buf, uint32_t in_len,
                                         uint8_t *out_buf, uint32_t out_len)
 {
-    // 1. Ƭѡ
-    CS_L;
-
-    // 2. 
-    if (in_len > 0)
-    {
-        HAL_StatusTypeDef status = HAL_SPI_Transmit(&hspi1, in_buf, in_len, 1000);
-        if (status != HAL_OK)
-        {
-            // ͽʧ  ҲҪرƬѡ
-            CS_H;
-            return 1;
-        }
-    }
-    // 3. 
-    if (out_len > 0)
-    {
-        HAL_StatusTypeDef status = HAL_SPI_Receive(&hspi1, out_buf, out_len, 1000);
-        if (status != HAL_OK)
-        {
-            // ͽʧ  ҲҪرƬѡ
-            CS_H;
-            return 1;
-        }
-    }
+    /* дΪͷѯ, ֱӽյ߻, MOSINOP */
+    llcc68SpiBytes += in_len + out_len;
+    return SPI_Transfer(in_buf, in_len, NULL, out_buf, out_len) == HAL_OK ? 0 : 1;
+}
 
-    // رƬѡ
-    CS_H;
-    return 0;
+/**
+ * @brief      interface spi bus transfer
+ * @param[in]  *header points to a command header buffer
+ * @param[in]  header_len is the header length
+ * @param[in]  *tx_buf points to a data buffer to send, NULL for read
+ * @param[out] *rx_buf points to a data buffer to receive, NULL for write
+ * @param[in]  len is the data length
+ * @return     status code
+ *             - 0 success
+ *             - 1 transfer failed
+ * @note       ͷݶͬһƬѡڴ, ݶνϳʱDMAֱӰ˵߻
+ */
+uint8_t llcc68_interface_spi_transfer(uint8_t *header, uint32_t header_len,
+                                      uint8_t *tx_buf, uint8_t *rx_buf, uint32_t len)
+{
+    llcc68SpiBytes += header_len + len;
+    return SPI_Transfer(header, header_len, tx_buf, rx_buf, len) == HAL_OK ? 0 : 1;
 }
 
 /**
@@ -135,6 +128,7 @@ uint8_t llcc68_interface_reset_gpio_write(uint8_t data)
  */
 uint8_t llcc68_interface_busy_gpio_init(void)
 {
+    GPIOB1_Init();  /* ʼLoRaоƬBUSY, ֻ */
     return 0;
 }
 
@@ -174,6 +168,16 @@ void llcc68_interface_delay_ms(uint32_t ms)
     HAL_Delay(ms);
 }
 
+/**
+ * @brief     interface delay us
+ * @param[in] us
+ * @note      BUSYŵ΢뼶ѯ
+ */
+void llcc68_interface_delay_us(uint32_t us)
+{
+    delay_us(us);
+}
+
 /**
  * @brief     interface print format data
  * @param[in] fmt is the format data
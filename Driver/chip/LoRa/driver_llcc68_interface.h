@@ -5,6 +5,8 @@
 #include "spi/spi.h"
 #include "stdarg.h"
 
+extern uint32_t llcc68SpiBytes;  /**< total spi bytes including command headers */
+
 #ifdef __cplusplus
 extern "C"{
 #endif
@@ -48,6 +50,21 @@ uint8_t llcc68_interface_spi_deinit(void);
 uint8_t llcc68_interface_spi_write_read(uint8_t *in_buf, uint32_t in_len,
                                         uint8_t *out_buf, uint32_t out_len);
 
+/**
+ * @brief      interface spi bus transfer
+ * @param[in]  *header points to a command header buffer
+ * @param[in]  header_len is the header length
+ * @param[in]  *tx_buf points to a data buffer to send, NULL for read
+ * @param[out] *rx_buf points to a data buffer to receive, NULL for write
+ * @param[in]  len is the data length
+ * @return     status code
+ *             - 0 success
+ *             - 1 transfer failed
+ * @note       none
+ */
+uint8_t llcc68_interface_spi_transfer(uint8_t *header, uint32_t header_len,
+                                      uint8_t *tx_buf, uint8_t *rx_buf, uint32_t len);
+
 /**
  * @brief  interface reset gpio init
  * @return status code
@@ -111,6 +128,13 @@ uint8_t llcc68_interface_busy_gpio_read(uint8_t *value);
  */
 void llcc68_interface_delay_ms(uint32_t ms);
 
+/**
+ * @brief     interface delay us
+ * @param[in] us
+ * @note      none
+ */
+void llcc68_interface_delay_us(uint32_t us);
+
 /**
  * @brief     interface print format data
  * @param[in] fmt is the format data
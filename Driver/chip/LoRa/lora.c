@@ -17,6 +17,7 @@ llcc68_handle_t gs_handle = {
     .spi_init = llcc68_interface_spi_init,                    /* SPI接口初始化函数 */
     .spi_deinit = llcc68_interface_spi_deinit,                /* SPI接口反初始化函数 */
     .spi_write_read = llcc68_interface_spi_write_read,        /* SPI读写操作函数 */
+    .spi_transfer = llcc68_interface_spi_transfer,            /* SPI分段零拷贝传输函数 */
     .reset_gpio_init = llcc68_interface_reset_gpio_init,      /* 复位GPIO初始化函数 */
     .reset_gpio_deinit = llcc68_interface_reset_gpio_deinit,  /* 复位GPIO反初始化函数 */
     .reset_gpio_write = llcc68_interface_reset_gpio_write,    /* 复位GPIO写入函数 */
@@ -25,255 +26,983 @@ llcc68_handle_t gs_handle = {
     .busy_gpio_read = llcc68_interface_busy_gpio_read,        /* 忙碌GPIO读取函数 */
     .debug_print = llcc68_interface_debug_print,              /* 调试打印函数 */
     .delay_ms = llcc68_interface_delay_ms,                    /* 毫秒延时函数 */
+    .delay_us = llcc68_interface_delay_us,                    /* 微秒延时函数, 用于BUSY轮询 */
     .receive_callback = llcc68_interface_receive_callback,    /* 接收回调函数 */
 }; /**< LLCC68芯片操作句柄 */
 
+/* 异步操作状态与回调, 由LORA_Process()在DIO1中断后分发 */
+static volatile LoraStateTypeDef loraState = LORA_STATE_IDLE;
+static uint8_t loraRxSingle = 0;                    /* 1表示单次接收, 完成或超时后回到空闲 */
+static LORA_TxCallbackTypeDef loraTxCallback = NULL;
+static LORA_RxCallbackTypeDef loraRxCallback = NULL;
+static LORA_CadCallbackTypeDef loraCadCallback = NULL;
+static volatile uint8_t loraTxResult = 0;           /* 阻塞发送的结果 */
+static uint8_t loraTxLength = 0;                    /* 当前发送数据包长度, 用于计算空中时间 */
+static int16_t loraPacketRssi = 0;                  /* 最近一次接收数据包的RSSI(dBm) */
+static int8_t loraPacketSnr = 0;                    /* 最近一次接收数据包的SNR(dB) */
+
+/* 低功耗监听档位及各档位的睡眠时间(ms) */
+static LoraListenProfileTypeDef loraListenProfile = LORA_LISTEN_PROFILE;
+static const uint16_t loraListenSleepMs[LORA_LISTEN_NUM] = {0, 100, 1000};
+
+/* 区域子频段表 */
+static const LoraSubBandTypeDef loraSubBands[] = {
+#ifdef LORA_REGION_EU868
+    {863000000, 868000000, 10},     /* g: 1% */
+    {868000000, 868600000, 10},     /* g1: 1% */
+    {868700000, 869200000, 1},      /* g2: 0.1% */
+    {869400000, 869650000, 100},    /* g3: 10% */
+    {869700000, 870000000, 10},     /* g4: 1% */
+#else
+    {470000000, 510000000, LORA_DUTY_CYCLE_PERMILLE},
+#endif
+};
+
+#define LORA_SUB_BAND_NUM (sizeof(loraSubBands) / sizeof(loraSubBands[0]))
+
+/* 占空比额度, 由persist模块掉电保持 */
+LoraDutyStateTypeDef loraDuty = {0};
+
+/* 跳频信道表 */
+static const uint32_t loraChannels[] = {LORA_CHANNEL_PLAN};
+
+#define LORA_CHANNEL_NUM (sizeof(loraChannels) / sizeof(loraChannels[0]))
+
+/* 先听后发状态 */
+static uint8_t loraTxChannel = 0;                   /* 当前发送信道在信道表中的下标 */
+static uint32_t loraTxFrequency = 0;                /* 当前数据包的发送频率(Hz), 0表示尚未选择 */
+static uint8_t loraLbtBusy = 0;                     /* 当前数据包连续检测到信道忙的次数 */
+static uint32_t loraBackoffStart = 0;               /* 退避开始时的HAL tick */
+static uint32_t loraBackoffMs = 0;                  /* 本次退避时长(ms) */
+static uint32_t loraRandom = 0x2545F491;            /* 伪随机数状态, 每次取数时混入芯片随机数 */
+static uint8_t loraLbtOn = 1;                       /* 运行时先听后发开关, 定时发送的信标需关闭 */
+static uint8_t loraRxInvertIq = LLCC68_LORA_DEFAULT_INVERT_IQ;  /* 接收IQ极性, LoRaWAN下行需反转 */
+
+/* 先听后发统计 */
+LoraLbtStatsTypeDef loraLbtStats = {0};
+
+static uint8_t LORA_ConfigReceive(void);
+
+/* 目标配置, 默认取LLCC68_LORA_DEFAULT_*参数 */
+LoraConfigTypeDef loraConfig = {
+    .frequency = LLCC68_LORA_DEFAULT_RF_FREQUENCY,
+    .sf = LLCC68_LORA_DEFAULT_SF,
+    .bandwidth = LLCC68_LORA_DEFAULT_BANDWIDTH,
+    .cr = LLCC68_LORA_DEFAULT_CR,
+    .ldro = LLCC68_LORA_DEFAULT_LOW_DATA_RATE_OPTIMIZE,
+    .txDbm = LLCC68_LORA_DEFAULT_TX_DBM,
+    .rampTime = LLCC68_LORA_DEFAULT_RAMP_TIME,
+    .paDutyCycle = LLCC68_LORA_DEFAULT_PA_CONFIG_DUTY_CYCLE,
+    .paHpMax = LLCC68_LORA_DEFAULT_PA_CONFIG_HP_MAX,
+    .syncWord = LLCC68_LORA_DEFAULT_SYNC_WORD,
+    .rxGain = LLCC68_LORA_DEFAULT_RX_GAIN,
+    .ocp = LLCC68_LORA_DEFAULT_OCP,
+};
+
+/* 芯片当前配置的影子, 冷启动(硬件复位)后无效 */
+LoraShadowTypeDef loraShadow = {0};
+
+/**
+ * @brief   记录配置步骤失败
+ * @param   step 失败的步骤名
+ * @retval  uint8_t 固定返回1
+ */
+static uint8_t LORA_ConfigFailed(const char *step)
+{
+    llcc68_interface_debug_print("llcc68: %s failed.\n", step);
+    return 1;
+}
+
 /**
- * @brief   初始化LoRa通信模块
- * @details 完成LLCC68芯片的完整初始化流程，包括：
- *          1. 初始化芯片基本功能和接口
- *          2. 设置待机模式和时钟源
- *          3. 配置前导码和电源管理参数
- *          4. 设置中断和状态清除
- *          5. 配置LoRa调制参数和发射功率
- *          6. 设置RF频率和缓冲区地址
- *          7. 配置同步字和接收增益
- *          8. 进入接收模式
+ * @brief   把寄存器追加到热启动保持列表
+ * @details 读出当前列表, 只追加尚未在列表中的寄存器, 保留芯片已有的项
+ * @param   regs 寄存器地址
+ * @param   num 寄存器个数
+ * @retval  uint8_t 0: 成功；1: 读写失败或列表已满
+ */
+static uint8_t LORA_RetainRegisters(const uint16_t *regs, uint8_t num)
+{
+    uint8_t list[1 + LORA_RETENTION_MAX * 2];
+    uint8_t count;
+    uint8_t i, j;
+
+    if (llcc68_read_register(&gs_handle, LORA_REG_RETENTION_LIST, list, sizeof(list)) != 0)
+    {
+        return 1;
+    }
+    count = (list[0] > LORA_RETENTION_MAX) ? 0 : list[0];
+
+    for (i = 0; i < num; i++)
+    {
+        for (j = 0; j < count; j++)
+        {
+            if ((((uint16_t)list[1 + j * 2] << 8) | list[2 + j * 2]) == regs[i])
+            {
+                break;
+            }
+        }
+        if (j < count)
+        {
+            continue;
+        }
+        if (count >= LORA_RETENTION_MAX)
+        {
+            return 1;
+        }
+        list[1 + count * 2] = (uint8_t)(regs[i] >> 8);
+        list[2 + count * 2] = (uint8_t)regs[i];
+        count++;
+    }
+
+    list[0] = count;
+    return llcc68_write_register(&gs_handle, LORA_REG_RETENTION_LIST, list, sizeof(list)) != 0;
+}
+
+/**
+ * @brief   冷启动后的一次性配置
+ * @details 写入不随业务变化的设置: 前导码计时、电源调节器、回退模式、中断、数据包类型、
+ *          缓冲区基址、符号超时、统计与错误清除、发射调制与钳位勘误。热启动睡眠默认不保持的
+ *          勘误寄存器(RxGain、发射调制、IQ极性、发射钳位)追加到保持列表, 唤醒后无需重写。
  * @param   None
- * @retval  None
- * @note    此函数必须在使用其他LoRa相关函数前调用
- *          初始化过程中如有任何步骤失败，会打印错误信息
- * @warning 确保SPI和GPIO引脚的时钟已使能，否则初始化会失败
+ * @retval  uint8_t 0: 成功；1: 任一步骤失败
  */
-void LORA_Init(void)
+static uint8_t LORA_ConfigOnce(void)
 {
-    uint8_t res;
-    uint32_t reg;
     uint8_t modulation;
     uint8_t config;
+    static const uint16_t retention[] = {
+        0x08AC,     /* RxGain */
+        0x0889,     /* 发射调制, 勘误位0x04 */
+        0x0736,     /* IQ极性设置, 反相IQ勘误 */
+        0x08D8,     /* 发射钳位, 勘误位0x1E */
+    };
 
-    /* 初始化LLCC68芯片基本功能 */
-    res = llcc68_init(&gs_handle);
-    if (res != 0)
+    if (llcc68_set_stop_timer_on_preamble(&gs_handle, LLCC68_LORA_DEFAULT_STOP_TIMER_ON_PREAMBLE) != 0)
     {
-        llcc68_interface_debug_print("llcc68: init failed.\n");
+        return LORA_ConfigFailed("stop timer on preamble");
     }
-    
+    if (llcc68_set_regulator_mode(&gs_handle, LLCC68_LORA_DEFAULT_REGULATOR_MODE) != 0)
+    {
+        return LORA_ConfigFailed("set regulator mode");
+    }
+    if (llcc68_set_rx_tx_fallback_mode(&gs_handle, LLCC68_RX_TX_FALLBACK_MODE_STDBY_XOSC) != 0)
+    {
+        return LORA_ConfigFailed("set rx tx fallback mode");
+    }
+    if (llcc68_set_dio_irq_params(&gs_handle, 0x03FF, 0x03FF, 0x0000, 0x0000) != 0)
+    {
+        return LORA_ConfigFailed("set dio irq params");
+    }
+    if (llcc68_clear_irq_status(&gs_handle, 0x03FF) != 0)
+    {
+        return LORA_ConfigFailed("clear irq status");
+    }
+    if (llcc68_set_packet_type(&gs_handle, LLCC68_PACKET_TYPE_LORA) != 0)
+    {
+        return LORA_ConfigFailed("set packet type");
+    }
+    if (llcc68_set_buffer_base_address(&gs_handle, 0x00, 0x00) != 0)
+    {
+        return LORA_ConfigFailed("set buffer base address");
+    }
+    if (llcc68_set_lora_symb_num_timeout(&gs_handle, LLCC68_LORA_DEFAULT_SYMB_NUM_TIMEOUT) != 0)
+    {
+        return LORA_ConfigFailed("set lora symb num timeout");
+    }
+    if (llcc68_reset_stats(&gs_handle, 0x0000, 0x0000, 0x0000) != 0)
+    {
+        return LORA_ConfigFailed("reset stats");
+    }
+    if (llcc68_clear_device_errors(&gs_handle) != 0)
+    {
+        return LORA_ConfigFailed("clear device errors");
+    }
+
+    /* 发射调制与钳位寄存器勘误: 读-改-写 */
+    if (llcc68_get_tx_modulation(&gs_handle, &modulation) != 0 ||
+        llcc68_set_tx_modulation(&gs_handle, modulation | 0x04) != 0)
+    {
+        return LORA_ConfigFailed("set tx modulation");
+    }
+    if (llcc68_get_tx_clamp_config(&gs_handle, &config) != 0 ||
+        llcc68_set_tx_clamp_config(&gs_handle, config | 0x1E) != 0)
+    {
+        return LORA_ConfigFailed("set tx clamp config");
+    }
+
+    /* 勘误寄存器默认不在热启动保持范围内, 追加到保持列表 */
+    if (LORA_RetainRegisters(retention, sizeof(retention) / sizeof(retention[0])) != 0)
+    {
+        return LORA_ConfigFailed("set retention list");
+    }
+    return 0;
+}
+
+/**
+ * @brief   检查热启动唤醒后芯片配置是否保持
+ * @details 芯片掉电或复位后数据包类型恢复为GFSK, 读到LoRa说明配置仍然有效
+ * @param   None
+ * @retval  uint8_t 0: 配置保持；1: 配置已丢失
+ */
+static uint8_t LORA_CheckRetained(void)
+{
+    llcc68_packet_type_t type;
+
+    if (llcc68_get_packet_type(&gs_handle, &type) != 0)
+    {
+        return 1;
+    }
+    return type == LLCC68_PACKET_TYPE_LORA ? 0 : 1;
+}
+
+/**
+ * @brief   按影子差异写入射频配置
+ * @details 与loraShadow比较, 只发送发生变化的设置命令; 影子无效时全部写入。
+ *          SetPaConfig会把OCP恢复为默认值, 因此PA配置变化后同时重写OCP。
+ *          任一步骤失败时影子置为无效, 下次调用重新全部写入。
+ * @param   config 目标配置
+ * @retval  uint8_t 0: 成功；1: 写入失败
+ */
+uint8_t LORA_ApplyConfig(const LoraConfigTypeDef *config)
+{
+    LoraConfigTypeDef *shadow = &loraShadow.config;
+    uint8_t all = !loraShadow.valid;
+    uint8_t paChanged = 0;
+    uint32_t reg;
+
+    loraShadow.valid = 0;
+
+    if (all || config->paDutyCycle != shadow->paDutyCycle || config->paHpMax != shadow->paHpMax)
+    {
+        if (llcc68_set_pa_config(&gs_handle, config->paDutyCycle, config->paHpMax) != 0)
+        {
+            return LORA_ConfigFailed("set pa config");
+        }
+        shadow->paDutyCycle = config->paDutyCycle;
+        shadow->paHpMax = config->paHpMax;
+        paChanged = 1;
+    }
+    if (all || config->txDbm != shadow->txDbm || config->rampTime != shadow->rampTime)
+    {
+        if (llcc68_set_tx_params(&gs_handle, config->txDbm, (llcc68_ramp_time_t)config->rampTime) != 0)
+        {
+            return LORA_ConfigFailed("set tx params");
+        }
+        shadow->txDbm = config->txDbm;
+        shadow->rampTime = config->rampTime;
+    }
+    if (all || config->sf != shadow->sf || config->bandwidth != shadow->bandwidth ||
+        config->cr != shadow->cr || config->ldro != shadow->ldro)
+    {
+        if (llcc68_set_lora_modulation_params(&gs_handle, (llcc68_lora_sf_t)config->sf,
+                                              (llcc68_lora_bandwidth_t)config->bandwidth,
+                                              (llcc68_lora_cr_t)config->cr, (llcc68_bool_t)config->ldro) != 0)
+        {
+            return LORA_ConfigFailed("set lora modulation params");
+        }
+        shadow->sf = config->sf;
+        shadow->bandwidth = config->bandwidth;
+        shadow->cr = config->cr;
+        shadow->ldro = config->ldro;
+    }
+    if (all || config->frequency != shadow->frequency)
+    {
+        if (llcc68_frequency_convert_to_register(&gs_handle, config->frequency, &reg) != 0 ||
+            llcc68_set_rf_frequency(&gs_handle, reg) != 0)
+        {
+            return LORA_ConfigFailed("set rf frequency");
+        }
+        shadow->frequency = config->frequency;
+    }
+    if (all || config->syncWord != shadow->syncWord)
+    {
+        if (llcc68_set_lora_sync_word(&gs_handle, config->syncWord) != 0)
+        {
+            return LORA_ConfigFailed("set lora sync word");
+        }
+        shadow->syncWord = config->syncWord;
+    }
+    if (all || config->rxGain != shadow->rxGain)
+    {
+        if (llcc68_set_rx_gain(&gs_handle, config->rxGain) != 0)
+        {
+            return LORA_ConfigFailed("set rx gain");
+        }
+        shadow->rxGain = config->rxGain;
+    }
+    if (all || paChanged || config->ocp != shadow->ocp)
+    {
+        if (llcc68_set_ocp(&gs_handle, config->ocp) != 0)
+        {
+            return LORA_ConfigFailed("set ocp");
+        }
+        shadow->ocp = config->ocp;
+    }
+
+    loraShadow.valid = 1;
+    return 0;
+}
+
+/**
+ * @brief   唤醒LoRa芯片并写入配置, 芯片停留在待机模式
+ * @details 芯片上次由LORA_Sleep()进入热启动睡眠且影子有效时, 只唤醒芯片并按差异写入配置;
+ *          否则硬件复位芯片, 完成一次性配置后写入全部射频配置。
+ *          每次唤醒打印启动类型、耗时和SPI字节数, 用于比较冷/热启动开销。
+ * @param   None
+ * @retval  None
+ * @note    适用于唤醒后还要修改配置再发送或接收的场合(如LoRaWAN接收窗口), 避免先进入接收模式
+ * @warning 确保SPI和GPIO引脚的时钟已使能，否则初始化会失败
+ */
+void LORA_Wakeup(void)
+{
+    uint32_t start = HAL_GetTick();
+    uint32_t bytes = llcc68SpiBytes;
+    uint8_t warm = 0;
+
+    if (loraShadow.valid && PWR_GetSession(PWR_SESSION_LORA) &&
+        llcc68_resume(&gs_handle) == 0 && LORA_CheckRetained() == 0)
+    {
+        warm = 1;
+    }
+    else
+    {
+        loraShadow.valid = 0;
+        if (llcc68_init(&gs_handle) != 0)
+        {
+            llcc68_interface_debug_print("llcc68: init failed.\n");
+        }
+    }
+    PWR_SetSession(PWR_SESSION_LORA, 0);  /* 芯片已唤醒, 清除睡眠标记 */
+
+    /* 初始化DIO1中断引脚，中断事件由LORA_Process()处理 */
+    GPIOB14_Init();
+
     /* 设置芯片进入待机模式，使用32MHz晶振 */
-    res = llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ);
-    if (res != 0)
+    if (llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ) != 0)
     {
         llcc68_interface_debug_print("llcc68: set standby failed.\n");
-        (void)llcc68_deinit(&gs_handle);
     }
-    
-    /* 设置前导码检测时是否停止计时器 */
-    res = llcc68_set_stop_timer_on_preamble(&gs_handle, LLCC68_LORA_DEFAULT_STOP_TIMER_ON_PREAMBLE);
-    if (res != 0)
+
+    if (!warm)
     {
-        llcc68_interface_debug_print("llcc68: stop timer on preamble failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        (void)LORA_ConfigOnce();
     }
-    
-    /* 设置电源调节器工作模式 */
-    res = llcc68_set_regulator_mode(&gs_handle, LLCC68_LORA_DEFAULT_REGULATOR_MODE);
-    if (res != 0)
+    (void)LORA_ApplyConfig(&loraConfig);
+
+    llcc68_interface_debug_print("llcc68: %s start %lu ms, %lu spi bytes.\n", warm ? "warm" : "cold",
+                                 (unsigned long)(HAL_GetTick() - start), (unsigned long)(llcc68SpiBytes - bytes));
+}
+
+/**
+ * @brief   初始化LoRa通信模块: 唤醒芯片并写入配置后进入接收模式
+ * @param   None
+ * @retval  None
+ * @note    此函数必须在使用其他LoRa相关函数前调用, LORA_Sleep()之后也需重新调用(或LORA_Wakeup())
+ */
+void LORA_Init(void)
+{
+    LORA_Wakeup();
+    LORA_EnterReceiveMode();
+}
+
+/**
+ * @brief   LoRa芯片进入热启动睡眠
+ * @details 关闭射频开关后以热启动模式睡眠, 配置寄存器保持; 影子有效时在备份寄存器中写入
+ *          会话标记, 下次LORA_Init()(含MCU待机唤醒后)只需唤醒芯片。
+ * @param   None
+ * @retval  uint8_t 0: 成功；1: 进入睡眠失败
+ * @note    睡眠期间BUSY为高, 除LORA_Init()、LORA_Wakeup()外不可调用其他LoRa函数
+ */
+uint8_t LORA_Sleep(void)
+{
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_2 | GPIO_PIN_12, GPIO_PIN_RESET);
+
+    loraState = LORA_STATE_IDLE;
+    loraTxCallback = NULL;
+    loraRxCallback = NULL;
+    loraCadCallback = NULL;
+
+    if (llcc68_set_sleep(&gs_handle, LLCC68_LORA_DEFAULT_START_MODE, LLCC68_LORA_DEFAULT_RTC_WAKE_UP) != 0)
     {
-        llcc68_interface_debug_print("llcc68: set regulator mode failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        return 1;
     }
-    
-    /* 配置功率放大器参数以实现目标输出功率 */
-    res = llcc68_set_pa_config(&gs_handle, LLCC68_LORA_DEFAULT_PA_CONFIG_DUTY_CYCLE, LLCC68_LORA_DEFAULT_PA_CONFIG_HP_MAX);
-    if (res != 0)
+    if (loraShadow.valid)
     {
-        llcc68_interface_debug_print("llcc68: set pa config failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        PWR_SetSession(PWR_SESSION_LORA, 1);
     }
-    
-    /* 设置接收/发送失败后的回退模式为待机模式 */
-    res = llcc68_set_rx_tx_fallback_mode(&gs_handle, LLCC68_RX_TX_FALLBACK_MODE_STDBY_XOSC);
-    if (res != 0)
+    return 0;
+}
+
+/**
+ * @brief   带宽枚举转换为Hz
+ * @param   bandwidth llcc68_lora_bandwidth_t
+ * @retval  uint32_t 带宽(Hz)
+ */
+static uint32_t LORA_BandwidthHz(uint8_t bandwidth)
+{
+    uint32_t bandwidthHz = 125000;
+
+    /* LLCC68仅支持125/250/500kHz, 枚举值依次递增 */
+    if (bandwidth >= LLCC68_LORA_BANDWIDTH_125_KHZ && bandwidth <= LLCC68_LORA_BANDWIDTH_500_KHZ)
     {
-        llcc68_interface_debug_print("llcc68: set rx tx fallback mode failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        bandwidthHz <<= bandwidth - LLCC68_LORA_BANDWIDTH_125_KHZ;
     }
-    
-    /* 配置DIO引脚中断参数，启用所有中断 */
-    res = llcc68_set_dio_irq_params(&gs_handle, 0x03FF, 0x03FF, 0x0000, 0x0000);
-    if (res != 0)
+    return bandwidthHz;
+}
+
+/**
+ * @brief   计算LoRa数据包的空中时间
+ * @details 按LLCC68手册公式, 以1/4符号为单位精确计算:
+ *          SF7及以上: 前导码 + 4.25 + 8 + ceil(max(8*PL + 16*CRC - 4*SF + 8 + 20*IH, 0) / (4*(SF - 2*LDRO))) * (CR + 4)
+ *          SF5/SF6:   前导码 + 6.25 + 8 + ceil(max(8*PL + 16*CRC - 4*SF + 20*IH, 0) / (4*SF)) * (CR + 4)
+ *          IH在显式头部时取1, 符号时间为2^SF/BW
+ * @param   config 射频配置(使用SF、带宽、编码率、低数据率优化)
+ * @param   preambleLength 前导码长度(符号)
+ * @param   implicitHeader 1: 隐式头部；0: 显式头部
+ * @param   crcOn 1: 开启CRC；0: 关闭CRC
+ * @param   length 负载长度(字节)
+ * @retval  uint32_t 空中时间(us)
+ * @note    Tools/host/lora_toa_test.c 在PC上以参考值和浮点公式验证本函数
+ */
+uint32_t LORA_TimeOnAirUs(const LoraConfigTypeDef *config, uint16_t preambleLength,
+                          uint8_t implicitHeader, uint8_t crcOn, uint8_t length)
+{
+    uint8_t sf = config->sf;
+    int32_t bits = 8 * (int32_t)length + 16 * (crcOn ? 1 : 0) - 4 * sf + 20 * (implicitHeader ? 0 : 1);
+    int32_t bitsPerSymbol = 4 * sf;
+    uint32_t quarterSymbols = 4 * (uint32_t)preambleLength + 4 * 8;
+
+    if (sf >= 7)
     {
-        llcc68_interface_debug_print("llcc68: set dio irq params failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        bits += 8;
+        quarterSymbols += 17;
+        if (config->ldro)
+        {
+            bitsPerSymbol = 4 * (sf - 2);
+        }
     }
-    
-    /* 清除所有中断状态位 */
-    res = llcc68_clear_irq_status(&gs_handle, 0x03FF);
-    if (res != 0)
+    else
     {
-        llcc68_interface_debug_print("llcc68: clear irq status failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        quarterSymbols += 25;
     }
-    
-    /* 设置数据包类型为LoRa模式 */
-    res = llcc68_set_packet_type(&gs_handle, LLCC68_PACKET_TYPE_LORA);
-    if (res != 0)
+    if (bits > 0)
+    {
+        quarterSymbols += 4 * ((bits + bitsPerSymbol - 1) / bitsPerSymbol) * (config->cr + 4);
+    }
+
+    return (uint32_t)((((uint64_t)quarterSymbols << sf) * 1000000 / 4 + LORA_BandwidthHz(config->bandwidth) - 1) /
+                      LORA_BandwidthHz(config->bandwidth));
+}
+
+/**
+ * @brief   按当前配置计算数据包的空中时间
+ * @param   length 负载长度(字节)
+ * @retval  uint32_t 空中时间(us)
+ */
+uint32_t LORA_GetTimeOnAirUs(uint8_t length)
+{
+    return LORA_TimeOnAirUs(&loraConfig, LORA_GetPreambleLength(),
+                            LLCC68_LORA_DEFAULT_HEADER == LLCC68_LORA_HEADER_IMPLICIT,
+                            LLCC68_LORA_DEFAULT_CRC_TYPE == LLCC68_LORA_CRC_TYPE_ON, length);
+}
+
+/**
+ * @brief   计算发送超时
+ * @param   length 负载长度(字节)
+ * @retval  uint32_t 芯片TX超时(us): 空中时间的9/8加LORA_TX_TIMEOUT_MARGIN_MS
+ */
+static uint32_t LORA_GetTxTimeoutUs(uint8_t length)
+{
+    uint32_t airtime = LORA_GetTimeOnAirUs(length);
+
+    return airtime + airtime / 8 + LORA_TX_TIMEOUT_MARGIN_MS * 1000;
+}
+
+/**
+ * @brief   获取当前数据包的发送频率
+ * @param   None
+ * @retval  uint32_t 发送频率(Hz), 尚未选择信道时为loraConfig.frequency
+ */
+static uint32_t LORA_GetTxFrequency(void)
+{
+    return loraTxFrequency != 0 ? loraTxFrequency : loraConfig.frequency;
+}
+
+/**
+ * @brief   查找频率所在的子频段
+ * @param   frequency 频率(Hz)
+ * @retval  int8_t 子频段下标, -1表示不在任何受限子频段内
+ */
+static int8_t LORA_FindSubBand(uint32_t frequency)
+{
+    uint8_t i;
+
+    for (i = 0; i < LORA_SUB_BAND_NUM; i++)
+    {
+        if (frequency >= loraSubBands[i].minHz && frequency < loraSubBands[i].maxHz)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief   按经过的RTC秒数补充各子频段额度
+ * @details 每秒补充 占空比(千分比) 毫秒, 上限为LORA_DUTY_WINDOW_S秒内允许的空中时间;
+ *          首次使用或RTC回退时额度置满
+ * @param   None
+ * @retval  None
+ */
+static void LORA_DutyRefill(void)
+{
+    uint32_t now = RTC_GetCounter();
+    uint32_t elapsed;
+    uint32_t capacity;
+    uint8_t i;
+
+    if (loraDuty.lastUpdate == 0 || now < loraDuty.lastUpdate)
+    {
+        elapsed = LORA_DUTY_WINDOW_S;
+    }
+    else
+    {
+        elapsed = now - loraDuty.lastUpdate;
+        if (elapsed > LORA_DUTY_WINDOW_S)
+        {
+            elapsed = LORA_DUTY_WINDOW_S;
+        }
+    }
+    loraDuty.lastUpdate = now != 0 ? now : 1;
+
+    for (i = 0; i < LORA_SUB_BAND_NUM; i++)
+    {
+        capacity = (uint32_t)LORA_DUTY_WINDOW_S * loraSubBands[i].permille;
+        loraDuty.creditMs[i] += elapsed * loraSubBands[i].permille;
+        if (loraDuty.creditMs[i] > capacity)
+        {
+            loraDuty.creditMs[i] = capacity;
+        }
+    }
+}
+
+/**
+ * @brief   查询按占空比限制发送数据包需要等待的时间
+ * @param   length 负载长度(字节)
+ * @retval  uint32_t 需等待的时间(ms), 0表示可立即发送
+ */
+uint32_t LORA_GetDutyCycleWaitMs(uint8_t length)
+{
+#ifdef LORA_DUTY_CYCLE_ENABLE
+    int8_t band = LORA_FindSubBand(LORA_GetTxFrequency());
+    uint32_t needMs;
+
+    if (band < 0)
+    {
+        return 0;
+    }
+
+    LORA_DutyRefill();
+    needMs = (LORA_GetTimeOnAirUs(length) + 999) / 1000;
+    if (loraDuty.creditMs[band] >= needMs)
+    {
+        return 0;
+    }
+    return ((needMs - loraDuty.creditMs[band]) * 1000 + loraSubBands[band].permille - 1) / loraSubBands[band].permille;
+#else
+    (void)length;
+    return 0;
+#endif
+}
+
+/**
+ * @brief   从所在子频段扣除一次发送的空中时间
+ * @param   length 负载长度(字节)
+ * @retval  None
+ */
+static void LORA_DutyCharge(uint8_t length)
+{
+#ifdef LORA_DUTY_CYCLE_ENABLE
+    int8_t band = LORA_FindSubBand(LORA_GetTxFrequency());
+    uint32_t needMs = (LORA_GetTimeOnAirUs(length) + 999) / 1000;
+
+    if (band >= 0)
+    {
+        loraDuty.creditMs[band] = loraDuty.creditMs[band] > needMs ? loraDuty.creditMs[band] - needMs : 0;
+    }
+#else
+    (void)length;
+#endif
+}
+
+/**
+ * @brief   启动已写入芯片缓冲区的数据包发送
+ * @details 扣除占空比额度, 芯片TX超时按空中时间设置(单位15.625us)
+ * @param   None
+ * @retval  uint8_t 0: 成功；1: 失败
+ */
+static uint8_t LORA_StartTx(void)
+{
+    loraState = LORA_STATE_TX;
+    LORA_DutyCharge(loraTxLength);
+
+    if (llcc68_set_tx(&gs_handle, LORA_GetTxTimeoutUs(loraTxLength) / 1000 * 64) != 0)
     {
-        llcc68_interface_debug_print("llcc68: set packet type failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        loraState = LORA_STATE_IDLE;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   发送失败或放弃时回到空闲并通知回调
+ * @param   None
+ * @retval  None
+ */
+static void LORA_TxFailed(void)
+{
+    loraState = LORA_STATE_IDLE;
+    if (loraTxCallback != NULL)
+    {
+        loraTxCallback(1);
+    }
+}
+
+/**
+ * @brief   获取伪随机数
+ * @details xorshift32, 每次取数时混入芯片随机数发生器的值(芯片刚做过CAD或接收时熵最好),
+ *          读取失败时仍可继续产生序列
+ * @param   None
+ * @retval  uint32_t 伪随机数
+ */
+uint32_t LORA_Random(void)
+{
+    uint32_t r;
+
+    if (llcc68_get_random_number(&gs_handle, &r) == 0)
+    {
+        loraRandom ^= r;
+    }
+    if (loraRandom == 0)
+    {
+        loraRandom = 0x2545F491;
+    }
+    loraRandom ^= loraRandom << 13;
+    loraRandom ^= loraRandom >> 17;
+    loraRandom ^= loraRandom << 5;
+    return loraRandom;
+}
+
+/**
+ * @brief   选择发送信道并写入芯片频率
+ * @details 信道表只有一个信道时使用loraConfig.frequency; 否则伪随机选择信道,
+ *          信道忙后重选时避开刚检测到忙的信道。只改变频率, 其余射频配置取loraConfig。
+ * @param   avoidCurrent 1: 避开当前信道；0: 任意信道
+ * @retval  uint8_t 0: 成功；1: 写入频率失败
+ */
+static uint8_t LORA_SelectChannel(uint8_t avoidCurrent)
+{
+    LoraConfigTypeDef config = loraConfig;
+    uint8_t channel;
+
+    if (LORA_CHANNEL_NUM > 1)
+    {
+        channel = LORA_Random() % LORA_CHANNEL_NUM;
+        if (avoidCurrent && channel == loraTxChannel)
+        {
+            channel = (channel + 1) % LORA_CHANNEL_NUM;
+        }
+        loraTxChannel = channel;
+        config.frequency = loraChannels[channel];
+    }
+    loraTxFrequency = config.frequency;
+    return LORA_ApplyConfig(&config);
+}
+
+/**
+ * @brief   启动信道活动检测
+ * @details 射频开关切换到接收通路, 设置CAD参数并只开CAD中断, CAD结束后芯片回到待机模式
+ * @param   state CAD期间的工作状态: LORA_STATE_CAD或LORA_STATE_TX_CAD
+ * @retval  uint8_t 0: 已启动CAD；1: 配置或启动失败
+ */
+static uint8_t LORA_StartCad(LoraStateTypeDef state)
+{
+    /* 射频开关切换到接收通路 */
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_2, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
+
+    if (llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ) != 0 ||
+        llcc68_set_cad_params(&gs_handle, LLCC68_LORA_DEFAULT_CAD_SYMBOL_NUM, LLCC68_LORA_DEFAULT_CAD_DET_PEAK,
+                              LLCC68_LORA_DEFAULT_CAD_DET_MIN, LLCC68_LORA_CAD_EXIT_MODE_ONLY, 0) != 0 ||
+        llcc68_set_dio_irq_params(&gs_handle, LLCC68_IRQ_CAD_DONE | LLCC68_IRQ_CAD_DETECTED,
+                                  LLCC68_IRQ_CAD_DONE, 0x0000, 0x0000) != 0 ||
+        llcc68_clear_irq_status(&gs_handle, 0x03FFU) != 0)
+    {
+        return 1;
     }
-    
-    /* 设置发射功率和功率爬升时间 */
-    res = llcc68_set_tx_params(&gs_handle, LLCC68_LORA_DEFAULT_TX_DBM, LLCC68_LORA_DEFAULT_RAMP_TIME);
-    if (res != 0)
+
+    loraState = state;
+
+    if (llcc68_set_cad(&gs_handle) != 0)
     {
-        llcc68_interface_debug_print("llcc68: set tx params failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        loraState = LORA_STATE_IDLE;
+        return 1;
     }
-    
-    /* 设置LoRa调制参数：扩频因子、带宽、编码率、低数据率优化 */
-    res = llcc68_set_lora_modulation_params(&gs_handle, LLCC68_LORA_DEFAULT_SF, LLCC68_LORA_DEFAULT_BANDWIDTH, 
-                                            LLCC68_LORA_DEFAULT_CR, LLCC68_LORA_DEFAULT_LOW_DATA_RATE_OPTIMIZE);
-    if (res != 0)
+    return 0;
+}
+
+/**
+ * @brief   开始发送已写入芯片缓冲区的数据包
+ * @details 使能且未在运行时关闭先听后发时先做CAD, 信道空闲才启动发送; 否则直接发送
+ * @param   None
+ * @retval  uint8_t 0: 成功；1: 失败
+ */
+static uint8_t LORA_BeginTx(void)
+{
+#ifdef LORA_LBT_ENABLE
+    if (loraLbtOn)
     {
-        llcc68_interface_debug_print("llcc68: set lora modulation params failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        loraLbtStats.cadCount++;
+        return LORA_StartCad(LORA_STATE_TX_CAD);
     }
-    
-    /* 将RF频率转换为寄存器值 */
-    res = llcc68_frequency_convert_to_register(&gs_handle, LLCC68_LORA_DEFAULT_RF_FREQUENCY, (uint32_t *)&reg);
-    if (res != 0)
+#endif
+    return LORA_StartTx();
+}
+
+/**
+ * @brief   运行时开关先听后发
+ * @details 发送时刻本身携带信息的数据包(如TDMA信标)不能被退避推迟, 发送前关闭, 发送后重新打开。
+ *          未定义LORA_LBT_ENABLE时无作用。
+ * @param   enable 1: 打开；0: 关闭
+ * @retval  None
+ */
+void LORA_SetLbt(uint8_t enable)
+{
+    loraLbtOn = enable;
+}
+
+/**
+ * @brief   设置接收IQ极性
+ * @details LoRaWAN网关下行使用反转IQ, 终端之间直接通信使用标准IQ; 发送始终使用默认极性。
+ *          下次启动接收时生效。
+ * @param   invert LLCC68_BOOL_TRUE: 反转；LLCC68_BOOL_FALSE: 标准
+ * @retval  None
+ */
+void LORA_SetRxInvertIq(uint8_t invert)
+{
+    loraRxInvertIq = invert;
+}
+
+/**
+ * @brief   信道忙时安排随机退避
+ * @details 第n次信道忙后退避 LORA_LBT_SLOT_MIN_MS + [0, 时隙*2^n) ms, n不超过LORA_LBT_BACKOFF_EXP_MAX;
+ *          时隙取本包空中时间(不小于LORA_LBT_SLOT_MIN_MS)。退避结束后换信道重新检测。
+ *          CAD只接收不发射, 退避不增加空中时间。
+ * @param   None
+ * @retval  uint8_t 0: 已开始退避；1: 连续信道忙达到LORA_LBT_MAX_ATTEMPTS次, 放弃发送
+ */
+static uint8_t LORA_Backoff(void)
+{
+    uint32_t slotMs = (LORA_GetTimeOnAirUs(loraTxLength) + 999) / 1000;
+    uint8_t exponent;
+
+    loraLbtStats.busyCount++;
+    if (++loraLbtBusy >= LORA_LBT_MAX_ATTEMPTS)
     {
-        llcc68_interface_debug_print("llcc68: convert to register failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        loraLbtStats.dropCount++;
+        return 1;
     }
-    
-    /* 设置RF工作频率 */
-    res = llcc68_set_rf_frequency(&gs_handle, reg);
-    if (res != 0)
+
+    if (slotMs < LORA_LBT_SLOT_MIN_MS)
     {
-        llcc68_interface_debug_print("llcc68: set rf frequency failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        slotMs = LORA_LBT_SLOT_MIN_MS;
     }
-    
-    /* 设置发送和接收缓冲区的基地址 */
-    res = llcc68_set_buffer_base_address(&gs_handle, 0x00, 0x00);
-    if (res != 0)
+    exponent = loraLbtBusy < LORA_LBT_BACKOFF_EXP_MAX ? loraLbtBusy : LORA_LBT_BACKOFF_EXP_MAX;
+    loraBackoffMs = LORA_LBT_SLOT_MIN_MS + LORA_Random() % (slotMs << exponent);
+    loraBackoffStart = HAL_GetTick();
+    loraLbtStats.backoffMs += loraBackoffMs;
+    loraState = LORA_STATE_TX_BACKOFF;
+    return 0;
+}
+
+/**
+ * @brief   计算当前配置下的LoRa符号时间
+ * @param   None
+ * @retval  uint32_t 符号时间(us), 即2^SF/BW
+ */
+static uint32_t LORA_SymbolUs(void)
+{
+    return (uint32_t)(((uint64_t)1000000 << loraConfig.sf) / LORA_BandwidthHz(loraConfig.bandwidth));
+}
+
+/**
+ * @brief   获取当前监听档位对应的前导码长度
+ * @details 连续接收时使用默认长度; 低功耗监听时前导码需覆盖接收方一个完整的
+ *          "2*接收窗口+睡眠"周期(芯片手册RX duty cycle约束), 再加LORA_SNIFF_PREAMBLE_MARGIN余量,
+ *          保证睡眠中的节点至少有一个完整接收窗口落在前导码内。
+ * @param   None
+ * @retval  uint16_t 前导码长度(符号)
+ */
+uint16_t LORA_GetPreambleLength(void)
+{
+    uint32_t symbolUs;
+    uint32_t length;
+
+    if (loraListenProfile == LORA_LISTEN_CONTINUOUS)
     {
-        llcc68_interface_debug_print("llcc68: set buffer base address failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        return LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH;
     }
-    
-    /* 设置LoRa符号数超时参数 */
-    res = llcc68_set_lora_symb_num_timeout(&gs_handle, LLCC68_LORA_DEFAULT_SYMB_NUM_TIMEOUT);
-    if (res != 0)
+
+    symbolUs = LORA_SymbolUs();
+    length = (2 * LORA_SNIFF_RX_SYMBOLS * symbolUs + (uint32_t)loraListenSleepMs[loraListenProfile] * 1000 + symbolUs - 1) / symbolUs;
+    length += LORA_SNIFF_PREAMBLE_MARGIN;
+    if (length < LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH)
     {
-        llcc68_interface_debug_print("llcc68: set lora symb num timeout failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        length = LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH;
     }
-    
-    /* 重置芯片统计信息 */
-    res = llcc68_reset_stats(&gs_handle, 0x0000, 0x0000, 0x0000);
-    if (res != 0)
+    return length > 0xFFFF ? 0xFFFF : (uint16_t)length;
+}
+
+/**
+ * @brief   按监听档位启动接收
+ * @details 连续档位进入连续接收; 其他档位进入芯片RX duty cycle, 周期单位为15.625us
+ * @param   None
+ * @retval  uint8_t 0: 成功；1: 失败
+ */
+static uint8_t LORA_StartListen(void)
+{
+    uint32_t rxPeriod;
+    uint32_t sleepPeriod;
+
+    if (loraListenProfile == LORA_LISTEN_CONTINUOUS)
     {
-        llcc68_interface_debug_print("llcc68: reset stats failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        return llcc68_continuous_receive(&gs_handle) != 0 ? 1 : 0;
     }
-    
-    /* 清除设备错误状态 */
-    res = llcc68_clear_device_errors(&gs_handle);
-    if (res != 0)
+
+    rxPeriod = LORA_SNIFF_RX_SYMBOLS * LORA_SymbolUs() * 64 / 1000;
+    sleepPeriod = (uint32_t)loraListenSleepMs[loraListenProfile] * 64;
+    return llcc68_set_rx_duty_cycle(&gs_handle, rxPeriod, sleepPeriod) != 0 ? 1 : 0;
+}
+
+/**
+ * @brief   设置接收监听档位
+ * @details 同时改变本机接收方式和发送前导码长度, 正在持续监听时立即按新档位重新启动接收
+ * @param   profile 监听档位
+ * @retval  None
+ */
+void LORA_SetListenProfile(LoraListenProfileTypeDef profile)
+{
+    if (profile >= LORA_LISTEN_NUM || profile == loraListenProfile)
     {
-        llcc68_interface_debug_print("llcc68: clear device errors failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        return;
     }
-    
-    /* 设置LoRa同步字，用于网络识别 */
-    res = llcc68_set_lora_sync_word(&gs_handle, LLCC68_LORA_DEFAULT_SYNC_WORD);
-    if (res != 0)
+    loraListenProfile = profile;
+
+    if (loraState == LORA_STATE_RX && !loraRxSingle)
     {
-        llcc68_interface_debug_print("llcc68: set lora sync word failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        if (llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ) != 0 ||
+            LORA_ConfigReceive() != 0 || LORA_StartListen() != 0)
+        {
+            loraState = LORA_STATE_IDLE;
+        }
     }
-    
-    /* 获取当前发射调制配置 */
-    res = llcc68_get_tx_modulation(&gs_handle, (uint8_t *)&modulation);
-    if (res != 0)
+}
+
+/**
+ * @brief   读取最近接收数据包的RSSI和SNR
+ * @param   None
+ * @retval  None
+ */
+static void LORA_ReadPacketStatus(void)
+{
+    uint8_t rssiRaw, snrRaw, signalRaw;
+    float rssi, snr, signal;
+
+    if (llcc68_get_lora_packet_status(&gs_handle, &rssiRaw, &snrRaw, &signalRaw, &rssi, &snr, &signal) == 0)
     {
-        llcc68_interface_debug_print("llcc68: get tx modulation failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        loraPacketRssi = (int16_t)rssi;
+        loraPacketSnr = (int8_t)snr;
     }
-    modulation |= 0x04;  /* 设置特定的调制位 */
-    
-    /* 应用修改后的发射调制配置 */
-    res = llcc68_set_tx_modulation(&gs_handle, modulation);
-    if (res != 0)
+}
+
+/**
+ * @brief   获取最近接收数据包的链路质量
+ * @details 在接收回调中调用即为当前数据包的值, 供ADR等链路层使用
+ * @param   rssi 输出RSSI(dBm), 可为NULL
+ * @param   snr 输出SNR(dB), 可为NULL
+ * @retval  None
+ */
+void LORA_GetPacketStatus(int16_t *rssi, int8_t *snr)
+{
+    if (rssi != NULL)
     {
-        llcc68_interface_debug_print("llcc68: set tx modulation failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        *rssi = loraPacketRssi;
     }
-    
-    /* 设置接收增益以优化接收灵敏度 */
-    res = llcc68_set_rx_gain(&gs_handle, LLCC68_LORA_DEFAULT_RX_GAIN);
-    if (res != 0)
+    if (snr != NULL)
     {
-        llcc68_interface_debug_print("llcc68: set rx gain failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        *snr = loraPacketSnr;
     }
-    
-    /* 设置过流保护阈值 */
-    res = llcc68_set_ocp(&gs_handle, LLCC68_LORA_DEFAULT_OCP);
-    if (res != 0)
+}
+
+/**
+ * @brief   设置IQ极性寄存器
+ * @details LLCC68在标准IQ极性下需要置位0x0736寄存器的bit2(芯片勘误)
+ * @param   invert 与数据包参数一致的IQ极性 llcc68_bool_t
+ * @retval  uint8_t 0: 成功；1: 读写寄存器失败
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static uint8_t LORA_SetIqPolarity(uint8_t invert)
+{
+    uint8_t setup;
+
+    /* 获取当前IQ极性配置 */
+    if (llcc68_get_iq_polarity(&gs_handle, (uint8_t *)&setup) != 0)
     {
-        llcc68_interface_debug_print("llcc68: set ocp failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        return 1;
     }
-    
-    /* 获取当前发射钳位配置 */
-    res = llcc68_get_tx_clamp_config(&gs_handle, (uint8_t *)&config);
-    if (res != 0)
+
+    /* 根据IQ极性调整设置 */
+    if (invert == LLCC68_BOOL_FALSE)
     {
-        llcc68_interface_debug_print("llcc68: get tx clamp config failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        setup |= 1 << 2;    /* 不反转IQ极性时设置bit2 */
     }
-    config |= 0x1E;  /* 设置发射钳位参数 */
-    
-    /* 应用修改后的发射钳位配置 */
-    res = llcc68_set_tx_clamp_config(&gs_handle, config);
-    if (res != 0)
+    else
     {
-        llcc68_interface_debug_print("llcc68: set tx clamp config failed.\n");
-        (void)llcc68_deinit(&gs_handle);
+        setup &= ~(1 << 2); /* 反转IQ极性时清除bit2 */
     }
 
-    /* 初始化完成后进入接收模式 */
-    LORA_EnterReceiveMode();
+    /* 应用修改后的IQ极性配置 */
+    if (llcc68_set_iq_polarity(&gs_handle, setup) != 0)
+    {
+        return 1;
+    }
+    return 0;
 }
 
 /**
  * @brief   进入LoRa发送模式
- * @details 配置芯片进入发送状态，并设置相关GPIO控制引脚和中断：
- *          1. 控制状态指示LED：拉低接收指示灯，点亮发送指示灯
- *          2. 配置发送相关的DIO中断参数
+ * @details 配置芯片进入发送状态，并设置射频开关和中断：
+ *          1. 射频开关切换到发送通路：关闭RxEN，打开TxEN
+ *          2. 配置发送相关的DIO中断参数，TX_DONE与TIMEOUT映射到DIO1
  *          3. 清除所有中断状态位
  * @param   None
  * @retval  uint8_t 操作结果
  *          - 0: 成功进入发送模式
  *          - 1: 设置中断参数或清除中断状态失败
  * @note    发送完成后建议调用LORA_EnterReceiveMode()恢复接收模式
- *          GPIO控制：GPIOB1-接收指示灯，GPIOB2-发送指示灯
+ *          GPIO控制：GPIOB2-TxEN，GPIOB12-RxEN；GPIOB1为BUSY输入，不可写
  * @warning 发送前确保芯片已正确初始化，且数据准备就绪
  */
 uint8_t LORA_EnterSendMode(void)
 {
-    /* 控制状态指示GPIO：关闭接收指示灯 */
-    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, GPIO_PIN_RESET);
-    /* 控制状态指示GPIO：打开发送指示灯 */
+    /* 射频开关：关闭接收通路 */
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET);
+    /* 射频开关：打开发送通路 */
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_2, GPIO_PIN_SET);
 
-    /* 配置发送模式相关的DIO中断：发送完成、超时、CAD完成、CAD检测 */
-    if (llcc68_set_dio_irq_params(&gs_handle, LLCC68_IRQ_TX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CAD_DONE | LLCC68_IRQ_CAD_DETECTED,
-                                  LLCC68_IRQ_TX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CAD_DONE | LLCC68_IRQ_CAD_DETECTED,
+    /* 配置发送模式相关的DIO中断：发送完成、超时 */
+    if (llcc68_set_dio_irq_params(&gs_handle, LLCC68_IRQ_TX_DONE | LLCC68_IRQ_TIMEOUT,
+                                  LLCC68_IRQ_TX_DONE | LLCC68_IRQ_TIMEOUT,
                                   0x0000, 0x0000) != 0)
     {
         return 1;
@@ -289,34 +1018,28 @@ uint8_t LORA_EnterSendMode(void)
 }
 
 /**
- * @brief   进入LoRa接收模式
- * @details 配置芯片进入连续接收状态，包括以下步骤：
- *          1. 控制状态指示LED：拉低发送指示灯，点亮接收指示灯
- *          2. 配置接收相关的DIO中断参数
- *          3. 清除所有中断状态位
- *          4. 设置LoRa数据包参数
- *          5. 配置IQ极性设置
- *          6. 启动连续接收模式
+ * @brief   配置LoRa接收参数
+ * @details 切换射频开关到接收通路，配置接收相关的DIO中断、数据包参数和IQ极性
  * @param   None
- * @retval  uint8_t 操作结果
- *          - 0: 成功进入接收模式
- *          - 1: 配置过程中任一步骤失败
- * @note    这是芯片的默认工作模式，初始化完成后会自动进入
- *          GPIO控制：GPIOB1-接收指示灯，GPIOB2-发送指示灯
- * @warning 接收过程中避免频繁切换模式，可能影响接收性能
+ * @retval  uint8_t 0: 成功；1: 配置过程中任一步骤失败
+ * @note    该函数为静态函数，仅在本文件内部使用
  */
-uint8_t LORA_EnterReceiveMode(void)
+static uint8_t LORA_ConfigReceive(void)
 {
-    /* 控制状态指示GPIO：关闭发送指示灯 */
+    /* 射频开关：关闭发送通路 */
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_2, GPIO_PIN_RESET);
-    /* 控制状态指示GPIO：打开接收指示灯 */
-    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, GPIO_PIN_SET);
+    /* 射频开关：打开接收通路 */
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
 
-    uint8_t setup;
-    
-    /* 配置接收模式相关的DIO中断：接收完成、超时、CRC错误、CAD完成、CAD检测 */
-    if (llcc68_set_dio_irq_params(&gs_handle, LLCC68_IRQ_RX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CRC_ERR | LLCC68_IRQ_CAD_DONE | LLCC68_IRQ_CAD_DETECTED,
-                                  LLCC68_IRQ_RX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CRC_ERR | LLCC68_IRQ_CAD_DONE | LLCC68_IRQ_CAD_DETECTED,
+    /* 跳频发送后回到接收频率 */
+    if (loraShadow.config.frequency != loraConfig.frequency && LORA_ApplyConfig(&loraConfig) != 0)
+    {
+        return 1;
+    }
+
+    /* 配置接收模式相关的DIO中断：接收完成、超时、CRC错误 */
+    if (llcc68_set_dio_irq_params(&gs_handle, LLCC68_IRQ_RX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CRC_ERR,
+                                  LLCC68_IRQ_RX_DONE | LLCC68_IRQ_TIMEOUT | LLCC68_IRQ_CRC_ERR,
                                   0x0000, 0x0000) != 0)
     {
         return 1;
@@ -329,53 +1052,77 @@ uint8_t LORA_EnterReceiveMode(void)
     }
     
     /* 设置LoRa数据包参数：前导码长度、头部类型、缓冲区大小、CRC、IQ极性 */
-    if (llcc68_set_lora_packet_params(&gs_handle, LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH,
+    if (llcc68_set_lora_packet_params(&gs_handle, LORA_GetPreambleLength(),
                                       LLCC68_LORA_DEFAULT_HEADER, LLCC68_LORA_DEFAULT_BUFFER_SIZE,
-                                      LLCC68_LORA_DEFAULT_CRC_TYPE, LLCC68_LORA_DEFAULT_INVERT_IQ) != 0)
-    {
-        return 1;
-    }
-    
-    /* 获取当前IQ极性配置 */
-    if (llcc68_get_iq_polarity(&gs_handle, (uint8_t *)&setup) != 0)
+                                      LLCC68_LORA_DEFAULT_CRC_TYPE, (llcc68_bool_t)loraRxInvertIq) != 0)
     {
         return 1;
     }
     
-    /* 根据默认配置调整IQ极性设置 */
-#if LLCC68_LORA_DEFAULT_INVERT_IQ == LLCC68_BOOL_FALSE
-    setup |= 1 << 2;   /* 不反转IQ极性时设置bit2 */
-#else
-    setup &= ~(1 << 2); /* 反转IQ极性时清除bit2 */
-#endif
-    
-    /* 应用修改后的IQ极性配置 */
-    if (llcc68_set_iq_polarity(&gs_handle, setup) != 0)
+    return LORA_SetIqPolarity(loraRxInvertIq);
+}
+
+/**
+ * @brief   进入LoRa接收模式
+ * @details 配置芯片进入连续接收状态，包括以下步骤：
+ *          1. 射频开关切换到接收通路：关闭TxEN，打开RxEN
+ *          2. 配置接收相关的DIO中断参数
+ *          3. 清除所有中断状态位
+ *          4. 设置LoRa数据包参数
+ *          5. 配置IQ极性设置
+ *          6. 按监听档位启动连续接收或RX duty cycle低功耗监听
+ * @param   None
+ * @retval  uint8_t 操作结果
+ *          - 0: 成功进入接收模式
+ *          - 1: 配置过程中任一步骤失败
+ * @note    这是芯片的默认工作模式，初始化完成后会自动进入。
+ *          此模式下接收到的数据由LORA_ReceiveData()取出；需要回调通知时使用LORA_ReceiveAsync()
+ * @warning 接收过程中避免频繁切换模式，可能影响接收性能
+ */
+uint8_t LORA_EnterReceiveMode(void)
+{
+    loraRxCallback = NULL;
+    loraRxSingle = 0;
+
+    if (LORA_ConfigReceive() != 0)
     {
         return 1;
     }
     
-    /* 启动连续接收模式，芯片将持续监听信道 */
-    if (llcc68_continuous_receive(&gs_handle) != 0)
+    /* 按监听档位启动连续接收或低功耗监听 */
+    if (LORA_StartListen() != 0)
     {
         return 1;
     }
     
+    loraState = LORA_STATE_RX;
     return 0;
 }
 
+/**
+ * @brief   阻塞发送的完成回调，记录发送结果
+ * @param   result 0: 发送成功；1: 超时
+ * @retval  None
+ */
+static void LORA_SendDataCallback(uint8_t result)
+{
+    loraTxResult = result;
+}
+
 /**
  * @brief   发送LoRa数据
  * @details 通过LoRa芯片发送指定长度的数据包，完整流程包括：
- *          1. 切换芯片到发送模式
- *          2. 调用底层传输函数发送数据
- *          3. 发送失败时恢复到接收模式
- *          4. 发送成功后自动恢复接收模式
+ *          1. 超出占空比额度时不发送，直接返回
+ *          2. 调用LORA_SendAsync()启动发送(使能先听后发时先做CAD，信道忙则退避重试)
+ *          3. CAD、退避和空中传输期间MCU以WFI休眠，由DIO1中断或SysTick唤醒后处理
+ *          4. 开始发射后超过芯片TX超时再加LORA_TX_TIMEOUT_MARGIN_MS仍未完成时强制回到待机模式
+ *          5. 发送结束后恢复接收模式
  * @param   sendDataBuffer 指向要发送数据的缓冲区指针
  * @param   length 要发送的数据字节数 (1-255字节)
  * @retval  uint8_t 发送结果
  *          - 0: 发送成功
- *          - 1: 发送失败（模式切换失败或数据传输失败）
+ *          - 1: 发送失败（模式切换失败、数据传输失败、超时或信道持续忙）
+ *          - 2: 超出占空比额度，等待时间由LORA_GetDutyCycleWaitMs()给出
  * @note    发送完成后会自动恢复到接收模式
  *          使用默认的LoRa参数进行数据传输
  * @warning 确保sendDataBuffer指向的内存区域至少有length字节的有效数据
@@ -383,31 +1130,53 @@ uint8_t LORA_EnterReceiveMode(void)
  */
 uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
 {
-    /* 切换芯片到发送模式 */
-    LORA_EnterSendMode();
+    uint32_t tickstart = HAL_GetTick();
+    uint32_t timeoutMs = LORA_GetTxTimeoutUs((uint8_t)length) / 1000 + LORA_TX_TIMEOUT_MARGIN_MS;
+
+    if (LORA_GetDutyCycleWaitMs((uint8_t)length) > 0)
+    {
+        return 2;
+    }
 
-    /* 使用LoRa协议发送数据，配置前导码、头部、CRC、IQ极性等参数 */
-    if (llcc68_lora_transmit(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ,
-                             LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH, LLCC68_LORA_DEFAULT_HEADER,
-                             LLCC68_LORA_DEFAULT_CRC_TYPE, LLCC68_LORA_DEFAULT_INVERT_IQ,
-                            (uint8_t *)sendDataBuffer, length, 0) != 0)
+    loraTxResult = 1;
+    if (LORA_SendAsync(sendDataBuffer, length, LORA_SendDataCallback) != 0)
     {
         /* 发送失败时立即恢复接收模式 */
         LORA_EnterReceiveMode();
         return 1;
     }
 
+    /* 等待DIO1中断，CAD、退避和空中传输期间休眠 */
+    while (loraState == LORA_STATE_TX || loraState == LORA_STATE_TX_CAD || loraState == LORA_STATE_TX_BACKOFF)
+    {
+        LORA_Process();
+        if (loraState != LORA_STATE_TX)
+        {
+            tickstart = HAL_GetTick();  /* 超时从开始发射时计算 */
+        }
+        else if ((HAL_GetTick() - tickstart) > timeoutMs)
+        {
+            llcc68_interface_debug_print("llcc68: send timeout.\n");
+            llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ);
+            loraState = LORA_STATE_IDLE;
+            break;
+        }
+        if (loraState == LORA_STATE_TX || loraState == LORA_STATE_TX_CAD || loraState == LORA_STATE_TX_BACKOFF)
+        {
+            __WFI();
+        }
+    }
+
     /* 发送完成后恢复接收模式 */
     LORA_EnterReceiveMode();
     
-    /* 发送成功，返回结果 */
-    return 0;
+    return loraTxResult;
 }
 
 /**
  * @brief   接收LoRa数据
- * @details 处理LoRa芯片的接收中断并获取接收到的数据：
- *          1. 调用中断处理函数处理芯片状态
+ * @details 处理连续接收模式下收到的数据包：
+ *          1. 调用LORA_Process()处理DIO1中断事件(无中断时不访问SPI)
  *          2. 检查芯片内部接收缓冲区是否有新数据
  *          3. 如有数据则复制到用户提供的缓冲区
  *          4. 自动添加字符串结束符便于文本处理
@@ -416,7 +1185,6 @@ uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
  * @param   length 指向存储接收数据长度的变量指针
  * @retval  uint8_t 接收处理结果
  *          - 0: 处理成功（有无数据都返回0）
- *          - 1: 中断处理失败
  * @note    需要定期调用此函数以处理接收到的数据
  *          接收到的数据会自动添加字符串结束符'\0'
  *          函数返回成功不代表一定有新数据，需检查length值
@@ -425,11 +1193,8 @@ uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
  */
 uint8_t LORA_ReceiveData(uint8_t *receiveDataBuffer, uint16_t *length)
 {
-    /* 处理芯片中断状态，更新接收缓冲区 */
-    if(llcc68_irq_handler(&gs_handle) != 0)
-    {
-        return 1;
-    }
+    /* 处理DIO1中断事件，更新接收缓冲区 */
+    LORA_Process();
 
     /* 检查是否有新的接收数据 */
     if(gs_handle.receive_len > 0)
@@ -446,4 +1211,243 @@ uint8_t LORA_ReceiveData(uint8_t *receiveDataBuffer, uint16_t *length)
         gs_handle.receive_len = 0;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief   异步发送LoRa数据
+ * @details 写入数据包并启动发送后立即返回，TX_DONE由DIO1中断通知，
+ *          LORA_Process()检测到后调用callback。发送结束后芯片回到待机模式。
+ *          所在子频段的占空比额度不足时，数据留在芯片缓冲区，状态为LORA_STATE_TX_WAIT，
+ *          由LORA_Process()在额度恢复后启动发送。芯片TX超时按空中时间设置。
+ *          信道表有多个信道时每包伪随机选择发送信道；使能先听后发时发送前先做CAD，
+ *          信道忙则随机退避并换信道重试，连续忙LORA_LBT_MAX_ATTEMPTS次后以结果1调用callback。
+ * @param   sendDataBuffer 指向要发送数据的缓冲区指针，函数返回后即可释放
+ * @param   length 要发送的数据字节数 (1-255字节)
+ * @param   callback 发送完成回调，可为NULL
+ * @retval  uint8_t 0: 已启动发送或已排队；1: 配置或启动失败
+ */
+uint8_t LORA_SendAsync(uint8_t *sendDataBuffer, uint16_t length, LORA_TxCallbackTypeDef callback)
+{
+    /* 切换芯片到发送模式 */
+    if (LORA_EnterSendMode() != 0)
+    {
+        return 1;
+    }
+
+    /* 待机模式下配置数据包参数并写入数据 */
+    if (llcc68_set_standby(&gs_handle, LLCC68_CLOCK_SOURCE_XTAL_32MHZ) != 0 ||
+        llcc68_set_lora_packet_params(&gs_handle, LORA_GetPreambleLength(),
+                                      LLCC68_LORA_DEFAULT_HEADER, (uint8_t)length,
+                                      LLCC68_LORA_DEFAULT_CRC_TYPE, LLCC68_LORA_DEFAULT_INVERT_IQ) != 0 ||
+        LORA_SetIqPolarity(LLCC68_LORA_DEFAULT_INVERT_IQ) != 0 ||
+        llcc68_write_buffer(&gs_handle, 0x00, sendDataBuffer, length) != 0)
+    {
+        return 1;
+    }
+
+    loraTxCallback = callback;
+    loraTxLength = (uint8_t)length;
+    loraLbtBusy = 0;
+
+    if (LORA_SelectChannel(0) != 0)
+    {
+        return 1;
+    }
+    if (LORA_GetDutyCycleWaitMs(loraTxLength) > 0)
+    {
+        loraState = LORA_STATE_TX_WAIT;
+        return 0;
+    }
+    return LORA_BeginTx();
+}
+
+/**
+ * @brief   异步接收LoRa数据
+ * @details 启动接收后立即返回，RX_DONE、CRC错误和接收超时由DIO1中断通知，
+ *          LORA_Process()检测到后调用callback。
+ * @param   timeoutMs 接收超时(ms)，0表示连续接收，收到数据包后继续接收
+ * @param   callback 接收完成回调，可为NULL
+ * @retval  uint8_t 0: 已启动接收；1: 配置或启动失败
+ */
+uint8_t LORA_ReceiveAsync(uint32_t timeoutMs, LORA_RxCallbackTypeDef callback)
+{
+    if (LORA_ConfigReceive() != 0)
+    {
+        return 1;
+    }
+
+    loraRxCallback = callback;
+    loraRxSingle = (timeoutMs != 0);
+    loraState = LORA_STATE_RX;
+
+    if (timeoutMs == 0)
+    {
+        if (LORA_StartListen() != 0)
+        {
+            loraState = LORA_STATE_IDLE;
+            return 1;
+        }
+    }
+    else if (llcc68_single_receive(&gs_handle, (double)timeoutMs * 1000.0) != 0)
+    {
+        loraState = LORA_STATE_IDLE;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   异步信道活动检测(CAD)
+ * @details 启动CAD后立即返回，CAD_DONE由DIO1中断通知，
+ *          LORA_Process()检测到后以检测结果调用callback。CAD结束后芯片回到待机模式。
+ * @param   callback CAD完成回调，可为NULL
+ * @retval  uint8_t 0: 已启动CAD；1: 配置或启动失败
+ */
+uint8_t LORA_CadAsync(LORA_CadCallbackTypeDef callback)
+{
+    loraCadCallback = callback;
+    return LORA_StartCad(LORA_STATE_CAD);
+}
+
+/**
+ * @brief   处理LoRa中断事件
+ * @details DIO1(PB14)上升沿中断只置位标志，本函数在主循环中读取并清除芯片中断状态，
+ *          按当前状态分发TX_DONE、RX_DONE、CAD_DONE和超时事件到对应回调。
+ *          DIO1未触发时不访问SPI。
+ * @param   None
+ * @retval  None
+ * @note    回调在本函数中调用，可以在回调中启动下一次操作
+ */
+void LORA_Process(void)
+{
+    LoraStateTypeDef state = loraState;
+
+    /* 退避结束后换信道, 按占空比额度重新检测或排队 */
+    if (state == LORA_STATE_TX_BACKOFF && (HAL_GetTick() - loraBackoffStart) >= loraBackoffMs)
+    {
+        if (LORA_SelectChannel(1) != 0)
+        {
+            LORA_TxFailed();
+        }
+        else
+        {
+            loraState = LORA_STATE_TX_WAIT;
+        }
+        state = loraState;
+    }
+
+    /* 占空比额度恢复后启动排队的发送 */
+    if (state == LORA_STATE_TX_WAIT && LORA_GetDutyCycleWaitMs(loraTxLength) == 0 && LORA_BeginTx() != 0)
+    {
+        LORA_TxFailed();
+    }
+    state = loraState;
+
+    /* DIO1在中断状态清除前保持高电平，同时检查电平以防边沿在清标志前到达 */
+    if (gpioB14Flag == 0 && HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_14) == GPIO_PIN_RESET)
+    {
+        return;
+    }
+    gpioB14Flag = 0;
+
+    gs_handle.tx_done = 0;
+    gs_handle.cad_done = 0;
+    gs_handle.cad_detected = 0;
+    gs_handle.timeout = 0;
+    if (llcc68_irq_handler(&gs_handle) != 0)
+    {
+        return;
+    }
+
+    if (state == LORA_STATE_TX && (gs_handle.tx_done || gs_handle.timeout))
+    {
+        loraState = LORA_STATE_IDLE;
+        if (loraTxCallback != NULL)
+        {
+            loraTxCallback(gs_handle.tx_done ? 0 : 1);
+        }
+    }
+    else if (state == LORA_STATE_TX_CAD && gs_handle.cad_done)
+    {
+        if (gs_handle.cad_detected)
+        {
+            if (LORA_Backoff() != 0)
+            {
+                llcc68_interface_debug_print("llcc68: channel busy, drop packet.\n");
+                LORA_TxFailed();
+            }
+        }
+        else if (LORA_EnterSendMode() != 0 || LORA_StartTx() != 0)
+        {
+            LORA_TxFailed();
+        }
+        else
+        {
+            loraLbtStats.txCount++;
+        }
+    }
+    else if (state == LORA_STATE_CAD && gs_handle.cad_done)
+    {
+        loraState = LORA_STATE_IDLE;
+        if (loraCadCallback != NULL)
+        {
+            loraCadCallback(gs_handle.cad_detected);
+        }
+    }
+    else if (state == LORA_STATE_RX)
+    {
+        uint8_t received = (gs_handle.receive_len > 0);
+
+        if (received)
+        {
+            LORA_ReadPacketStatus();
+        }
+        if (received || gs_handle.crc_error || gs_handle.timeout)
+        {
+            if (loraRxSingle)
+            {
+                loraState = LORA_STATE_IDLE;
+            }
+            /* 未注册回调时数据留给LORA_ReceiveData()取出 */
+            if (loraRxCallback != NULL)
+            {
+                if (received)
+                {
+                    loraRxCallback(gs_handle.receive_buf, gs_handle.receive_len);
+                    gs_handle.receive_len = 0;
+                }
+                else
+                {
+                    loraRxCallback(NULL, 0);
+                }
+            }
+            /* RX duty cycle收到数据包后芯片回到待机, 持续监听时重新启动 */
+            if (!loraRxSingle && loraState == LORA_STATE_RX && loraListenProfile != LORA_LISTEN_CONTINUOUS &&
+                LORA_StartListen() != 0)
+            {
+                loraState = LORA_STATE_IDLE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief   获取LoRa当前工作状态
+ * @retval  LoraStateTypeDef 当前状态
+ */
+LoraStateTypeDef LORA_GetState(void)
+{
+    return loraState;
+}
+
+/**
+ * @brief   通过调试串口输出先听后发统计
+ * @details 输出格式: LBT,<CAD次数>,<信道忙次数>,<累计退避ms>,<放弃包数>,<发出包数>
+ * @param   None
+ * @retval  None
+ */
+void LORA_ReportLbtStats(void)
+{
+    llcc68_interface_debug_print("LBT,%lu,%lu,%lu,%lu,%lu\r\n", loraLbtStats.cadCount, loraLbtStats.busyCount,
+                                 loraLbtStats.backoffMs, loraLbtStats.dropCount, loraLbtStats.txCount);
+}
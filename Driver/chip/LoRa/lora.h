@@ -13,6 +13,9 @@
 
 #include "spi/spi.h"
 #include "gpio/gpio.h"
+#include "PWR/pwr.h"
+#include "rtc/rtc.h"
+#include "user_config.h"
 
 /* ===== LoRa芯片默认配置参数定义 ===== */
 
@@ -91,9 +94,148 @@
 /** @brief RTC唤醒功能 - 启用RTC唤醒以降低功耗 */
 #define LLCC68_LORA_DEFAULT_RTC_WAKE_UP                 LLCC68_BOOL_TRUE                  
 
+/** @brief 发送超时余量(ms) - 芯片TX超时取空中时间的9/8再加该余量, 软件等待再加一倍余量 */
+#define LORA_TX_TIMEOUT_MARGIN_MS                       50
+
+/** @brief 占空比统计窗口(秒) - 每个子频段的空中时间额度上限为窗口时长乘以占空比 */
+#define LORA_DUTY_WINDOW_S                              3600
+
+/** @brief 子频段表最大条目数 */
+#define LORA_SUB_BAND_MAX                               5
+
+/** @brief 先听后发退避时隙下限(ms) - 不小于一次CAD加芯片模式切换的时间 */
+#define LORA_LBT_SLOT_MIN_MS                            10
+
+/** @brief 保持列表寄存器 - 1字节项数 + 最多4个16位寄存器地址, 列表中的寄存器在热启动睡眠中保持 */
+#define LORA_REG_RETENTION_LIST                         0x029F
+
+/** @brief 保持列表最多容纳的寄存器数 */
+#define LORA_RETENTION_MAX                              4
+
+/** @brief 低功耗监听每个接收窗口的符号数 - 足够芯片完成前导码检测 */
+#define LORA_SNIFF_RX_SYMBOLS                           8
+
+/** @brief 低功耗监听前导码余量(符号) - 补偿双方时钟误差与唤醒时间 */
+#define LORA_SNIFF_PREAMBLE_MARGIN                      4
+
+/* ===== 低功耗监听 ===== */
+
+/**
+ * @brief 接收监听档位
+ * @note  非连续档位使用芯片的RX duty cycle: 接收LORA_SNIFF_RX_SYMBOLS个符号后睡眠sleepMs,
+ *        检测到前导码后保持接收直到数据包结束。发送方前导码需覆盖一个完整的"2*接收+睡眠"周期,
+ *        因此收发双方必须使用相同档位。
+ */
+typedef enum
+{
+    LORA_LISTEN_CONTINUOUS = 0,     /* 连续接收, 前导码使用默认长度 */
+    LORA_LISTEN_BALANCED,           /* 睡眠100ms, 接收延迟与电流折中 */
+    LORA_LISTEN_LOW_POWER,          /* 睡眠1000ms, 适合下行稀少的场景 */
+    LORA_LISTEN_NUM,
+} LoraListenProfileTypeDef;
+
+/* ===== 配置影子 ===== */
+
+/** @brief 射频配置, 各字段与LLCC68设置命令一一对应 */
+typedef struct
+{
+    uint32_t frequency;     /* 射频频率(Hz) */
+    uint8_t sf;             /* 扩频因子 llcc68_lora_sf_t */
+    uint8_t bandwidth;      /* 带宽 llcc68_lora_bandwidth_t */
+    uint8_t cr;             /* 编码率 llcc68_lora_cr_t */
+    uint8_t ldro;           /* 低数据率优化 llcc68_bool_t */
+    int8_t txDbm;           /* 发射功率(dBm) */
+    uint8_t rampTime;       /* 功率爬升时间 llcc68_ramp_time_t */
+    uint8_t paDutyCycle;    /* PA占空比 */
+    uint8_t paHpMax;        /* PA最大功率档 */
+    uint16_t syncWord;      /* 同步字 */
+    uint8_t rxGain;         /* 接收增益 */
+    uint8_t ocp;            /* 过流保护 */
+} LoraConfigTypeDef;
+
+/** @brief 芯片当前配置的影子, 热启动睡眠期间与芯片保持一致 */
+typedef struct
+{
+    LoraConfigTypeDef config;   /* 最近一次写入芯片的配置 */
+    uint8_t valid;              /* 1表示影子与芯片一致 */
+    uint8_t reserved[3];
+} LoraShadowTypeDef;
+
+/** @brief 区域子频段: 频率范围与占空比上限 */
+typedef struct
+{
+    uint32_t minHz;         /* 起始频率(Hz, 含) */
+    uint32_t maxHz;         /* 截止频率(Hz, 不含) */
+    uint16_t permille;      /* 占空比上限(千分比) */
+} LoraSubBandTypeDef;
+
+/** @brief 各子频段剩余空中时间额度, 按RTC秒数补充 */
+typedef struct
+{
+    uint32_t lastUpdate;                    /* 上次结算时的RTC计数(秒), 0表示尚未初始化 */
+    uint32_t creditMs[LORA_SUB_BAND_MAX];   /* 各子频段剩余可用空中时间(ms) */
+} LoraDutyStateTypeDef;
+
+/** @brief 先听后发统计 */
+typedef struct
+{
+    uint32_t cadCount;      /* 发送前CAD次数 */
+    uint32_t busyCount;     /* 检测到信道忙的次数 */
+    uint32_t backoffMs;     /* 累计退避时间(ms) */
+    uint32_t dropCount;     /* 连续信道忙超过LORA_LBT_MAX_ATTEMPTS而放弃的数据包 */
+    uint32_t txCount;       /* 通过CAD后发出的数据包 */
+} LoraLbtStatsTypeDef;
+
+extern LoraConfigTypeDef loraConfig;    /* 目标配置, 修改后调用LORA_ApplyConfig()生效 */
+extern LoraDutyStateTypeDef loraDuty;   /* 占空比额度, 由persist模块掉电保持 */
+extern LoraLbtStatsTypeDef loraLbtStats;    /* 先听后发统计 */
+extern LoraShadowTypeDef loraShadow;    /* 配置影子, 由persist模块掉电保持 */
+
+/* ===== 异步操作 ===== */
+
+/** @brief LoRa工作状态 */
+typedef enum
+{
+    LORA_STATE_IDLE = 0,    /* 空闲(待机) */
+    LORA_STATE_TX,          /* 发送中, 等待TX_DONE */
+    LORA_STATE_TX_WAIT,     /* 数据已写入芯片缓冲区, 等待占空比额度恢复后发送 */
+    LORA_STATE_TX_CAD,      /* 发送前信道活动检测中 */
+    LORA_STATE_TX_BACKOFF,  /* 信道忙, 随机退避后换信道重新检测 */
+    LORA_STATE_RX,          /* 接收中, 等待RX_DONE */
+    LORA_STATE_CAD,         /* 信道活动检测中, 等待CAD_DONE */
+} LoraStateTypeDef;
+
+/** @brief 发送完成回调, result为0表示发送成功, 1表示超时或信道持续忙 */
+typedef void (*LORA_TxCallbackTypeDef)(uint8_t result);
+
+/** @brief 接收完成回调, CRC错误或接收超时时buffer为NULL、length为0 */
+typedef void (*LORA_RxCallbackTypeDef)(uint8_t *buffer, uint16_t length);
+
+/** @brief CAD完成回调, detected为1表示检测到信道活动 */
+typedef void (*LORA_CadCallbackTypeDef)(uint8_t detected);
+
 
 void LORA_Init(void);
 
+void LORA_Wakeup(void);
+
+uint8_t LORA_ApplyConfig(const LoraConfigTypeDef *config);
+
+uint8_t LORA_Sleep(void);
+
+void LORA_SetListenProfile(LoraListenProfileTypeDef profile);
+
+uint16_t LORA_GetPreambleLength(void);
+
+void LORA_GetPacketStatus(int16_t *rssi, int8_t *snr);
+
+uint32_t LORA_TimeOnAirUs(const LoraConfigTypeDef *config, uint16_t preambleLength,
+                          uint8_t implicitHeader, uint8_t crcOn, uint8_t length);
+
+uint32_t LORA_GetTimeOnAirUs(uint8_t length);
+
+uint32_t LORA_GetDutyCycleWaitMs(uint8_t length);
+
 uint8_t LORA_EnterSendMode(void);
 
 uint8_t LORA_EnterReceiveMode(void);
@@ -102,4 +244,22 @@ uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length);
 
 uint8_t LORA_ReceiveData(uint8_t *receiveDataBuffer, uint16_t *length);
 
+uint8_t LORA_SendAsync(uint8_t *sendDataBuffer, uint16_t length, LORA_TxCallbackTypeDef callback);
+
+uint8_t LORA_ReceiveAsync(uint32_t timeoutMs, LORA_RxCallbackTypeDef callback);
+
+uint8_t LORA_CadAsync(LORA_CadCallbackTypeDef callback);
+
+void LORA_Process(void);
+
+LoraStateTypeDef LORA_GetState(void);
+
+void LORA_SetLbt(uint8_t enable);
+
+void LORA_SetRxInvertIq(uint8_t invert);
+
+uint32_t LORA_Random(void);
+
+void LORA_ReportLbtStats(void);
+
 #endif
@@ -8,6 +8,8 @@
  * @note    使用前需要初始化USART2接口和GPIOB3控制引脚
  */
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_GNSS
+
 #include "at6558r.h"
 
 /* 引用全局位置数据变量（定义在 APP/location/location.c 中，类型在 user_config.h 中） */
@@ -91,9 +93,9 @@ void AT6558R_PrintInfo(void)
     HAL_Delay(500);
 
     /* 打印接收缓冲区中的所有响应信息 */
-    DEBUG_Printf("-------------------AT6558R-------------------\r\n");
-    DEBUG_Printf("%s", rxBuffer);
-    DEBUG_Printf("---------------------------------------------\r\n");
+    DEBUG_Trace("-------------------AT6558R-------------------\r\n");
+    DEBUG_Trace("%s", rxBuffer);
+    DEBUG_Trace("---------------------------------------------\r\n");
 }
 
 /**
@@ -103,12 +105,12 @@ void AT6558R_PrintInfo(void)
  *          2. 初始化UART通信接口
  *          3. 配置GNSS数据输出频率
  *          4. 设置多模卫星工作模式
- * @param   None
+ * @param   frequency GNSS数据输出频率命令, 如AT6558R_FREQUENCY_1Hz
  * @retval  None
  * @note    此函数必须在使用其他AT6558R相关功能前调用
  * @warning 确保相关的时钟已使能，GPIO和USART2外设可正常工作
  */
-void AT6558R_Init(void)
+void AT6558R_Init(char *frequency)
 {
     /* 初始化GPIOB3引脚并设置为高电平，启动AT6558R芯片 */
     /* 该引脚控制芯片的电源使能，高电平有效 */
@@ -118,9 +120,9 @@ void AT6558R_Init(void)
     /* USART2用于发送AT命令和接收GNSS数据 */
     USART2_Init();
 
-    /* 配置GNSS数据输出频率为1Hz */
+    /* 配置GNSS数据输出频率 */
     /* 1Hz表示每秒输出一次完整的定位信息 */
-    AT6558R_SendCmd(AT6558R_FREQUENCY_1Hz);
+    AT6558R_SendCmd(frequency);
 
     /* 设置GNSS工作模式为双模（GPS + 北斗BDS） */
     /* 双模可以同时接收GPS和北斗卫星信号，提高定位精度和可靠性 */
@@ -236,6 +238,7 @@ uint8_t AT6558R_VerifyValidityOfGPSData(void)
  * - 4: N/S
  * - 5: longitude (dddmm.mmmm)
  * - 6: E/W
+ * - 7: speed over ground (knots)
  * - 9: date (ddmmyy)
  *
  * @par 实现细节与限制
@@ -354,6 +357,12 @@ void AT6558R_ExtractGNRMCData(void)
         locationData.longitude_direction = (tokens[6][0] == 'E') ? 0 : 1; /* 0:E,1:W，保存方向标志 */
     }
 
+    /* 解析对地速度（节 -> km/h） */
+    if (idx > 7 && tokens[7])
+    {
+        locationData.speed = atof(tokens[7]) * 1.852f;
+    }
+
     /* 解析日期 ddmmyy（UTC 日期） */
     if (idx > 9 && tokens[9] && strlen(tokens[9]) >= 6)
     {
@@ -401,17 +410,17 @@ void AT6558R_ExtractGNRMCData(void)
     locationData.time.second = local_sec;
 
     /* 成功解析后打印调试信息（使用东八区本地时间） */
-    DEBUG_Printf("GNRMC(Local,+8): %02d-%02d-%02d %02d:%02d:%02d, %.6f %s, %.6f %s\r\n",
-                 local_day,
-                 local_month,
-                 local_year,
-                 local_hour,
-                 local_min,
-                 local_sec,
-                 locationData.latitude,
-                 (locationData.latitude_direction == 0) ? "N" : "S",
-                 locationData.longitude,
-                 (locationData.longitude_direction == 0) ? "E" : "W"); /* 输出本地时间 */
+    DEBUG_Info("GNRMC(Local,+8): %02d-%02d-%02d %02d:%02d:%02d, %.6f %s, %.6f %s\r\n",
+               local_day,
+               local_month,
+               local_year,
+               local_hour,
+               local_min,
+               local_sec,
+               locationData.latitude,
+               (locationData.latitude_direction == 0) ? "N" : "S",
+               locationData.longitude,
+               (locationData.longitude_direction == 0) ? "E" : "W"); /* 输出本地时间 */
 }
 
 void AT6558R_EnterLowPowerMode(void)
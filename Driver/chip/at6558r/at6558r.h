@@ -19,7 +19,7 @@
 #define AT6558R_Info_CustomerNumber "PCAS06,3"        /* 客户编号信息 */
 #define AT6558R_Info_UpgradeCode "PCAS06,5"           /* 升级码信息 */
 
-void AT6558R_Init(void);
+void AT6558R_Init(char *frequency);
 
 void AT6558R_PrintInfo(void);
 
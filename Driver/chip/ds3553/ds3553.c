@@ -5,11 +5,29 @@
  * @note    使用前需要初始化I2C接口和GPIOB5引脚
  */
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_SENSOR
+
 #include "ds3553.h"
 
 /* 全局变量：当前步数计数值,存储从DS3553芯片读取的步数计数，范围0~16777215 */
 uint32_t countOfStep = 0;
 
+/* 当前访问的完成标志、结果及后续处理函数 */
+static volatile uint8_t ds3553Done = 1;
+static volatile HAL_StatusTypeDef ds3553Status = HAL_OK;
+static I2C1_CallbackTypeDef ds3553Next = NULL;
+
+/* DS3553寄存器影子，由persist模块掉电保持 */
+DS3553_ShadowTypeDef ds3553Shadow = {0};
+
+/* 本次MCU运行期间会话是否已打开，待机唤醒后清零 */
+static uint8_t ds3553Opened = 0;
+
+/* 突发读取时使用的接收缓冲区(USER_SET + 3字节步数)、配置漂移标志与用户回调 */
+static uint8_t stepBuffer[4];
+static volatile uint8_t ds3553Drift = 0;
+static DS3553_CallbackTypeDef stepCallback = NULL;
+
 /**
  * @brief   启动DS3553芯片通信序列
  * @details 通过拉低GPIOB5引脚来启动与DS3553芯片的通信，
@@ -41,73 +59,208 @@ static void DS3553_Stop(void)
 }
 
 /**
- * @brief   向DS3553指定寄存器写入数据
- * @details 通过I2C接口向DS3553芯片的指定寄存器地址写入指定长度的数据。
- *          该函数实现完整的I2C写操作序列，包括起始、数据传输和停止。
- * @param   addr 目标寄存器地址 (8位地址)
- * @param   bufferOfSend 指向要写入数据的缓冲区指针
- * @param   len 要写入的数据字节数 (1-255字节)
+ * @brief   DS3553单次寄存器访问完成处理
+ * @details 由I2C1完成回调在中断上下文中调用：按保持时间延时后释放片选，
+ *          记录结果并转交给发起访问时指定的后续处理函数。
+ * @param   status I2C传输结果
  * @retval  None
- * @note    该函数为静态函数，仅在本文件内部使用，写操作完成后会自动添加延时确保数据写入成功
- * @warning 确保bufferOfSend指向的内存区域至少有len字节的有效数据
  */
-static void DS3553_WriteData(uint8_t addr, uint8_t *bufferOfSend, uint8_t len)
+static void DS3553_TransferCallback(HAL_StatusTypeDef status)
+{
+    I2C1_CallbackTypeDef next = ds3553Next;
+
+    /* 等待停止条件后的保持时间，再释放片选 */
+    delay_us(DS3553_CS_HOLD_US);
+    DS3553_Stop();
+
+    ds3553Status = status;
+    ds3553Done = 1;
+    if (next != NULL)
+    {
+        next(status);
+    }
+}
+
+/**
+ * @brief   DS3553访问或I2C1总线是否正忙
+ * @retval  1 正忙；0 空闲
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static uint8_t DS3553_IsBusy(void)
 {
-    uint8_t tempBuffer[1 + len]; /* 临时缓冲区：寄存器地址+数据 */
+    return ds3553Done == 0 || I2C1_IsBusy();
+}
 
-    /* 组装I2C发送数据包：第一字节为寄存器地址，后续为数据 */
-    tempBuffer[0] = addr;
-    for (uint8_t i = 0; i < len; i++)
+/**
+ * @brief   发起一次DS3553寄存器异步访问
+ * @details 拉低片选并等待建立时间后，以中断方式启动I2C寄存器读或写，函数立即返回。
+ *          读操作在写寄存器地址后以重复起始条件转入读，整个访问只占用一次片选。
+ *          I2C1或上一次访问未完成时直接返回HAL_BUSY，不改动片选和完成状态，以免打断进行中的访问；
+ *          启动与完成状态的设置在关中断下进行，启动成功后才记录后续处理函数。
+ * @param   write 1表示写寄存器，0表示读寄存器
+ * @param   addr 目标寄存器地址 (8位地址)
+ * @param   buffer 数据缓冲区，访问完成前必须保持有效
+ * @param   len 数据字节数 (1-255字节)
+ * @param   next 访问完成后在中断上下文中调用的处理函数，可为NULL
+ * @retval  HAL_OK 已启动；HAL_BUSY 正忙，未做任何改动；其他 启动失败，片选已释放
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static HAL_StatusTypeDef DS3553_StartTransfer(uint8_t write, uint8_t addr, uint8_t *buffer, uint8_t len, I2C1_CallbackTypeDef next)
+{
+    HAL_StatusTypeDef status;
+    uint32_t primask;
+
+    if (DS3553_IsBusy())
     {
-        tempBuffer[1 + i] = *(bufferOfSend + i);
+        return HAL_BUSY;
     }
 
-    /* 启动DS3553通信序列 */
+    /* 启动DS3553通信序列，等待片选建立时间 */
     DS3553_Start();
+    delay_us(DS3553_CS_SETUP_US);
+
+    /* 完成中断在启动之后才能进入, 保证其读到本次的后续处理函数 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (write)
+    {
+        status = I2C1_MemWriteAsync(DS3553_ADDW, addr, buffer, len, DS3553_TransferCallback);
+    }
+    else
+    {
+        status = I2C1_MemReadAsync(DS3553_ADDW, addr, buffer, len, DS3553_TransferCallback);
+    }
+    if (status == HAL_OK)
+    {
+        ds3553Done = 0;
+        ds3553Next = next;
+    }
+    __set_PRIMASK(primask);
 
-    /* 等待通信线路稳定 */
-    HAL_Delay(10);
+    if (status != HAL_OK)
+    {
+        DS3553_Stop();
+    }
+    return status;
+}
 
-    /* 通过I2C发送完整数据包 */
-    I2C1_SendBytes(DS3553_ADDW, tempBuffer, 1 + len);
+/**
+ * @brief   等待当前DS3553访问完成
+ * @param   None
+ * @retval  HAL_OK 访问成功；HAL_TIMEOUT 超时，I2C1已复位；其他 传输错误
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static HAL_StatusTypeDef DS3553_WaitTransfer(void)
+{
+    uint32_t tickstart = HAL_GetTick();
 
-    /* 停止DS3553通信序列 */
-    DS3553_Stop();
+    while (ds3553Done == 0)
+    {
+        if ((HAL_GetTick() - tickstart) > DS3553_TIMEOUT_MS)
+        {
+            /* 芯片无响应，放弃本次传输并释放片选, 被放弃传输的回调不再调用 */
+            I2C1_Reset();
+            DS3553_Stop();
+            ds3553Status = HAL_TIMEOUT;
+            ds3553Done = 1;
+            DEBUG_Error("DS3553 I2C timeout\r\n");
+            return HAL_TIMEOUT;
+        }
+    }
+    return ds3553Status;
+}
+
+/**
+ * @brief   向DS3553指定寄存器写入数据
+ * @details 发起异步写访问并等待完成，总耗时为片选建立/保持时间加I2C传输时间。
+ * @param   addr 目标寄存器地址 (8位地址)
+ * @param   bufferOfSend 指向要写入数据的缓冲区指针
+ * @param   len 要写入的数据字节数 (1-255字节)
+ * @retval  HAL_OK 写入成功；其他 写入失败
+ * @note    该函数为静态函数，仅在本文件内部使用
+ * @warning 确保bufferOfSend指向的内存区域至少有len字节的有效数据
+ */
+static HAL_StatusTypeDef DS3553_WriteData(uint8_t addr, uint8_t *bufferOfSend, uint8_t len)
+{
+    HAL_StatusTypeDef status = DS3553_StartTransfer(1, addr, bufferOfSend, len, NULL);
 
-    /* 等待写操作完成，确保数据已写入芯片内部寄存器 */
-    HAL_Delay(15);
+    if (status != HAL_OK)
+    {
+        return status;
+    }
+    return DS3553_WaitTransfer();
 }
 
 /**
  * @brief   从DS3553指定寄存器读取数据
- * @details 通过I2C接口从DS3553芯片的指定寄存器地址读取指定长度的数据。
- *          该函数实现完整的I2C读操作序列，包括写寄存器地址和读取数据。
+ * @details 发起异步读访问并等待完成，寄存器地址写入与数据读取之间使用重复起始条件。
  * @param   addr 目标寄存器地址 (8位地址)
  * @param   bufferOfRead 指向存储读取数据的缓冲区指针
  * @param   len 要读取的数据字节数 (1-255字节)
- * @retval  None
- * @note    该函数为静态函数，仅在本文件内部使用。读操作完成后会自动添加延时确保操作时序正确
+ * @retval  HAL_OK 读取成功；其他 读取失败
+ * @note    该函数为静态函数，仅在本文件内部使用
  * @warning 确保bufferOfRead指向的内存区域至少有len字节的可用空间
  */
-static void DS3553_ReadData(uint8_t addr, uint8_t *bufferOfRead, uint8_t len)
+static HAL_StatusTypeDef DS3553_ReadData(uint8_t addr, uint8_t *bufferOfRead, uint8_t len)
 {
-    /* 启动DS3553通信序列 */
-    DS3553_Start();
+    HAL_StatusTypeDef status = DS3553_StartTransfer(0, addr, bufferOfRead, len, NULL);
 
-    /* 等待通信线路稳定 */
-    HAL_Delay(10);
-
-    /* 发送寄存器地址，指定要读取的寄存器 */
-    I2C1_SendByte(DS3553_ADDW, addr);
+    if (status != HAL_OK)
+    {
+        return status;
+    }
+    return DS3553_WaitTransfer();
+}
 
-    /* 从指定寄存器读取数据 */
-    I2C1_ReceiveBytes(DS3553_ADDR, bufferOfRead, len);
+/**
+ * @brief   初始化I2C1和片选引脚
+ * @param   None
+ * @retval  None
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static void DS3553_BusInit(void)
+{
+    /* 初始化I2C通信接口 */
+    I2C1_Init();
 
-    /* 停止DS3553通信序列 */
+    /* 初始化GPIOB5作为片选控制引脚，空闲时保持高电平 */
+    GPIOB5_Init();
     DS3553_Stop();
+}
+
+/**
+ * @brief   读取芯片ID与USER_SET并按需写入配置
+ * @details 仅当USER_SET与DS3553_USER_SET_CONFIG不一致时才写入，
+ *          完成后更新寄存器影子并在备份寄存器中记录本次上电已配置。
+ * @param   None
+ * @retval  None
+ * @note    该函数为静态函数，仅在本文件内部使用
+ */
+static void DS3553_Configure(void)
+{
+    uint8_t chipId = 0;
+    uint8_t set = 0;
+    uint8_t config = DS3553_USER_SET_CONFIG;
+
+    if (DS3553_ReadData(CHIP_ID, &chipId, 1) != HAL_OK || DS3553_ReadData(USER_SET, &set, 1) != HAL_OK)
+    {
+        return;
+    }
 
-    /* 等待读操作完成，确保时序正确 */
-    HAL_Delay(15);
+    /* 配置漂移时才写入USER_SET寄存器 */
+    if ((set & DS3553_USER_SET_MASK) != config)
+    {
+        DEBUG_Info("DS3553 USER_SET 0x%02X -> 0x%02X\r\n", set, config);
+        if (DS3553_WriteData(USER_SET, &config, 1) != HAL_OK)
+        {
+            return;
+        }
+    }
+
+    ds3553Shadow.chipId = chipId;
+    ds3553Shadow.userSet = config;
+    ds3553Shadow.valid = 1;
+    PWR_SetSession(PWR_SESSION_DS3553, 1);
 }
 
 /**
@@ -115,30 +268,47 @@ static void DS3553_ReadData(uint8_t addr, uint8_t *bufferOfRead, uint8_t len)
  * @details 完成DS3553芯片的完整初始化流程，包括：
  *          1. 初始化I2C通信接口
  *          2. 初始化GPIO控制引脚
- *          3. 配置芯片工作模式和参数
- *          4. 验证配置结果
+ *          3. 读取芯片ID和USER_SET，配置不一致时写入
+ *          4. 更新寄存器影子
  * @param   None
  * @retval  None
- * @note    此函数必须在使用其他DS3553相关函数前调用
+ * @note    无论会话状态如何都会重新读取芯片配置，周期性访问应使用DS3553_Open
  * @warning 确保I2C1和GPIOB5的时钟已使能
  */
 void DS3553_Init(void)
 {
-    uint8_t set = 0x18; /* 初始配置值：0x18 = 0001 1000b */
-
-    /* 初始化I2C通信接口 */
-    I2C1_Init();
-
-    /* 初始化GPIOB5作为片选控制引脚 */
-    GPIOB5_Init();
+    DS3553_BusInit();
+    DS3553_Configure();
+    ds3553Opened = 1;
+}
 
-    /* 配置用户设置寄存器 */
-    set = 0x18; /* 恢复默认值 */
-    set &= ~(0x01 << 4);
-    set |= (0x01 << 1);
+/**
+ * @brief   打开DS3553会话
+ * @details DS3553独立于MCU供电并持续计步，只需在整机上电后配置一次：
+ *          - 同一次MCU运行期间(含STOP唤醒)重复调用直接返回；
+ *          - 待机唤醒后仅重新初始化I2C1和片选引脚，备份寄存器中的会话标记
+ *            与掉电保持的寄存器影子均有效时不访问芯片；
+ *          - 整机上电后执行完整的DS3553_Init。
+ *          之后的配置漂移由DS3553_GetStepCount的突发读取发现并修正。
+ * @param   None
+ * @retval  None
+ */
+void DS3553_Open(void)
+{
+    if (ds3553Opened)
+    {
+        return;
+    }
 
-    /* 将配置写入芯片的USER_SET寄存器 */
-    DS3553_WriteData(USER_SET, &set, 1);
+    if (ds3553Shadow.valid && PWR_GetSession(PWR_SESSION_DS3553))
+    {
+        DS3553_BusInit();
+        ds3553Opened = 1;
+    }
+    else
+    {
+        DS3553_Init();
+    }
 }
 
 /**
@@ -159,50 +329,109 @@ void DS3553_PrintInfo(void)
 {
     uint8_t tempbuffer = 0;
 
-    DEBUG_Printf("--------------------DS3553-------------------\r\n");
+    DEBUG_Info("--------------------DS3553-------------------\r\n");
     /* 读取并打印芯片ID */
     DS3553_ReadData(CHIP_ID, &tempbuffer, 1);
-    DEBUG_Printf("DS3553 CHIP_ID: 0x%02X\r\n", tempbuffer);
+    DEBUG_Info("DS3553 CHIP_ID: 0x%02X\r\n", tempbuffer);
 
     /* 读取并打印用户设置寄存器值 */
     DS3553_ReadData(USER_SET, &tempbuffer, 1);
-    DEBUG_Printf("DS3553 Init USER_SET: 0x%02X\r\n", tempbuffer);
-    DEBUG_Printf("---------------------------------------------\r\n");
+    DEBUG_Info("DS3553 Init USER_SET: 0x%02X\r\n", tempbuffer);
+    DEBUG_Info("---------------------------------------------\r\n");
 }
 
 /**
  * @brief   获取DS3553芯片当前的步数计数值
- * @details 从DS3553芯片读取24位(3字节)的步数计数值，并将其转换为32位无符号整数。
+ * @details 从USER_SET开始一次突发读取4字节：USER_SET用于检查配置是否漂移，
+ *          随后的24位(3字节)步数计数值转换为32位无符号整数。
  *          DS3553芯片将步数存储在连续的3个寄存器中：
  *          - STEP_CNT_L (0xC4): 步数低字节
  *          - STEP_CNT_M (0xC5): 步数中字节
  *          - STEP_CNT_H (0xC6): 步数高字节
  * @param   None
  * @retval  uint32_t 当前步数计数值 (范围: 0 ~ 16777215)
- * @note    读取的步数值会同时更新全局变量countOfStep
+ * @note    读取的步数值会同时更新全局变量countOfStep，读取失败时返回上次的步数；
+ *          USER_SET与寄存器影子不一致(如芯片曾单独掉电)时重新配置芯片
  * @warning 芯片复位或掉电后步数计数会清零
  *
  * @par     数据格式说明:
  *          芯片采用小端序存储，即：
- *          - tempbuffer[0] = 低字节 (STEP_CNT_L)
- *          - tempbuffer[1] = 中字节 (STEP_CNT_M)
- *          - tempbuffer[2] = 高字节 (STEP_CNT_H)
+ *          - stepBuffer[1] = 低字节 (STEP_CNT_L)
+ *          - stepBuffer[2] = 中字节 (STEP_CNT_M)
+ *          - stepBuffer[3] = 高字节 (STEP_CNT_H)
  *          最终步数 = (高字节<<16) | (中字节<<8) | 低字节
  */
 uint32_t DS3553_GetStepCount(void)
 {
-    uint8_t tempbuffer[3] = {0}; /* 存储3字节步数数据的缓冲区 */
-
-    /* 从STEP_CNT_L开始连续读取3字节步数数据 */
-    DS3553_ReadData(STEP_CNT_L, tempbuffer, 3);
+    /* 突发读取USER_SET与3字节步数数据，读取失败时保持上次的步数 */
+    if (DS3553_GetStepCountAsync(NULL) == HAL_OK)
+    {
+        DS3553_WaitTransfer();
+    }
 
-    /* 将3字节数据组合成32位步数值（小端序转大端序） */
-    countOfStep = (tempbuffer[2] << 16) | (tempbuffer[1] << 8) | (tempbuffer[0]);
+    if (ds3553Drift)
+    {
+        ds3553Drift = 0;
+        DEBUG_Warn("DS3553 USER_SET drift: 0x%02X\r\n", stepBuffer[0]);
+        DS3553_Configure();
+    }
 
     /* 返回当前步数计数值 */
     return countOfStep;
 }
 
+/**
+ * @brief   步数异步读取完成处理
+ * @param   status I2C传输结果
+ * @retval  None
+ * @note    在I2C1中断上下文中调用
+ */
+static void DS3553_StepCallback(HAL_StatusTypeDef status)
+{
+    if (status == HAL_OK)
+    {
+        /* 将3字节数据组合成32位步数值（小端序转大端序） */
+        countOfStep = ((uint32_t)stepBuffer[3] << 16) | ((uint32_t)stepBuffer[2] << 8) | stepBuffer[1];
+
+        /* 配置漂移在中断外由DS3553_GetStepCount处理 */
+        if ((stepBuffer[0] & DS3553_USER_SET_MASK) != ds3553Shadow.userSet)
+        {
+            ds3553Drift = 1;
+        }
+    }
+
+    if (stepCallback != NULL)
+    {
+        stepCallback(status);
+    }
+}
+
+/**
+ * @brief   异步读取DS3553步数计数值
+ * @details 启动一次USER_SET~STEP_CNT_H的连续读取后立即返回，
+ *          读取完成后在中断上下文中更新countOfStep并调用callback。
+ * @param   callback 完成回调，可为NULL
+ * @retval  HAL_OK 已启动读取；HAL_BUSY I2C1或上一次访问正忙, 进行中的读取及其回调不受影响；其他 启动失败
+ */
+HAL_StatusTypeDef DS3553_GetStepCountAsync(DS3553_CallbackTypeDef callback)
+{
+    HAL_StatusTypeDef status;
+    DS3553_CallbackTypeDef previous = stepCallback;
+
+    if (DS3553_IsBusy())
+    {
+        return HAL_BUSY;
+    }
+
+    stepCallback = callback; /* 总线空闲, 没有进行中的读取会使用该回调 */
+    status = DS3553_StartTransfer(0, USER_SET, stepBuffer, sizeof(stepBuffer), DS3553_StepCallback);
+    if (status != HAL_OK)
+    {
+        stepCallback = previous;
+    }
+    return status;
+}
+
 /**
  * @brief   复位DS3553芯片的步数计数器
  * @details 通过设置USER_SET寄存器的RST_STEP位(bit2)来清零步数计数器。
@@ -223,7 +452,10 @@ void DS3553_Reset(void)
     uint8_t data = 0;
 
     /* 读取当前用户设置寄存器的值，保持其他配置不变 */
-    DS3553_ReadData(USER_SET, &data, 1);
+    if (DS3553_ReadData(USER_SET, &data, 1) != HAL_OK)
+    {
+        return;
+    }
 
     /* 设置RST_STEP位(bit2)为1，触发步数计数器复位 */
     data |= 0x04; /* 0x04 = 0000 0100b，对应bit2 */
@@ -4,6 +4,8 @@
 #include "i2c/i2c.h"
 #include "gpio/gpio.h"
 #include "debug/debug.h"
+#include "delay/delay.h"
+#include "PWR/pwr.h"
 
 extern I2C_HandleTypeDef hi2c1;
 
@@ -18,14 +20,42 @@ extern I2C_HandleTypeDef hi2c1;
 #define STEP_CNT_M 0xC5
 #define STEP_CNT_H 0xC6
 
+/* USER_SET配置值: 默认值0x18清除bit4、置位bit1; bit2(RST_STEP)由芯片自动清零, 比较配置时忽略 */
+#define DS3553_USER_SET_CONFIG 0x0A
+#define DS3553_USER_SET_MASK 0xFB
+
+/* 片选时序(us): CS拉低到I2C起始条件的建立时间, I2C停止条件到CS拉高的保持时间 */
+#define DS3553_CS_SETUP_US 30
+#define DS3553_CS_HOLD_US 5
+
+/* 单次寄存器访问超时时间(ms), 400kHz下3字节读取实际约0.2ms */
+#define DS3553_TIMEOUT_MS 5
+
+/* 异步访问完成回调, 在I2C1中断上下文中调用 */
+typedef void (*DS3553_CallbackTypeDef)(HAL_StatusTypeDef status);
+
+/* DS3553寄存器影子, 由persist模块掉电保持 */
+typedef struct
+{
+    uint8_t chipId;     // 芯片ID
+    uint8_t userSet;    // 已写入的USER_SET配置
+    uint8_t valid;      // 1表示影子有效
+    uint8_t reserved;
+} DS3553_ShadowTypeDef;
+
 extern uint32_t countOfStep;
+extern DS3553_ShadowTypeDef ds3553Shadow;
 
 void DS3553_Init(void);
 
+void DS3553_Open(void);
+
 void DS3553_PrintInfo(void);
 
 uint32_t DS3553_GetStepCount(void);
 
+HAL_StatusTypeDef DS3553_GetStepCountAsync(DS3553_CallbackTypeDef callback);
+
 void DS3553_Reset(void);
 
 #endif
\ No newline at end of file
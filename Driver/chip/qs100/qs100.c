@@ -9,6 +9,8 @@
  * - GPIO: 用于控制模块的唤醒引脚
  * - Debug: 用于调试信息输出
  */
+#define LOG_MODULE_LEVEL LOG_LEVEL_NBIOT
+
 #include "qs100/qs100.h"
 
 /**
@@ -20,6 +22,12 @@
  */
 uint8_t tempBuffer[64] = {0};
 
+/* 最近一次发送的网络代价, 供上报策略使用 */
+QS100_LinkStatsTypeDef qs100LinkStats = {0};
+
+/* AT+NSOSD 数据部分按块转换为十六进制发送, 不再按数据长度在栈上分配整条命令 */
+static uint8_t qs100HexBuffer[QS100_HEX_CHUNK * 2];
+
 /**
  * @brief 检查tempBuffer中是否包含有效的AT命令响应
  * @details 扫描tempBuffer缓冲区，查找"OK"或"ERROR"字符串，
@@ -44,6 +52,41 @@ static uint8_t QS100_CheckResponse(void)
     return 0;  // 未找到有效响应
 }
 
+/**
+ * @brief 接收AT命令的响应到tempBuffer
+ * @details 先以空闲中断方式接收, 未收到"OK"或"ERROR"时以普通接收方式重试, 最多重试5次
+ * @see QS100_SendCommand()
+ */
+static void QS100_ReceiveResponse(void)
+{
+    uint8_t i = 0;  // 重试计数器
+    
+    // 清空临时缓冲区，准备接收新的响应数据
+    memset(tempBuffer, 0, sizeof(tempBuffer));
+    
+    // 使用空闲中断方式接收数据，这种方式更适合接收不定长的AT响应
+    USART3_ReceiveToIdle(tempBuffer, sizeof(tempBuffer));
+    
+    // 重试机制：最多尝试5次接收有效响应
+    while (i < 5)
+    {
+        // 检查接收到的响应是否包含"OK"或"ERROR"
+        if (QS100_CheckResponse() == 1)
+        {
+            // 收到有效响应，打印到调试接口并退出循环
+            DEBUG_Trace("%s\r\n", tempBuffer);
+            break;
+        }
+        else
+        {
+            // 未收到有效响应，使用普通接收方式重试
+            // 这里使用阻塞式接收作为备用方案
+            USART3_ReceiveData(tempBuffer, sizeof(tempBuffer));
+            i++;  // 增加重试计数
+        }
+    }
+}
+
 /**
  * @brief 获取网络附着状态
  * @details 发送AT+CGATT?命令查询模块的网络附着状态。
@@ -159,35 +202,40 @@ static void QS100_ConnectServer(uint8_t socket, char *ip, uint16_t port)
  * @param[in] len 数据长度，单位为字节
  * @note 该函数为内部使用的静态函数
  * @note 数据会被转换为大写十六进制字符串格式发送
- * @warning 确保cmd缓冲区(512字节)足够存储完整的命令
+ * @note 命令分三段经串口连续发出: 命令头、按QS100_HEX_CHUNK字节一块转换的十六进制数据、命令尾,
+ *       数据长度不受命令缓冲区限制, 栈上只有命令头和命令尾
  * @warning SEQUENCE必须在调用前定义，否则会编译错误
  * @see QS100_SendCommand()
  */
 static void QS100_SendTo(uint8_t socket, uint8_t *data, uint16_t len)
 {
-    // 计算十六进制字符串所需长度（每字节需2个字符+结束符）
-    uint16_t hex_len = len * 2 + 1;
-    uint8_t hex_data[hex_len];  // 存储十六进制字符串的缓冲区
+    static const char hex[] = "0123456789ABCDEF";
+    char cmd[24] = {0};  // 命令头或命令尾，24字节足够
+    uint16_t i, n;
     
-    // 清空缓冲区
-    memset(hex_data, 0, hex_len);
+    // 命令头: AT+NSOSD=<socket>,<length>,
+    sprintf(cmd, "AT+NSOSD=%d,%d,", socket, len);
+    USART3_SendData((uint8_t *)cmd, strlen(cmd));
     
-    // 将二进制数据转换为十六进制字符串
-    for (uint16_t i = 0; i < len; i++)
+    // 数据: 每字节转换为2位大写十六进制字符
+    while (len > 0)
     {
-        // 将每个字节转换为2位大写十六进制字符
-        sprintf((char *)hex_data + i * 2, "%02X", data[i]);
+        n = (len > QS100_HEX_CHUNK) ? QS100_HEX_CHUNK : len;
+        for (i = 0; i < n; i++)
+        {
+            qs100HexBuffer[i * 2] = hex[data[i] >> 4];
+            qs100HexBuffer[i * 2 + 1] = hex[data[i] & 0x0F];
+        }
+        USART3_SendData(qs100HexBuffer, n * 2);
+        data += n;
+        len -= n;
     }
     
-    // 命令缓冲区，512字节应足够存储大部分发送命令
-    uint8_t cmd[512] = {0};
+    // 命令尾: ,<rai>,<sequence>
+    sprintf(cmd, ",0x200,%d\r\n", SEQUENCE);
+    USART3_SendData((uint8_t *)cmd, strlen(cmd));
     
-    // 组装发送数据命令
-    // AT+NSOSD=<socket>,<length>,<data>,<rai>,<sequence>
-    sprintf((char *)cmd, "AT+NSOSD=%d,%d,%s,0x200,%d\r\n", socket, len, hex_data, SEQUENCE);
-    
-    // 发送命令到模块
-    QS100_SendCommand(cmd);
+    QS100_ReceiveResponse();
 }
 
 /**
@@ -220,10 +268,10 @@ void QS100_Reset(void)
     USART3_ReceiveData(tempBuffer, sizeof(tempBuffer));
     if (strlen((char *)tempBuffer) > 0)
     {
-        DEBUG_Printf("------------ QS100 Reset Response -----------\r\n");
-        DEBUG_Printf("%s\r\n", tempBuffer);
-        DEBUG_Printf("QS100 Reset Successful!\r\n");
-        DEBUG_Printf("---------------------------------------------\r\n");
+        DEBUG_Trace("------------ QS100 Reset Response -----------\r\n");
+        DEBUG_Trace("%s\r\n", tempBuffer);
+        DEBUG_Info("QS100 Reset Successful!\r\n");
+        DEBUG_Trace("---------------------------------------------\r\n");
     }
 }
 
@@ -276,7 +324,7 @@ void QS100_Wakeup(void)
  */
 void QS100_PrintInfo(void)
 {
-    DEBUG_Printf("------------------- QS100 -------------------\r\n");
+    DEBUG_Trace("------------------- QS100 -------------------\r\n");
 
     // 获取SIM卡的国际移动用户识别码(IMSI)
     QS100_SendCommand((uint8_t *)"AT+CIMI\r\n");
@@ -308,7 +356,7 @@ void QS100_PrintInfo(void)
     QS100_SendCommand((uint8_t *)"AT+NV=GET,PRODUCTVER\r\n");  // 产品版本
     QS100_SendCommand((uint8_t *)"AT+NV=GET,VER\r\n");         // 综合版本信息
 
-    DEBUG_Printf("---------------------------------------------\r\n");
+    DEBUG_Trace("---------------------------------------------\r\n");
 }
 
 /**
@@ -330,35 +378,11 @@ void QS100_PrintInfo(void)
  */
 void QS100_SendCommand(uint8_t *cmd)
 {
-    uint8_t i = 0;  // 重试计数器
-    
     // 通过USART3发送AT命令到QS100模块
     USART3_SendData(cmd, strlen((char *)cmd));
     
-    // 清空临时缓冲区，准备接收新的响应数据
-    memset(tempBuffer, 0, sizeof(tempBuffer));
-    
-    // 使用空闲中断方式接收数据，这种方式更适合接收不定长的AT响应
-    USART3_ReceiveToIdle(tempBuffer, sizeof(tempBuffer));
-    
-    // 重试机制：最多尝试5次接收有效响应
-    while (i < 5)
-    {
-        // 检查接收到的响应是否包含"OK"或"ERROR"
-        if (QS100_CheckResponse() == 1)
-        {
-            // 收到有效响应，打印到调试接口并退出循环
-            DEBUG_Printf("%s\r\n", tempBuffer);
-            break;
-        }
-        else
-        {
-            // 未收到有效响应，使用普通接收方式重试
-            // 这里使用阻塞式接收作为备用方案
-            USART3_ReceiveData(tempBuffer, sizeof(tempBuffer));
-            i++;  // 增加重试计数
-        }
-    }
+    // 接收并检查响应
+    QS100_ReceiveResponse();
 }
 
 /**
@@ -374,6 +398,7 @@ void QS100_SendCommand(uint8_t *cmd)
  *          6. 关闭客户端连接（NSOCL命令）
  * @param[in] data 指向要发送的二进制数据缓冲区
  * @param[in] len 数据长度，单位为字节，建议不超过1KB
+ * @return uint8_t 0 表示SEQUENCE查询确认发送成功；1 表示重试用尽仍未确认
  * @note 每个步骤都具有重试机制，最多重试10次
  * @note 函数使用预定义的IP和PORT连接服务器
  * @note 发送状态通过硬编码的缓冲区位置检查（存在风险）
@@ -386,12 +411,16 @@ void QS100_SendCommand(uint8_t *cmd)
  * @todo 改进错误处理机制
  * @todo 使用更可靠的状态检查方法
  */
-void QS100_SendData(uint8_t *data, uint16_t len)
+uint8_t QS100_SendData(uint8_t *data, uint16_t len)
 {
     //==================== 第一步：检查网络连接状态 ====================
     // 检查模块是否已连接到移动网络，这是数据传输的前提条件
     uint8_t i = 0;  // 重试计数器，用于各个步骤的重试控制
     
+    PROFILE_Begin(PROFILE_PHASE_ATTACH);
+    uint32_t tickstart = HAL_GetTick();
+    qs100LinkStats.retries = 0;
+
     // 发送网络附着状态查询命令
     QS100_GetIP();
     
@@ -404,7 +433,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 注意：这里的检查方式较为简单，可能匹配到其他含"1"的内容
         if (strstr((char *)pbuffer, "1") != NULL)
         {
-            DEBUG_Printf("Internet Connected\r\n");
+            DEBUG_Info("Internet Connected\r\n");
             break;  // 网络连接正常，退出重试循环
         }
         else
@@ -418,6 +447,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
 
     //==================== 第二步：创建网络套接字 ====================
     // 创建TCP套接字用于与服务器通信
+    qs100LinkStats.retries += i;
     i = 0;  // 重置重试计数器
     uint8_t socket = 0xff;  // 套接字号，初始化为无效值0xff
     
@@ -438,7 +468,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         else
         {
             // 套接字创建成功，打印套接字号
-            DEBUG_Printf("Socket is socket %d\r\n", socket);
+            DEBUG_Info("Socket is socket %d\r\n", socket);
             break;  // 退出重试循环
         }
         // 注意：如果10次重试后仍未成功创建套接字，socket仍为0xff，
@@ -446,6 +476,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
     }
     //==================== 第三步：连接到远程服务器 ====================
     // 使用创建的套接字连接到预定义的服务器地址和端口
+    qs100LinkStats.retries += i;
     i = 0;  // 重置重试计数器
     
     // 发送连接服务器命令，使用头文件中定义的IP和PORT
@@ -459,7 +490,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 检查连接响应是否包含"OK"，表示连接成功
         if (strstr(buffer_str, "OK") != NULL)
         {
-            DEBUG_Printf("Connect Server Successful\r\n");
+            DEBUG_Info("Connect Server Successful\r\n");
             break;  // 连接成功，退出重试循环
         }
         else
@@ -473,8 +504,13 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 这可能导致发送失败，应该在此处添加错误处理
     }
 
+    qs100LinkStats.attachTime = HAL_GetTick() - tickstart;
+    PROFILE_End(PROFILE_PHASE_ATTACH);
+
     //==================== 第四步：发送数据并检查状态 ====================
     // 将用户数据发送到服务器，并检查发送状态
+    PROFILE_Begin(PROFILE_PHASE_SEND);
+    qs100LinkStats.retries += i;
     i = 0;  // 重置重试计数器
     uint8_t cmd[64] = {0};  // 用于存储状态查询命令的缓冲区
     
@@ -498,7 +534,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 检查连接响应是否包含"1"，表示连接成功
         if (strstr(buffer_str, "1") != NULL)
         {
-            DEBUG_Printf("Send Data Successful!\r\n");
+            DEBUG_Info("Send Data Successful!\r\n");
             break;  // 连接成功，退出重试循环
         }
         
@@ -517,8 +553,13 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 注意：如果10次重试后仍显示发送失败，函数仍会继续执行关闭操作
     }
 
+    PROFILE_End(PROFILE_PHASE_SEND);
+    uint8_t result = (i < 10) ? 0 : 1;  // 发送状态确认结果
+
     //==================== 第五步：关闭网络套接字连接 ====================
     // 数据发送完成后，关闭套接字连接以释放网络资源
+    PROFILE_Begin(PROFILE_PHASE_CLOSE);
+    qs100LinkStats.retries += i;
     i = 0;  // 重置重试计数器
     
     // 发送关闭套接字命令
@@ -532,7 +573,7 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 检查关闭响应是否包含"OK"，表示关闭成功
         if (strstr((char *)buffer_str, "OK") != NULL)
         {
-            DEBUG_Printf("Close Client Successful\r\n");
+            DEBUG_Info("Close Client Successful\r\n");
             break;  // 关闭成功，退出重试循环
         }
         else
@@ -546,7 +587,10 @@ void QS100_SendData(uint8_t *data, uint16_t len)
         // 未关闭的套接字可能会占用系统资源
     }
     
+    qs100LinkStats.retries += i;
     HAL_Delay(1000);  // 最后等待1秒，确保关闭客户端完成
+    PROFILE_End(PROFILE_PHASE_CLOSE);
+    return result;
 }
 
 
@@ -6,8 +6,19 @@
 #include "GPIO/gpio.h"
 #include "Debug/debug.h"
 #include "user_config.h"
+#include "Profile/profile.h"
 
 #define SEQUENCE 5
+#define QS100_HEX_CHUNK 32     /* AT+NSOSD 每次转换为十六进制发送的数据字节数 */
+
+typedef struct
+{
+    uint32_t attachTime;    // 最近一次发送的网络附着、创建并连接套接字耗时(ms)
+    uint8_t retries;        // 最近一次发送各步骤的重试次数之和
+} QS100_LinkStatsTypeDef;
+
+extern QS100_LinkStatsTypeDef qs100LinkStats;
+extern uint8_t tempBuffer[64];  /* 最近一条AT命令的响应 */
 
 void QS100_Init(void);
 
@@ -21,7 +32,7 @@ void QS100_PrintInfo(void);
 
 void QS100_SendCommand(uint8_t *cmd);
 
-void QS100_SendData(uint8_t *data, uint16_t len);
+uint8_t QS100_SendData(uint8_t *data, uint16_t len);
 
 
 #endif
@@ -0,0 +1,181 @@
+/**
+ * @file aes.c
+ * @brief AES-128加密与AES-CMAC(RFC 4493)
+ *
+ * 只实现加密方向: LoRaWAN的载荷加密(CTR方式)、入网应答解密(设备端用加密运算)和MIC(CMAC)
+ * 都只需要AES加密。按字节运算, 只用256字节的S盒, 不使用T表, 以Flash和RAM占用为先。
+ */
+
+#include "Aes/aes.h"
+
+static const uint8_t aesSbox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16,
+};
+
+/**
+ * @brief GF(2^8)上乘以x
+ */
+static uint8_t AES_Xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
+}
+
+/**
+ * @brief 展开AES-128轮密钥
+ * @param ctx 输出轮密钥
+ * @param key 16字节密钥
+ */
+void AES_SetKey(AesContextTypeDef *ctx, const uint8_t key[AES_BLOCK_SIZE])
+{
+    uint8_t *w = ctx->roundKey;
+    uint8_t rcon = 0x01;
+    uint8_t t[4];
+    uint8_t i;
+
+    memcpy(w, key, AES_BLOCK_SIZE);
+    for (i = 4; i < 4 * (AES_ROUNDS + 1); i++)
+    {
+        memcpy(t, w + 4 * (i - 1), 4);
+        if (i % 4 == 0)
+        {
+            uint8_t first = t[0];
+
+            t[0] = aesSbox[t[1]] ^ rcon;
+            t[1] = aesSbox[t[2]];
+            t[2] = aesSbox[t[3]];
+            t[3] = aesSbox[first];
+            rcon = AES_Xtime(rcon);
+        }
+        w[4 * i + 0] = w[4 * (i - 4) + 0] ^ t[0];
+        w[4 * i + 1] = w[4 * (i - 4) + 1] ^ t[1];
+        w[4 * i + 2] = w[4 * (i - 4) + 2] ^ t[2];
+        w[4 * i + 3] = w[4 * (i - 4) + 3] ^ t[3];
+    }
+}
+
+/**
+ * @brief 加密一个分组
+ * @param ctx 轮密钥
+ * @param in 明文
+ * @param out 密文, 可与in相同
+ */
+void AES_Encrypt(const AesContextTypeDef *ctx, const uint8_t in[AES_BLOCK_SIZE], uint8_t out[AES_BLOCK_SIZE])
+{
+    uint8_t s[AES_BLOCK_SIZE];
+    uint8_t t[AES_BLOCK_SIZE];
+    uint8_t round;
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; i++)
+    {
+        s[i] = in[i] ^ ctx->roundKey[i];
+    }
+
+    for (round = 1; round <= AES_ROUNDS; round++)
+    {
+        /* SubBytes + ShiftRows, 状态按列存放: s[4 * 列 + 行] */
+        for (i = 0; i < AES_BLOCK_SIZE; i++)
+        {
+            t[i] = aesSbox[s[(i + 4 * (i % 4)) % AES_BLOCK_SIZE]];
+        }
+
+        /* MixColumns, 最后一轮没有 */
+        if (round < AES_ROUNDS)
+        {
+            for (i = 0; i < AES_BLOCK_SIZE; i += 4)
+            {
+                uint8_t a0 = t[i], a1 = t[i + 1], a2 = t[i + 2], a3 = t[i + 3];
+                uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+                t[i + 0] = a0 ^ all ^ AES_Xtime(a0 ^ a1);
+                t[i + 1] = a1 ^ all ^ AES_Xtime(a1 ^ a2);
+                t[i + 2] = a2 ^ all ^ AES_Xtime(a2 ^ a3);
+                t[i + 3] = a3 ^ all ^ AES_Xtime(a3 ^ a0);
+            }
+        }
+
+        for (i = 0; i < AES_BLOCK_SIZE; i++)
+        {
+            s[i] = t[i] ^ ctx->roundKey[round * AES_BLOCK_SIZE + i];
+        }
+    }
+
+    memcpy(out, s, AES_BLOCK_SIZE);
+}
+
+/**
+ * @brief CMAC子密钥生成: 左移一位, 移出位为1时异或0x87
+ */
+static void AES_CmacShift(uint8_t block[AES_BLOCK_SIZE])
+{
+    uint8_t carry = block[0] & 0x80;
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE - 1; i++)
+    {
+        block[i] = (uint8_t)((block[i] << 1) | (block[i + 1] >> 7));
+    }
+    block[AES_BLOCK_SIZE - 1] = (uint8_t)(block[AES_BLOCK_SIZE - 1] << 1);
+    if (carry)
+    {
+        block[AES_BLOCK_SIZE - 1] ^= 0x87;
+    }
+}
+
+/**
+ * @brief 计算AES-CMAC
+ * @param ctx 轮密钥
+ * @param data 消息
+ * @param length 消息长度
+ * @param mac 输出16字节MAC
+ */
+void AES_Cmac(const AesContextTypeDef *ctx, const uint8_t *data, uint16_t length, uint8_t mac[AES_BLOCK_SIZE])
+{
+    uint8_t subkey[AES_BLOCK_SIZE] = {0};
+    uint8_t x[AES_BLOCK_SIZE] = {0};
+    uint16_t remain = length;
+    uint8_t i;
+
+    /* K1 = L << 1, K2 = K1 << 1, L = AES(K, 0) */
+    AES_Encrypt(ctx, subkey, subkey);
+    AES_CmacShift(subkey);
+
+    while (remain > AES_BLOCK_SIZE)
+    {
+        for (i = 0; i < AES_BLOCK_SIZE; i++)
+        {
+            x[i] ^= data[i];
+        }
+        AES_Encrypt(ctx, x, x);
+        data += AES_BLOCK_SIZE;
+        remain -= AES_BLOCK_SIZE;
+    }
+
+    /* 最后一个分组: 完整时异或K1, 否则补10...0后异或K2 */
+    if (remain < AES_BLOCK_SIZE)
+    {
+        AES_CmacShift(subkey);
+    }
+    for (i = 0; i < AES_BLOCK_SIZE; i++)
+    {
+        uint8_t byte = (i < remain) ? data[i] : ((i == remain) ? 0x80 : 0x00);
+
+        x[i] ^= byte ^ subkey[i];
+    }
+    AES_Encrypt(ctx, x, mac);
+}
@@ -0,0 +1,20 @@
+#ifndef __AES_H__
+#define __AES_H__
+
+#include "stdint.h"
+#include "string.h"
+
+#define AES_BLOCK_SIZE  16
+#define AES_ROUNDS      10      /* AES-128 */
+
+/* 已展开的轮密钥 */
+typedef struct
+{
+    uint8_t roundKey[(AES_ROUNDS + 1) * AES_BLOCK_SIZE];
+} AesContextTypeDef;
+
+void AES_SetKey(AesContextTypeDef *ctx, const uint8_t key[AES_BLOCK_SIZE]);
+void AES_Encrypt(const AesContextTypeDef *ctx, const uint8_t in[AES_BLOCK_SIZE], uint8_t out[AES_BLOCK_SIZE]);
+void AES_Cmac(const AesContextTypeDef *ctx, const uint8_t *data, uint16_t length, uint8_t mac[AES_BLOCK_SIZE]);
+
+#endif
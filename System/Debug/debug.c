@@ -44,8 +44,12 @@ FILE __stdout;
 /* 重定义fputc函数，printf最终通过fputc输出到串口 */
 int fputc(int ch, FILE *f)
 {
+#ifdef LOG_BINARY
+    LOG_PutChar((uint8_t)ch);             /* 写入日志缓冲区, 由DMA发送 */
+#else
     while ((USART1->SR & 0X40) == 0);     /* 等待上一个字符发送完成 */
     USART1->DR = (uint8_t)ch;             /* 将要发送的字符ch写入DR寄存器 */
+#endif
     return ch;                            /* 返回发送的字符 */
 }
 /*********************************************结束*************************************/
@@ -79,4 +83,20 @@ void DEBUG_Init(void)
     huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
     huart1.Init.OverSampling = UART_OVERSAMPLING_16;
     HAL_UART_Init(&huart1);
+#ifdef LOG_BINARY
+    LOG_Init();
+#endif
+}
+
+/**
+ * @brief 等待调试串口发送完成
+ * @note  进入低功耗模式前调用, 保证最后的调试信息完整输出
+ */
+void DEBUG_Flush(void)
+{
+#ifdef LOG_BINARY
+    LOG_Flush();                          /* 等待日志缓冲区经DMA发送完毕 */
+#else
+    while ((USART1->SR & 0X40) == 0);     /* 等待发送完成(TC) */
+#endif
 }
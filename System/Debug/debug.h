@@ -4,18 +4,72 @@
 #include "sys/sys.h"
 #include "stdio.h"
 #include "string.h"
+#include "user_config.h"
+#include "Log/log.h"
+
+extern UART_HandleTypeDef huart1;
 
 void DEBUG_Init(void);
+void DEBUG_Flush(void);
+
+/* 本文件的编译期日志阈值, 源文件可在包含头文件之前定义为 user_config.h 中的 LOG_LEVEL_<模块> */
+#ifndef LOG_MODULE_LEVEL
+    #define LOG_MODULE_LEVEL LOG_LEVEL_DEFAULT
+#endif
 
 /* 宏定义控制调试开关 */
 #ifdef DEBUG_ENABLE
     #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : \
                          (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__))
 
-    #define DEBUG_Printf(fmt, ...) printf("[%s, %d] "fmt, __FILENAME__, __LINE__, ##__VA_ARGS__)
+#ifdef LOG_BINARY
+    /* 只记录格式字符串地址和参数, 文件名和前缀由上位机还原 */
+    #define DEBUG_Output(fmt, ...) LOG_Write(__FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#else
+    #define DEBUG_Output(fmt, ...) printf("[%s, %d] "fmt, __FILENAME__, __LINE__, ##__VA_ARGS__)
+#endif
+
+    /* 运行时按 logConfig.mask 过滤 */
+    #define LOG_ON(level, fmt, ...) \
+        do { if (logConfig.mask & (1U << (level))) DEBUG_Output(fmt, ##__VA_ARGS__); } while (0)
 #else
     #define __FILENAME__ 
-    #define DEBUG_Printf(fmt, ...)
+    #define DEBUG_Output(fmt, ...)
+    #define LOG_ON(level, fmt, ...) ((void)0)
 #endif
+#define LOG_OFF(level, fmt, ...) ((void)0)
+
+/*
+ * 编译期过滤: LOG_GATE_<阈值>_<级别> 展开为 LOG_ON 或 LOG_OFF。
+ * 用记号拼接而不用 if 常量判断, 工程以-O0编译时常量条件的代码和字符串不保证被去除。
+ */
+#define LOG_GATE(threshold, level)  LOG_GATE_(threshold, level)
+#define LOG_GATE_(threshold, level) LOG_GATE_##threshold##_##level
+#define LOG_GATE_0_1  LOG_OFF
+#define LOG_GATE_0_2  LOG_OFF
+#define LOG_GATE_0_3  LOG_OFF
+#define LOG_GATE_0_4  LOG_OFF
+#define LOG_GATE_1_1  LOG_ON
+#define LOG_GATE_1_2  LOG_OFF
+#define LOG_GATE_1_3  LOG_OFF
+#define LOG_GATE_1_4  LOG_OFF
+#define LOG_GATE_2_1  LOG_ON
+#define LOG_GATE_2_2  LOG_ON
+#define LOG_GATE_2_3  LOG_OFF
+#define LOG_GATE_2_4  LOG_OFF
+#define LOG_GATE_3_1  LOG_ON
+#define LOG_GATE_3_2  LOG_ON
+#define LOG_GATE_3_3  LOG_ON
+#define LOG_GATE_3_4  LOG_OFF
+#define LOG_GATE_4_1  LOG_ON
+#define LOG_GATE_4_2  LOG_ON
+#define LOG_GATE_4_3  LOG_ON
+#define LOG_GATE_4_4  LOG_ON
+
+#define DEBUG_Error(fmt, ...) LOG_GATE(LOG_MODULE_LEVEL, LOG_LEVEL_ERROR)(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define DEBUG_Warn(fmt, ...)  LOG_GATE(LOG_MODULE_LEVEL, LOG_LEVEL_WARN)(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define DEBUG_Info(fmt, ...)  LOG_GATE(LOG_MODULE_LEVEL, LOG_LEVEL_INFO)(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define DEBUG_Trace(fmt, ...) LOG_GATE(LOG_MODULE_LEVEL, LOG_LEVEL_TRACE)(LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define DEBUG_Printf          DEBUG_Info
 
 #endif
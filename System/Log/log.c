@@ -0,0 +1,423 @@
+/**
+ * @file log.c
+ * @brief 延迟二进制日志: 调用处只记录格式字符串地址和原始参数, 由USART1 TX DMA在后台发送
+ *
+ * LOG_Write() 按格式字符串取出参数编码为一帧写入环形缓冲区，不做格式化，字符串参数复制内容，
+ * 其余参数按原始字节记录；DMA空闲时立即启动发送，每段发送完成的中断中启动下一段，CPU不等待串口。
+ * 上位机 Tools/log_decode.py 按帧中的地址在ELF(.axf)中查找格式字符串和文件名，还原为文本。
+ * printf 的输出(LOG_PutChar)以原始文本字节写入同一缓冲区，与日志帧按写入顺序交错。
+ *
+ * 缓冲区满时，线程模式下以WFI等待DMA腾出空间(日志不丢失, 最坏情况退化为串口速率)；
+ * 中断中或中断被关闭时无法等待，丢弃该条日志并计数，之后补发一条丢弃计数日志。
+ *
+ * 日志级别由 debug.h 的 DEBUG_Error/Warn/Info/Trace 在两处过滤：编译期按模块阈值整条去除，
+ * 运行时按 logConfig.mask 跳过(掉电保持)，两者都不满足时不调用本模块。
+ */
+
+#include "Log/log.h"
+
+DMA_HandleTypeDef hdma_usart1_tx;
+
+static uint8_t logBuffer[LOG_BUFFER_SIZE];
+static volatile uint16_t logHead = 0;           /* 写入位置 */
+static volatile uint16_t logTail = 0;           /* 发送位置 */
+static volatile uint16_t logDmaLength = 0;      /* DMA正在发送的字节数, 0表示空闲 */
+static volatile uint32_t logDropped = 0;        /* 缓冲区满被丢弃的日志条数 */
+static uint32_t logDroppedReported = 0;         /* 已报告的丢弃条数 */
+static uint8_t logReady = 0;                    /* 1 表示DMA已初始化 */
+
+/* 静态初始化为缺省掩码, PERSIST_Init()恢复保存的配置之前的日志(含错误)也能输出 */
+LogConfigTypeDef logConfig = {LOG_DEFAULT_MASK, LOG_CONFIG_VALID};
+
+/**
+ * @brief 检查恢复的运行时日志级别掩码
+ * @note  需在PERSIST_Init()之后调用, 保存的配置无效时恢复 LOG_DEFAULT_MASK
+ */
+void LOG_ConfigInit(void)
+{
+    if (logConfig.valid != LOG_CONFIG_VALID)
+    {
+        logConfig.mask = LOG_DEFAULT_MASK;
+        logConfig.valid = LOG_CONFIG_VALID;
+    }
+}
+
+/**
+ * @brief 设置运行时日志级别掩码, 进入STANDBY前随掉电保持数据写入Flash
+ * @param mask bit n 为1表示输出级别n的日志; 编译期已去除的调用不受影响
+ */
+void LOG_SetMask(uint8_t mask)
+{
+    logConfig.mask = mask;
+    logConfig.valid = LOG_CONFIG_VALID;
+}
+
+/**
+ * @brief DMA空闲时发送缓冲区中连续的一段
+ * @note  需在关中断时调用
+ */
+static void LOG_Kick(void)
+{
+    uint16_t length;
+
+    if (!logReady || logDmaLength != 0 || logHead == logTail)
+    {
+        return;
+    }
+
+    length = (logHead > logTail) ? (logHead - logTail) : (LOG_BUFFER_SIZE - logTail);
+    logDmaLength = length;
+    HAL_DMA_Start_IT(&hdma_usart1_tx, (uint32_t)&logBuffer[logTail], (uint32_t)&USART1->DR, length);
+}
+
+/**
+ * @brief DMA发送完成回调: 释放已发送的数据并发送下一段
+ */
+static void LOG_DmaComplete(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    logTail = (logTail + logDmaLength) % LOG_BUFFER_SIZE;
+    logDmaLength = 0;
+    LOG_Kick();
+}
+
+/**
+ * @brief 初始化USART1 TX DMA(DMA1通道4)
+ * @note  需在HAL_UART_Init(&huart1)之后调用
+ */
+void LOG_Init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_usart1_tx.Instance = DMA1_Channel4;                       /* USART1_TX固定映射到DMA1通道4 */
+    hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+    HAL_DMA_Init(&hdma_usart1_tx);
+    hdma_usart1_tx.XferCpltCallback = LOG_DmaComplete;
+
+    SET_BIT(USART1->CR3, USART_CR3_DMAT);                          /* 发送数据寄存器空时请求DMA */
+    HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+
+    logReady = 1;
+    __disable_irq();
+    LOG_Kick(); /* 发送初始化前写入的内容 */
+    __enable_irq();
+}
+
+/**
+ * @brief 当前能否等待缓冲区腾出空间: 线程模式且中断未关闭
+ */
+static uint8_t LOG_CanWait(uint32_t primask)
+{
+    return logReady && primask == 0 && __get_IPSR() == 0;
+}
+
+/**
+ * @brief 把数据整体写入环形缓冲区并启动发送
+ * @return uint8_t 0 表示已写入；1 表示缓冲区满被丢弃
+ */
+static uint8_t LOG_Commit(const uint8_t *data, uint16_t length)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t used;
+    uint16_t first;
+
+    while (1)
+    {
+        __disable_irq();
+        used = (logHead + LOG_BUFFER_SIZE - logTail) % LOG_BUFFER_SIZE;
+        if (LOG_BUFFER_SIZE - 1 - used >= length)
+        {
+            break;
+        }
+        if (!LOG_CanWait(primask))
+        {
+            logDropped++;
+            __set_PRIMASK(primask);
+            return 1;
+        }
+        __set_PRIMASK(primask);
+        __WFI(); /* 等待DMA发送完成中断释放空间 */
+    }
+
+    first = LOG_BUFFER_SIZE - logHead;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(&logBuffer[logHead], data, first);
+    memcpy(&logBuffer[0], data + first, length - first);
+    logHead = (logHead + length) % LOG_BUFFER_SIZE;
+    LOG_Kick();
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+/**
+ * @brief 向日志负载追加字节, 超出LOG_RECORD_MAX时不追加
+ * @return uint8_t 0 表示已追加；1 表示空间不足
+ */
+static uint8_t LOG_Put(uint8_t *record, uint16_t *length, const void *data, uint16_t size)
+{
+    if (*length + size > LOG_RECORD_MAX)
+    {
+        return 1;
+    }
+    memcpy(record + *length, data, size);
+    *length += size;
+    return 0;
+}
+
+/**
+ * @brief 追加一个4字节整数参数
+ */
+static uint8_t LOG_PutWord(uint8_t *record, uint16_t *length, uint32_t value)
+{
+    return LOG_Put(record, length, &value, 4);
+}
+
+/**
+ * @brief 追加一个字符串参数: 2字节长度 + 内容, 按剩余空间和LOG_STRING_MAX截断
+ */
+static uint8_t LOG_PutString(uint8_t *record, uint16_t *length, const char *str)
+{
+    uint16_t room = LOG_RECORD_MAX - *length;
+    uint16_t size = 0;
+    uint16_t field;
+
+    if (room < 2)
+    {
+        return 1;
+    }
+    room = (room - 2 < LOG_STRING_MAX) ? (room - 2) : LOG_STRING_MAX;
+    if (str == NULL)
+    {
+        str = "(null)";
+    }
+    while (str[size] != '\0' && size < room)
+    {
+        size++;
+    }
+    field = (str[size] != '\0') ? (size | LOG_TRUNCATED) : size;
+
+    (void)LOG_Put(record, length, &field, 2);
+    memcpy(record + *length, str, size);
+    *length += size;
+    return 0;
+}
+
+/**
+ * @brief 按格式字符串把参数编码到负载中
+ * @details 只识别转换说明的结构(标志、宽度、精度、长度修饰符), 不做格式化
+ */
+static void LOG_Encode(uint8_t *record, uint16_t *length, const char *fmt, va_list args)
+{
+    const char *p = fmt;
+    uint8_t longs;
+    uint8_t full = 0;
+
+    while (*p != '\0' && !full)
+    {
+        if (*p++ != '%')
+        {
+            continue;
+        }
+        if (*p == '%')
+        {
+            p++;
+            continue;
+        }
+
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+        {
+            p++;
+        }
+        if (*p == '*')
+        {
+            full |= LOG_PutWord(record, length, (uint32_t)va_arg(args, int));
+            p++;
+        }
+        while (*p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+        if (*p == '.')
+        {
+            p++;
+            if (*p == '*')
+            {
+                full |= LOG_PutWord(record, length, (uint32_t)va_arg(args, int));
+                p++;
+            }
+            while (*p >= '0' && *p <= '9')
+            {
+                p++;
+            }
+        }
+        longs = 0;
+        while (*p == 'l' || *p == 'h' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L')
+        {
+            longs += (*p == 'l');
+            p++;
+        }
+
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+            if (longs >= 2)
+            {
+                uint64_t value = va_arg(args, unsigned long long);
+                full |= LOG_Put(record, length, &value, 8);
+            }
+            else
+            {
+                full |= LOG_PutWord(record, length, va_arg(args, unsigned int));
+            }
+            break;
+        case 'p':
+            full |= LOG_PutWord(record, length, (uint32_t)va_arg(args, void *));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = va_arg(args, double);
+            full |= LOG_Put(record, length, &value, 8);
+            break;
+        }
+        case 's':
+            full |= LOG_PutString(record, length, va_arg(args, const char *));
+            break;
+        case '\0':
+            return;
+        default:
+            break;
+        }
+        p++;
+    }
+}
+
+/**
+ * @brief 编码一条日志并写入缓冲区
+ */
+static void LOG_WriteV(const char *file, uint16_t line, const char *fmt, va_list args)
+{
+    uint8_t frame[LOG_RECORD_MAX + 3];
+    uint8_t *record = frame + 2;
+    uint32_t tick = HAL_GetTick();
+    uint16_t length = 0;
+    uint8_t sum = 0;
+    uint16_t i;
+
+    (void)LOG_Put(record, &length, &tick, 4);
+    (void)LOG_PutWord(record, &length, (uint32_t)fmt);
+    (void)LOG_PutWord(record, &length, (uint32_t)file);
+    (void)LOG_Put(record, &length, &line, 2);
+    LOG_Encode(record, &length, fmt, args);
+
+    for (i = 0; i < length; i++)
+    {
+        sum += record[i];
+    }
+    frame[0] = LOG_FRAME_SYNC;
+    frame[1] = (uint8_t)length;
+    frame[length + 2] = sum;
+    (void)LOG_Commit(frame, length + 3);
+}
+
+/**
+ * @brief 丢弃计数日志的编码入口(固定参数经va_list传递)
+ */
+static void LOG_WriteInternal(uint16_t line, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    LOG_WriteV(__FILE__, line, fmt, args);
+    va_end(args);
+}
+
+/**
+ * @brief 记录一条日志, 由DEBUG_Printf调用
+ * @param file 源文件名(__FILE__), 只记录地址
+ * @param line 行号
+ * @param fmt 格式字符串, 需为字符串常量(只记录地址)
+ */
+void LOG_Write(const char *file, uint16_t line, const char *fmt, ...)
+{
+    va_list args;
+    uint32_t dropped = logDropped;
+
+    if (dropped != logDroppedReported && LOG_CanWait(__get_PRIMASK()))
+    {
+        logDroppedReported = dropped;
+        LOG_WriteInternal(__LINE__, "Log dropped %lu records\r\n", dropped);
+    }
+
+    va_start(args, fmt);
+    LOG_WriteV(file, line, fmt, args);
+    va_end(args);
+}
+
+/**
+ * @brief 写入一个原始文本字节(printf经fputc输出)
+ */
+void LOG_PutChar(uint8_t ch)
+{
+    (void)LOG_Commit(&ch, 1);
+}
+
+/**
+ * @brief 等待缓冲区内容全部发送完成
+ * @note  进入低功耗模式或切换时钟前调用; 中断被关闭时轮询DMA标志
+ */
+void LOG_Flush(void)
+{
+    if (!logReady)
+    {
+        return;
+    }
+
+    while (logHead != logTail || logDmaLength != 0)
+    {
+        if (LOG_CanWait(__get_PRIMASK()))
+        {
+            __WFI();
+        }
+        else
+        {
+            HAL_DMA_IRQHandler(&hdma_usart1_tx);
+        }
+    }
+    while ((USART1->SR & USART_SR_TC) == 0); /* 等待最后一个字节移出 */
+}
+
+/**
+ * @brief 获取因缓冲区满丢弃的日志条数
+ */
+uint32_t LOG_GetDropped(void)
+{
+    return logDropped;
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_usart1_tx);
+}
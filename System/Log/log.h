@@ -0,0 +1,60 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include "sys/sys.h"
+#include "stdarg.h"
+#include "string.h"
+#include "user_config.h"
+
+/*
+ * 二进制日志帧(经USART1 TX DMA发送), 调试串口上与printf输出的文本混合:
+ *   [0]        LOG_FRAME_SYNC
+ *   [1]        负载长度N
+ *   [2..N+1]   负载
+ *   [N+2]      负载各字节之和(低8位)
+ * 负载:
+ *   [0..3]     HAL_GetTick()(ms)
+ *   [4..7]     格式字符串地址(由上位机在ELF中查找字符串)
+ *   [8..11]    __FILE__ 字符串地址
+ *   [12..13]   __LINE__
+ *   [14..]     参数, 按格式字符串依次排列:
+ *              整数/字符/指针/'*'宽度 4字节, %lld 8字节, 浮点 8字节(double),
+ *              %s 2字节长度(bit15表示被截断) + 字符串内容(不含'\0')
+ * 多字节字段均为小端。
+ */
+#define LOG_FRAME_SYNC      0xA5
+#define LOG_HEADER_LEN      14
+#define LOG_RECORD_MAX      240     /* 单条日志负载上限(不超过255), 超出的参数不再记录 */
+#define LOG_STRING_MAX      200     /* %s参数最多记录的字节数 */
+#define LOG_TRUNCATED       0x8000  /* %s长度字段中的截断标记 */
+
+/*
+ * 日志级别。各模块的编译期阈值(user_config.h LOG_LEVEL_*)须直接展开为这里的数字,
+ * debug.h 以记号拼接按阈值选择输出或空语句, 高于阈值的调用连同格式字符串不进入编译结果。
+ */
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_TRACE     4
+
+#define LOG_CONFIG_VALID    0xA5    /* 掉电保持的日志配置有效标记 */
+
+typedef struct
+{
+    uint8_t mask;           // 运行时允许输出的级别, bit n 对应级别 n
+    uint8_t valid;          // LOG_CONFIG_VALID 表示已初始化
+    uint8_t reserved[2];
+} LogConfigTypeDef;
+
+extern LogConfigTypeDef logConfig;
+
+void LOG_ConfigInit(void);
+void LOG_SetMask(uint8_t mask);
+void LOG_Init(void);
+void LOG_Write(const char *file, uint16_t line, const char *fmt, ...);
+void LOG_PutChar(uint8_t ch);
+void LOG_Flush(void);
+uint32_t LOG_GetDropped(void);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file memory.c
+ * @brief 内存预算: cJSON 使用的固定块内存池, 栈和堆的水位填充与测量
+ *
+ * 内存池由 MEMORY_POOL_NUM 个 MEMORY_POOL_BLOCK 字节的块组成, 空闲块以单向链表相连, 分配和释放
+ * 都是常数时间, 不产生碎片。块大小按 cJSON 节点(ARMCC下40字节)确定, 键名、字符串值(设备ID 33字节)
+ * 也各占一块; 超过块大小的请求直接失败, 因此序列化必须使用 cJSON_PrintPreallocated()。
+ * 只在线程模式下使用, 不做中断保护。
+ *
+ * 栈和堆的边界取自链接器为启动文件中 STACK、HEAP 段生成的 $$Base/$$Limit 符号。
+ */
+
+#include "Memory/memory.h"
+
+extern uint32_t STACK$$Base;
+extern uint32_t STACK$$Limit;
+extern uint32_t HEAP$$Base;
+extern uint32_t HEAP$$Limit;
+
+MemoryStatsTypeDef memoryStats = {0};
+
+static uint64_t memoryPool[MEMORY_POOL_NUM][MEMORY_POOL_BLOCK / 8]; /* 8字节对齐, 满足double成员 */
+static void *memoryFreeList = NULL;                                 /* 空闲块链表, 块首字存放下一块地址 */
+static uint8_t memoryPoolUsed = 0;                                  /* 当前占用的块数 */
+
+/**
+ * @brief 以标记填充一段内存
+ */
+static void MEMORY_Paint(uint32_t *start, uint32_t *end)
+{
+    while (start < end)
+    {
+        *start++ = MEMORY_PAINT;
+    }
+}
+
+/**
+ * @brief 初始化内存池并挂接到cJSON, 填充栈和堆的空闲部分
+ * @note  需在main开始时调用, 此时栈只用了main的栈帧, 堆尚未分配
+ */
+void MEMORY_Init(void)
+{
+    cJSON_Hooks hooks = {MEMORY_Alloc, MEMORY_Free};
+    uint8_t i;
+
+    memoryFreeList = NULL;
+    for (i = 0; i < MEMORY_POOL_NUM; i++)
+    {
+        *(void **)memoryPool[i] = memoryFreeList;
+        memoryFreeList = memoryPool[i];
+    }
+    memoryPoolUsed = 0;
+    cJSON_InitHooks(&hooks);
+
+    MEMORY_Paint(&STACK$$Base, (uint32_t *)((__get_MSP() - MEMORY_STACK_GUARD) & ~3u));
+    MEMORY_Paint((uint32_t *)((uint8_t *)&HEAP$$Base + MEMORY_HEAP_SKIP), &HEAP$$Limit);
+}
+
+/**
+ * @brief 从内存池分配一块
+ * @param size 请求的字节数, 不能超过 MEMORY_POOL_BLOCK
+ * @retval 块地址, 块已用完或请求过大时返回NULL并计数
+ */
+void *MEMORY_Alloc(size_t size)
+{
+    void *block = memoryFreeList;
+
+    if (size > MEMORY_POOL_BLOCK || block == NULL)
+    {
+        memoryStats.poolFailures++;
+        return NULL;
+    }
+
+    memoryFreeList = *(void **)block;
+    if (++memoryPoolUsed > memoryStats.poolPeak)
+    {
+        memoryStats.poolPeak = memoryPoolUsed;
+    }
+    return block;
+}
+
+/**
+ * @brief 释放内存池中的块, 不属于内存池的地址被忽略
+ */
+void MEMORY_Free(void *ptr)
+{
+    uint32_t offset = (uint8_t *)ptr - (uint8_t *)memoryPool;
+
+    if (ptr == NULL || offset >= sizeof(memoryPool) || offset % MEMORY_POOL_BLOCK != 0)
+    {
+        return;
+    }
+
+    *(void **)ptr = memoryFreeList;
+    memoryFreeList = ptr;
+    memoryPoolUsed--;
+}
+
+/**
+ * @brief 扫描栈和堆中残留的标记, 更新最高水位
+ * @details 栈自高地址向下增长, 从栈底向上第一个被改写的字到栈顶为已用部分;
+ *          堆自低地址分配, 从堆顶向下第一个被改写的字到堆起始为已用部分。
+ */
+void MEMORY_Update(void)
+{
+    uint32_t *p = &STACK$$Base;
+    uint16_t used;
+
+    while (p < &STACK$$Limit && *p == MEMORY_PAINT)
+    {
+        p++;
+    }
+    used = (uint8_t *)&STACK$$Limit - (uint8_t *)p;
+    if (used > memoryStats.stackPeak)
+    {
+        memoryStats.stackPeak = used;
+    }
+
+    p = &HEAP$$Limit;
+    while (p > &HEAP$$Base && *(p - 1) == MEMORY_PAINT)
+    {
+        p--;
+    }
+    used = (uint8_t *)p - (uint8_t *)&HEAP$$Base;
+    if (used > memoryStats.heapPeak)
+    {
+        memoryStats.heapPeak = used;
+    }
+}
+
+/**
+ * @brief 通过日志(Info级别)输出内存水位
+ * @details 输出格式:
+ *          MEM,stack,<最高水位>,<栈大小>
+ *          MEM,heap,<最高水位>,<堆大小>
+ *          MEM,pool,<当前块数>,<最大块数>,<总块数>,<分配失败次数>
+ */
+void MEMORY_Print(void)
+{
+    MEMORY_Update();
+
+    DEBUG_Info("MEM,stack,%u,%u\r\n", memoryStats.stackPeak,
+               (unsigned int)((uint8_t *)&STACK$$Limit - (uint8_t *)&STACK$$Base));
+    DEBUG_Info("MEM,heap,%u,%u\r\n", memoryStats.heapPeak,
+               (unsigned int)((uint8_t *)&HEAP$$Limit - (uint8_t *)&HEAP$$Base));
+    DEBUG_Info("MEM,pool,%u,%u,%u,%u\r\n", memoryPoolUsed, memoryStats.poolPeak, MEMORY_POOL_NUM,
+               memoryStats.poolFailures);
+}
@@ -0,0 +1,39 @@
+#ifndef __MEMORY_H__
+#define __MEMORY_H__
+
+#include "sys/sys.h"
+#include "string.h"
+#include "user_config.h"
+#include "debug/debug.h"
+#include "cJSON/cJSON.h"
+
+/*
+ * 内存预算(20KB RAM):
+ *   - 栈和堆的大小由 startup_stm32f103xb.s 的 Stack_Size/Heap_Size 决定, MEMORY_Init() 在main开始时
+ *     以 MEMORY_PAINT 填充两者的空闲部分, 之后自底向上查找第一个被改写的字, 得到历史最高水位;
+ *   - cJSON 不再使用堆, 由本模块的固定块内存池分配节点和字符串, 序列化直接写入 locationData.json_data;
+ *   - 各驱动中按数据长度变化的缓冲区(VLA)改为按最大长度确定的静态缓冲区。
+ * 水位和内存池峰值随掉电保持数据保存, 表示自擦除Flash以来的最大值, 由 MEMORY_Print() 输出。
+ */
+#define MEMORY_PAINT        0xCDCDCDCD  /* 未使用的栈和堆中填充的标记 */
+#define MEMORY_STACK_GUARD  64          /* 填充栈时在当前栈指针下方保留的字节数 */
+#define MEMORY_HEAP_SKIP    16          /* 填充堆时跳过C库写在堆起始处的空闲块头 */
+
+typedef struct
+{
+    uint16_t stackPeak;     // 栈最高水位(字节)
+    uint16_t heapPeak;      // 堆最高水位(字节)
+    uint16_t poolFailures;  // 内存池分配失败次数(块已用完或请求超过块大小)
+    uint8_t poolPeak;       // 内存池同时占用的最大块数
+    uint8_t reserved;
+} MemoryStatsTypeDef;
+
+extern MemoryStatsTypeDef memoryStats;
+
+void MEMORY_Init(void);
+void *MEMORY_Alloc(size_t size);
+void MEMORY_Free(void *ptr);
+void MEMORY_Update(void);
+void MEMORY_Print(void);
+
+#endif
@@ -0,0 +1,145 @@
+#include "Profile/profile.h"
+
+/* 统计数据, 由persist模块在STANDBY前保存、复位后恢复 */
+ProfileStatsTypeDef profileStats = {0};
+
+/* 进入休眠时的RTC计数, 0表示未在休眠; 每次进入STANDBY前都要保存, 因此不放在按间隔写入的统计数据中 */
+uint32_t profileSleepStart = 0;
+
+#ifdef PROFILE_ENABLE
+
+static const char *const profileName[PROFILE_PHASE_NUM] = {
+    "wake", "gnss", "step", "json", "attach", "send", "close", "sleep",
+};
+
+static uint32_t profileStart[PROFILE_PHASE_NUM]; /* 各阶段开始时刻(us) */
+
+/**
+ * @brief 记录一个阶段样本
+ * @param phase 阶段
+ * @param ms 阶段耗时(ms)
+ */
+static void PROFILE_Record(ProfilePhaseTypeDef phase, uint32_t ms)
+{
+    ProfilePhaseStatsTypeDef *stats = &profileStats.phase[phase];
+    uint32_t limit = 10;
+    uint8_t bucket = 0;
+
+    while (bucket < PROFILE_HIST_BUCKETS - 1 && ms >= limit)
+    {
+        bucket++;
+        limit *= 10;
+    }
+
+    if (stats->count == 0 || ms < stats->min)
+    {
+        stats->min = ms;
+    }
+    if (ms > stats->max)
+    {
+        stats->max = ms;
+    }
+    stats->total += ms;
+    stats->count++;
+    stats->histogram[bucket]++;
+    profileStats.last[phase] = ms;
+}
+
+/**
+ * @brief 阶段开始标记
+ * @param phase 阶段
+ */
+void PROFILE_Begin(ProfilePhaseTypeDef phase)
+{
+    profileStart[phase] = CLOCK_GetMicros();
+}
+
+/**
+ * @brief 阶段结束标记, 基于DWT周期计数器计时, 可跨越时钟切换
+ * @note  阶段内的STOP休眠(如LoRaWAN接收窗口之间的等待)不计入, 只统计CPU运行时间
+ * @param phase 阶段
+ */
+void PROFILE_End(ProfilePhaseTypeDef phase)
+{
+    PROFILE_Record(phase, (CLOCK_GetMicros() - profileStart[phase]) / 1000);
+}
+
+/**
+ * @brief 休眠开始标记
+ * @note  休眠期间DWT停止, 用RTC计数器计时; 开始时刻由persist模块在进入STANDBY前保存, 复位后仍可计算
+ */
+void PROFILE_SleepBegin(void)
+{
+    profileSleepStart = RTC_GetCounter();
+}
+
+/**
+ * @brief 休眠结束标记, STOP唤醒或STANDBY复位后调用
+ */
+void PROFILE_SleepEnd(void)
+{
+    uint32_t now = RTC_GetCounter();
+
+    /* 掉电后RTC重新计数时丢弃该样本 */
+    if (profileSleepStart != 0 && now >= profileSleepStart)
+    {
+        PROFILE_Record(PROFILE_PHASE_SLEEP, (now - profileSleepStart) * 1000);
+    }
+    profileSleepStart = 0;
+}
+
+/**
+ * @brief 通过日志(Info级别)输出当前统计窗口, 不清零
+ * @details 输出格式(每阶段一条日志, 供Tools/profile_report.py解析, 二进制日志先经log_decode.py还原):
+ *          PROF,<阶段>,<样本数>,<累计ms>,<最短ms>,<最长ms>,<直方图0>,...,<直方图5>
+ */
+void PROFILE_Print(void)
+{
+    uint8_t i;
+
+    DEBUG_Info("PROF,cycles,%u\r\n", profileStats.cycles);
+    for (i = 0; i < PROFILE_PHASE_NUM; i++)
+    {
+        ProfilePhaseStatsTypeDef *stats = &profileStats.phase[i];
+
+        /* 每行一次调用, 不被其他日志帧打断; 直方图分桶数为 PROFILE_HIST_BUCKETS(6) */
+        DEBUG_Info("PROF,%s,%u,%lu,%lu,%lu,%u,%u,%u,%u,%u,%u\r\n", profileName[i], stats->count, stats->total,
+                   stats->min, stats->max, stats->histogram[0], stats->histogram[1], stats->histogram[2],
+                   stats->histogram[3], stats->histogram[4], stats->histogram[5]);
+    }
+}
+
+/**
+ * @brief 上报周期结束时调用, 每PROFILE_EMIT_CYCLES个周期输出统计和内存水位, 统计清零
+ */
+void PROFILE_Report(void)
+{
+    if (++profileStats.cycles < PROFILE_EMIT_CYCLES)
+    {
+        return;
+    }
+
+    PROFILE_Print();
+    MEMORY_Print();
+    memset(profileStats.phase, 0, sizeof(profileStats.phase));
+    profileStats.cycles = 0;
+}
+
+/**
+ * @brief 将最近一个周期各阶段耗时(ms)以数组形式加入上报JSON
+ * @param root JSON对象
+ */
+void PROFILE_AddToJSON(cJSON *root)
+{
+#ifdef PROFILE_UPLINK
+    uint8_t i;
+    cJSON *array = cJSON_AddArrayToObject(root, "prof");
+
+    for (i = 0; i < PROFILE_PHASE_NUM; i++)
+    {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(profileStats.last[i]));
+    }
+#endif
+}
+
+#endif
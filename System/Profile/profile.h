@@ -0,0 +1,63 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include "user_config.h"
+#include "debug/debug.h"
+#include "cJSON/cJSON.h"
+#include "CLOCK/clock.h"
+#include "RTC/rtc.h"
+#include "Memory/memory.h"
+
+#define PROFILE_HIST_BUCKETS    6   /* 直方图分桶: <10ms, <100ms, <1s, <10s, <100s, >=100s */
+
+typedef enum
+{
+    PROFILE_PHASE_WAKE = 0,     // 唤醒外设模块
+    PROFILE_PHASE_GNSS,         // GNSS定位(TTFF)
+    PROFILE_PHASE_STEP,         // 读取步数
+    PROFILE_PHASE_JSON,         // 打包JSON
+    PROFILE_PHASE_ATTACH,       // 网络附着、创建并连接套接字
+    PROFILE_PHASE_SEND,         // 发送数据并确认
+    PROFILE_PHASE_CLOSE,        // 关闭套接字
+    PROFILE_PHASE_SLEEP,        // 低功耗休眠(RTC计时, 1秒分辨率)
+    PROFILE_PHASE_NUM,
+} ProfilePhaseTypeDef;
+
+typedef struct
+{
+    uint32_t total;                             // 累计时间(ms)
+    uint32_t min;                               // 最短时间(ms)
+    uint32_t max;                               // 最长时间(ms)
+    uint16_t count;                             // 样本数
+    uint16_t histogram[PROFILE_HIST_BUCKETS];   // 分桶计数
+} ProfilePhaseStatsTypeDef;
+
+typedef struct
+{
+    ProfilePhaseStatsTypeDef phase[PROFILE_PHASE_NUM];
+    uint32_t last[PROFILE_PHASE_NUM];           // 最近一个周期各阶段时间(ms)
+    uint16_t cycles;                            // 本统计窗口内的上报周期数
+} ProfileStatsTypeDef;
+
+extern ProfileStatsTypeDef profileStats;
+extern uint32_t profileSleepStart;
+
+#ifdef PROFILE_ENABLE
+    void PROFILE_Begin(ProfilePhaseTypeDef phase);
+    void PROFILE_End(ProfilePhaseTypeDef phase);
+    void PROFILE_SleepBegin(void);
+    void PROFILE_SleepEnd(void);
+    void PROFILE_Print(void);
+    void PROFILE_Report(void);
+    void PROFILE_AddToJSON(cJSON *root);
+#else
+    #define PROFILE_Begin(phase)
+    #define PROFILE_End(phase)
+    #define PROFILE_SleepBegin()
+    #define PROFILE_SleepEnd()
+    #define PROFILE_Print()
+    #define PROFILE_Report()
+    #define PROFILE_AddToJSON(root)
+#endif
+
+#endif
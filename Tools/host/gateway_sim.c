@@ -0,0 +1,738 @@
+/**
+ * @file gateway_sim.c
+ * @brief LoRa汇聚网关在PC上的多节点仿真
+ *
+ * 网关一侧运行固件代码(gateway.c、loraLink.c、loraFrag.c、loraFrame.c、adr.c), 射频换成虚拟信道;
+ * 叶节点按 LORALINK_Send() 的行为建模: 每个上报周期在发送窗口内的随机时刻发出一个位置帧,
+ * 之后打开 LORALINK_ACK_WINDOW_MS 的应答窗口, 未收到应答时随机退避 [0, LORALINK_BACKOFF_MS*2^N)
+ * 后以相同序号重发, 最多 LORALINK_MAX_RETRIES 次。
+ * 虚拟信道为单信道、半双工: 空中时间有重叠的数据包全部丢失(不考虑捕获效应), 网关发送应答期间
+ * 收不到上行; 应答另以给定概率丢失, 使叶节点重发, 网关收到重复帧。
+ * 空中时间按手册公式计算(SF9/125kHz, CR 4/5, 前导码12, 显式头部, CRC开)。
+ * 每个周期结束时调用 GATEWAY_BuildBatch(), 解码批量帧并检查:
+ *   - 帧头和每个位置帧都能解码, 自身位置在前, 每个节点至多一帧, 内容与叶节点发出的一致
+ *   - 同一(节点ID, 序号)只上行一次
+ *   - 收到 = 上行 + 重复 + 节点表溢出; 本批不足 GATEWAY_MAX_NODES 个叶节点时, 至少有一份到达网关的帧
+ *     全部上行, 网关统计的重复帧数等于到达的多余副本数, 没有溢出
+ * 另检查叶节点重新上电(序号回退超过 GATEWAY_DUP_WINDOW)后的帧被接受, 窗口内回退的帧被丢弃,
+ * 链路层的对端统计(重复、丢失、最近序号)与之一致。
+ *
+ * 用法(仓库根目录):
+ *   gcc -std=gnu99 -Wall -Wno-format -ITools/host -IUser -ISystem -IAPP -IDriver/chip -IDriver/chip/LoRa \
+ *       -o gateway_sim Tools/host/host.c Tools/host/gateway_sim.c APP/loraLink/loraLink.c \
+ *       APP/loraFrag/loraFrag.c APP/loraFrame/loraFrame.c APP/adr/adr.c -lm
+ *   ./gateway_sim                              默认场景: 4、7、12个节点
+ *   ./gateway_sim -n 30 -c 200 -w 2000 -l 0.2 -s 7 [-v]
+ *     -n 节点数  -c 周期数  -w 发送窗口(ms)  -l 应答丢失概率  -s 随机种子  -v 输出固件日志
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "host.h"
+#include "gateway/gateway.c"    /* 直接包含, 以便按 GATEWAY_Listen() 的顺序调用 GATEWAY_StartReceive() */
+
+#define SIM_LEAF_MAX    64
+#define SIM_TX_MAX      (SIM_LEAF_MAX * (LORALINK_MAX_RETRIES + 1) * 2)
+#define SIM_EVENT_MAX   (SIM_TX_MAX * 2)
+#define SIM_PERIOD_MS   60000   /* 上报周期, 足够容纳发送窗口和全部重发 */
+#define SIM_GATEWAY     (-1)    /* 网关作为发送方的编号 */
+#define SIM_GATEWAY_ID  0x6A7E0001
+
+/* 事件类型, 同一时刻按此顺序处理: 先结束的发送不与同时开始的发送重叠 */
+typedef enum
+{
+    SIM_EVENT_TX_END = 0,
+    SIM_EVENT_WINDOW_END,
+    SIM_EVENT_TX_START,
+} SimEventKindTypeDef;
+
+typedef enum
+{
+    SIM_LEAF_IDLE = 0,
+    SIM_LEAF_TX,
+    SIM_LEAF_WAIT_ACK,
+    SIM_LEAF_BACKOFF,
+    SIM_LEAF_DONE,
+} SimLeafStateTypeDef;
+
+typedef struct
+{
+    uint64_t start;
+    uint64_t end;
+    int sender;             // 叶节点下标, SIM_GATEWAY 为网关
+    uint8_t data[LORAFRAME_POSITION_LEN];
+    uint8_t length;
+} SimTxTypeDef;
+
+typedef struct
+{
+    uint64_t at;
+    uint8_t kind;           // SimEventKindTypeDef
+    int index;              // 发送结束为发送记录下标, 其余为叶节点下标
+} SimEventTypeDef;
+
+typedef struct
+{
+    LoraPositionTypeDef position;
+    uint8_t frame[LORAFRAME_POSITION_LEN];
+    uint8_t state;          // SimLeafStateTypeDef
+    uint8_t attempt;
+    uint8_t ackInFlight;    // 应答窗口内有发给本节点的应答正在发送
+    uint8_t forwarded;      // 已上行过帧
+    uint16_t forwardedSeq;  // 最近上行的序号
+    uint64_t windowEnd;     // 应答窗口结束时刻
+    uint32_t copies;        // 本周期的帧到达网关的份数
+} SimLeafTypeDef;
+
+typedef struct
+{
+    uint32_t frames;        // 叶节点产生的帧
+    uint32_t sent;          // 叶节点发送次数(含重发)
+    uint32_t collided;      // 因信道冲突或网关发送而丢失的上行
+    uint32_t arrived;       // 到达网关的上行
+    uint32_t acked;         // 收到应答的帧
+    uint32_t failed;        // 重发用尽的帧
+    uint32_t forwarded;     // 网关上行的叶节点帧
+} SimResultTypeDef;
+
+static struct
+{
+    uint64_t now;
+    uint32_t delayMs;       // 网关HAL_Delay()累计, 下一次发送时计入
+    uint32_t random;
+    double ackLoss;
+    LORA_RxCallbackTypeDef rxCallback;
+    SimTxTypeDef tx[SIM_TX_MAX];
+    int txNum;
+    SimEventTypeDef events[SIM_EVENT_MAX];
+    int eventNum;
+    SimLeafTypeDef leaves[SIM_LEAF_MAX];
+    int leafNum;
+    SimResultTypeDef result;
+} sim;
+
+static uint16_t simBackup[16];
+
+/* ===== 硬件替身 ===== */
+
+volatile uint8_t gpioB14Flag = 0;
+volatile uint32_t gpioB14Tick = 0;
+volatile uint8_t gpioA10Flag = 0;
+volatile uint8_t rtcAlarmFlag = 0;
+LoraConfigTypeDef loraConfig = {0};
+
+static uint32_t SIM_Random(void)
+{
+    sim.random ^= sim.random << 13;
+    sim.random ^= sim.random >> 17;
+    sim.random ^= sim.random << 5;
+    return sim.random;
+}
+
+void HOST_Wfi(void)
+{
+}
+
+uint32_t HAL_GetUIDw0(void)
+{
+    return 0x00320041;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+    return 0x3437510B;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+    return 0x32363234;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(sim.now + sim.delayMs);
+}
+
+void HAL_Delay(uint32_t ms)
+{
+    sim.delayMs += ms;
+}
+
+uint32_t RTC_GetCounter(void)
+{
+    return (uint32_t)(sim.now / 1000);
+}
+
+void RTC_SetAlarm(uint32_t seconds)
+{
+    (void)seconds;
+}
+
+uint16_t PWR_ReadBackup(uint32_t reg)
+{
+    return simBackup[reg];
+}
+
+void PWR_WriteBackup(uint32_t reg, uint16_t data)
+{
+    simBackup[reg] = data;
+}
+
+void LORA_Init(void)
+{
+    sim.rxCallback = NULL;
+}
+
+void LORA_Process(void)
+{
+}
+
+LoraStateTypeDef LORA_GetState(void)
+{
+    return sim.rxCallback != NULL ? LORA_STATE_RX : LORA_STATE_IDLE;
+}
+
+void LORA_SetLbt(uint8_t enable)
+{
+    (void)enable;
+}
+
+uint32_t LORA_Random(void)
+{
+    return SIM_Random();
+}
+
+uint8_t LORA_ApplyConfig(const LoraConfigTypeDef *config)
+{
+    loraConfig = *config;
+    return 0;
+}
+
+void LORA_GetPacketStatus(int16_t *rssi, int8_t *snr)
+{
+    *rssi = -80 - (int16_t)(SIM_Random() % 40);
+    *snr = (int8_t)(SIM_Random() % 20) - 10;
+}
+
+uint8_t LORA_ReceiveAsync(uint32_t timeoutMs, LORA_RxCallbackTypeDef callback)
+{
+    HOST_CHECK(timeoutMs == 0, "gateway receive must be continuous, timeout %u", timeoutMs);
+    sim.rxCallback = callback;
+    return 0;
+}
+
+/* ===== 虚拟信道 ===== */
+
+/**
+ * @brief 空中时间(ms, 向上取整), SF9/125kHz, CR 4/5, 前导码12, 显式头部, CRC开
+ */
+static uint32_t SIM_AirMs(uint8_t length)
+{
+    double symbolMs = 512.0 / 125.0;
+    double payload = ceil(fmax(8.0 * length - 4 * 9 + 28 + 16, 0) / (4 * 9)) * 5;
+
+    return (uint32_t)ceil((12 + 4.25 + 8 + payload) * symbolMs);
+}
+
+static void SIM_Push(uint64_t at, uint8_t kind, int index)
+{
+    if (sim.eventNum >= SIM_EVENT_MAX)
+    {
+        HOST_CHECK(0, "event queue full");
+        return;
+    }
+    sim.events[sim.eventNum].at = at;
+    sim.events[sim.eventNum].kind = kind;
+    sim.events[sim.eventNum].index = index;
+    sim.eventNum++;
+}
+
+/**
+ * @brief 取出最早的事件
+ */
+static SimEventTypeDef SIM_Pop(void)
+{
+    SimEventTypeDef event;
+    int best = 0;
+    int i;
+
+    for (i = 1; i < sim.eventNum; i++)
+    {
+        if (sim.events[i].at < sim.events[best].at ||
+            (sim.events[i].at == sim.events[best].at && sim.events[i].kind < sim.events[best].kind))
+        {
+            best = i;
+        }
+    }
+    event = sim.events[best];
+    sim.events[best] = sim.events[--sim.eventNum];
+    return event;
+}
+
+static int SIM_Transmit(int sender, const uint8_t *data, uint8_t length, uint64_t start)
+{
+    SimTxTypeDef *tx;
+
+    if (sim.txNum >= SIM_TX_MAX)
+    {
+        HOST_CHECK(0, "transmission log full");
+        return -1;
+    }
+    tx = &sim.tx[sim.txNum];
+    tx->start = start;
+    tx->end = start + SIM_AirMs(length);
+    tx->sender = sender;
+    tx->length = length;
+    memcpy(tx->data, data, length);
+    SIM_Push(tx->end, SIM_EVENT_TX_END, sim.txNum);
+    return sim.txNum++;
+}
+
+/**
+ * @brief 是否与其他发送(含网关自身的应答)在时间上重叠
+ */
+static uint8_t SIM_Overlapped(int index)
+{
+    const SimTxTypeDef *tx = &sim.tx[index];
+    int i;
+
+    for (i = 0; i < sim.txNum; i++)
+    {
+        if (i != index && sim.tx[i].start < tx->end && tx->start < sim.tx[i].end)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int SIM_FindLeaf(uint32_t nodeId)
+{
+    int i;
+
+    for (i = 0; i < sim.leafNum; i++)
+    {
+        if (sim.leaves[i].position.nodeId == nodeId)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 网关发送(应答): 从当前时刻加上转向延时开始, 发送期间不在接收状态
+ */
+uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
+{
+    uint64_t start = sim.now + sim.delayMs;
+    int leaf;
+
+    sim.delayMs = 0;
+    sim.rxCallback = NULL;
+    if (SIM_Transmit(SIM_GATEWAY, sendDataBuffer, (uint8_t)length, start) < 0)
+    {
+        return 1;
+    }
+
+    leaf = SIM_FindLeaf(LORAFRAME_Get(sendDataBuffer + 1, 4));
+    if (leaf >= 0 && sim.leaves[leaf].state == SIM_LEAF_WAIT_ACK && start <= sim.leaves[leaf].windowEnd)
+    {
+        sim.leaves[leaf].ackInFlight = 1;
+    }
+    return 0;
+}
+
+/* ===== 叶节点 ===== */
+
+/**
+ * @brief 应答窗口结束: 收到应答则本周期完成, 否则退避后重发或放弃
+ */
+static void SIM_LeafDecide(int index, uint8_t acked)
+{
+    SimLeafTypeDef *leaf = &sim.leaves[index];
+
+    leaf->ackInFlight = 0;
+    if (acked)
+    {
+        leaf->state = SIM_LEAF_DONE;
+        sim.result.acked++;
+        return;
+    }
+    if (++leaf->attempt > LORALINK_MAX_RETRIES)
+    {
+        leaf->state = SIM_LEAF_DONE;
+        sim.result.failed++;
+        return;
+    }
+    leaf->state = SIM_LEAF_BACKOFF;
+    SIM_Push(sim.now + SIM_Random() % ((uint32_t)LORALINK_BACKOFF_MS << leaf->attempt), SIM_EVENT_TX_START, index);
+}
+
+/**
+ * @brief 叶节点的上行发送结束: 打开应答窗口; 网关在接收状态且没有冲突时收到该帧,
+ *        按 GATEWAY_Listen() 的顺序处理接收回调、回复应答并重新开始接收
+ */
+static void SIM_UplinkEnd(int txIndex)
+{
+    SimTxTypeDef *tx = &sim.tx[txIndex];
+    SimLeafTypeDef *leaf = &sim.leaves[tx->sender];
+    LORA_RxCallbackTypeDef callback = sim.rxCallback;
+
+    leaf->state = SIM_LEAF_WAIT_ACK;
+    leaf->windowEnd = tx->end + LORALINK_ACK_WINDOW_MS;
+    SIM_Push(leaf->windowEnd, SIM_EVENT_WINDOW_END, tx->sender);
+
+    if (callback == NULL || SIM_Overlapped(txIndex))
+    {
+        sim.result.collided++;
+        return;
+    }
+    sim.result.arrived++;
+    leaf->copies++;
+    callback(tx->data, tx->length);
+    if (LORALINK_Poll() || LORAFRAG_Poll())
+    {
+        GATEWAY_StartReceive();
+    }
+}
+
+/**
+ * @brief 网关的应答发送结束: 目标叶节点在窗口内且应答未冲突、未丢失时确认
+ */
+static void SIM_AckEnd(int txIndex)
+{
+    SimTxTypeDef *tx = &sim.tx[txIndex];
+    int index = SIM_FindLeaf(LORAFRAME_Get(tx->data + 1, 4));
+    SimLeafTypeDef *leaf;
+    uint8_t acked;
+
+    HOST_CHECK(tx->data[0] == LORALINK_TYPE_ACK && tx->length == LORALINK_ACK_LEN && index >= 0,
+               "gateway sent an unexpected frame type %02X", tx->data[0]);
+    if (index < 0)
+    {
+        return;
+    }
+    leaf = &sim.leaves[index];
+    if (leaf->state != SIM_LEAF_WAIT_ACK || !leaf->ackInFlight)
+    {
+        return;
+    }
+    acked = !SIM_Overlapped(txIndex) && (double)SIM_Random() / 4294967296.0 >= sim.ackLoss &&
+            memcmp(tx->data + 1, leaf->frame + 1, 6) == 0 && tx->data[7] == leaf->frame[0];
+    SIM_LeafDecide(index, acked);
+}
+
+static void SIM_Dispatch(const SimEventTypeDef *event)
+{
+    SimLeafTypeDef *leaf;
+
+    switch (event->kind)
+    {
+    case SIM_EVENT_TX_START:
+        leaf = &sim.leaves[event->index];
+        leaf->state = SIM_LEAF_TX;
+        sim.result.sent++;
+        SIM_Transmit(event->index, leaf->frame, LORAFRAME_POSITION_LEN, sim.now);
+        break;
+    case SIM_EVENT_TX_END:
+        if (sim.tx[event->index].sender == SIM_GATEWAY)
+        {
+            SIM_AckEnd(event->index);
+        }
+        else
+        {
+            SIM_UplinkEnd(event->index);
+        }
+        break;
+    case SIM_EVENT_WINDOW_END:
+        leaf = &sim.leaves[event->index];
+        /* 应答已在发送时窗口不提前关闭, 由应答结束时判定 */
+        if (leaf->state == SIM_LEAF_WAIT_ACK && !leaf->ackInFlight && leaf->windowEnd == sim.now)
+        {
+            SIM_LeafDecide(event->index, 0);
+        }
+        break;
+    }
+}
+
+/* ===== 仿真 ===== */
+
+/**
+ * @brief 解码批量帧并与叶节点发出、到达的帧比较
+ */
+static void SIM_CheckBatch(const uint8_t *batch, uint16_t length, const LoraPositionTypeDef *self,
+                           const GatewayStatsTypeDef *before)
+{
+    uint8_t seen[SIM_LEAF_MAX] = {0};
+    LoraPositionTypeDef position;
+    uint32_t copies = 0;
+    uint32_t extra = 0;
+    uint8_t count = batch[5];
+    uint32_t received = gatewayStats.received - before->received;
+    uint32_t duplicates = gatewayStats.duplicates - before->duplicates;
+    uint32_t overflow = gatewayStats.overflow - before->overflow;
+    uint8_t complete;
+    uint8_t i;
+    int index;
+
+    HOST_CHECK(batch[0] == LORAFRAME_TYPE_BATCH && LORAFRAME_Get(batch + 1, 4) == SIM_GATEWAY_ID,
+               "batch header %02X %08X", batch[0], LORAFRAME_Get(batch + 1, 4));
+    HOST_CHECK(count >= 1 && count <= GATEWAY_MAX_NODES + 1 &&
+               length == LORAFRAME_BATCH_HEADER_LEN + count * LORAFRAME_POSITION_LEN,
+               "batch count %u length %u", count, length);
+    HOST_CHECK(LORAFRAME_DecodePosition(batch + LORAFRAME_BATCH_HEADER_LEN, LORAFRAME_POSITION_LEN, &position) == 0 &&
+               position.nodeId == self->nodeId && position.seq == self->seq, "batch does not start with the gateway");
+
+    for (i = 1; i < count; i++)
+    {
+        const uint8_t *entry = batch + LORAFRAME_BATCH_HEADER_LEN + i * LORAFRAME_POSITION_LEN;
+        SimLeafTypeDef *leaf;
+
+        if (LORAFRAME_DecodePosition(entry, LORAFRAME_POSITION_LEN, &position) != 0)
+        {
+            HOST_CHECK(0, "batch entry %u does not decode", i);
+            continue;
+        }
+        index = SIM_FindLeaf(position.nodeId);
+        if (index < 0)
+        {
+            HOST_CHECK(0, "batch entry %u from unknown node %08X", i, position.nodeId);
+            continue;
+        }
+        leaf = &sim.leaves[index];
+        HOST_CHECK(!seen[index], "node %08X twice in one batch", position.nodeId);
+        HOST_CHECK(memcmp(entry, leaf->frame, LORAFRAME_POSITION_LEN) == 0,
+                   "node %08X entry differs from the frame it sent", position.nodeId);
+        HOST_CHECK(!leaf->forwarded || position.seq != leaf->forwardedSeq,
+                   "node %08X seq %u forwarded twice", position.nodeId, position.seq);
+        HOST_CHECK(leaf->copies > 0, "node %08X forwarded without reaching the gateway", position.nodeId);
+        seen[index] = 1;
+        leaf->forwarded = 1;
+        leaf->forwardedSeq = position.seq;
+    }
+
+    /* 待上行条目只在批量上行时清除, 本批未满说明周期内节点表从未被待上行条目占满 */
+    complete = sim.leafNum <= GATEWAY_MAX_NODES || count - 1 < GATEWAY_MAX_NODES;
+    for (index = 0; index < sim.leafNum; index++)
+    {
+        SimLeafTypeDef *leaf = &sim.leaves[index];
+
+        copies += leaf->copies;
+        extra += leaf->copies > 1 ? leaf->copies - 1 : 0;
+        if (complete)
+        {
+            HOST_CHECK(seen[index] == (leaf->copies > 0), "node %08X seq %u: %u copies arrived, forwarded %u",
+                       leaf->position.nodeId, leaf->position.seq, leaf->copies, seen[index]);
+        }
+    }
+    sim.result.forwarded += count - 1;
+
+    HOST_CHECK(received == copies, "gateway received %u, %u arrived", received, copies);
+    HOST_CHECK(received == (uint32_t)(count - 1) + duplicates + overflow,
+               "received %u != forwarded %u + duplicates %u + overflow %u", received, count - 1, duplicates, overflow);
+    if (complete)
+    {
+        HOST_CHECK(duplicates == extra && overflow == 0, "duplicates %u (expected %u), overflow %u",
+                   duplicates, extra, overflow);
+    }
+}
+
+/**
+ * @brief 一个上报周期: 各叶节点在窗口内随机时刻发出新帧, 运行到所有重发结束后网关上行一批
+ */
+static void SIM_RunCycle(uint32_t cycle, uint32_t windowMs, LoraPositionTypeDef *self)
+{
+    uint8_t batch[GATEWAY_BATCH_MAX];
+    GatewayStatsTypeDef before = gatewayStats;
+    uint64_t start = (uint64_t)cycle * SIM_PERIOD_MS;
+    uint16_t length;
+    int i;
+
+    if (start < sim.now)
+    {
+        start = sim.now;    /* 发送窗口接近上报周期时, 上一周期的重发可能尚未结束 */
+    }
+
+    sim.txNum = 0;
+    for (i = 0; i < sim.leafNum; i++)
+    {
+        SimLeafTypeDef *leaf = &sim.leaves[i];
+
+        leaf->position.seq++;
+        leaf->position.timestamp = 1700000000 + (uint32_t)(start / 1000);
+        leaf->position.latitude = 31230000 + (int32_t)(SIM_Random() % 10000);
+        leaf->position.longitude = 121470000 + (int32_t)(SIM_Random() % 10000);
+        leaf->position.steps += SIM_Random() % 100;
+        LORAFRAME_EncodePosition(&leaf->position, leaf->frame);
+        leaf->state = SIM_LEAF_IDLE;
+        leaf->attempt = 0;
+        leaf->ackInFlight = 0;
+        leaf->copies = 0;
+        sim.result.frames++;
+        SIM_Push(start + SIM_Random() % windowMs, SIM_EVENT_TX_START, i);
+    }
+
+    while (sim.eventNum > 0)
+    {
+        SimEventTypeDef event = SIM_Pop();
+
+        sim.now = event.at;
+        SIM_Dispatch(&event);
+    }
+    for (i = 0; i < sim.leafNum; i++)
+    {
+        HOST_CHECK(sim.leaves[i].state == SIM_LEAF_DONE, "leaf %d did not finish", i);
+    }
+
+    self->seq++;
+    self->timestamp = 1700000000 + (uint32_t)(start / 1000);
+    length = GATEWAY_BuildBatch(batch, self);
+    SIM_CheckBatch(batch, length, self, &before);
+}
+
+static void SIM_Reset(int leafNum, double ackLoss, uint32_t seed)
+{
+    int i;
+
+    memset(&sim, 0, sizeof(sim));
+    memset(&gatewayStats, 0, sizeof(gatewayStats));
+    memset(&loraLinkPeers, 0, sizeof(loraLinkPeers));
+    sim.random = seed != 0 ? seed : 1;
+    sim.ackLoss = ackLoss;
+    sim.leafNum = leafNum;
+    for (i = 0; i < leafNum; i++)
+    {
+        sim.leaves[i].position.nodeId = 0x10000000 + (uint32_t)i * 0x01010101;
+        sim.leaves[i].position.seq = (uint16_t)SIM_Random();
+        sim.leaves[i].position.flags = LORAFRAME_FLAG_FIX | LORAFRAME_FLAG_TIME;
+    }
+    GATEWAY_Init();
+}
+
+static void SIM_Run(int leafNum, uint32_t cycles, uint32_t windowMs, double ackLoss, uint32_t seed)
+{
+    LoraPositionTypeDef self = {SIM_GATEWAY_ID, 0, LORAFRAME_FLAG_FIX | LORAFRAME_FLAG_TIME};
+    SimResultTypeDef *r = &sim.result;
+    uint32_t cycle;
+
+    if (leafNum < 1 || leafNum > SIM_LEAF_MAX || windowMs == 0)
+    {
+        HOST_CHECK(0, "invalid scenario: %d nodes (1..%d), window %u ms", leafNum, SIM_LEAF_MAX, windowMs);
+        return;
+    }
+    SIM_Reset(leafNum, ackLoss, seed);
+    for (cycle = 0; cycle < cycles; cycle++)
+    {
+        SIM_RunCycle(cycle, windowMs, &self);
+    }
+
+    printf("%5d %6u %7u %7u %8u %7u %6u %5u %8u %8u %9u %7.1f%%\n", leafNum, r->frames, r->sent,
+           r->sent - r->frames, r->collided, r->arrived, r->acked, r->failed, gatewayStats.duplicates,
+           gatewayStats.overflow, r->forwarded, r->frames ? 100.0 * r->forwarded / r->frames : 0.0);
+}
+
+/**
+ * @brief 叶节点重新上电: 序号回退超过 GATEWAY_DUP_WINDOW 视为新帧, 窗口内回退视为重复帧;
+ *        链路层对端统计同样去重, 重新上电时从新序号同步且不计丢失
+ */
+static void SIM_TestReboot(void)
+{
+    LoraPositionTypeDef self = {SIM_GATEWAY_ID, 0, 0};
+    LoraPositionTypeDef position = {0};
+    uint8_t frame[LORAFRAME_POSITION_LEN];
+    uint8_t batch[GATEWAY_BATCH_MAX];
+    static const struct
+    {
+        uint16_t seq;
+        uint8_t stored;
+        uint8_t lost;       // 链路层推算的丢失帧数增量
+    } steps[] = {
+        {100, 1, 0},
+        {100, 0, 0},
+        {101 - GATEWAY_DUP_WINDOW, 0, 0},
+        {100 - GATEWAY_DUP_WINDOW, 1, 0},
+        {0xFFFF, 1, 0},
+        {0xFFFF - GATEWAY_DUP_WINDOW + 1, 0, 0},
+        {3, 1, 3},
+        {1, 0, 0},
+        {7, 1, 3},
+    };
+    const LoraLinkPeerTypeDef *peer = &loraLinkPeers[0];
+    uint8_t i;
+
+    SIM_Reset(1, 0, 1);
+    position.nodeId = sim.leaves[0].position.nodeId;
+    for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+    {
+        GatewayStatsTypeDef before = gatewayStats;
+        LoraLinkPeerTypeDef peerBefore = *peer;
+        uint16_t length;
+
+        position.seq = steps[i].seq;
+        LORAFRAME_EncodePosition(&position, frame);
+        sim.rxCallback(frame, LORAFRAME_POSITION_LEN);
+        (void)LORALINK_Poll();
+        GATEWAY_StartReceive();
+        length = GATEWAY_BuildBatch(batch, &self);
+        HOST_CHECK(gatewayStats.duplicates - before.duplicates == !steps[i].stored &&
+                   length == LORAFRAME_BATCH_HEADER_LEN + (1 + steps[i].stored) * LORAFRAME_POSITION_LEN,
+                   "seq %u after %u: stored %u, expected %u", steps[i].seq, i ? steps[i - 1].seq : 0,
+                   length > LORAFRAME_BATCH_HEADER_LEN + LORAFRAME_POSITION_LEN, steps[i].stored);
+        HOST_CHECK(peer->nodeId == position.nodeId && peer->duplicates - peerBefore.duplicates == !steps[i].stored &&
+                   peer->frames - peerBefore.frames == steps[i].stored &&
+                   peer->lastSeq == (steps[i].stored ? steps[i].seq : peerBefore.lastSeq) &&
+                   peer->lost - peerBefore.lost == steps[i].lost,
+                   "link seq %u: last %u, duplicates +%u, frames +%u, lost +%u", steps[i].seq, peer->lastSeq,
+                   peer->duplicates - peerBefore.duplicates, peer->frames - peerBefore.frames,
+                   peer->lost - peerBefore.lost);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const int defaultNodes[] = {4, GATEWAY_MAX_NODES, 12};
+    int leafNum = 0;
+    uint32_t cycles = 100;
+    uint32_t windowMs = 10000;
+    double ackLoss = 0.1;
+    uint32_t seed = 1;
+    int option;
+    uint8_t i;
+
+    while ((option = getopt(argc, argv, "n:c:w:l:s:v")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': leafNum = atoi(optarg); break;
+        case 'c': cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'w': windowMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'l': ackLoss = atof(optarg); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'v': hostVerbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n nodes] [-c cycles] [-w window_ms] [-l ack_loss] [-s seed] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SIM_TestReboot();
+
+    printf("window %u ms, ack loss %.2f, seed %u, %u cycles, uplink %u ms, ack %u ms\n", windowMs, ackLoss, seed,
+           cycles, SIM_AirMs(LORAFRAME_POSITION_LEN), SIM_AirMs(LORALINK_ACK_LEN));
+    printf("nodes frames    sent retries collided arrived  acked  fail     dups overflow forwarded delivery\n");
+    if (leafNum != 0)
+    {
+        SIM_Run(leafNum, cycles, windowMs, ackLoss, seed);
+    }
+    else
+    {
+        for (i = 0; i < sizeof(defaultNodes) / sizeof(defaultNodes[0]); i++)
+        {
+            SIM_Run(defaultNodes[i], cycles, windowMs, ackLoss, seed);
+        }
+    }
+    return HOST_Report("gateway_sim");
+}
@@ -0,0 +1,35 @@
+/**
+ * @file host.c
+ * @brief PC测试程序的公共部分: 日志开关和断言统计
+ */
+
+#include "host.h"
+
+int hostVerbose = 0;
+int hostChecks = 0;
+int hostFailures = 0;
+GPIO_TypeDef hostGpioB = {0};
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    port->odr = state ? (port->odr | pin) : (port->odr & ~pin);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->idr & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void GPIOB14_Init(void)
+{
+}
+
+/**
+ * @brief 输出断言统计
+ * @return int 进程退出码, 0 表示全部通过
+ */
+int HOST_Report(const char *name)
+{
+    printf("%s: %d checks, %d failures\n", name, hostChecks, hostFailures);
+    return hostFailures ? 1 : 0;
+}
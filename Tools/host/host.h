@@ -0,0 +1,130 @@
+/**
+ * @file host.h
+ * @brief 在PC上编译固件模块的替身头文件
+ *
+ * 本目录下的 sys/sys.h、debug/debug.h 和板级驱动头文件都只包含本文件, -ITools/host 放在最前,
+ * 被测的 .c 文件因此只引入与硬件无关的部分; 被测模块调用的硬件函数(RTC、备份寄存器、DIO1时刻、
+ * 低功耗等待等)在这里声明, 由各测试程序以替身实现。编译选项见各测试程序的文件说明。
+ */
+
+#ifndef __HOST_H__
+#define __HOST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* sys.h / HAL */
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define __WFI() HOST_Wfi()
+
+void HOST_Wfi(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+uint32_t HAL_GetUIDw0(void);
+uint32_t HAL_GetUIDw1(void);
+uint32_t HAL_GetUIDw2(void);
+
+/* debug.h: 日志在 hostVerbose 非0时输出到标准输出 */
+extern int hostVerbose;
+
+#define DEBUG_Output(fmt, ...) ((void)(hostVerbose && printf("  | " fmt, ##__VA_ARGS__)))
+#define DEBUG_Error(fmt, ...)  DEBUG_Output(fmt, ##__VA_ARGS__)
+#define DEBUG_Warn(fmt, ...)   DEBUG_Output(fmt, ##__VA_ARGS__)
+#define DEBUG_Info(fmt, ...)   DEBUG_Output(fmt, ##__VA_ARGS__)
+#define DEBUG_Trace(fmt, ...)  DEBUG_Output(fmt, ##__VA_ARGS__)
+#define DEBUG_Flush()
+
+/* gpio.h: 引脚电平保存在 hostGpioB 中 */
+typedef struct
+{
+    uint16_t odr;
+    uint16_t idr;
+} GPIO_TypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_2      ((uint16_t)0x0004)
+#define GPIO_PIN_12     ((uint16_t)0x1000)
+#define GPIO_PIN_14     ((uint16_t)0x4000)
+#define GPIOB           (&hostGpioB)
+
+extern GPIO_TypeDef hostGpioB;
+extern volatile uint8_t gpioB14Flag;
+extern volatile uint8_t gpioA10Flag;
+extern volatile uint32_t gpioB14Tick;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void GPIOB14_Init(void);
+
+/* rtc.h */
+extern volatile uint8_t rtcAlarmFlag;
+
+uint32_t RTC_GetCounter(void);
+uint32_t RTC_GetCounterMs(uint16_t *millis);
+void RTC_SetAlarm(uint32_t seconds);
+
+/* pwr.h */
+#define PWR_BKP_LORA_FRAME_SEQ  8
+#define PWR_BKP_LORA_FRAG_ID    9
+#define PWR_BKP_LORAWAN_FCNT    10
+#define PWR_SESSION_LORA        0x0002
+
+uint16_t PWR_ReadBackup(uint32_t reg);
+void PWR_WriteBackup(uint32_t reg, uint16_t data);
+uint8_t PWR_GetSession(uint16_t flag);
+void PWR_SetSession(uint16_t flag, uint8_t set);
+
+/* adc.h */
+uint16_t ADC1_ReadVdd(void);
+
+/* lowPower.h, 以及经它引入的命令行、性能统计和时钟接口(在PC上不起作用) */
+void LOWPOWER_StopFor(uint32_t seconds);
+
+#define LOWPOWER_SleepModules()
+#define SHELL_Poll()            0
+#define SHELL_Session()         0
+#define SHELL_ArmWakeup()
+#define SHELL_DisarmWakeup()
+#define PROFILE_SleepBegin()
+#define PROFILE_SleepEnd()
+#define CLOCK_Resume()
+#define HAL_SuspendTick()
+#define HAL_ResumeTick()
+#define HAL_PWR_EnterSTOPMode(regulator, entry) HOST_Wfi()
+#define __disable_irq()
+#define __enable_irq()
+
+/* 测试断言: 失败时记录并继续, 由 HOST_Report() 汇总 */
+extern int hostChecks;
+extern int hostFailures;
+
+#define HOST_CHECK(cond, ...)                                              \
+    do                                                                     \
+    {                                                                      \
+        hostChecks++;                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            hostFailures++;                                                \
+            printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);         \
+            printf(__VA_ARGS__);                                           \
+            printf("\n");                                                  \
+        }                                                                  \
+    } while (0)
+
+int HOST_Report(const char *name);
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file lora_toa_test.c
+ * @brief LORA_TimeOnAirUs() 在PC上的测试
+ *
+ * 把 lora.c 与 driver_llcc68.c 一起编译, SPI、GPIO替身不连接芯片。检查:
+ *   - 参考值(前导码8, 显式头部, CRC开, CR 4/5, 10字节):
+ *       SF7/125kHz 41.216ms, SF9/125kHz 144.384ms, SF9/125kHz开启低数据率优化 164.864ms,
+ *       SF6/125kHz(SF5/SF6的前导码多2个符号) 21.632ms
+ *   - 与按Semtech手册公式以浮点计算的结果逐一比较: SF5~SF11, 125/250/500kHz, CR 4/5~4/8,
+ *     低数据率优化、隐式头部、CRC的各种组合, 负载0~255字节, 前导码8/12/100
+ *   - LORA_GetTimeOnAirUs() 使用当前配置和监听档位的前导码长度
+ *
+ * 用法(仓库根目录):
+ *   gcc -std=gnu99 -Wall -Wno-format -ITools/host -IUser -ISystem -IAPP -IDriver/chip -IDriver/chip/LoRa \
+ *       -o lora_toa_test Tools/host/host.c Tools/host/lora_toa_test.c Driver/chip/LoRa/driver_llcc68.c -lm
+ *   ./lora_toa_test
+ */
+
+#include <math.h>
+
+#include "host.h"
+#include "LoRa/lora.c"
+
+/* ===== 硬件替身 ===== */
+
+volatile uint8_t gpioB14Flag = 0;
+volatile uint32_t gpioB14Tick = 0;
+uint32_t llcc68SpiBytes = 0;
+
+void HOST_Wfi(void)
+{
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return 0;
+}
+
+uint32_t RTC_GetCounter(void)
+{
+    return 0;
+}
+
+uint8_t PWR_GetSession(uint16_t flag)
+{
+    (void)flag;
+    return 0;
+}
+
+void PWR_SetSession(uint16_t flag, uint8_t set)
+{
+    (void)flag;
+    (void)set;
+}
+
+uint8_t llcc68_interface_spi_init(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_spi_deinit(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_spi_write_read(uint8_t *in_buf, uint32_t in_len, uint8_t *out_buf, uint32_t out_len)
+{
+    (void)in_buf;
+    (void)in_len;
+    memset(out_buf, 0, out_len);
+    return 0;
+}
+
+uint8_t llcc68_interface_spi_transfer(uint8_t *header, uint32_t header_len, uint8_t *tx_buf, uint8_t *rx_buf, uint32_t len)
+{
+    (void)header;
+    (void)header_len;
+    (void)tx_buf;
+    if (rx_buf != NULL)
+    {
+        memset(rx_buf, 0, len);
+    }
+    return 0;
+}
+
+uint8_t llcc68_interface_reset_gpio_init(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_reset_gpio_deinit(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_reset_gpio_write(uint8_t data)
+{
+    (void)data;
+    return 0;
+}
+
+uint8_t llcc68_interface_busy_gpio_init(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_busy_gpio_deinit(void)
+{
+    return 0;
+}
+
+uint8_t llcc68_interface_busy_gpio_read(uint8_t *value)
+{
+    *value = 0;
+    return 0;
+}
+
+void llcc68_interface_delay_ms(uint32_t ms)
+{
+    (void)ms;
+}
+
+void llcc68_interface_delay_us(uint32_t us)
+{
+    (void)us;
+}
+
+void llcc68_interface_debug_print(const char *const fmt, ...)
+{
+    (void)fmt;
+}
+
+void llcc68_interface_receive_callback(uint16_t type, uint8_t *buf, uint16_t len)
+{
+    (void)type;
+    (void)buf;
+    (void)len;
+}
+
+/* ===== 测试 ===== */
+
+/**
+ * @brief 按手册公式以浮点计算空中时间(us)
+ * @param cr 1~4 对应 4/5~4/8
+ */
+static double TEST_ReferenceUs(int sf, double bandwidthHz, int cr, int ldro, int implicitHeader, int crcOn,
+                               int length, int preamble)
+{
+    double symbolUs = pow(2, sf) / bandwidthHz * 1e6;
+    double bits = 8.0 * length + 16 * crcOn - 4 * sf + 20 * (1 - implicitHeader);
+    double bitsPerSymbol = 4.0 * sf;
+    double preambleSymbols = preamble + 6.25;
+
+    if (sf >= 7)
+    {
+        bits += 8;
+        bitsPerSymbol = 4.0 * (sf - 2 * ldro);
+        preambleSymbols = preamble + 4.25;
+    }
+    return (preambleSymbols + 8 + ceil(fmax(bits, 0) / bitsPerSymbol) * (cr + 4)) * symbolUs;
+}
+
+static uint32_t TEST_TimeOnAir(uint8_t sf, uint8_t bandwidth, uint8_t ldro, uint8_t length)
+{
+    LoraConfigTypeDef config = loraConfig;
+
+    config.sf = sf;
+    config.bandwidth = bandwidth;
+    config.cr = LLCC68_LORA_CR_4_5;
+    config.ldro = ldro;
+    return LORA_TimeOnAirUs(&config, 8, 0, 1, length);
+}
+
+static void TEST_Reference(void)
+{
+    uint32_t us;
+
+    us = TEST_TimeOnAir(LLCC68_LORA_SF_7, LLCC68_LORA_BANDWIDTH_125_KHZ, 0, 10);
+    HOST_CHECK(us == 41216, "SF7/125kHz/10B = %u us, expected 41216", us);
+    us = TEST_TimeOnAir(LLCC68_LORA_SF_9, LLCC68_LORA_BANDWIDTH_125_KHZ, 0, 10);
+    HOST_CHECK(us == 144384, "SF9/125kHz/10B = %u us, expected 144384", us);
+    us = TEST_TimeOnAir(LLCC68_LORA_SF_9, LLCC68_LORA_BANDWIDTH_125_KHZ, 1, 10);
+    HOST_CHECK(us == 164864, "SF9/125kHz/10B LDRO = %u us, expected 164864", us);
+    us = TEST_TimeOnAir(LLCC68_LORA_SF_6, LLCC68_LORA_BANDWIDTH_125_KHZ, 0, 10);
+    HOST_CHECK(us == 21632, "SF6/125kHz/10B = %u us, expected 21632", us);
+}
+
+static void TEST_Sweep(void)
+{
+    static const uint16_t preambles[3] = {8, 12, 100};
+    static const uint8_t bandwidths[3] = {LLCC68_LORA_BANDWIDTH_125_KHZ, LLCC68_LORA_BANDWIDTH_250_KHZ,
+                                          LLCC68_LORA_BANDWIDTH_500_KHZ};
+    LoraConfigTypeDef config = loraConfig;
+    int mismatches = 0;
+    int sf, b, cr, ldro, ih, crc, length, p;
+
+    for (sf = 5; sf <= 11; sf++)
+    for (b = 0; b < 3; b++)
+    for (cr = 1; cr <= 4; cr++)
+    for (ldro = 0; ldro <= 1; ldro++)
+    for (ih = 0; ih <= 1; ih++)
+    for (crc = 0; crc <= 1; crc++)
+    for (p = 0; p < 3; p++)
+    for (length = 0; length <= 255; length++)
+    {
+        double reference = TEST_ReferenceUs(sf, 125000.0 * (1 << b), cr, sf >= 7 ? ldro : 0, ih, crc, length,
+                                            preambles[p]);
+        uint32_t us;
+
+        config.sf = (uint8_t)sf;
+        config.bandwidth = bandwidths[b];
+        config.cr = (uint8_t)cr;
+        config.ldro = (uint8_t)ldro;
+        us = LORA_TimeOnAirUs(&config, preambles[p], (uint8_t)ih, (uint8_t)crc, (uint8_t)length);
+        if (us != (uint32_t)ceil(reference - 1e-6) && mismatches++ < 5)
+        {
+            HOST_CHECK(0, "SF%d BW%d CR4/%d LDRO%d IH%d CRC%d PL%d preamble %u: %u us, reference %.3f",
+                       sf, 125 << b, cr + 4, ldro, ih, crc, length, preambles[p], us, reference);
+        }
+    }
+    HOST_CHECK(mismatches == 0, "%d mismatches against the reference formula", mismatches);
+}
+
+static void TEST_Current(void)
+{
+    uint32_t continuous;
+    uint32_t expect;
+
+    loraConfig.sf = LLCC68_LORA_SF_9;
+    loraConfig.bandwidth = LLCC68_LORA_BANDWIDTH_125_KHZ;
+    loraConfig.cr = LLCC68_LORA_CR_4_5;
+    loraConfig.ldro = 0;
+
+    LORA_SetListenProfile(LORA_LISTEN_CONTINUOUS);
+    continuous = LORA_GetTimeOnAirUs(10);
+    expect = (uint32_t)ceil(TEST_ReferenceUs(9, 125000, 1, 0, 0, 1, 10, LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH));
+    HOST_CHECK(continuous == expect, "current config SF9/10B = %u us, expected %u", continuous, expect);
+
+    LORA_SetListenProfile(LORA_LISTEN_NUM - 1);
+    expect = (uint32_t)ceil(TEST_ReferenceUs(9, 125000, 1, 0, 0, 1, 10, LORA_GetPreambleLength()));
+    HOST_CHECK(LORA_GetTimeOnAirUs(10) == expect && expect > continuous,
+               "sniff profile uses the long preamble: %u us", LORA_GetTimeOnAirUs(10));
+    LORA_SetListenProfile(LORA_LISTEN_CONTINUOUS);
+}
+
+int main(int argc, char **argv)
+{
+    hostVerbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    TEST_Reference();
+    TEST_Sweep();
+    TEST_Current();
+    return HOST_Report("lora_toa_test");
+}
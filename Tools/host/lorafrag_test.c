@@ -0,0 +1,423 @@
+/**
+ * @file lorafrag_test.c
+ * @brief LoRa分片传输(APP/loraFrag)在PC上的测试
+ *
+ * 发送方和接收方运行同一份 loraFrag.c(两侧使用的状态互不相交), 射频由有损的虚拟信道代替:
+ * 发送方的每个分片按丢包计划或概率丢失, 未丢失的分片交给接收方 LORAFRAG_OnReceive();
+ * 发送方开始等待SACK时, 接收方按主循环的顺序调用 LORAFRAG_Poll(), SACK同样可能丢失。检查:
+ *   - 每轮只发送上一次收到的SACK中缺失的分片, 请求应答标记只在本轮最后一个分片上
+ *   - 分片的头部(节点ID、消息ID、分片数、总长度)和数据与消息一致, 消息ID逐条加1
+ *   - SACK位图与接收方实际收到的分片一致, 发送SACK时先听后发已关闭
+ *   - 返回0时消息已重组且内容一致; 任何情况下同一消息只回调一次
+ *   - 首轮丢失指定分片、丢失请求应答的分片、丢失SACK、轮数用尽、非法长度, 以及随机丢包
+ *
+ * 用法(仓库根目录):
+ *   gcc -std=gnu99 -Wall -Wno-format -ITools/host -IUser -ISystem -IAPP -IDriver/chip -IDriver/chip/LoRa \
+ *       -o lorafrag_test Tools/host/host.c Tools/host/lorafrag_test.c
+ *   ./lorafrag_test       # -v 同时输出固件日志
+ */
+
+#include "host.h"
+#include "loraFrame/loraFrame.c"
+#include "loraFrag/loraFrag.c"
+
+#define TEST_ROUND_MAX      8
+#define TEST_RANDOM_NUM     500
+
+/* 虚拟信道和测试记录 */
+static struct
+{
+    /* 丢包: 计划(按轮次的分片位图和SACK)或概率 */
+    uint32_t dropFragments[TEST_ROUND_MAX];
+    uint8_t dropSack[TEST_ROUND_MAX];
+    double fragmentLoss;
+    double sackLoss;
+
+    /* 发送方一侧 */
+    const uint8_t *message;
+    uint16_t length;
+    uint16_t msgId;
+    uint8_t round;
+    uint32_t roundSent;                 // 本轮发出的分片位图
+    int8_t roundAckReq;                 // 本轮带请求应答标记的分片, -1表示没有
+    uint32_t sackKnown;                 // 已交给发送方的SACK位图之和
+    uint8_t lbt;
+    LORA_RxCallbackTypeDef rxCallback;
+    uint8_t sack[LORAFRAG_SACK_LEN];
+    uint8_t sackPending;
+
+    /* 接收方一侧 */
+    uint8_t delivered[LORAFRAG_MESSAGE_MAX];
+    uint16_t deliveredLength;
+    uint8_t deliveries;
+} test;
+
+/* ===== 硬件替身 ===== */
+
+static uint16_t hostBackup[11];
+static uint32_t hostRandom = 1;
+
+static uint32_t TEST_Random(void)
+{
+    hostRandom ^= hostRandom << 13;
+    hostRandom ^= hostRandom >> 17;
+    hostRandom ^= hostRandom << 5;
+    return hostRandom;
+}
+
+static uint8_t TEST_Chance(double probability)
+{
+    return (double)TEST_Random() / 4294967296.0 < probability;
+}
+
+void HOST_Wfi(void)
+{
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return 0;
+}
+
+void HAL_Delay(uint32_t ms)
+{
+    (void)ms;
+}
+
+uint32_t HAL_GetUIDw0(void)
+{
+    return 0x00320041;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+    return 0x3437510B;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+    return 0x32363234;
+}
+
+uint32_t RTC_GetCounter(void)
+{
+    return 1000;
+}
+
+uint16_t PWR_ReadBackup(uint32_t reg)
+{
+    return hostBackup[reg];
+}
+
+void PWR_WriteBackup(uint32_t reg, uint16_t data)
+{
+    hostBackup[reg] = data;
+}
+
+void LORA_SetLbt(uint8_t enable)
+{
+    test.lbt = enable;
+}
+
+LoraStateTypeDef LORA_GetState(void)
+{
+    return test.rxCallback != NULL ? LORA_STATE_RX : LORA_STATE_IDLE;
+}
+
+/* ===== 虚拟信道 ===== */
+
+static void TEST_OnMessage(uint32_t nodeId, const uint8_t *data, uint16_t length)
+{
+    HOST_CHECK(nodeId == LORAFRAME_GetNodeId(), "message from node %08X", nodeId);
+    memcpy(test.delivered, data, length);
+    test.deliveredLength = length;
+    test.deliveries++;
+}
+
+/**
+ * @brief 发送方的分片: 检查后按计划或概率丢失, 未丢失时交给接收方
+ */
+static void TEST_Fragment(uint8_t *frame, uint16_t length)
+{
+    uint8_t index = frame[7] & LORAFRAG_INDEX_MASK;
+    uint8_t count = (uint8_t)((test.length + LORAFRAG_FRAGMENT_SIZE - 1) / LORAFRAG_FRAGMENT_SIZE);
+    uint16_t offset = (uint16_t)index * LORAFRAG_FRAGMENT_SIZE;
+    uint16_t size = test.length - offset < LORAFRAG_FRAGMENT_SIZE ? test.length - offset : LORAFRAG_FRAGMENT_SIZE;
+    uint32_t drop = test.round < TEST_ROUND_MAX ? test.dropFragments[test.round] : 0;
+
+    HOST_CHECK(LORAFRAME_Get(frame + 1, 4) == LORAFRAME_GetNodeId() && LORAFRAME_Get(frame + 5, 2) == test.msgId &&
+               frame[8] == count && LORAFRAME_Get(frame + 9, 2) == test.length,
+               "fragment header: msg %u count %u length %u", LORAFRAME_Get(frame + 5, 2), frame[8],
+               LORAFRAME_Get(frame + 9, 2));
+    HOST_CHECK(index < count && length == LORAFRAG_HEADER_LEN + size &&
+               memcmp(frame + LORAFRAG_HEADER_LEN, test.message + offset, size) == 0,
+               "fragment %u: %u bytes do not match the message", index, length);
+    HOST_CHECK(!(test.sackKnown & (1UL << index)), "round %u resent fragment %u already in a SACK",
+               test.round, index);
+    HOST_CHECK(!(test.roundSent & (1UL << index)), "fragment %u sent twice in round %u", index, test.round);
+    test.roundSent |= 1UL << index;
+    if (frame[7] & LORAFRAG_FLAG_ACK_REQ)
+    {
+        HOST_CHECK(test.roundAckReq < 0, "second ACK_REQ in round %u", test.round);
+        test.roundAckReq = index;
+    }
+
+    if ((drop & (1UL << index)) || TEST_Chance(test.fragmentLoss))
+    {
+        return;
+    }
+    HOST_CHECK(LORAFRAG_OnReceive(frame, length, TEST_OnMessage) == 0, "fragment not accepted");
+}
+
+/**
+ * @brief 接收方的SACK: 检查后按计划或概率丢失, 未丢失时在发送方下次LORA_Process()时交付
+ */
+static void TEST_Sack(uint8_t *frame, uint16_t length)
+{
+    uint8_t drop = test.round < TEST_ROUND_MAX ? test.dropSack[test.round] : 0;
+
+    HOST_CHECK(!test.lbt, "SACK sent with listen-before-talk on");
+    HOST_CHECK(length == LORAFRAG_SACK_LEN && LORAFRAME_Get(frame + 1, 4) == LORAFRAME_GetNodeId() &&
+               LORAFRAME_Get(frame + 5, 2) == test.msgId, "SACK header: msg %u", LORAFRAME_Get(frame + 5, 2));
+    HOST_CHECK(LORAFRAME_Get(frame + 7, 4) == loraFragSlots[0].received, "SACK bitmap %08X, received %08X",
+               LORAFRAME_Get(frame + 7, 4), loraFragSlots[0].received);
+
+    if (drop || TEST_Chance(test.sackLoss))
+    {
+        return;
+    }
+    memcpy(test.sack, frame, LORAFRAG_SACK_LEN);
+    test.sackPending = 1;
+}
+
+uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
+{
+    if (sendDataBuffer[0] == LORAFRAG_TYPE_FRAGMENT)
+    {
+        if (test.msgId != LORAFRAME_Get(sendDataBuffer + 5, 2))
+        {
+            test.msgId = (uint16_t)LORAFRAME_Get(sendDataBuffer + 5, 2);
+            test.sackKnown = 0;
+        }
+        TEST_Fragment(sendDataBuffer, length);
+    }
+    else
+    {
+        HOST_CHECK(sendDataBuffer[0] == LORAFRAG_TYPE_SACK, "unexpected frame type %02X", sendDataBuffer[0]);
+        TEST_Sack(sendDataBuffer, length);
+    }
+    return 0;
+}
+
+/**
+ * @brief 发送方本轮发完, 开始等待SACK: 检查本轮发送的分片, 接收方按主循环回复SACK
+ */
+uint8_t LORA_ReceiveAsync(uint32_t timeoutMs, LORA_RxCallbackTypeDef callback)
+{
+    uint8_t count = (uint8_t)((test.length + LORAFRAG_FRAGMENT_SIZE - 1) / LORAFRAG_FRAGMENT_SIZE);
+    uint32_t missing = LORAFRAG_AllMask(count) & ~test.sackKnown;
+    int8_t highest = 31;
+
+    while (highest >= 0 && !(test.roundSent & (1UL << highest)))
+    {
+        highest--;
+    }
+    HOST_CHECK(timeoutMs == LORAFRAG_ACK_TIMEOUT_MS, "SACK timeout %u", timeoutMs);
+    HOST_CHECK(test.roundSent == missing, "round %u sent %08X, missing %08X", test.round, test.roundSent, missing);
+    HOST_CHECK(test.roundAckReq == highest, "round %u ACK_REQ on %d, last fragment %d", test.round,
+               test.roundAckReq, highest);
+
+    test.sackPending = 0;
+    (void)LORAFRAG_Poll();  /* 网关主循环回复SACK, 之后重新开始的连续接收在测试中不需要 */
+    test.rxCallback = callback;
+    test.round++;
+    test.roundSent = 0;
+    test.roundAckReq = -1;
+    return 0;
+}
+
+void LORA_Process(void)
+{
+    LORA_RxCallbackTypeDef callback = test.rxCallback;
+
+    if (callback == NULL)
+    {
+        return;
+    }
+    test.rxCallback = NULL;
+    if (test.sackPending)
+    {
+        test.sackPending = 0;
+        test.sackKnown |= LORAFRAME_Get(test.sack + 7, 4);
+        callback(test.sack, LORAFRAG_SACK_LEN);
+    }
+    else
+    {
+        callback(NULL, 0);  /* 接收超时 */
+    }
+}
+
+/* ===== 测试 ===== */
+
+/**
+ * @brief 按当前丢包设置发送一条消息
+ * @return uint8_t LORAFRAG_Send() 的返回值
+ */
+static uint8_t TEST_Send(const uint8_t *message, uint16_t length)
+{
+    uint16_t msgId = PWR_ReadBackup(PWR_BKP_LORA_FRAG_ID);
+    uint8_t result;
+
+    test.message = message;
+    test.length = length;
+    test.round = 0;
+    test.roundSent = 0;
+    test.roundAckReq = -1;
+    test.deliveries = 0;
+    test.lbt = 1;
+    LORA_SetLbt(1);
+
+    result = LORAFRAG_Send(message, length);
+
+    HOST_CHECK(test.lbt, "listen-before-talk left off");
+    HOST_CHECK(test.rxCallback == NULL, "receive still pending");
+    HOST_CHECK(PWR_ReadBackup(PWR_BKP_LORA_FRAG_ID) == (uint16_t)(msgId + 1), "message ID %u after %u",
+               PWR_ReadBackup(PWR_BKP_LORA_FRAG_ID), msgId);
+    HOST_CHECK(test.deliveries <= 1, "message delivered %u times", test.deliveries);
+    if (test.deliveries == 1)
+    {
+        HOST_CHECK(test.deliveredLength == length && memcmp(test.delivered, message, length) == 0,
+                   "reassembled %u bytes differ from the %u sent", test.deliveredLength, length);
+    }
+    if (result == 0)
+    {
+        HOST_CHECK(test.deliveries == 1, "sender done but the message was not reassembled");
+    }
+    return result;
+}
+
+static void TEST_Plan(uint8_t round, uint32_t fragments, uint8_t sack)
+{
+    test.dropFragments[round] = fragments;
+    test.dropSack[round] = sack;
+}
+
+static void TEST_ClearPlan(void)
+{
+    memset(test.dropFragments, 0, sizeof(test.dropFragments));
+    memset(test.dropSack, 0, sizeof(test.dropSack));
+    test.fragmentLoss = 0;
+    test.sackLoss = 0;
+}
+
+static void TEST_FillMessage(uint8_t *message, uint16_t length)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        message[i] = (uint8_t)TEST_Random();
+    }
+}
+
+static void TEST_Scripted(void)
+{
+    static uint8_t message[LORAFRAG_MESSAGE_MAX];
+    LoraFragStatsTypeDef before;
+    uint8_t result;
+
+    TEST_FillMessage(message, sizeof(message));
+
+    /* 无丢包: 300字节, 5个分片(最后一个44字节), 一轮完成 */
+    TEST_ClearPlan();
+    before = loraFragStats;
+    result = TEST_Send(message, 300);
+    HOST_CHECK(result == 0 && test.round == 1, "lossless: result %u after %u rounds", result, test.round);
+    HOST_CHECK(loraFragStats.fragments - before.fragments == 5 && loraFragStats.resent == before.resent,
+               "lossless: %u fragments, %u resent", loraFragStats.fragments - before.fragments,
+               loraFragStats.resent - before.resent);
+
+    /* 首轮丢失分片1和4: 第二轮只重发这两个, 请求应答在分片4上 */
+    TEST_ClearPlan();
+    TEST_Plan(0, (1UL << 1) | (1UL << 4), 0);
+    before = loraFragStats;
+    result = TEST_Send(message, LORAFRAG_MESSAGE_MAX);
+    HOST_CHECK(result == 0 && test.round == 2, "selective: result %u after %u rounds", result, test.round);
+    HOST_CHECK(loraFragStats.resent - before.resent == 2, "selective: %u resent", loraFragStats.resent - before.resent);
+
+    /* 丢失请求应答的最后一个分片: 没有SACK, 第二轮重发全部分片 */
+    TEST_ClearPlan();
+    TEST_Plan(0, 1UL << 4, 0);
+    before = loraFragStats;
+    result = TEST_Send(message, 300);
+    HOST_CHECK(result == 0 && test.round == 2 && loraFragStats.resent - before.resent == 5,
+               "last lost: result %u, %u rounds, %u resent", result, test.round, loraFragStats.resent - before.resent);
+
+    /* SACK丢失: 接收方已完成, 第二轮重发的分片不再回调 */
+    TEST_ClearPlan();
+    TEST_Plan(0, 0, 1);
+    before = loraFragStats;
+    result = TEST_Send(message, 200);
+    HOST_CHECK(result == 0 && test.round == 2 && loraFragStats.resent - before.resent == 4 &&
+               loraFragStats.completed - before.completed == 1,
+               "SACK lost: result %u, %u rounds, %u resent, %u completed", result, test.round,
+               loraFragStats.resent - before.resent, loraFragStats.completed - before.completed);
+
+    /* 每轮都丢失分片2: 轮数用尽后失败, 之后每轮只发分片2 */
+    TEST_ClearPlan();
+    for (result = 0; result < LORAFRAG_MAX_ROUNDS; result++)
+    {
+        TEST_Plan(result, 1UL << 2, 0);
+    }
+    before = loraFragStats;
+    result = TEST_Send(message, 400);
+    HOST_CHECK(result == 1 && test.round == LORAFRAG_MAX_ROUNDS && test.deliveries == 0 &&
+               loraFragStats.failed - before.failed == 1 &&
+               loraFragStats.resent - before.resent == LORAFRAG_MAX_ROUNDS - 1,
+               "exhausted: result %u, %u rounds, %u resent", result, test.round, loraFragStats.resent - before.resent);
+
+    /* 单个分片的消息 */
+    TEST_ClearPlan();
+    result = TEST_Send(message, 1);
+    HOST_CHECK(result == 0 && test.round == 1, "single byte: result %u after %u rounds", result, test.round);
+
+    /* 非法长度不发送 */
+    before = loraFragStats;
+    HOST_CHECK(LORAFRAG_Send(message, 0) == 1 && LORAFRAG_Send(message, LORAFRAG_MESSAGE_MAX + 1) == 1 &&
+               loraFragStats.messages == before.messages && loraFragStats.fragments == before.fragments,
+               "invalid lengths must be rejected");
+}
+
+static void TEST_RandomLoss(void)
+{
+    static uint8_t message[LORAFRAG_MESSAGE_MAX];
+    LoraFragStatsTypeDef before = loraFragStats;
+    uint32_t delivered = 0;
+    uint32_t succeeded = 0;
+    uint16_t i;
+
+    TEST_ClearPlan();
+    test.fragmentLoss = 0.25;
+    test.sackLoss = 0.2;
+    for (i = 0; i < TEST_RANDOM_NUM; i++)
+    {
+        uint16_t length = 1 + TEST_Random() % LORAFRAG_MESSAGE_MAX;
+
+        TEST_FillMessage(message, length);
+        succeeded += TEST_Send(message, length) == 0;
+        delivered += test.deliveries;
+    }
+    printf("random loss: %u messages, %u confirmed, %u reassembled, %u fragments, %u resent, %u failed\n",
+           TEST_RANDOM_NUM, succeeded, delivered, loraFragStats.fragments - before.fragments,
+           loraFragStats.resent - before.resent, loraFragStats.failed - before.failed);
+    HOST_CHECK(succeeded + (loraFragStats.failed - before.failed) == TEST_RANDOM_NUM, "every message ends once");
+}
+
+int main(int argc, char **argv)
+{
+    hostVerbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    TEST_Scripted();
+    TEST_RandomLoss();
+    return HOST_Report("lorafrag_test");
+}
@@ -0,0 +1,1055 @@
+/**
+ * @file lorawan_test.c
+ * @brief LoRaWAN终端(APP/lorawan)在PC上的一致性测试
+ *
+ * 把 lorawan.c、aes.c、loraFrame.c 与替身编译在一起: 射频由模拟信道代替, 记录每次发送和接收窗口,
+ * 下行包只有在窗口的频率、扩频因子、IQ反相都匹配且前导码落在窗口内时才能收到; 网络服务器替身
+ * 按 LoRaWAN 1.0.x 规范独立组帧(入网应答用AES解密运算加密), 校验上行MIC并解密载荷。覆盖:
+ *   - AES-128(FIPS-197)和AES-CMAC(RFC 4493)测试向量
+ *   - OTAA入网: 入网请求MIC、入网应答解密和会话密钥派生, MIC错误的入网应答被丢弃
+ *   - 接收窗口: RX1/RX2的时刻、频率和速率, 窗口前只唤醒芯片到待机, 配置后再开始接收
+ *   - 上行加密和MIC, 确认型上行的ACK, 确认型下行后的上行置位ACK
+ *   - 上下行帧计数跨16位回绕, 重放的下行被拒绝, 备份寄存器恢复上行帧计数
+ *   - LinkADRReq、RXParamSetupReq(FOpts和端口0两种方式)的应答状态和生效
+ *
+ * 用法(仓库根目录):
+ *   gcc -std=gnu99 -Wall -Wno-format -ITools/host -IUser -ISystem -IAPP -IDriver/chip -IDriver/chip/LoRa \
+ *       -o lorawan_test Tools/host/host.c Tools/host/lorawan_test.c
+ *   (-Wno-format: 固件按ARM的uint32_t即unsigned long书写格式串)
+ *   ./lorawan_test        # -v 同时输出固件日志
+ */
+
+#include "host.h"
+#include "user_config.h"
+
+/* 测试使用非零的入网参数 */
+#undef LORAWAN_OTAA
+#undef LORAWAN_DEV_EUI
+#undef LORAWAN_JOIN_EUI
+#undef LORAWAN_APP_KEY
+#define LORAWAN_OTAA
+#define LORAWAN_DEV_EUI     {0x00, 0x80, 0xE1, 0x15, 0x00, 0x0A, 0x1B, 0x2C}
+#define LORAWAN_JOIN_EUI    {0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01}
+#define LORAWAN_APP_KEY     {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, \
+                             0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C}
+
+#include "Aes/aes.c"
+#include "loraFrame/loraFrame.c"
+#include "lorawan/lorawan.c"
+
+#define TEST_AIR_MS         60          /* 模拟的上行空中时间(ms) */
+#define TEST_RX_AIR_MS      50          /* 模拟的下行空中时间(ms) */
+#define TEST_TX_DONE_LAG_MS 3           /* DIO1中断到固件读取时间的延迟(ms) */
+#define TEST_DOWN_MAX       4
+#define TEST_WINDOW_MAX     8
+#define TEST_REPLY_MAX      4
+
+/* ===== 硬件替身 ===== */
+
+static uint64_t hostMs = 1000000;                   /* 虚拟时间(ms) */
+static uint16_t hostBackup[11];                     /* 备份寄存器 DR1~DR10 */
+static uint32_t hostRandom = 1;
+volatile uint32_t gpioB14Tick = 0;
+
+void HOST_Wfi(void)
+{
+    hostMs++;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)hostMs;
+}
+
+uint32_t HAL_GetUIDw0(void)
+{
+    return 0x00320041;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+    return 0x3437510B;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+    return 0x32363234;
+}
+
+uint32_t RTC_GetCounter(void)
+{
+    return (uint32_t)(hostMs / 1000);
+}
+
+uint32_t RTC_GetCounterMs(uint16_t *millis)
+{
+    *millis = (uint16_t)(hostMs % 1000);
+    return (uint32_t)(hostMs / 1000);
+}
+
+uint16_t PWR_ReadBackup(uint32_t reg)
+{
+    return hostBackup[reg];
+}
+
+void PWR_WriteBackup(uint32_t reg, uint16_t data)
+{
+    hostBackup[reg] = data;
+}
+
+uint8_t PWR_GetSession(uint16_t flag)
+{
+    return (hostBackup[6] & flag) ? 1 : 0;
+}
+
+void PWR_SetSession(uint16_t flag, uint8_t set)
+{
+    hostBackup[6] = set ? (hostBackup[6] | flag) : (hostBackup[6] & ~flag);
+}
+
+uint16_t ADC1_ReadVdd(void)
+{
+    return 3300;
+}
+
+void LOWPOWER_StopFor(uint32_t seconds)
+{
+    hostMs += (uint64_t)seconds * 1000;
+}
+
+/* ===== 模拟射频 ===== */
+
+typedef enum
+{
+    RADIO_SLEEP = 0,
+    RADIO_STANDBY,
+    RADIO_RX,
+} RadioModeTypeDef;
+
+typedef struct
+{
+    uint8_t data[LORAWAN_PHY_MAX];
+    uint8_t length;
+    uint32_t frequency;
+    uint8_t sf;
+    uint64_t atMs;              /* 上行为发送完成时刻, 下行为前导码到达时刻 */
+} RadioPacketTypeDef;
+
+typedef struct
+{
+    uint32_t frequency;
+    uint8_t sf;
+    uint64_t openMs;
+    uint32_t timeoutMs;
+    uint8_t received;
+} RadioWindowTypeDef;
+
+static struct
+{
+    RadioModeTypeDef mode;
+    uint8_t invertIq;
+    uint32_t frequency;         /* 最近一次LORA_ApplyConfig()写入的频率 */
+    uint8_t sf;
+    int8_t txDbm;
+    uint32_t inits;             /* LORA_Init()调用次数 */
+    RadioPacketTypeDef up;      /* 最近一次上行 */
+    RadioPacketTypeDef down[TEST_DOWN_MAX];
+    uint8_t downNum;
+    RadioWindowTypeDef windows[TEST_WINDOW_MAX];
+    uint8_t windowNum;
+    LORA_RxCallbackTypeDef rxCallback;
+    uint64_t rxEndMs;
+    int8_t rxIndex;             /* 窗口内收到的下行, -1表示超时 */
+} radio;
+
+LoraConfigTypeDef loraConfig = {0};
+
+static void NS_OnUplink(const RadioPacketTypeDef *up);
+
+void LORA_Init(void)
+{
+    radio.inits++;
+    radio.mode = RADIO_RX;
+}
+
+void LORA_Wakeup(void)
+{
+    radio.mode = RADIO_STANDBY;
+}
+
+uint8_t LORA_ApplyConfig(const LoraConfigTypeDef *config)
+{
+    HOST_CHECK(radio.mode != RADIO_SLEEP, "configuration written while the radio sleeps");
+    radio.frequency = config->frequency;
+    radio.sf = config->sf;
+    radio.txDbm = config->txDbm;
+    return 0;
+}
+
+uint8_t LORA_Sleep(void)
+{
+    radio.mode = RADIO_SLEEP;
+    radio.rxCallback = NULL;
+    return 0;
+}
+
+void LORA_SetRxInvertIq(uint8_t invert)
+{
+    radio.invertIq = invert;
+}
+
+void LORA_GetPacketStatus(int16_t *rssi, int8_t *snr)
+{
+    *rssi = -95;
+    *snr = 6;
+}
+
+uint32_t LORA_Random(void)
+{
+    hostRandom = hostRandom * 1103515245U + 12345U;
+    return hostRandom >> 8;
+}
+
+LoraStateTypeDef LORA_GetState(void)
+{
+    return radio.rxCallback != NULL ? LORA_STATE_RX : LORA_STATE_IDLE;
+}
+
+uint8_t LORA_SendData(uint8_t *sendDataBuffer, uint16_t length)
+{
+    HOST_CHECK(radio.mode != RADIO_SLEEP, "transmit while the radio sleeps");
+    memcpy(radio.up.data, sendDataBuffer, length);
+    radio.up.length = (uint8_t)length;
+    radio.up.frequency = radio.frequency;
+    radio.up.sf = radio.sf;
+
+    hostMs += TEST_AIR_MS;
+    gpioB14Tick = HAL_GetTick();
+    radio.up.atMs = hostMs;
+    hostMs += TEST_TX_DONE_LAG_MS;
+    radio.mode = RADIO_STANDBY;
+
+    NS_OnUplink(&radio.up);
+    return 0;
+}
+
+uint8_t LORA_ReceiveAsync(uint32_t timeoutMs, LORA_RxCallbackTypeDef callback)
+{
+    RadioWindowTypeDef *window = &radio.windows[radio.windowNum < TEST_WINDOW_MAX ? radio.windowNum++ : 0];
+    uint8_t i;
+
+    /* 窗口前必须停在待机: 先进入接收模式再改配置会在错误的频率和IQ下接收 */
+    HOST_CHECK(radio.mode == RADIO_STANDBY, "receive window started in mode %d", radio.mode);
+
+    window->frequency = radio.frequency;
+    window->sf = radio.sf;
+    window->openMs = hostMs;
+    window->timeoutMs = timeoutMs;
+    window->received = 0;
+
+    radio.rxIndex = -1;
+    radio.rxEndMs = hostMs + timeoutMs;
+    for (i = 0; i < radio.downNum; i++)
+    {
+        RadioPacketTypeDef *down = &radio.down[i];
+
+        if (down->frequency == radio.frequency && down->sf == radio.sf && radio.invertIq &&
+            down->atMs >= hostMs && down->atMs <= hostMs + timeoutMs)
+        {
+            radio.rxIndex = (int8_t)i;
+            radio.rxEndMs = down->atMs + TEST_RX_AIR_MS;
+            window->received = 1;
+            break;
+        }
+    }
+
+    radio.mode = RADIO_RX;
+    radio.rxCallback = callback;
+    return 0;
+}
+
+void LORA_Process(void)
+{
+    static uint8_t buffer[LORAWAN_PHY_MAX];
+    LORA_RxCallbackTypeDef callback = radio.rxCallback;
+    uint8_t length;
+
+    if (callback == NULL || hostMs < radio.rxEndMs)
+    {
+        return;
+    }
+    radio.rxCallback = NULL;
+    radio.mode = RADIO_STANDBY;
+
+    if (radio.rxIndex < 0)
+    {
+        callback(NULL, 0);
+        return;
+    }
+    length = radio.down[radio.rxIndex].length;
+    memcpy(buffer, radio.down[radio.rxIndex].data, length);
+    radio.down[radio.rxIndex] = radio.down[--radio.downNum];
+    callback(buffer, length);
+}
+
+/* ===== 网络服务器替身 ===== */
+
+typedef struct
+{
+    uint8_t window;             /* 0 不应答；1 RX1；2 RX2 */
+    uint8_t corruptMic;         /* 1 表示篡改MIC */
+    /* 入网应答 */
+    uint8_t dlSettings;
+    uint8_t rxDelay;
+    /* 数据下行 */
+    uint8_t confirmed;
+    uint8_t ack;
+    uint8_t fopts[LORAWAN_FOPTS_MAX];
+    uint8_t foptsLen;
+    int16_t port;               /* -1 表示没有FRMPayload */
+    uint8_t payload[32];
+    uint8_t payloadLen;
+    int64_t fcnt;               /* -1 表示使用下一个下行帧计数 */
+} NsReplyTypeDef;
+
+static struct
+{
+    uint8_t appKey[AES_BLOCK_SIZE];
+    uint8_t nwkSKey[AES_BLOCK_SIZE];
+    uint8_t appSKey[AES_BLOCK_SIZE];
+    uint32_t appNonce;
+    uint32_t netId;
+    uint32_t devAddr;
+    uint16_t devNonce;
+    uint8_t joinMicOk;          /* 最近一次入网请求MIC正确 */
+    uint8_t rx1DrOffset;
+    uint8_t rx2Dr;
+    uint32_t rx2Frequency;
+    uint8_t rxDelay;
+    uint32_t fCntUpNext;        /* 下一个可接受的上行帧计数 */
+    uint32_t fCntDown;          /* 下一个下行帧计数 */
+    /* 最近一次数据上行 */
+    uint8_t upValid;            /* MIC正确 */
+    uint8_t upMhdr;
+    uint8_t upFCtrl;
+    uint32_t upFCnt;
+    uint8_t upFOpts[LORAWAN_FOPTS_MAX];
+    uint8_t upFOptsLen;
+    int16_t upPort;
+    uint8_t upData[LORAWAN_PHY_MAX];
+    uint8_t upLen;
+    uint32_t uplinks;
+    NsReplyTypeDef replies[TEST_REPLY_MAX];  /* 依次用于之后的上行 */
+    uint8_t replyNum;
+} ns;
+
+static uint8_t nsInvSbox[256];
+
+/**
+ * @brief GF(2^8)乘法
+ */
+static uint8_t NS_Mul(uint8_t a, uint8_t b)
+{
+    uint8_t r = 0;
+
+    while (b)
+    {
+        if (b & 1)
+        {
+            r ^= a;
+        }
+        a = AES_Xtime(a);
+        b >>= 1;
+    }
+    return r;
+}
+
+/**
+ * @brief AES-128解密一个分组, 服务器以此加密入网应答
+ */
+static void NS_AesDecrypt(const AesContextTypeDef *ctx, const uint8_t in[AES_BLOCK_SIZE], uint8_t out[AES_BLOCK_SIZE])
+{
+    uint8_t s[AES_BLOCK_SIZE];
+    uint8_t t[AES_BLOCK_SIZE];
+    int round;
+    int c;
+    int r;
+
+    for (c = 0; c < AES_BLOCK_SIZE; c++)
+    {
+        s[c] = in[c] ^ ctx->roundKey[AES_ROUNDS * AES_BLOCK_SIZE + c];
+    }
+    for (round = AES_ROUNDS - 1; round >= 0; round--)
+    {
+        /* InvShiftRows + InvSubBytes + AddRoundKey */
+        for (c = 0; c < 4; c++)
+        {
+            for (r = 0; r < 4; r++)
+            {
+                t[((c + r) % 4) * 4 + r] = s[c * 4 + r];
+            }
+        }
+        for (c = 0; c < AES_BLOCK_SIZE; c++)
+        {
+            s[c] = nsInvSbox[t[c]] ^ ctx->roundKey[round * AES_BLOCK_SIZE + c];
+        }
+        if (round == 0)
+        {
+            break;
+        }
+        for (c = 0; c < AES_BLOCK_SIZE; c += 4)
+        {
+            uint8_t a0 = s[c], a1 = s[c + 1], a2 = s[c + 2], a3 = s[c + 3];
+
+            s[c + 0] = NS_Mul(a0, 14) ^ NS_Mul(a1, 11) ^ NS_Mul(a2, 13) ^ NS_Mul(a3, 9);
+            s[c + 1] = NS_Mul(a0, 9) ^ NS_Mul(a1, 14) ^ NS_Mul(a2, 11) ^ NS_Mul(a3, 13);
+            s[c + 2] = NS_Mul(a0, 13) ^ NS_Mul(a1, 9) ^ NS_Mul(a2, 14) ^ NS_Mul(a3, 11);
+            s[c + 3] = NS_Mul(a0, 11) ^ NS_Mul(a1, 13) ^ NS_Mul(a2, 9) ^ NS_Mul(a3, 14);
+        }
+    }
+    memcpy(out, s, AES_BLOCK_SIZE);
+}
+
+static void NS_PutLe(uint8_t *p, uint32_t value, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+    {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t NS_GetLe(const uint8_t *p, int size)
+{
+    uint32_t value = 0;
+    int i;
+
+    for (i = 0; i < size; i++)
+    {
+        value |= (uint32_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+static void NS_Mic(const uint8_t *key, const uint8_t *data, uint16_t length, uint8_t mic[4])
+{
+    AesContextTypeDef ctx;
+    uint8_t mac[AES_BLOCK_SIZE];
+
+    AES_SetKey(&ctx, key);
+    AES_Cmac(&ctx, data, length, mac);
+    memcpy(mic, mac, 4);
+}
+
+/**
+ * @brief 数据帧MIC, B0 = 0x49 | 0^4 | Dir | DevAddr | FCnt(32) | 0 | len(msg)
+ */
+static void NS_DataMic(uint8_t dir, uint32_t fcnt, const uint8_t *msg, uint8_t length, uint8_t mic[4])
+{
+    uint8_t block[AES_BLOCK_SIZE + LORAWAN_PHY_MAX] = {0x49};
+
+    block[5] = dir;
+    NS_PutLe(block + 6, ns.devAddr, 4);
+    NS_PutLe(block + 10, fcnt, 4);
+    block[15] = length;
+    memcpy(block + AES_BLOCK_SIZE, msg, length);
+    NS_Mic(ns.nwkSKey, block, AES_BLOCK_SIZE + length, mic);
+}
+
+/**
+ * @brief FRMPayload加解密, Ai = 0x01 | 0^4 | Dir | DevAddr | FCnt(32) | 0 | i
+ */
+static void NS_Crypt(const uint8_t *key, uint8_t dir, uint32_t fcnt, uint8_t *data, uint8_t length)
+{
+    AesContextTypeDef ctx;
+    uint8_t a[AES_BLOCK_SIZE];
+    uint8_t s[AES_BLOCK_SIZE];
+    int i;
+
+    AES_SetKey(&ctx, key);
+    for (i = 0; i < length; i++)
+    {
+        if (i % AES_BLOCK_SIZE == 0)
+        {
+            memset(a, 0, sizeof(a));
+            a[0] = 0x01;
+            a[5] = dir;
+            NS_PutLe(a + 6, ns.devAddr, 4);
+            NS_PutLe(a + 10, fcnt, 4);
+            a[15] = (uint8_t)(i / AES_BLOCK_SIZE + 1);
+            AES_Encrypt(&ctx, a, s);
+        }
+        data[i] ^= s[i % AES_BLOCK_SIZE];
+    }
+}
+
+/**
+ * @brief 按区域规则计算应答窗口的频率和扩频因子, 把下行放入模拟信道
+ */
+static void NS_Schedule(const RadioPacketTypeDef *up, const NsReplyTypeDef *reply, uint8_t delayS,
+                        const uint8_t *frame, uint8_t length)
+{
+    RadioPacketTypeDef *down;
+    uint32_t channel = (up->frequency - LORAWAN_UP_FREQ_BASE) / LORAWAN_FREQ_STEP;
+    int dr = 12 - up->sf - ns.rx1DrOffset;
+
+    if (radio.downNum >= TEST_DOWN_MAX)
+    {
+        return;
+    }
+    down = &radio.down[radio.downNum++];
+    memcpy(down->data, frame, length);
+    down->length = length;
+    if (reply->window == 1)
+    {
+        down->frequency = LORAWAN_DOWN_FREQ_BASE + (channel % LORAWAN_DOWN_CHANNELS) * LORAWAN_FREQ_STEP;
+        down->sf = (uint8_t)(12 - (dr < LORAWAN_DR_MIN ? LORAWAN_DR_MIN : dr));
+        down->atMs = up->atMs + delayS * 1000U;
+    }
+    else
+    {
+        down->frequency = ns.rx2Frequency;
+        down->sf = (uint8_t)(12 - ns.rx2Dr);
+        down->atMs = up->atMs + (delayS + 1) * 1000U;
+    }
+}
+
+/**
+ * @brief 处理入网请求, 按应答脚本生成入网应答
+ */
+static void NS_OnJoinRequest(const RadioPacketTypeDef *up, const NsReplyTypeDef *reply)
+{
+    static const uint8_t devEui[8] = LORAWAN_DEV_EUI;
+    static const uint8_t joinEui[8] = LORAWAN_JOIN_EUI;
+    AesContextTypeDef ctx;
+    uint8_t frame[17];
+    uint8_t block[AES_BLOCK_SIZE] = {0};
+    uint8_t mic[4];
+    int i;
+
+    NS_Mic(ns.appKey, up->data, 19, mic);
+    ns.joinMicOk = up->length == 23 && memcmp(mic, up->data + 19, 4) == 0;
+    for (i = 0; i < 8; i++)
+    {
+        ns.joinMicOk &= up->data[1 + i] == joinEui[7 - i] && up->data[9 + i] == devEui[7 - i];
+    }
+    if (!ns.joinMicOk || reply->window == 0)
+    {
+        return;
+    }
+    ns.devNonce = (uint16_t)NS_GetLe(up->data + 17, 2);
+
+    /* JoinAccept = MHDR | AppNonce(3) | NetID(3) | DevAddr(4) | DLSettings | RxDelay | MIC */
+    frame[0] = LORAWAN_MHDR_JOIN_ACCEPT;
+    NS_PutLe(frame + 1, ns.appNonce, 3);
+    NS_PutLe(frame + 4, ns.netId, 3);
+    NS_PutLe(frame + 7, ns.devAddr, 4);
+    frame[11] = reply->dlSettings;
+    frame[12] = reply->rxDelay;
+    NS_Mic(ns.appKey, frame, 13, frame + 13);
+    if (reply->corruptMic)
+    {
+        frame[14] ^= 0x01;
+    }
+    AES_SetKey(&ctx, ns.appKey);
+    NS_AesDecrypt(&ctx, frame + 1, frame + 1);
+    NS_Schedule(up, reply, LORAWAN_JOIN_DELAY1_S, frame, sizeof(frame));
+
+    /* 会话密钥 = aes128_encrypt(AppKey, 0x01/0x02 | AppNonce | NetID | DevNonce | pad16) */
+    block[0] = 0x01;
+    NS_PutLe(block + 1, ns.appNonce, 3);
+    NS_PutLe(block + 4, ns.netId, 3);
+    NS_PutLe(block + 7, ns.devNonce, 2);
+    AES_Encrypt(&ctx, block, ns.nwkSKey);
+    block[0] = 0x02;
+    AES_Encrypt(&ctx, block, ns.appSKey);
+    if (!reply->corruptMic)
+    {
+        ns.rx1DrOffset = (reply->dlSettings >> 4) & 0x07;
+        ns.rx2Dr = reply->dlSettings & 0x0F;
+        ns.rxDelay = reply->rxDelay ? reply->rxDelay : 1;
+        ns.fCntUpNext = 0;
+        ns.fCntDown = 0;
+    }
+}
+
+/**
+ * @brief 校验数据上行并解密, 按应答脚本生成数据下行
+ */
+static void NS_OnData(const RadioPacketTypeDef *up, const NsReplyTypeDef *reply)
+{
+    uint8_t frame[LORAWAN_PHY_MAX];
+    uint8_t mic[4];
+    uint8_t len = 0;
+    uint8_t start;
+    uint32_t fcnt;
+
+    ns.upValid = 0;
+    ns.upMhdr = up->data[0];
+    ns.upFCtrl = up->data[5];
+    ns.upFOptsLen = ns.upFCtrl & 0x0F;
+    start = 8 + ns.upFOptsLen;
+    if (up->length < start + 4 || NS_GetLe(up->data + 1, 4) != ns.devAddr)
+    {
+        return;
+    }
+
+    fcnt = (ns.fCntUpNext & 0xFFFF0000U) | NS_GetLe(up->data + 6, 2);
+    if (fcnt < ns.fCntUpNext)
+    {
+        fcnt += 0x10000;
+    }
+    NS_DataMic(0, fcnt, up->data, up->length - 4, mic);
+    if (memcmp(mic, up->data + up->length - 4, 4) != 0)
+    {
+        return;
+    }
+    ns.upValid = 1;
+    ns.upFCnt = fcnt;
+    ns.fCntUpNext = fcnt + 1;
+    memcpy(ns.upFOpts, up->data + 8, ns.upFOptsLen);
+    ns.upPort = -1;
+    ns.upLen = 0;
+    if (start < up->length - 4)
+    {
+        ns.upPort = up->data[start];
+        ns.upLen = up->length - 4 - start - 1;
+        memcpy(ns.upData, up->data + start + 1, ns.upLen);
+        NS_Crypt(ns.upPort == 0 ? ns.nwkSKey : ns.appSKey, 0, fcnt, ns.upData, ns.upLen);
+    }
+
+    if (reply->window == 0)
+    {
+        return;
+    }
+    fcnt = reply->fcnt >= 0 ? (uint32_t)reply->fcnt : ns.fCntDown++;
+    frame[len++] = reply->confirmed ? LORAWAN_MHDR_CONFIRMED_DN : LORAWAN_MHDR_UNCONFIRMED_DN;
+    NS_PutLe(frame + len, ns.devAddr, 4);
+    len += 4;
+    frame[len++] = (reply->ack ? LORAWAN_FCTRL_ACK : 0) | reply->foptsLen;
+    NS_PutLe(frame + len, fcnt, 2);
+    len += 2;
+    memcpy(frame + len, reply->fopts, reply->foptsLen);
+    len += reply->foptsLen;
+    if (reply->port >= 0)
+    {
+        frame[len++] = (uint8_t)reply->port;
+        memcpy(frame + len, reply->payload, reply->payloadLen);
+        NS_Crypt(reply->port == 0 ? ns.nwkSKey : ns.appSKey, 1, fcnt, frame + len, reply->payloadLen);
+        len += reply->payloadLen;
+    }
+    NS_DataMic(1, fcnt, frame, len, frame + len);
+    if (reply->corruptMic)
+    {
+        frame[len] ^= 0x01;
+    }
+    len += 4;
+
+    NS_Schedule(up, reply, ns.rxDelay, frame, len);
+}
+
+static void NS_OnUplink(const RadioPacketTypeDef *up)
+{
+    NsReplyTypeDef reply = {0};
+
+    if (ns.replyNum > 0)
+    {
+        reply = ns.replies[0];
+        memmove(ns.replies, ns.replies + 1, --ns.replyNum * sizeof(NsReplyTypeDef));
+    }
+    ns.uplinks++;
+
+    if ((up->data[0] & LORAWAN_MTYPE_MASK) == LORAWAN_MHDR_JOIN_REQUEST)
+    {
+        NS_OnJoinRequest(up, &reply);
+    }
+    else
+    {
+        NS_OnData(up, &reply);
+    }
+}
+
+/**
+ * @brief 追加一条下行应答脚本, 返回以便填写
+ */
+static NsReplyTypeDef *NS_Reply(uint8_t window)
+{
+    NsReplyTypeDef *reply = &ns.replies[ns.replyNum++];
+
+    memset(reply, 0, sizeof(*reply));
+    reply->window = window;
+    reply->port = -1;
+    reply->fcnt = -1;
+    return reply;
+}
+
+/* ===== 测试 ===== */
+
+static void TEST_Hex(const char *hex, uint8_t *out)
+{
+    while (hex[0] && hex[1])
+    {
+        unsigned int byte;
+
+        sscanf(hex, "%2x", &byte);
+        *out++ = (uint8_t)byte;
+        hex += 2;
+    }
+}
+
+/**
+ * @brief 重置设备、射频和服务器到出厂状态
+ */
+static void TEST_Reset(void)
+{
+    static const uint8_t appKey[AES_BLOCK_SIZE] = LORAWAN_APP_KEY;
+
+    memset(hostBackup, 0, sizeof(hostBackup));
+    memset(&radio, 0, sizeof(radio));
+    memset(&ns, 0, sizeof(ns));
+    memset(&lorawanSession, 0, sizeof(lorawanSession));
+    radio.mode = RADIO_SLEEP;
+
+    memcpy(ns.appKey, appKey, AES_BLOCK_SIZE);
+    ns.appNonce = 0x5A3C01;
+    ns.netId = 0x000013;
+    ns.devAddr = 0x26011F3A;
+    ns.rx2Dr = LORAWAN_RX2_DR;
+    ns.rx2Frequency = LORAWAN_RX2_FREQUENCY;
+    ns.rxDelay = LORAWAN_RECEIVE_DELAY1_S;
+
+    LORAWAN_Init();
+}
+
+/**
+ * @brief 入网并确认会话可用, rx1DrOffset=0, RX2 DR3, RX1延时1秒
+ */
+static void TEST_Join(void)
+{
+    static const uint8_t data[2] = {0x00, 0x01};
+    NsReplyTypeDef *reply = NS_Reply(1);
+
+    reply->dlSettings = LORAWAN_RX2_DR;
+    reply->rxDelay = 1;
+    HOST_CHECK(LORAWAN_Send(LORAWAN_FPORT, data, sizeof(data), 0) == 0, "join and first uplink");
+    HOST_CHECK(lorawanSession.joined, "joined");
+}
+
+/**
+ * @brief 发送一个上行, 清除窗口记录
+ */
+static uint8_t TEST_Send(uint8_t confirmed)
+{
+    static const uint8_t data[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+
+    radio.windowNum = 0;
+    return LORAWAN_Send(LORAWAN_FPORT, data, sizeof(data), confirmed);
+}
+
+static void TEST_Aes(void)
+{
+    static const char *cmac[4] = {
+        "bb1d6929e95937287fa37d129b756746",
+        "070a16b46b4d4144f79bdd9dd04a287c",
+        "dfa66747de9ae63030ca32611497c827",
+        "51f0bebf7e3b9d92fc49741779363cfe",
+    };
+    static const uint16_t lengths[4] = {0, 16, 40, 64};
+    AesContextTypeDef ctx;
+    uint8_t key[16];
+    uint8_t msg[64];
+    uint8_t expect[16];
+    uint8_t out[16];
+    uint8_t back[16];
+    int i;
+
+    /* FIPS-197 附录C.1 */
+    TEST_Hex("000102030405060708090a0b0c0d0e0f", key);
+    TEST_Hex("00112233445566778899aabbccddeeff", msg);
+    TEST_Hex("69c4e0d86a7b0430d8cdb78070b4c55a", expect);
+    AES_SetKey(&ctx, key);
+    AES_Encrypt(&ctx, msg, out);
+    HOST_CHECK(memcmp(out, expect, 16) == 0, "FIPS-197 C.1 encrypt");
+    NS_AesDecrypt(&ctx, out, back);
+    HOST_CHECK(memcmp(back, msg, 16) == 0, "FIPS-197 C.1 decrypt");
+
+    /* RFC 4493 第4节 */
+    TEST_Hex("2b7e151628aed2a6abf7158809cf4f3c", key);
+    TEST_Hex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+             "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710", msg);
+    AES_SetKey(&ctx, key);
+    for (i = 0; i < 4; i++)
+    {
+        TEST_Hex(cmac[i], expect);
+        AES_Cmac(&ctx, msg, lengths[i], out);
+        HOST_CHECK(memcmp(out, expect, 16) == 0, "RFC 4493 example %d (len %u)", i + 1, lengths[i]);
+    }
+}
+
+static void TEST_JoinAccept(void)
+{
+    uint64_t txDone;
+    uint16_t devNonce;
+    NsReplyTypeDef *reply;
+
+    TEST_Reset();
+
+    /* MIC错误的入网应答在RX1被丢弃, 随后RX2也没有应答 */
+    reply = NS_Reply(1);
+    reply->corruptMic = 1;
+    HOST_CHECK(TEST_Send(0) == 1, "join with corrupted join-accept fails");
+    HOST_CHECK(ns.joinMicOk, "join-request MIC");
+    HOST_CHECK(!lorawanSession.joined, "corrupted join-accept rejected");
+    HOST_CHECK(radio.windowNum == 2, "RX1 and RX2 opened, got %u", radio.windowNum);
+    txDone = radio.up.atMs;
+    HOST_CHECK(radio.windows[0].openMs == txDone + LORAWAN_JOIN_DELAY1_S * 1000 - LORAWAN_RX_ERROR_MS,
+               "RX1 opens %lld ms after TX done", (long long)(radio.windows[0].openMs - txDone));
+    HOST_CHECK(radio.windows[1].openMs == txDone + (LORAWAN_JOIN_DELAY1_S + 1) * 1000 - LORAWAN_RX_ERROR_MS,
+               "RX2 opens %lld ms after TX done", (long long)(radio.windows[1].openMs - txDone));
+    HOST_CHECK(radio.windows[0].frequency == LORAWAN_DOWN_FREQ_BASE +
+               ((radio.up.frequency - LORAWAN_UP_FREQ_BASE) / LORAWAN_FREQ_STEP % LORAWAN_DOWN_CHANNELS) * LORAWAN_FREQ_STEP,
+               "RX1 frequency %u", radio.windows[0].frequency);
+    HOST_CHECK(radio.windows[1].frequency == LORAWAN_RX2_FREQUENCY && radio.windows[1].sf == 12 - LORAWAN_RX2_DR,
+               "RX2 at %u SF%u", radio.windows[1].frequency, radio.windows[1].sf);
+    HOST_CHECK(radio.mode == RADIO_SLEEP, "radio sleeps after the windows");
+
+    /* 有效入网应答在RX2: rx1DrOffset=1, RX2 DR4, RX1延时2秒 */
+    devNonce = lorawanSession.devNonce;
+    reply = NS_Reply(2);
+    reply->dlSettings = 0x14;
+    reply->rxDelay = 2;
+    HOST_CHECK(TEST_Send(0) == 0, "join in RX2 and uplink");
+    HOST_CHECK(lorawanSession.devNonce == devNonce + 1, "DevNonce increments");
+    HOST_CHECK(lorawanSession.joined, "joined");
+    HOST_CHECK(lorawanSession.devAddr == ns.devAddr, "DevAddr %08X", lorawanSession.devAddr);
+    HOST_CHECK(memcmp(lorawanSession.nwkSKey, ns.nwkSKey, AES_BLOCK_SIZE) == 0, "NwkSKey derivation");
+    HOST_CHECK(memcmp(lorawanSession.appSKey, ns.appSKey, AES_BLOCK_SIZE) == 0, "AppSKey derivation");
+    HOST_CHECK(lorawanSession.rx1DrOffset == 1 && lorawanSession.rx2Dr == 4 && lorawanSession.rxDelay == 2,
+               "DLSettings/RxDelay applied: offset %u, RX2 DR%u, delay %u",
+               lorawanSession.rx1DrOffset, lorawanSession.rx2Dr, lorawanSession.rxDelay);
+    HOST_CHECK(ns.upValid && ns.upFCnt == 0, "first data uplink verified by the server");
+    HOST_CHECK(ns.upPort == LORAWAN_FPORT && ns.upLen == 4 && ns.upData[0] == 0xDE && ns.upData[3] == 0xEF,
+               "uplink payload decrypts");
+    HOST_CHECK(lorawanSession.fCntUp == 1 && hostBackup[PWR_BKP_LORAWAN_FCNT] == (LORAWAN_FCNT_VALID | 1),
+               "FCntUp saved to the backup register");
+    HOST_CHECK(radio.inits == 0, "LORA_Init() (receive mode) never used, %u calls", radio.inits);
+}
+
+static void TEST_Windows(void)
+{
+    NsReplyTypeDef *reply;
+    uint64_t txDone;
+
+    TEST_Reset();
+    TEST_Join();
+
+    /* 无应答: RX1/RX2按rxDelay打开, RX1速率不低于DR_MIN */
+    HOST_CHECK(TEST_Send(0) == 0, "unconfirmed uplink");
+    txDone = radio.up.atMs;
+    HOST_CHECK(radio.windowNum == 2, "both windows opened");
+    HOST_CHECK(radio.windows[0].openMs == txDone + 1000 - LORAWAN_RX_ERROR_MS, "RX1 timing");
+    HOST_CHECK(radio.windows[1].openMs == txDone + 2000 - LORAWAN_RX_ERROR_MS, "RX2 timing");
+    HOST_CHECK(radio.windows[0].sf == radio.up.sf, "RX1 SF%u follows uplink SF%u", radio.windows[0].sf, radio.up.sf);
+    HOST_CHECK(radio.windows[0].timeoutMs >= LORAWAN_RX_SYMBOLS * (1U << radio.windows[0].sf) / 125,
+               "RX1 covers %u preamble symbols", LORAWAN_RX_SYMBOLS);
+    HOST_CHECK(radio.invertIq == LLCC68_LORA_DEFAULT_INVERT_IQ, "IQ polarity restored");
+
+    /* 确认型上行: RX1收到ACK后不再打开RX2 */
+    reply = NS_Reply(1);
+    reply->ack = 1;
+    HOST_CHECK(TEST_Send(1) == 0, "confirmed uplink acknowledged");
+    HOST_CHECK(radio.windowNum == 1 && radio.windows[0].received, "ACK received in RX1 only");
+
+    /* 确认型上行无应答 */
+    HOST_CHECK(TEST_Send(1) == 1, "confirmed uplink without ACK fails");
+
+    /* ACK在RX2 */
+    reply = NS_Reply(2);
+    reply->ack = 1;
+    HOST_CHECK(TEST_Send(1) == 0, "ACK in RX2");
+    HOST_CHECK(radio.windowNum == 2 && radio.windows[1].received, "RX2 received");
+
+    /* MIC错误的下行被丢弃 */
+    reply = NS_Reply(1);
+    reply->ack = 1;
+    reply->corruptMic = 1;
+    HOST_CHECK(TEST_Send(1) == 1, "downlink with bad MIC ignored");
+
+    /* 确认型下行: 下一个上行置位ACK, 再下一个清除 */
+    reply = NS_Reply(1);
+    reply->confirmed = 1;
+    reply->port = 10;
+    reply->payloadLen = 3;
+    HOST_CHECK(TEST_Send(0) == 0, "confirmed downlink");
+    HOST_CHECK(lorawanSession.ackDown == 1, "ackDown pending");
+    TEST_Send(0);
+    HOST_CHECK(ns.upValid && (ns.upFCtrl & LORAWAN_FCTRL_ACK), "next uplink carries ACK");
+    TEST_Send(0);
+    HOST_CHECK(ns.upValid && !(ns.upFCtrl & LORAWAN_FCTRL_ACK), "ACK sent once");
+    HOST_CHECK(radio.inits == 0, "LORA_Init() never used");
+}
+
+static void TEST_FCnt(void)
+{
+    NsReplyTypeDef *reply;
+
+    TEST_Reset();
+    TEST_Join();
+
+    /* 上行帧计数跨16位: 帧中只有低16位, MIC使用完整的32位 */
+    lorawanSession.fCntUp = 0xFFFF;
+    ns.fCntUpNext = 0xFFFF;
+    TEST_Send(0);
+    HOST_CHECK(ns.upValid && ns.upFCnt == 0xFFFF, "FCntUp 0xFFFF, server got %X", ns.upFCnt);
+    TEST_Send(0);
+    HOST_CHECK(radio.up.data[6] == 0 && radio.up.data[7] == 0, "16-bit FCnt wraps in the frame");
+    HOST_CHECK(ns.upValid && ns.upFCnt == 0x10000, "FCntUp 0x10000 MIC, server got %X", ns.upFCnt);
+    HOST_CHECK(lorawanSession.fCntUp == 0x10001, "FCntUp %X", lorawanSession.fCntUp);
+
+    /* 下行帧计数跨16位 */
+    lorawanSession.fCntDown = 0xFFFF;
+    ns.fCntDown = 0xFFFF;
+    reply = NS_Reply(1);
+    reply->ack = 1;
+    HOST_CHECK(TEST_Send(1) == 0, "downlink FCnt 0xFFFF accepted");
+    reply = NS_Reply(1);
+    reply->ack = 1;
+    HOST_CHECK(TEST_Send(1) == 0, "downlink FCnt 0x10000 accepted");
+    HOST_CHECK(lorawanSession.fCntDown == 0x10001, "FCntDown %X", lorawanSession.fCntDown);
+
+    /* 重放已接受的下行帧计数 */
+    reply = NS_Reply(1);
+    reply->ack = 1;
+    reply->fcnt = 0x10000;
+    HOST_CHECK(TEST_Send(1) == 1, "replayed downlink rejected");
+    HOST_CHECK(lorawanSession.fCntDown == 0x10001, "FCntDown unchanged by replay");
+
+    /* STANDBY前未保存: 以备份寄存器为准 */
+    lorawanSession.fCntUp = 100;
+    hostBackup[PWR_BKP_LORAWAN_FCNT] = LORAWAN_FCNT_VALID | 105;
+    LORAWAN_Init();
+    HOST_CHECK(lorawanSession.fCntUp == 105, "FCntUp caught up from backup register: %u", lorawanSession.fCntUp);
+
+    /* 备份域丢失: 跳过一段 */
+    hostBackup[PWR_BKP_LORAWAN_FCNT] = 0;
+    LORAWAN_Init();
+    HOST_CHECK(lorawanSession.fCntUp == 105 + LORAWAN_FCNT_GAP, "FCntUp skips gap: %u", lorawanSession.fCntUp);
+}
+
+static void TEST_LinkAdr(void)
+{
+    NsReplyTypeDef *reply;
+    uint32_t channel;
+
+    TEST_Reset();
+    TEST_Join();
+
+    /* DR5, TXPower 3, ChMask 0x00F0(信道4~7), ChMaskCntl 0, NbTrans 1 */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x03\x53\xF0\x00\x01", 5);
+    TEST_Send(0);
+    HOST_CHECK(lorawanSession.dataRate == 5 && lorawanSession.txPower == 3 && lorawanSession.chMask[0] == 0x00F0,
+               "LinkADRReq applied: DR%u TXPower %u mask %04X",
+               lorawanSession.dataRate, lorawanSession.txPower, lorawanSession.chMask[0]);
+    TEST_Send(0);
+    HOST_CHECK(ns.upValid && ns.upFOptsLen == 2 && ns.upFOpts[0] == 0x03 && ns.upFOpts[1] == 0x07,
+               "LinkADRAns all accepted");
+    channel = (radio.up.frequency - LORAWAN_UP_FREQ_BASE) / LORAWAN_FREQ_STEP;
+    HOST_CHECK(channel >= 4 && channel <= 7, "uplink on enabled channel, got %u", channel);
+    HOST_CHECK(radio.up.sf == 7 && radio.txDbm == LORAWAN_MAX_EIRP_DBM - 6, "uplink SF%u %ddBm",
+               radio.up.sf, radio.txDbm);
+
+    /* DR2不支持: 整条命令不生效 */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x03\x21\xFF\x00\x01", 5);
+    TEST_Send(0);
+    TEST_Send(0);
+    HOST_CHECK(ns.upFOptsLen == 2 && ns.upFOpts[1] == 0x05, "LinkADRAns DR NACK, status %02X", ns.upFOpts[1]);
+    HOST_CHECK(lorawanSession.dataRate == 5 && lorawanSession.txPower == 3 && lorawanSession.chMask[0] == 0x00F0,
+               "rejected LinkADRReq not applied");
+
+    /* 全部信道关闭 */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x03\xFF\x00\x00\x01", 5);
+    TEST_Send(0);
+    TEST_Send(0);
+    HOST_CHECK(ns.upFOpts[1] == 0x06, "LinkADRAns ChMask NACK, status %02X", ns.upFOpts[1]);
+
+    /* 端口0的FRMPayload(NwkSKey加密)中的LinkADRReq: DR4, 保持功率 */
+    reply = NS_Reply(1);
+    reply->port = 0;
+    reply->payloadLen = 5;
+    memcpy(reply->payload, "\x03\x4F\xF0\x00\x01", 5);
+    TEST_Send(0);
+    HOST_CHECK(lorawanSession.dataRate == 4 && lorawanSession.txPower == 3, "port 0 LinkADRReq applied");
+    TEST_Send(0);
+    HOST_CHECK(ns.upFOpts[0] == 0x03 && ns.upFOpts[1] == 0x07, "port 0 LinkADRAns");
+}
+
+static void TEST_RxParamSetup(void)
+{
+    NsReplyTypeDef *reply;
+
+    TEST_Reset();
+    TEST_Join();
+
+    /* RX1DROffset 2, RX2 DR4, RX2 501.3MHz */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x05\x24\x08\x7E\x4C", 5);
+    TEST_Send(0);
+    HOST_CHECK(lorawanSession.rx1DrOffset == 2 && lorawanSession.rx2Dr == 4 && lorawanSession.rx2Frequency == 501300000,
+               "RXParamSetupReq applied: offset %u, DR%u, %u Hz",
+               lorawanSession.rx1DrOffset, lorawanSession.rx2Dr, lorawanSession.rx2Frequency);
+
+    /* 服务器收到应答后按新参数在RX2下发 */
+    ns.rx1DrOffset = 2;
+    ns.rx2Dr = 4;
+    ns.rx2Frequency = 501300000;
+    reply = NS_Reply(2);
+    reply->ack = 1;
+    HOST_CHECK(TEST_Send(1) == 0, "ACK received with new RX2 parameters");
+    HOST_CHECK(ns.upFOptsLen == 2 && ns.upFOpts[0] == 0x05 && ns.upFOpts[1] == 0x07, "RXParamSetupAns accepted");
+    HOST_CHECK(radio.windows[1].frequency == 501300000 && radio.windows[1].sf == 8 && radio.windows[1].received,
+               "RX2 at %u SF%u", radio.windows[1].frequency, radio.windows[1].sf);
+
+    /* 频率不在下行频段 */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x05\x03\x60\xB7\x47", 5);
+    TEST_Send(0);
+    TEST_Send(0);
+    HOST_CHECK(ns.upFOpts[0] == 0x05 && ns.upFOpts[1] == 0x06, "frequency NACK, status %02X", ns.upFOpts[1]);
+    HOST_CHECK(lorawanSession.rx2Frequency == 501300000 && lorawanSession.rx2Dr == 4, "rejected RXParamSetupReq not applied");
+
+    /* RX2速率不支持 */
+    reply = NS_Reply(1);
+    reply->foptsLen = 5;
+    memcpy(reply->fopts, "\x05\x02\x08\x7E\x4C", 5);
+    TEST_Send(0);
+    TEST_Send(0);
+    HOST_CHECK(ns.upFOpts[1] == 0x05, "RX2 DR NACK, status %02X", ns.upFOpts[1]);
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    hostVerbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    for (i = 0; i < 256; i++)
+    {
+        nsInvSbox[aesSbox[i]] = (uint8_t)i;
+    }
+
+    TEST_Aes();
+    TEST_JoinAccept();
+    TEST_Windows();
+    TEST_FCnt();
+    TEST_LinkAdr();
+    TEST_RxParamSetup();
+    return HOST_Report("lorawan_test");
+}
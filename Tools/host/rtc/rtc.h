@@ -0,0 +1,2 @@
+/* 替身: 固件头文件 rtc/rtc.h 在PC上由 host.h 代替 */
+#include "host.h"
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+二进制日志解码
+
+调试串口在 LOG_BINARY 下输出二进制日志帧(格式见 System/Log/log.h), 与 printf 的文本交错:
+    0xA5, 负载长度N, 负载[N], 负载字节和
+    负载 = tick(4) + 格式字符串地址(4) + __FILE__地址(4) + __LINE__(2) + 参数
+本脚本在编译生成的ELF(.axf)中按地址取出格式字符串和文件名, 按格式字符串解析参数并还原为
+与 printf 模式相同的 "[文件名, 行号] 文本"; 帧以外的字节原样输出。固件与ELF需为同一次编译。
+输出可继续交给 profile_report.py、transport_tune.py 等脚本。
+
+用法:
+    python3 log_decode.py Project/eide/build/Target/LocationProject.axf capture.bin
+    python3 log_decode.py LocationProject.axf --port /dev/ttyUSB0 --baud 115200 --time
+    cat capture.bin | python3 log_decode.py LocationProject.axf
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5       # LOG_FRAME_SYNC
+HEADER_LEN = 14         # LOG_HEADER_LEN
+TRUNCATED = 0x8000      # LOG_TRUNCATED
+
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?([hlLzjt]*)([diuxXocpfFeEgGaAs%])")
+
+
+class Elf:
+    """只读取ELF32小端文件中已分配的节, 用于按地址取字符串"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("不是ELF32小端文件: %s" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if flags & 0x2 and sh_type != 8 and size:     # SHF_ALLOC, 非SHT_NOBITS
+                self.sections.append((addr, size, data[offset:offset + size]))
+        self.cache = {}
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        for base, size, blob in self.sections:
+            if base <= addr < base + size:
+                end = blob.find(b"\0", addr - base)
+                text = blob[addr - base:end if end >= 0 else size].decode("utf-8", errors="replace")
+                self.cache[addr] = text
+                return text
+        return None
+
+
+def format_record(fmt, args):
+    """按格式字符串从参数字节中取值并格式化, 参数不足时以<?>代替"""
+    out = []
+    pos = 0
+    last = 0
+
+    def take(size):
+        nonlocal pos
+        if pos + size > len(args):
+            raise IndexError
+        value = args[pos:pos + size]
+        pos += size
+        return value
+
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        try:
+            if width == "*":
+                width = str(struct.unpack("<i", take(4))[0])
+            if prec == "*":
+                prec = str(struct.unpack("<i", take(4))[0])
+            spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+            if conv in "diuxXoc":
+                wide = length.count("l") >= 2
+                raw = take(8 if wide else 4)
+                signed = conv in "di"
+                value = struct.unpack("<" + ("q" if signed else "Q") if wide else "<" + ("i" if signed else "I"), raw)[0]
+                if conv == "c":
+                    out.append((spec + "c") % chr(value & 0xFF))
+                else:
+                    out.append((spec + ("d" if conv in "iu" else conv)) % value)
+            elif conv == "p":
+                out.append("0x%08x" % struct.unpack("<I", take(4))[0])
+            elif conv == "s":
+                field = struct.unpack("<H", take(2))[0]
+                text = take(field & ~TRUNCATED).decode("utf-8", errors="replace")
+                out.append((spec + "s") % (text + ("..." if field & TRUNCATED else "")))
+            else:
+                out.append((spec + (conv if conv not in "aA" else "e")) % struct.unpack("<d", take(8))[0])
+        except (IndexError, struct.error):
+            out.append("<?>")
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode(stream, elf, show_time, write):
+    """从字节流中解析日志帧, 帧以外的字节原样输出"""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            write(buf.decode("utf-8", errors="replace"))    # 结尾不完整的帧按文本输出
+            break
+        buf += chunk
+        i = 0
+        while i < len(buf):
+            if buf[i] != FRAME_SYNC:
+                j = buf.find(bytes([FRAME_SYNC]), i)
+                j = len(buf) if j < 0 else j
+                write(buf[i:j].decode("utf-8", errors="replace"))
+                i = j
+                continue
+            if i + 2 > len(buf) or i + 3 + buf[i + 1] > len(buf):
+                break   # 帧不完整, 等待更多数据
+            n = buf[i + 1]
+            payload = bytes(buf[i + 2:i + 2 + n])
+            if n < HEADER_LEN or sum(payload) & 0xFF != buf[i + 2 + n]:
+                write(chr(buf[i]))  # 不是有效帧, 按文本输出同步字节
+                i += 1
+                continue
+            tick, fmt_addr, file_addr, line = struct.unpack_from("<IIIH", payload)
+            fmt = elf.string(fmt_addr)
+            path = elf.string(file_addr) or "?"
+            name = re.split(r"[\\/]", path)[-1]
+            text = format_record(fmt, payload[HEADER_LEN:]) if fmt is not None else "<fmt 0x%08x>\r\n" % fmt_addr
+            write(("%10.3f " % (tick / 1000.0) if show_time else "") + "[%s, %d] %s" % (name, line, text))
+            i += 3 + n
+        del buf[:i]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="二进制日志解码")
+    parser.add_argument("elf", help="编译生成的ELF文件(.axf)")
+    parser.add_argument("log", nargs="?", help="串口原始数据文件, 缺省读取标准输入")
+    parser.add_argument("--port", help="直接从串口读取(需要pyserial)")
+    parser.add_argument("--baud", type=int, default=115200, help="串口波特率, 默认115200")
+    parser.add_argument("--time", action="store_true", help="在每条日志前输出设备时间戳(秒)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+
+    def write(text):
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud) as port:
+            class Reader:
+                def read(self, size):
+                    data = port.read(1)     # 阻塞到有数据
+                    return data + port.read(min(port.in_waiting, size - 1))
+            decode(Reader(), elf, args.time, write)
+    elif args.log:
+        with open(args.log, "rb") as f:
+            decode(f, elf, args.time, write)
+    else:
+        decode(sys.stdin.buffer, elf, args.time, write)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
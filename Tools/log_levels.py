@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+日志级别编译报告
+
+按 User/user_config.h 中的 LOG_LEVEL_* 阈值和各源文件开头的 LOG_MODULE_LEVEL, 统计工程中
+DEBUG_Error/Warn/Info/Trace(DEBUG_Printf 同 Info) 调用在编译期保留和去除的数量,
+估算去除的调用节省的Flash(格式字符串 + 调用代码)和每次执行节省的CPU周期。
+源文件列表取自 EIDE 工程(Project/eide/.eide/eide.json), 作为编译后任务运行:
+    python3 log_levels.py
+    python3 log_levels.py --verbose     # 同时列出每个被去除的调用
+
+代码大小和周期数是按-O0编译的经验估计值, 准确数值以编译生成的map文件为准。
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+LEVELS = ["NONE", "ERROR", "WARN", "INFO", "TRACE"]
+CALLS = {"Error": 1, "Warn": 2, "Info": 3, "Trace": 4, "Printf": 3}
+
+# -O0 下单个调用的估计值
+CALL_BYTES = 24         # 运行时掩码判断 + 调用 + 字面量池中的字符串地址
+ARG_BYTES = 6           # 每个参数的装载和压栈
+FILENAME_BYTES = 48     # printf模式下 __FILENAME__ 的strrchr调用
+BINARY_CYCLES = 400     # LOG_Write: 扫描格式字符串、编码、校验和、写入环形缓冲区
+BINARY_ARG_CYCLES = 60
+TEXT_CYCLES = 1500      # printf格式化和文件名前缀
+UART_CYCLES = 6250      # 72MHz下115200波特率发送一个字节, printf模式逐字符等待串口
+TEXT_PREFIX = 20        # "[文件名, 行号] " 的平均长度
+
+CALL = re.compile(r"\bDEBUG_(Error|Warn|Info|Trace|Printf)\s*\(")
+MODULE = re.compile(r"^\s*#define\s+LOG_MODULE_LEVEL\s+(\w+)", re.M)
+DEFINE = re.compile(r"^\s*#define\s+(\w+)(?:[ \t]+([^/\r\n]*?))?\s*(?:/[/*].*)?$", re.M)
+
+
+def strip_comments(text):
+    """去除注释, 保留字符串和行号"""
+    return re.sub(r"//[^\n]*|/\*.*?\*/|\"(?:\\.|[^\"\\])*\"|'(?:\\.|[^'\\])*'",
+                  lambda m: m.group(0) if m.group(0)[0] in "\"'" else re.sub(r"[^\n]", " ", m.group(0)),
+                  text, flags=re.S)
+
+
+def parse_config(path):
+    """读取 user_config.h 中的宏定义(只取无条件部分的最后一次定义)"""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = strip_comments(f.read())
+    return {m.group(1): (m.group(2) or "").strip() for m in DEFINE.finditer(text)}
+
+
+def resolve_level(name, config):
+    """把阈值宏展开为级别数字"""
+    seen = set()
+    while name not in seen:
+        seen.add(name)
+        if name.isdigit():
+            return int(name)
+        if name.startswith("LOG_LEVEL_") and name[10:] in LEVELS and name not in config:
+            return LEVELS.index(name[10:])
+        name = config.get(name, "")
+    raise ValueError("无法解析日志阈值: %s" % name)
+
+
+def source_files(root):
+    with open(os.path.join(root, "Project", "eide", ".eide", "eide.json"), encoding="utf-8") as f:
+        project = json.load(f)
+    files = []
+
+    def walk(folder):
+        for item in folder["files"]:
+            path = item["path"].replace("../../", "")
+            if path.endswith(".c") and "HAL_Driver" not in path:
+                files.append(path)
+        for sub in folder["folders"]:
+            walk(sub)
+
+    walk(project["virtualFolder"])
+    return files
+
+
+def find_file(root, path):
+    """EIDE工程在Windows下编辑, 路径大小写可能与磁盘不一致"""
+    full = os.path.join(root, path)
+    if os.path.exists(full):
+        return full
+    current = root
+    for part in path.split("/"):
+        names = {n.lower(): n for n in os.listdir(current)}
+        if part.lower() not in names:
+            return None
+        current = os.path.join(current, names[part.lower()])
+    return current
+
+
+def parse_call(text, start):
+    """从左括号之后解析一次调用, 返回(格式字符串字节数, 参数个数)"""
+    depth = 1
+    args = 0
+    fmt = b""
+    in_fmt = True
+    i = start
+    while i < len(text) and depth:
+        c = text[i]
+        if c == '"':
+            j = i + 1
+            while text[j] != '"':
+                j += 2 if text[j] == "\\" else 1
+            if in_fmt and depth == 1:
+                fmt += text[i + 1:j].encode("utf-8").decode("unicode_escape").encode("latin-1")
+            i = j
+        elif c == "'":
+            i = text.index("'", i + 2 if text[i + 1] == "\\" else i + 1)
+        elif c in "([{":
+            depth += 1
+        elif c in ")]}":
+            depth -= 1
+        elif c == "," and depth == 1:
+            args += 1
+            in_fmt = False
+        i += 1
+    return len(fmt), args
+
+
+def main():
+    parser = argparse.ArgumentParser(description="日志级别编译报告")
+    parser.add_argument("--root", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."),
+                        help="工程根目录, 默认为本脚本的上一级目录")
+    parser.add_argument("--verbose", action="store_true", help="列出每个被去除的调用")
+    args = parser.parse_args()
+
+    root = os.path.abspath(args.root)
+    config = parse_config(os.path.join(root, "User", "user_config.h"))
+    enabled = "DEBUG_ENABLE" in config
+    binary = "LOG_BINARY" in config
+    mask = int(config.get("LOG_DEFAULT_MASK", "0x1E"), 0)
+
+    modules = {}
+    removed = []
+    for path in source_files(root):
+        full = find_file(root, path)
+        if full is None:
+            continue
+        with open(full, "rb") as f:
+            raw = f.read()
+        try:
+            text = strip_comments(raw.decode("utf-8"))
+        except UnicodeDecodeError:
+            text = strip_comments(raw.decode("gbk", errors="replace"))
+        if not CALL.search(text):
+            continue
+
+        m = MODULE.search(text)
+        name = m.group(1) if m else "LOG_LEVEL_DEFAULT"
+        threshold = resolve_level(name, config) if enabled else 0
+        stats = modules.setdefault(name, {"threshold": threshold, "kept": [0] * 5, "removed": [0] * 5,
+                                          "masked": 0})
+        for call in CALL.finditer(text):
+            level = CALLS[call.group(1)]
+            fmt_len, nargs = parse_call(text, call.end())
+            if level <= threshold:
+                stats["kept"][level] += 1
+                stats["masked"] += not (mask >> level) & 1
+                continue
+            stats["removed"][level] += 1
+            string = fmt_len + 1 + (0 if binary else 9)     # printf模式拼接"[%s, %d] "前缀
+            string = (string + 3) & ~3
+            if binary:
+                code = CALL_BYTES + ARG_BYTES * (nargs + 3)     # 另有 __FILE__、__LINE__、格式字符串
+                cycles = BINARY_CYCLES + BINARY_ARG_CYCLES * nargs
+            else:
+                code = CALL_BYTES + ARG_BYTES * (nargs + 2) + FILENAME_BYTES
+                cycles = TEXT_CYCLES + UART_CYCLES * (fmt_len + TEXT_PREFIX)
+            line = text.count("\n", 0, call.start()) + 1
+            removed.append((name, path, line, LEVELS[level], string, code, cycles))
+
+    print("日志级别报告: %s, %s, 运行时缺省掩码 0x%02X" % (
+        "调试输出已使能" if enabled else "DEBUG_ENABLE 未定义, 全部调用已去除",
+        "二进制日志" if binary else "printf文本", mask))
+    print("%-20s %-6s %16s %16s %8s" % ("模块阈值", "级别", "保留 E/W/I/T", "去除 E/W/I/T", "运行屏蔽"))
+    for name in sorted(modules):
+        stats = modules[name]
+        print("%-20s %-6s %16s %16s %8d" % (
+            name, LEVELS[stats["threshold"]],
+            "/".join(str(n) for n in stats["kept"][1:]),
+            "/".join(str(n) for n in stats["removed"][1:]), stats["masked"]))
+
+    if args.verbose and removed:
+        print("\n去除的调用:")
+        for name, path, line, level, string, code, cycles in removed:
+            print("  %s:%d %s (%d+%d 字节, 约%d 周期/次)" % (path, line, level, string, code, cycles))
+
+    strings = sum(r[4] for r in removed)
+    code = sum(r[5] for r in removed)
+    cycles = sum(r[6] for r in removed)
+    print("\n去除 %d 个调用, 估计节省Flash %d 字节(格式字符串 %d + 代码 %d), 每个调用点各执行一次节省约 %d 周期(%.2f ms@72MHz)" % (
+        len(removed), strings + code, strings, code, cycles, cycles / 72000.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
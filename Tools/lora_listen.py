@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+LoRa低功耗监听电流估算
+
+按固件中的监听档位(lora.h LoraListenProfileTypeDef)计算 RX duty cycle 的接收窗口、
+发送方所需前导码长度、最坏接收延迟和平均接收电流, 并给出加长前导码带来的每包发送代价。
+计算方式与 LORA_GetPreambleLength()/LORA_StartListen() 一致:
+    符号时间   Tsym = 2^SF / BW
+    接收窗口   rx = LORA_SNIFF_RX_SYMBOLS * Tsym
+    前导码     ceil((2 * rx + sleep) / Tsym) + LORA_SNIFF_PREAMBLE_MARGIN, 不少于默认12
+    平均电流   (I_rx * (rx + wake) + I_sleep * sleep) / (rx + wake + sleep)
+
+用法:
+    python3 lora_listen.py
+    python3 lora_listen.py --sf 7 --bw 250 --sleep 100 --sleep 500 --sleep 2000
+    python3 lora_listen.py --rx-ma 4.6 --sleep-ua 1.2 --tx-ma 90 --packets 24
+"""
+
+import argparse
+import math
+import sys
+
+# 与固件保持一致
+RX_SYMBOLS = 8          # LORA_SNIFF_RX_SYMBOLS
+PREAMBLE_MARGIN = 4     # LORA_SNIFF_PREAMBLE_MARGIN
+DEFAULT_PREAMBLE = 12   # LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH
+PROFILES = [("continuous", 0), ("balanced", 100), ("low_power", 1000)]
+
+
+def preamble_symbols(tsym_ms, rx_ms, sleep_ms):
+    if sleep_ms == 0:
+        return DEFAULT_PREAMBLE
+    length = math.ceil((2 * rx_ms + sleep_ms) / tsym_ms) + PREAMBLE_MARGIN
+    return min(max(length, DEFAULT_PREAMBLE), 0xFFFF)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LoRa低功耗监听电流估算")
+    parser.add_argument("--sf", type=int, default=9, help="扩频因子, 默认9")
+    parser.add_argument("--bw", type=int, default=125, choices=[125, 250, 500], help="带宽(kHz), 默认125")
+    parser.add_argument("--sleep", type=int, action="append", metavar="MS", help="附加计算的睡眠时间(ms), 可重复")
+    parser.add_argument("--rx-ma", type=float, default=4.6, help="接收电流(mA), 默认4.6(DC-DC)")
+    parser.add_argument("--sleep-ua", type=float, default=1.2, help="duty cycle睡眠电流(uA, 含RC64k), 默认1.2")
+    parser.add_argument("--wake-ms", type=float, default=0.5, help="每次睡眠到接收的启动时间(ms), 默认0.5")
+    parser.add_argument("--tx-ma", type=float, default=90.0, help="发送电流(mA), 默认90(+17dBm)")
+    parser.add_argument("--packets", type=float, default=24, help="每天发送的数据包数, 用于折算前导码代价")
+    args = parser.parse_args()
+
+    tsym_ms = (2 ** args.sf) / args.bw
+    rx_ms = RX_SYMBOLS * tsym_ms
+    rows = list(PROFILES) + [("custom", s) for s in (args.sleep or [])]
+
+    print("SF%d BW%dkHz 符号时间 %.3f ms, 接收窗口 %.2f ms\n" % (args.sf, args.bw, tsym_ms, rx_ms))
+    print("%-11s %8s %8s %10s %10s %12s %14s" % ("档位", "睡眠ms", "前导码", "延迟ms", "占空比", "平均电流", "发送代价uA"))
+    for name, sleep_ms in rows:
+        preamble = preamble_symbols(tsym_ms, rx_ms, sleep_ms)
+        if sleep_ms == 0:
+            duty = 1.0
+            avg_ua = args.rx_ma * 1000
+            latency = 0.0
+        else:
+            on_ms = rx_ms + args.wake_ms
+            duty = on_ms / (on_ms + sleep_ms)
+            avg_ua = (args.rx_ma * 1000 * on_ms + args.sleep_ua * sleep_ms) / (on_ms + sleep_ms)
+            latency = sleep_ms + rx_ms
+        # 相对默认前导码多发送的时间折算到全天平均电流
+        extra_ms = (preamble - DEFAULT_PREAMBLE) * tsym_ms
+        tx_ua = args.tx_ma * 1000 * extra_ms * args.packets / 86400000
+        print("%-11s %8d %8d %10.1f %9.2f%% %10.1f uA %14.3f" % (
+            name, sleep_ms, preamble, latency, duty * 100, avg_ua, tx_ua))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""
+分阶段性能统计报告
+
+解析调试串口日志中由 PROFILE_Report() 输出的 PROF 行:
+    PROF,cycles,<周期数>
+    PROF,<阶段>,<样本数>,<累计ms>,<最短ms>,<最长ms>,<直方图0>,...,<直方图5>
+合并所有统计窗口, 输出各阶段耗时报告, 并按电流表估算每个上报周期的电荷、能量和平均电流。
+
+用法:
+    python3 profile_report.py debug.log
+    python3 profile_report.py debug.log --current gnss=60 --current send=120 --voltage 3.7
+    python3 profile_report.py debug.log --table currents.csv
+
+电流表文件为 "阶段,电流mA" 的CSV, 未列出的阶段使用默认值。
+"""
+
+import argparse
+import re
+import sys
+
+PHASES = ["wake", "gnss", "step", "json", "attach", "send", "close", "sleep"]
+BUCKETS = ["<10ms", "<100ms", "<1s", "<10s", "<100s", ">=100s"]
+
+# 各阶段整机电流(mA), 默认值按MCU 72MHz/8MHz运行电流与各模块典型值估计
+DEFAULT_CURRENT_MA = {
+    "wake": 15.0,
+    "gnss": 30.0,
+    "step": 5.0,
+    "json": 36.0,
+    "attach": 60.0,
+    "send": 120.0,
+    "close": 40.0,
+    "sleep": 0.01,
+}
+
+PROF_LINE = re.compile(r"PROF,([a-z]+),(\d+(?:,\d+)*)")
+
+
+def parse_log(lines):
+    cycles = 0
+    stats = {p: {"count": 0, "total": 0, "min": None, "max": 0, "hist": [0] * len(BUCKETS)} for p in PHASES}
+
+    for line in lines:
+        m = PROF_LINE.search(line)
+        if not m:
+            continue
+        name = m.group(1)
+        values = [int(v) for v in m.group(2).split(",")]
+        if name == "cycles":
+            cycles += values[0]
+            continue
+        if name not in stats or len(values) < 4 + len(BUCKETS):
+            continue
+        count, total, vmin, vmax = values[:4]
+        s = stats[name]
+        if count:
+            s["min"] = vmin if s["min"] is None else min(s["min"], vmin)
+            s["max"] = max(s["max"], vmax)
+        s["count"] += count
+        s["total"] += total
+        s["hist"] = [a + b for a, b in zip(s["hist"], values[4:4 + len(BUCKETS)])]
+
+    return cycles, stats
+
+
+def load_table(path, table):
+    with open(path, encoding="utf-8") as f:
+        for row in f:
+            row = row.split("#")[0].strip()
+            if not row:
+                continue
+            name, value = [x.strip() for x in row.split(",")[:2]]
+            table[name] = float(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="分阶段性能统计报告")
+    parser.add_argument("log", nargs="?", help="调试串口日志文件, 缺省读取标准输入")
+    parser.add_argument("--table", help="电流表CSV文件(阶段,电流mA)")
+    parser.add_argument("--current", action="append", default=[], metavar="PHASE=MA", help="覆盖某阶段电流(mA)")
+    parser.add_argument("--voltage", type=float, default=3.3, help="供电电压(V), 默认3.3")
+    args = parser.parse_args()
+
+    table = dict(DEFAULT_CURRENT_MA)
+    if args.table:
+        load_table(args.table, table)
+    for item in args.current:
+        name, value = item.split("=")
+        table[name] = float(value)
+
+    if args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            cycles, stats = parse_log(f)
+    else:
+        cycles, stats = parse_log(sys.stdin)
+
+    if cycles == 0:
+        print("未找到PROF统计数据")
+        return 1
+
+    print("上报周期数: %d\n" % cycles)
+    print("%-8s %6s %10s %10s %10s %10s  %s" % ("阶段", "样本", "平均ms", "最短ms", "最长ms", "占比", "  ".join(BUCKETS)))
+
+    cycle_ms = sum(s["total"] for s in stats.values()) / cycles
+    charge = 0.0  # 每周期电荷(mA*ms)
+    for name in PHASES:
+        s = stats[name]
+        mean = s["total"] / s["count"] if s["count"] else 0.0
+        per_cycle = s["total"] / cycles
+        share = per_cycle / cycle_ms * 100 if cycle_ms else 0.0
+        charge += per_cycle * table.get(name, 0.0)
+        print("%-8s %6d %10.1f %10s %10d %9.1f%%  %s" % (
+            name, s["count"], mean, s["min"] if s["min"] is not None else "-", s["max"], share,
+            "  ".join("%*d" % (len(b), h) for b, h in zip(BUCKETS, s["hist"]))))
+
+    print("\n平均周期: %.1f s" % (cycle_ms / 1000))
+    print("每周期电荷: %.3f mAh" % (charge / 3600000))
+    print("每周期能量: %.3f J" % (charge / 1000 * args.voltage / 1000))
+    print("平均电流: %.3f mA" % (charge / cycle_ms if cycle_ms else 0.0))
+
+    print("\n各阶段电荷占比:")
+    for name in PHASES:
+        part = stats[name]["total"] / cycles * table.get(name, 0.0)
+        print("  %-8s %6.2f mA  %5.1f%%" % (name, table.get(name, 0.0), part / charge * 100 if charge else 0.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
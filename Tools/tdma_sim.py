@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+LoRa时隙调度(TDMA)与纯ALOHA对比仿真
+
+按固件参数(user_config.h TDMA_*)模拟N个叶节点每个超帧各发送一个位置帧,
+统计两种接入方式的投递率和信道利用率:
+    ALOHA     每个节点在超帧内随机时刻发送, 空中时间重叠即视为冲突
+    TDMA      节点在 beacon + guard + slot * slotMs 处发送, 时隙号取节点ID对时隙数取余(hash)
+              或部署时分配(provisioned, 即 TDMA_NODE_INDEX)
+TDMA 中每个节点有残余频偏(漂移补偿后的误差, 均匀分布于 ±--drift ppm), 信标以 --beacon-loss
+概率丢失, 丢失期间误差按距上次同步的时间累积; 连续丢失超过 TDMA_MAX_MISSED 次的节点不发送。
+空中时间与 LORA_GetTimeOnAir() 的计算方式一致:
+    Tsym = 2^SF / BW
+    payloadSymb = 8 + max(ceil((8PL - 4SF + 28 + 16 - 20H) / (4(SF - 2DE))) * (CR + 4), 0)
+    ToA = (preamble + 4.25 + payloadSymb) * Tsym
+
+用法:
+    python3 tdma_sim.py
+    python3 tdma_sim.py --nodes 50 --nodes 200 --nodes 400 --frames 200
+    python3 tdma_sim.py --sf 7 --slot-ms 100 --drift 20 --beacon-loss 0.2
+"""
+
+import argparse
+import math
+import random
+import sys
+
+# 与固件保持一致
+FRAME_S = 160           # TDMA_FRAME_S
+SLOT_MS = 300           # TDMA_SLOT_MS
+SLOT_NUM = 500          # TDMA_SLOT_NUM
+BEACON_GUARD_MS = 1000  # TDMA_BEACON_GUARD_MS
+MAX_MISSED = 4          # TDMA_MAX_MISSED
+POSITION_LEN = 26       # LORAFRAME_POSITION_LEN
+PREAMBLE = 12           # LLCC68_LORA_DEFAULT_PREAMBLE_LENGTH
+
+
+def time_on_air_ms(sf, bw, cr, length, preamble=PREAMBLE):
+    tsym = (2 ** sf) / bw
+    de = 1 if tsym >= 16 else 0
+    num = 8 * length - 4 * sf + 28 + 16
+    symbols = 8 + max(math.ceil(num / (4 * (sf - 2 * de))) * (cr + 4), 0)
+    return (preamble + 4.25 + symbols) * tsym
+
+
+def count_delivered(starts, toa_ms):
+    """统计与其他发送没有重叠的数据包数"""
+    starts = sorted(starts)
+    ok = 0
+    for i, t in enumerate(starts):
+        prev_clear = i == 0 or starts[i - 1] + toa_ms <= t
+        next_clear = i == len(starts) - 1 or t + toa_ms <= starts[i + 1]
+        ok += prev_clear and next_clear
+    return ok
+
+
+def sim_aloha(nodes, frames, toa_ms, frame_ms, rng):
+    sent = ok = 0
+    for _ in range(frames):
+        starts = [rng.uniform(0, frame_ms - toa_ms) for _ in range(nodes)]
+        sent += nodes
+        ok += count_delivered(starts, toa_ms)
+    return sent, ok
+
+
+def sim_tdma(nodes, frames, toa_ms, args, rng, provisioned):
+    frame_ms = args.frame_s * 1000
+    if provisioned:
+        slots = [i % args.slot_num for i in range(nodes)]
+    else:
+        slots = [rng.getrandbits(32) % args.slot_num for _ in range(nodes)]
+    drift = [rng.uniform(-args.drift, args.drift) * 1e-6 for _ in range(nodes)]
+    missed = [0] * nodes
+    sent = ok = 0
+    for _ in range(frames):
+        starts = []
+        for n in range(nodes):
+            if rng.random() < args.beacon_loss:
+                missed[n] += 1
+            else:
+                missed[n] = 0
+            if missed[n] > MAX_MISSED:
+                continue  # 重新搜索信标, 本超帧不发送
+            offset = BEACON_GUARD_MS + slots[n] * args.slot_ms
+            error = drift[n] * (missed[n] * frame_ms + offset)
+            starts.append(offset + error)
+        sent += nodes
+        ok += count_delivered(starts, toa_ms)
+    return sent, ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LoRa时隙调度与纯ALOHA对比仿真")
+    parser.add_argument("--nodes", type=int, action="append", metavar="N", help="节点数, 可重复, 默认10到500")
+    parser.add_argument("--frames", type=int, default=100, help="仿真的超帧数, 默认100")
+    parser.add_argument("--sf", type=int, default=9, help="扩频因子, 默认9")
+    parser.add_argument("--bw", type=int, default=125, choices=[125, 250, 500], help="带宽(kHz), 默认125")
+    parser.add_argument("--cr", type=int, default=1, choices=[1, 2, 3, 4], help="编码率4/(4+CR), 默认1")
+    parser.add_argument("--frame-s", type=int, default=FRAME_S, help="超帧周期(秒), 默认%d" % FRAME_S)
+    parser.add_argument("--slot-ms", type=int, default=SLOT_MS, help="时隙长度(ms), 默认%d" % SLOT_MS)
+    parser.add_argument("--slot-num", type=int, default=SLOT_NUM, help="时隙数, 默认%d" % SLOT_NUM)
+    parser.add_argument("--drift", type=float, default=5.0, help="漂移补偿后的残余频偏(ppm), 默认5")
+    parser.add_argument("--beacon-loss", type=float, default=0.05, help="信标丢失概率, 默认0.05")
+    parser.add_argument("--seed", type=int, default=1, help="随机种子")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    toa_ms = time_on_air_ms(args.sf, args.bw, args.cr, POSITION_LEN)
+    frame_ms = args.frame_s * 1000
+    if BEACON_GUARD_MS + args.slot_num * args.slot_ms > frame_ms:
+        print("时隙总长超过超帧周期")
+        return 1
+    if toa_ms > args.slot_ms:
+        print("警告: 空中时间 %.1f ms 大于时隙长度 %d ms" % (toa_ms, args.slot_ms))
+
+    counts = args.nodes or [10, 50, 100, 200, 300, 400, 500]
+    print("SF%d BW%dkHz CR4/%d 位置帧空中时间 %.1f ms, 超帧 %d s, 时隙 %d x %d ms\n" % (
+        args.sf, args.bw, args.cr + 4, toa_ms, args.frame_s, args.slot_num, args.slot_ms))
+    print("%6s %8s %10s %10s %10s %10s" % ("节点", "负载", "ALOHA", "TDMA哈希", "TDMA分配", "利用率"))
+    for nodes in counts:
+        load = nodes * toa_ms / frame_ms
+        results = [
+            sim_aloha(nodes, args.frames, toa_ms, frame_ms, rng),
+            sim_tdma(nodes, args.frames, toa_ms, args, rng, False),
+            sim_tdma(nodes, args.frames, toa_ms, args, rng, True),
+        ]
+        ratios = [ok / sent if sent else 0.0 for sent, ok in results]
+        # 信道利用率: 成功投递占用的空中时间 / 超帧时长(TDMA分配)
+        print("%6d %7.2f%% %9.1f%% %9.1f%% %9.1f%% %9.2f%%" % (
+            nodes, load * 100, ratios[0] * 100, ratios[1] * 100, ratios[2] * 100, load * ratios[2] * 100))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
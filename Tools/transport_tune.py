@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+上行链路选择调参
+
+解析调试串口日志中由 TRANSPORT_Send() 输出的 XPORT 行:
+    XPORT,sel,<首选链路>,<cost|best|probe>,<截止ms>,<LoRa期望uJ>,<LoRa耗时ms>,<LoRa成功率%>,
+              <NB-IoT期望uJ>,<NB-IoT耗时ms>,<NB-IoT成功率%>
+    XPORT,res,<链路>,<1成功|0失败>,<耗时ms>,<能耗uJ>,<字节数>
+汇总每条链路的实测耗时、字节数和成功率, 按给定的能耗参数(与 user_config.h TRANSPORT_* 对应)
+重新计算每字节能耗和期望能耗, 输出各链路单独承担全部上报时的能耗, 以及固件实际选择的分布。
+
+用法:
+    python3 transport_tune.py debug.log
+    python3 transport_tune.py debug.log --lora-ma 45 --nbiot-ma 80 --supply-mv 3600
+"""
+
+import argparse
+import re
+import sys
+
+LINKS = ["lora", "nbiot"]
+
+# 与固件保持一致
+SUPPLY_MV = 3300        # TRANSPORT_SUPPLY_MV
+LORA_MA = 40            # TRANSPORT_LORA_MA
+NBIOT_MA = 60           # TRANSPORT_NBIOT_MA
+
+SEL_LINE = re.compile(r"XPORT,sel,([a-z]+),([a-z]+),(\d+(?:,\d+)*)")
+RES_LINE = re.compile(r"XPORT,res,([a-z]+),([01]),(\d+),(\d+),(\d+)")
+
+
+def parse_log(lines):
+    results = {link: [] for link in LINKS}
+    selections = {}
+
+    for line in lines:
+        m = RES_LINE.search(line)
+        if m and m.group(1) in results:
+            results[m.group(1)].append((int(m.group(2)), int(m.group(3)), int(m.group(5))))
+            continue
+        m = SEL_LINE.search(line)
+        if m:
+            key = (m.group(1), m.group(2))
+            selections[key] = selections.get(key, 0) + 1
+
+    return results, selections
+
+
+def main():
+    parser = argparse.ArgumentParser(description="上行链路选择调参")
+    parser.add_argument("log", nargs="?", help="调试串口日志文件, 缺省读取标准输入")
+    parser.add_argument("--lora-ma", type=float, default=LORA_MA, help="LoRa发送期间平均电流(mA)")
+    parser.add_argument("--nbiot-ma", type=float, default=NBIOT_MA, help="NB-IoT发送期间平均电流(mA)")
+    parser.add_argument("--supply-mv", type=float, default=SUPPLY_MV, help="供电电压(mV)")
+    args = parser.parse_args()
+
+    current = {"lora": args.lora_ma, "nbiot": args.nbiot_ma}
+    if args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            results, selections = parse_log(f)
+    else:
+        results, selections = parse_log(sys.stdin)
+
+    if not any(results.values()):
+        print("未找到XPORT发送记录")
+        return 1
+
+    print("%-6s %6s %8s %10s %8s %12s %14s" % ("链路", "发送", "成功率", "平均耗时ms", "平均字节", "uJ/字节", "每次上报期望uJ"))
+    for link in LINKS:
+        samples = results[link]
+        if not samples:
+            print("%-6s %6d %8s" % (link, 0, "-"))
+            continue
+        ok = sum(s[0] for s in samples)
+        total_ms = sum(s[1] for s in samples)
+        total_bytes = sum(s[2] for s in samples)
+        energy = total_ms * current[link] * args.supply_mv / 1000
+        rate = ok / len(samples)
+        per_byte = energy / total_bytes if total_bytes else 0.0
+        expected = energy / ok if ok else float("inf")
+        print("%-6s %6d %7.1f%% %10.1f %8.1f %12.1f %14.0f" % (
+            link, len(samples), rate * 100, total_ms / len(samples), total_bytes / len(samples), per_byte, expected))
+
+    if selections:
+        print("\n固件选择分布:")
+        for (link, reason), count in sorted(selections.items()):
+            print("  %-6s %-6s %d" % (link, reason, count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
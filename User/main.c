@@ -1,19 +1,43 @@
 #include "delay/delay.h"
 #include "debug/debug.h"
 #include "sys/sys.h"
+#include "CLOCK/clock.h"
 #include "location/location.h"
+#include "persist/persist.h"
+#include "adr/adr.h"
+#include "gateway/gateway.h"
+#include "tdma/tdma.h"
+#include "lorawan/lorawan.h"
 
 int main(void)
 {
+    MEMORY_Init();                      /* 填充栈和堆的水位标记, cJSON改用内存池 */
     HAL_Init();                         /* HAL库初始化 */
-    sys_stm32_clock_init(RCC_PLL_MUL9); /* 系统时钟初始化 */
-    delay_init(72);                     /* 延时函数初始化 */
+    CLOCK_Init();                       /* 系统时钟(72MHz)和延时函数初始化 */
     DEBUG_Init();                       /* 调试接口初始化 */
-
-    LOCATION_SendLocationData(20);      /* 发送定位数据并进入低功耗模式，20秒后唤醒(20s发送一次) */
+    PERSIST_Init();                     /* 恢复掉电保持数据 */
+    LOG_ConfigInit();                   /* 检查恢复的运行时日志级别 */
+    POLICY_Init();                      /* 恢复上报策略参数 */
+    SHELL_Init();                       /* 调试命令行(USART1接收中断) */
+    ADR_Init();                         /* 恢复LoRa自适应速率 */
+#if NODE_ROLE == NODE_ROLE_LORAWAN
+    LORAWAN_Init();                     /* 恢复LoRaWAN会话并校正上行帧计数 */
+#endif
+    LOWPOWER_Init();                    /* 低功耗管理初始化(RTC) */
+#if NODE_ROLE == NODE_ROLE_GATEWAY
+    GATEWAY_Init();                     /* 网关保持LoRa接收 */
+#endif
+    LOWPOWER_InitDone();                /* 记录待机唤醒至此的重新初始化耗时 */
 
     while (1)
     {
-
+        uint8_t hasFix = LOCATION_SendLocationData();   /* 采集并发送定位数据 */
+#if NODE_ROLE == NODE_ROLE_GATEWAY
+        GATEWAY_Listen(POLICY_Update(hasFix));          /* 网关以STOP模式接收叶节点位置帧直到下个上报周期 */
+#elif NODE_ROLE == NODE_ROLE_LEAF && defined(TDMA_ENABLE)
+        LOWPOWER_EnterLowPower(TDMA_AlignSleep(POLICY_Update(hasFix))); /* 在信标前唤醒 */
+#else
+        LOWPOWER_EnterLowPower(POLICY_Update(hasFix));  /* 按上报策略选择的间隔进入低功耗模式 */
+#endif
     }
 }
@@ -9,9 +9,171 @@
 /* 使能 GNRMC 演示 */
 #define ENABLE_GNRMC_DEMO 
 
+/* 本地时区相对UTC的偏移(秒), 东八区 */
+#define TIMEZONE_OFFSET (8 * 3600)
+
 /* 使能调试接口 */
 #define DEBUG_ENABLE
 
+/* 调试输出改为二进制日志帧, 调用处只记录格式字符串地址和参数, 由USART1 TX DMA在后台发送;
+   用Tools/log_decode.py配合编译生成的ELF(.axf)还原文本。注释掉时恢复printf逐字符发送 */
+#define LOG_BINARY
+#define LOG_BUFFER_SIZE     1024    /* 日志环形缓冲区大小(字节) */
+
+/* 各模块的编译期日志阈值(LOG_LEVEL_NONE/ERROR/WARN/INFO/TRACE), 高于阈值的 DEBUG_Error/Warn/Info/Trace
+   连同格式字符串不进入编译结果; 编译后由Tools/log_levels.py输出去除的调用数和节省的Flash */
+#define LOG_LEVEL_DEFAULT   LOG_LEVEL_INFO  /* 未单独设置的文件(时钟、RTC等) */
+#define LOG_LEVEL_LOCATION  LOG_LEVEL_INFO  /* 定位上报、上报策略和链路选择 */
+#define LOG_LEVEL_GNSS      LOG_LEVEL_INFO  /* AT6558R */
+#define LOG_LEVEL_NBIOT     LOG_LEVEL_INFO  /* QS100 */
+#define LOG_LEVEL_SENSOR    LOG_LEVEL_INFO  /* DS3553 */
+#define LOG_LEVEL_LORA      LOG_LEVEL_INFO  /* LoRa链路、分片、ADR、TDMA、网关和LoRaWAN */
+#define LOG_LEVEL_POWER     LOG_LEVEL_INFO  /* 低功耗 */
+#define LOG_DEFAULT_MASK    0x1E            /* 运行时级别掩码的缺省值(bit n 对应级别n), 掉电保持 */
+
+/* 使能分阶段性能统计, 每PROFILE_EMIT_CYCLES个上报周期通过调试串口输出一次 */
+#define PROFILE_ENABLE
+#define PROFILE_EMIT_CYCLES 10
+
+/* 上报数据中附带最近一个周期各阶段耗时 */
+// #define PROFILE_UPLINK
+
+/* cJSON使用的固定块内存池: 块大小不小于cJSON节点(ARMCC下40字节)且为8的倍数; 每个键值对占2~3块,
+   上报JSON最多约30块。栈、堆和内存池的最高水位随PROF统计一起输出(MEM行) */
+#define MEMORY_POOL_BLOCK   40      /* 块大小(字节) */
+#define MEMORY_POOL_NUM     32      /* 块数 */
+
+/* USART1调试命令行: 接收中断逐字节收取, 命令在休眠前和被串口唤醒后执行, 可查看统计、修改上报策略、
+   操作GNSS和NB-IoT模块、读写掉电保持的参数。STOP模式下由RX引脚下降沿唤醒(唤醒字符丢失, 先发一个回车) */
+#define SHELL_ENABLE
+#define SHELL_LINE_MAX      64      /* 命令行最大长度(字节) */
+#define SHELL_IDLE_MS       5000    /* 被串口唤醒后无输入该时长再继续休眠(ms) */
+#define SHELL_SESSION_S     300     /* 最近一条命令后该时长内以STOP代替STANDBY, 保持串口可唤醒(秒) */
+
+/* 上报策略参数(各模式间隔和间隔上限为默认值, 可经调试命令行修改并掉电保持) */
+#define POLICY_STATIONARY_INTERVAL  1800    /* 静止模式上报间隔上限(秒) */
+#define POLICY_WALKING_INTERVAL     60      /* 步行模式上报间隔(秒) */
+#define POLICY_VEHICLE_INTERVAL     20      /* 车载模式上报间隔(秒) */
+#define POLICY_MAX_INTERVAL         7200    /* 叠加电池和网络因素后的间隔上限(秒) */
+#define POLICY_WALKING_STEPS        20      /* 周期内步数增量不低于该值判为步行 */
+#define POLICY_VEHICLE_SPEED        15.0f   /* 速度不低于该值(km/h)判为车载 */
+#define POLICY_STILL_CYCLES         3       /* 连续静止该周期数后转为静止模式 */
+#define POLICY_BATTERY_LOW_MV       3000    /* 供电电压低于该值时间隔加倍 */
+#define POLICY_LINK_SLOW_MS         30000   /* 网络附着耗时超过该值时间隔加倍 */
+#define POLICY_LINK_RETRIES         5       /* 网络重试次数超过该值时间隔加倍 */
+
+/* 运动门控: 静止模式下唤醒后先读步数, 步数增量不足POLICY_WALKING_STEPS时跳过GNSS定位 */
+#define MOTION_GATE_ENABLE
+#define MOTION_HEARTBEAT_CYCLES     4       /* 连续跳过定位时每N个周期发送一次不含坐标的心跳, 0表示不发送 */
+
+/* DS3553运动中断输出接到PA0(WKUP)时使能: 静止模式下有运动立即唤醒, 不必等待RTC闹钟 */
+// #define MOTION_WAKEUP_ENABLE
+
+/* LoRa接收监听档位(LoraListenProfileTypeDef), 收发双方需一致: 发送方按档位加长前导码,
+   接收方按档位周期性接收/睡眠。用Tools/lora_listen.py估算各档位平均接收电流 */
+#define LORA_LISTEN_PROFILE         LORA_LISTEN_CONTINUOUS
+
+/* LoRa区域占空比限制: 按子频段跟踪空中时间额度, 额度不足的异步发送排队到额度恢复 */
+#define LORA_DUTY_CYCLE_ENABLE
+// #define LORA_REGION_EU868                /* 使用EU868子频段表, 否则按CN470整个频段统计 */
+#define LORA_DUTY_CYCLE_PERMILLE    10      /* CN470频段的占空比上限(千分比) */
+
+/* LoRa先听后发(LBT): 发送前做CAD, 信道忙时按二进制指数随机退避并换信道重试 */
+#define LORA_LBT_ENABLE
+#define LORA_LBT_MAX_ATTEMPTS       6       /* 连续检测到信道忙N次后放弃本次发送 */
+#define LORA_LBT_BACKOFF_EXP_MAX    4       /* 退避窗口上限为 2^N 个时隙(时隙为本包空中时间) */
+
+/* LoRa跳频信道表(Hz): 多于一个信道时每包伪随机选择发送信道, 接收始终回到loraConfig.frequency,
+   接收方需同时监听全部信道; 多信道示例: 480100000U, 480300000U, 480500000U, 480700000U */
+#define LORA_CHANNEL_PLAN           480000000U
+
+/* 节点角色: 独立节点自带NB-IoT上报; 叶节点经LoRa把位置帧发给网关, 不使用NB-IoT;
+   网关保持LoRa接收, 收集附近叶节点的位置帧去重后, 与自身位置一起经NB-IoT批量上行;
+   LoRaWAN节点把位置帧作为LoRaWAN上行发给公网网关, 不使用NB-IoT */
+#define NODE_ROLE_STANDALONE        0
+#define NODE_ROLE_LEAF              1
+#define NODE_ROLE_GATEWAY           2
+#define NODE_ROLE_LORAWAN           3       /* 经LoRaWAN公网网关上行, 见下方LORAWAN_*配置 */
+#define NODE_ROLE                   NODE_ROLE_STANDALONE
+#define GATEWAY_MAX_NODES           7       /* 网关每批转发的叶节点数, 受QS100单条AT命令长度限制 */
+#define GATEWAY_DUP_WINDOW          16      /* 序号落后该值以内视为重复帧, 超出视为叶节点重新上电 */
+
+/* LoRa时隙调度(TDMA): 网关在每个超帧开始发送带时间基准的信标, 叶节点由节点ID得到时隙,
+   按信标校正时钟漂移, 只在自己的时隙发送。每个节点每个超帧最多发送一次, 上报间隔按超帧对齐。
+   用Tools/tdma_sim.py估算不同节点数下的信道利用率和送达率 */
+// #define TDMA_ENABLE
+#define TDMA_FRAME_S                160     /* 超帧周期(秒), 网关在UTC秒数为其整数倍时发送信标 */
+#define TDMA_SLOT_MS                300     /* 时隙长度(ms), 需容纳SF9下一个位置帧的空中时间(约222ms)和保护间隔 */
+#define TDMA_SLOT_NUM               500     /* 每个超帧的时隙数 */
+#define TDMA_BEACON_GUARD_MS        1000    /* 信标开始到第一个时隙的间隔(ms) */
+#define TDMA_BEACON_WINDOW_MS       50      /* 信标接收窗口的最小余量(ms) */
+#define TDMA_MAX_MISSED             4       /* 连续丢失信标超过该次数后重新搜索整个超帧 */
+// #define TDMA_NODE_INDEX             0       /* 部署时分配的唯一时隙号, 未定义时取节点ID对时隙数取余 */
+
+/* LoRa分片传输: 超过一帧的消息按分片发送, 接收方以选择性应答(SACK)报告已收到的分片,
+   发送方只重发缺失的分片; 网关把重组后的消息按位置帧逐个处理 */
+#define LORAFRAG_FRAGMENT_SIZE      64      /* 每个分片的数据字节数, 加上分片头不超过LLCC68缓冲区 */
+#define LORAFRAG_MESSAGE_MAX        512     /* 单条消息最大字节数, 也是网关每个重组缓冲区的大小 */
+#define LORAFRAG_RX_SLOTS           2       /* 网关同时重组的消息数 */
+#define LORAFRAG_MAX_ROUNDS         4       /* 发送方最多发送轮数(首轮加重发) */
+#define LORAFRAG_ACK_TIMEOUT_MS     1000    /* 每轮最后一个分片发出后等待SACK的时间(ms) */
+#define LORAFRAG_RX_TIMEOUT_S       60      /* 网关重组缓冲区超过该时间没有新分片则可被其他消息占用 */
+
+/* LoRa可靠链路: 叶节点发送后只在短接收窗口内等待网关应答, 未收到时退避重发;
+   网关按节点记录序号去重并统计送达情况。使能TDMA时时隙内没有应答的时间, 不使用应答 */
+#define LORALINK_ACK_WINDOW_MS      400     /* 发送后等待应答的接收窗口(ms), 需容纳网关转向时间和应答帧的空中时间 */
+#define LORALINK_MAX_RETRIES        2       /* 未收到应答时最多重发次数 */
+#define LORALINK_BACKOFF_MS         500     /* 第N次重发前随机退避 [0, LORALINK_BACKOFF_MS * 2^N) ms */
+#define LORALINK_MAX_PEERS          GATEWAY_MAX_NODES   /* 网关统计的对端节点数 */
+
+/* LoRaWAN Class A(CN470-510, LoRaWAN 1.0.x): NODE_ROLE_LORAWAN时位置帧经LoRaWAN网关上行, 不使用NB-IoT。
+   LLCC68在125kHz下最高SF9(DR3), 网络服务器需把RX2数据速率配置为DR3及以上(区域默认DR0为SF12)。
+   EUI和密钥按网络服务器显示的顺序填写(高字节在前); 信道由LoRaWAN模块选择, LORA_CHANNEL_PLAN需保持单信道 */
+#define LORAWAN_OTAA                                /* 注释掉时使用ABP, 会话取下方ABP参数 */
+#define LORAWAN_DEV_EUI             {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+#define LORAWAN_JOIN_EUI            {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+#define LORAWAN_APP_KEY             {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+#define LORAWAN_DEV_ADDR            0x00000000U     /* ABP设备地址 */
+#define LORAWAN_NWK_SKEY            {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+#define LORAWAN_APP_SKEY            {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+#define LORAWAN_FPORT               2               /* 位置帧使用的应用端口 */
+#define LORAWAN_DEFAULT_DR          3               /* 入网和初始上行数据速率(DR3=SF9) */
+#define LORAWAN_DEFAULT_TX_POWER    1               /* TXPower档位, 0为19dBm, 每档减2dB */
+#define LORAWAN_CHANNEL_MASK        {0x00FF, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000}   /* 启用的上行信道, 每字16个, 需与网关一致 */
+#define LORAWAN_RX2_DR              3               /* RX2数据速率 */
+#define LORAWAN_RX2_FREQUENCY       505300000U      /* RX2频率(Hz) */
+#define LORAWAN_ADR                                 /* 上行帧置位ADR, 由网络服务器经LinkADRReq调整速率和功率 */
+
+/* 上行链路选择: 独立节点每次上报按期望能耗在LoRa(经附近网关)和NB-IoT之间选择, 失败时改用另一条链路;
+   能耗 = 发送耗时 x 链路平均电流 x 供电电压, 参数可用Tools/transport_tune.py按实测日志调整 */
+// #define TRANSPORT_ENABLE
+#define TRANSPORT_SUPPLY_MV         3300    /* 供电电压(mV) */
+#define TRANSPORT_LORA_MA           40      /* LoRa发送期间平均电流(mA), 含发射、应答窗口和退避 */
+#define TRANSPORT_NBIOT_MA          60      /* NB-IoT发送期间平均电流(mA), 含附着、建立套接字和发送确认 */
+#define TRANSPORT_LORA_PRIOR_MS     600     /* 尚无测量时LoRa单次发送耗时的先验(ms) */
+#define TRANSPORT_NBIOT_PRIOR_MS    20000   /* 尚无测量时NB-IoT单次发送耗时的先验(ms) */
+#define TRANSPORT_DEADLINE_MS       60000   /* 单次上报截止时间上限(ms), 另受当前上报间隔限制 */
+#define TRANSPORT_MIN_SUCCESS       128     /* 候选链路的最低成功率(Q8, 128为50%) */
+#define TRANSPORT_SUCCESS_FLOOR     16      /* 折算重发代价时成功率的下限(Q8), 避免期望能耗溢出 */
+#define TRANSPORT_PROBE_CYCLES      8       /* 更省电但被排除的链路连续N次未选用后试探一次 */
+#define TRANSPORT_EWMA_SHIFT        2       /* 估计值的滑动平均权重为 1/2^N */
+
+/* LoRa自适应速率(ADR): 按应答的SNR余量降低发射功率, 丢失应答时逐档回升 */
+#define ADR_ENABLE
+#define ADR_WINDOW                  8       /* 每累计N个应答评估一次余量 */
+#define ADR_MARGIN_DB               10      /* 在解调门限之上保留的余量(dB) */
+#define ADR_LOSS_STEP               2       /* 连续丢失N次应答升一档 */
+#define ADR_LOSS_FALLBACK           6       /* 连续丢失N次应答恢复默认速率 */
+
+/* 休眠策略能耗参数(实测值), 用于计算STOP/STANDBY模式的切换点 */
+#define LOWPOWER_RUN_CURRENT_UA         36000   /* 72MHz运行电流(uA) */
+#define LOWPOWER_STOP_CURRENT_UA        24      /* STOP模式(稳压器低功耗)电流(uA) */
+#define LOWPOWER_STANDBY_CURRENT_UA     3       /* STANDBY模式(LSI+RTC)电流(uA) */
+#define LOWPOWER_REINIT_DEFAULT_US      5000    /* 尚未实测时使用的待机唤醒重新初始化耗时(us) */
+
 typedef struct
 {
     uint8_t year;  // 年
@@ -34,6 +196,7 @@ typedef struct
     uint8_t longitude_direction; // 经度方向 (0: E, 1: W)
     float latitude;              // 纬度
     float longitude;             // 经度
+    float speed;                 // 对地速度(km/h)
     uint32_t steps;              // 步数
 
     uint8_t ID[33];              // 设备ID